@@ -4,6 +4,8 @@
 #include "AppPlatform.h"
 #include "AppRegistration.h"
 #include "event/EventBuffer.h"
+#include "event/EventIndex.h"
+#include "event/EventQueue.h"
 #include "event/LifecycleEvents.h"
 #include "file/FilePath.h"
 #include "file/FileSystem.h"
@@ -12,7 +14,7 @@
 #include "provider/GameObjectHandleProvider.h"
 #include "system/GraphicsSystem.h"
 #include "test/TestRegistry.h"
-#include "threading/WorkerPool.h"
+#include "threading/WorkStealingPool.h"
 #include "threading/SyncTask.h"
 #include "util/ScratchPad.h"
 
@@ -31,12 +33,12 @@ private:
 };
 
 App::App(std::unique_ptr<AppPlatform> appPlatform, std::unique_ptr<AppRegistration> registration)
-  : mWorkerPool(std::make_unique<WorkerPool>(4))
-  , mMessageQueue(std::make_unique<EventBuffer>())
+  : mWorkerPool(std::make_unique<WorkStealingPool>())
+  , mMessageQueue(std::make_unique<EventQueue>())
   , mFrozenMessageQueue(std::make_unique<EventBuffer>())
+  , mFrozenIndex(std::make_unique<EventIndex>())
   , mAppPlatform(std::move(appPlatform))
   , mProjectLocator(std::make_unique<ProjectLocator>())
-  , mMessageLock(std::make_unique<SpinLock>())
   , mGameObjectGen(std::make_unique<GameObjectGen>()) {
   FilePath path, file, ext;
   FilePath exePath(mAppPlatform->getExePath().c_str());
@@ -73,7 +75,7 @@ void App::onUriActivated(std::string uri) {
     mProjectLocator->setPathRoot(it->second.c_str(), PathSpace::Project);
     mAppPlatform->setWorkingDirectory(it->second.c_str());
   }
-  mMessageQueue->push(std::move(activated));
+  getMessageQueue().get().push(std::move(activated));
 }
 
 void App::init() {
@@ -81,25 +83,23 @@ void App::init() {
     if(system)
       system->init();
   }
-  mMessageLock->lock();
-  mMessageQueue->push(AllSystemsInitialized());
-  mMessageLock->unlock();
+  getMessageQueue().get().push(AllSystemsInitialized());
 }
 
 #include "imgui/imgui.h"
 
 void App::update(float dt) {
-  //Freeze message state by swapping them into freeze. Systems will look at this, while pushing to non-frozen queue
-  mMessageLock->lock();
-  mMessageQueue.swap(mFrozenMessageQueue);
-  mMessageLock->unlock();
+  //Freeze message state by moving everything pushed so far into frozen. Systems will look at this, while pushing to the queue
+  mMessageQueue->takeAll(*mFrozenMessageQueue);
+  //Index once here so each system only visits the event types it handles
+  mFrozenIndex->build(*mFrozenMessageQueue);
 
   ImGuiImpl::getPad().update();
 
-  auto frameTask = std::make_shared<SyncTask>();
+  auto frameTask = mWorkerPool->getTaskPool().create<SyncTask>();
 
   for(auto& system : mSystems) {
-    system->setEventBuffer(mFrozenMessageQueue.get());
+    system->setEventIndex(mFrozenIndex.get());
     system->queueTasks(dt, *mWorkerPool, frameTask);
   }
 
@@ -127,6 +127,7 @@ void App::update(float dt) {
 
   frameTask->sync();
   //All readers should have either looked at this in update or in a frameTask dependent task, so clear now.
+  mFrozenIndex->clear();
   mFrozenMessageQueue->clear();
 }
 
@@ -146,7 +147,7 @@ AppPlatform& App::getAppPlatform() {
 }
 
 MessageQueue App::getMessageQueue() {
-  return MessageQueue(*mMessageQueue, *mMessageLock);
+  return mMessageQueue->getBuffer();
 }
 
 System* App::_getSystem(size_t id) {
@@ -12,7 +12,8 @@ enum class SystemId : uint8_t;
 class IWorkerPool;
 class AppPlatform;
 class ProjectLocator;
-class SpinLock;
+class EventIndex;
+class EventQueue;
 
 class App
   : public MessageQueueProvider
@@ -37,9 +38,9 @@ private:
   std::unique_ptr<IWorkerPool> mWorkerPool;
   std::unique_ptr<AppPlatform> mAppPlatform;
   //Message queue is what is pushed to every frame, frozen is what all systems look at each frame to read from
-  std::unique_ptr<EventBuffer> mMessageQueue;
+  std::unique_ptr<EventQueue> mMessageQueue;
   std::unique_ptr<EventBuffer> mFrozenMessageQueue;
+  std::unique_ptr<EventIndex> mFrozenIndex;
   std::unique_ptr<ProjectLocator> mProjectLocator;
   std::unique_ptr<GameObjectHandleProvider> mGameObjectGen;
-  std::unique_ptr<SpinLock> mMessageLock;
 };
\ No newline at end of file
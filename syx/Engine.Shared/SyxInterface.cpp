@@ -2,15 +2,18 @@
 #include <SyxInterface.h>
 #include <stdlib.h>
 #include "DebugDrawer.h"
+#include "threading/TaskGroup.h"
 
 namespace Syx {
   namespace Interface {
     ::DebugDrawer* gDrawer = nullptr;
+    IWorkerPool* gWorkerPool = nullptr;
 
     SyxOptions getOptions(void) {
       SyxOptions result;
       result.mDebugFlags = SyxOptions::DrawModels;
-      result.mSimdFlags = 0;
+      result.mSimdFlags = SyxOptions::SIMD::ContactBatches;
+      result.mThreadingFlags = SyxOptions::ParallelSolve | SyxOptions::ParallelNarrowphase | SyxOptions::ParallelQueries | SyxOptions::ParallelSpaces;
       return result;
     }
 
@@ -76,11 +79,11 @@ namespace Syx {
 
     // 16 byte aligned
     void* allocAligned(size_t size) {
-      return _aligned_malloc(size, 16);
+      return ::operator new(size, std::align_val_t(16));
     }
 
     void freeAligned(void* p) {
-      return _aligned_free(p);
+      ::operator delete(p, std::align_val_t(16));
     }
 
     void* allocUnaligned(size_t size) {
@@ -94,5 +97,15 @@ namespace Syx {
     void log(const std::string& message) {
       printf(message.c_str());
     }
+
+    void parallelFor(size_t count, const std::function<void(size_t)>& callback) {
+      if(!gWorkerPool) {
+        for(size_t i = 0; i < count; ++i)
+          callback(i);
+        return;
+      }
+      //Callers already batch their work, so every index is worth its own task
+      ::parallelFor(*gWorkerPool, 0, count, 1, callback);
+    }
   }
 }
\ No newline at end of file
@@ -165,7 +165,7 @@ void Editor::uninit() {
 }
 
 void Editor::update(float dt, IWorkerPool&, std::shared_ptr<Task> frameTask) {
-  mEventHandler->handleEvents(*mEventBuffer);
+  mEventHandler->handleEvents(*mEventIndex);
 
   _updateInput(dt);
 }
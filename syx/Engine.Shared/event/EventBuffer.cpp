@@ -2,12 +2,20 @@
 #include "event/EventBuffer.h"
 #include "event/Event.h"
 
-EventBufferConstIt::EventBufferConstIt(const uint8_t* ptr)
-  : mPtr(ptr) {
+namespace {
+  //New chunks double in size until this, which is plenty for a frame's events without wasting much on the last chunk
+  const size_t MAX_GROWTH_CAPACITY = 64*1024;
+}
+
+EventBufferConstIt::EventBufferConstIt(const void* chunk, size_t offset)
+  : mChunk(chunk)
+  , mOffset(offset) {
+  _skipFinishedChunks();
 }
 
 EventBufferConstIt& EventBufferConstIt::operator++() {
-  mPtr += (**this).getSize();
+  mOffset += (**this).getSize();
+  _skipFinishedChunks();
   return *this;
 }
 
@@ -18,91 +26,166 @@ EventBufferConstIt EventBufferConstIt::operator++(int) {
 }
 
 bool EventBufferConstIt::operator==(EventBufferConstIt it) {
-  return mPtr == it.mPtr;
+  return mChunk == it.mChunk && mOffset == it.mOffset;
 }
 
 bool EventBufferConstIt::operator!=(EventBufferConstIt it) {
-  return mPtr != it.mPtr;
+  return !(*this == it);
 }
 
 const Event& EventBufferConstIt::operator*() {
-  return reinterpret_cast<const Event&>(*mPtr);
+  const EventBuffer::Chunk* chunk = static_cast<const EventBuffer::Chunk*>(mChunk);
+  return reinterpret_cast<const Event&>(chunk->getData()[mOffset]);
+}
+
+void EventBufferConstIt::_skipFinishedChunks() {
+  const EventBuffer::Chunk* chunk = static_cast<const EventBuffer::Chunk*>(mChunk);
+  while(chunk && mOffset >= chunk->mSize) {
+    chunk = chunk->mNext;
+    mOffset = 0;
+  }
+  mChunk = chunk;
+}
+
+uint8_t* EventBuffer::Chunk::getData() {
+  return reinterpret_cast<uint8_t*>(this + 1);
+}
+
+const uint8_t* EventBuffer::Chunk::getData() const {
+  return reinterpret_cast<const uint8_t*>(this + 1);
 }
 
 EventBuffer::EventBuffer(size_t baseCapacity)
-  : mBuffer(new uint8_t[baseCapacity])
-  , mBufferSize(0)
-  , mBufferCapacity(baseCapacity) {
+  : mHead(nullptr)
+  , mTail(nullptr)
+  , mFree(nullptr)
+  , mBaseCapacity(std::max(size_t(1), baseCapacity)) {
+}
+
+EventBuffer::~EventBuffer() {
+  clear();
+  while(Chunk* chunk = mFree) {
+    mFree = chunk->mNext;
+    _destroyChunk(chunk);
+  }
 }
 
 void EventBuffer::push(Event&& e) {
-  size_t start = mBufferSize;
-  _growBuffer(e.getSize());
-  Event::Registry::moveConstruct(std::move(e), mBuffer[start]);
+  Event::Registry::moveConstruct(std::move(e), *_allocate(e.getSize()));
 }
 
 void EventBuffer::push(const Event& e) {
-  size_t start = mBufferSize;
-  _growBuffer(e.getSize());
-  Event::Registry::copyConstruct(e, mBuffer[start]);
+  Event::Registry::copyConstruct(e, *_allocate(e.getSize()));
 }
 
 void EventBuffer::clear() {
-  size_t curByte = 0;
-  while(curByte < mBufferSize) {
-    Event& e = reinterpret_cast<Event&>(mBuffer[curByte]);
-    curByte += e.getSize();
-    e.~Event();
+  //Put all chunks on the free list, keeping the order so the largest is reused first
+  Chunk* chunk = mHead;
+  while(chunk) {
+    Chunk* next = chunk->mNext;
+    _clearChunk(*chunk);
+    chunk->mNext = mFree;
+    mFree = chunk;
+    chunk = next;
   }
+  mHead = mTail = nullptr;
+}
 
-  mBufferSize = 0;
+bool EventBuffer::empty() const {
+  return begin() == end();
 }
 
-void EventBuffer::_growBuffer(size_t bytes) {
-  size_t newSize = mBufferSize + bytes;
-  if(newSize < mBufferCapacity) {
-    mBufferSize = newSize;
-    return;
+uint8_t* EventBuffer::_allocate(size_t bytes) {
+  if(!mTail || mTail->mCapacity - mTail->mSize < bytes) {
+    Chunk* chunk = _createChunk(bytes);
+    if(mTail)
+      mTail->mNext = chunk;
+    else
+      mHead = chunk;
+    mTail = chunk;
   }
 
-  size_t newCap = std::max(1u, mBufferCapacity*2);
-  while(newCap < newSize)
-    newCap *= 2;
-  uint8_t* newBuff = new uint8_t[newCap];
+  uint8_t* result = mTail->getData() + mTail->mSize;
+  mTail->mSize += bytes;
+  return result;
+}
 
-  //Move construct over to new buffer
-  size_t curByte = 0;
-  while(curByte < mBufferSize) {
-    Event& e = reinterpret_cast<Event&>(mBuffer[curByte]);
-    size_t nextByte = curByte + e.getSize();
+EventBuffer::Chunk* EventBuffer::_createChunk(size_t minCapacity) {
+  if(mFree && mFree->mCapacity >= minCapacity) {
+    Chunk* result = mFree;
+    mFree = result->mNext;
+    result->mNext = nullptr;
+    return result;
+  }
+
+  size_t capacity = mTail ? std::min(mTail->mCapacity*2, MAX_GROWTH_CAPACITY) : mBaseCapacity;
+  capacity = std::max(capacity, minCapacity);
+  Chunk* result = new (::operator new(sizeof(Chunk) + capacity)) Chunk();
+  result->mNext = nullptr;
+  result->mSize = 0;
+  result->mCapacity = capacity;
+  return result;
+}
 
-    Event::Registry::moveConstruct(std::move(e), newBuff[curByte]);
+void EventBuffer::_destroyChunk(Chunk* chunk) {
+  chunk->~Chunk();
+  ::operator delete(chunk);
+}
+
+void EventBuffer::_clearChunk(Chunk& chunk) {
+  size_t curByte = 0;
+  while(curByte < chunk.mSize) {
+    Event& e = reinterpret_cast<Event&>(chunk.getData()[curByte]);
+    curByte += e.getSize();
     e.~Event();
-    curByte = nextByte;
   }
-
-  delete [] mBuffer;
-  mBuffer = newBuff;
-  mBufferSize = newSize;
-  mBufferCapacity = newCap;
+  chunk.mSize = 0;
 }
 
 void EventBuffer::appendTo(EventBuffer& listener) const {
-  size_t curByte = 0;
-  size_t dstStart = listener.mBufferSize;
-  listener._growBuffer(mBufferSize);
+  for(const Event& e : *this)
+    listener.push(e);
+}
 
-  while(curByte < mBufferSize) {
-    const Event& e = reinterpret_cast<const Event&>(mBuffer[curByte]);
-    Event::Registry::copyConstruct(e, listener.mBuffer[dstStart + curByte]);
-    curByte += e.getSize();
+void EventBuffer::splice(EventBuffer& other) {
+  if(!other.mHead)
+    return;
+
+  size_t splicedChunks = 0;
+  for(Chunk* chunk = other.mHead; chunk; chunk = chunk->mNext)
+    ++splicedChunks;
+
+  if(mTail)
+    mTail->mNext = other.mHead;
+  else
+    mHead = other.mHead;
+  mTail = other.mTail;
+  other.mHead = other.mTail = nullptr;
+
+  //Give other back as many free chunks as it gave up so it doesn't need to allocate. Moved as one run to keep the order
+  if(mFree) {
+    Chunk* first = mFree;
+    Chunk* last = mFree;
+    while(--splicedChunks && last->mNext)
+      last = last->mNext;
+    mFree = last->mNext;
+    last->mNext = other.mFree;
+    other.mFree = first;
   }
 }
 
 EventBufferConstIt EventBuffer::begin() const {
-  return EventBufferConstIt(mBuffer);
+  return EventBufferConstIt(mHead, 0);
 }
 
 EventBufferConstIt EventBuffer::end() const {
-  return EventBufferConstIt(mBuffer + mBufferSize);
+  return EventBufferConstIt(nullptr, 0);
+}
+
+size_t EventBuffer::getChunkCount() const {
+  size_t result = 0;
+  for(const Chunk* list : { mHead, mFree })
+    for(const Chunk* chunk = list; chunk; chunk = chunk->mNext)
+      ++result;
+  return result;
 }
@@ -4,7 +4,8 @@ class Event;
 
 class EventBufferConstIt : public std::iterator<std::forward_iterator_tag, const Event> {
 public:
-  EventBufferConstIt(const uint8_t* ptr);
+  //Position within a chunk of an EventBuffer. A null chunk is the end
+  EventBufferConstIt(const void* chunk, size_t offset);
 
   EventBufferConstIt& operator++();
   EventBufferConstIt operator++(int);
@@ -13,36 +14,67 @@ public:
   const Event& operator*();
 
 private:
-  const uint8_t* mPtr;
+  //Move to the next chunk that has events in it if the current one is finished
+  void _skipFinishedChunks();
+
+  const void* mChunk;
+  size_t mOffset;
 };
 
+//Events are stored back to back in a list of chunks. Growing adds a chunk rather than moving what's there,
+//so pushing never touches existing events, and whole buffers can be joined by linking their chunks with splice
 class EventBuffer {
 public:
-
   EventBuffer(size_t baseCapacity = 256);
   //No reason to copy this, so any copies would likely be accidental
   EventBuffer(const EventBuffer&) = delete;
   EventBuffer& operator=(const EventBuffer&) = delete;
+  ~EventBuffer();
 
   void push(Event&& e);
   void push(const Event& e);
   //Emplace an event of the given type and size. Must still be an event, but allows overallocation for variable event sizes within the same event type
   template<typename E, typename... Args>
   void emplace(size_t size, Args&&... args) {
-    size_t start = mBufferSize;
-    _growBuffer(size);
-    new (&mBuffer[start]) E(std::forward(args)...);
+    new (_allocate(size)) E(std::forward<Args>(args)...);
   }
 
   void appendTo(EventBuffer& listener) const;
+  //Move all of other's events onto the end of this without moving or copying them, leaving other empty.
+  //If this has chunks left over from clearing, other gets back as many as it gave up, so a producer spliced into
+  //this every frame keeps reusing the same chunks instead of allocating new ones while old ones pile up here
+  void splice(EventBuffer& other);
+  //Destroy all events. Chunks are kept for reuse
   void clear();
+  bool empty() const;
   EventBufferConstIt begin() const;
   EventBufferConstIt end() const;
+  //Number of chunks this owns, including free ones
+  size_t getChunkCount() const;
 
 private:
-  void _growBuffer(size_t bytes);
+  friend class EventBufferConstIt;
+
+  //Header of each allocation, with events following it. Aligned so events after it are, including ones with SIMD math types
+  struct alignas(16) Chunk {
+    uint8_t* getData();
+    const uint8_t* getData() const;
 
-  uint8_t* mBuffer;
-  size_t mBufferSize;
-  size_t mBufferCapacity;
-};
\ No newline at end of file
+    Chunk* mNext;
+    //Bytes used by events
+    size_t mSize;
+    size_t mCapacity;
+  };
+
+  //Reserve space for an event of the given size at the end of the buffer
+  uint8_t* _allocate(size_t bytes);
+  Chunk* _createChunk(size_t minCapacity);
+  static void _destroyChunk(Chunk* chunk);
+  void _clearChunk(Chunk& chunk);
+
+  Chunk* mHead;
+  Chunk* mTail;
+  //Empty chunks kept from clear
+  Chunk* mFree;
+  size_t mBaseCapacity;
+};
@@ -5,18 +5,17 @@
 #include "event/EventBuffer.h"
 
 void EventHandler::registerEventHandler(size_t type, Callback h) {
-  Callback* existingCallback = mEventHandlers.get(type);
-  //If a callback already exists, chain the calls together
-  if(existingCallback && *existingCallback) {
-    Callback existingCopy = std::move(*existingCallback);
-    mEventHandlers[type] = [cur = std::move(h), prev = std::move(existingCopy)](const Event& e) {
-      prev(e);
+  registerBatchHandler(type, [cur = std::move(h)](EventSpan<Event> events) {
+    for(const Event& e : events)
       cur(e);
-    };
-  }
-  else {
-    mEventHandlers[type] = std::move(h);
-  }
+  });
+}
+
+void EventHandler::registerBatchHandler(size_t type, BatchCallback h) {
+  std::vector<BatchCallback>& handlers = mEventHandlers[type];
+  if(handlers.empty())
+    mHandledTypes.push_back(type);
+  handlers.push_back(std::move(h));
 }
 
 void EventHandler::registerGlobalHandler(Callback h) {
@@ -35,11 +34,62 @@ void EventHandler::registerGlobalHandler(Callback h) {
 
 void EventHandler::handleEvents(const EventBuffer& buffer) {
   for(const Event& e : buffer) {
-    const Callback* handler = mEventHandlers.get(e.getType());
+    const std::vector<BatchCallback>* handlers = mEventHandlers.get(e.getType());
 
-    if(handler && *handler)
-      (*handler)(e);
+    if(handlers && !handlers->empty()) {
+      const Event* single = &e;
+      _dispatch(e.getType(), EventSpan<Event>(&single, 1));
+    }
     else if(mGlobalHandler)
       mGlobalHandler(e);
   }
-}
\ No newline at end of file
+}
+
+void EventHandler::handleEvents(const EventIndex& index) {
+  //The global handler needs to see every event, so the index doesn't help
+  if(mGlobalHandler) {
+    if(const EventBuffer* buffer = index.getBuffer())
+      handleEvents(*buffer);
+    return;
+  }
+
+  mCursors.clear();
+  for(size_t type : mHandledTypes) {
+    EventSpan<Event> events = index.getEvents(type);
+    if(!events.empty())
+      mCursors.push_back({ events, index.getOrder(type), 0, type });
+  }
+
+  //Merge the types back into buffer order, handing each run of consecutive events of one type to its handlers at once
+  while(!mCursors.empty()) {
+    size_t next = 0;
+    uint32_t limit = std::numeric_limits<uint32_t>::max();
+    for(size_t i = 1; i < mCursors.size(); ++i) {
+      const uint32_t order = mCursors[i].mOrder[mCursors[i].mPosition];
+      if(order < mCursors[next].mOrder[mCursors[next].mPosition]) {
+        limit = std::min(limit, mCursors[next].mOrder[mCursors[next].mPosition]);
+        next = i;
+      }
+      else
+        limit = std::min(limit, order);
+    }
+
+    //The run continues until the first event of any other type
+    Cursor& cursor = mCursors[next];
+    const uint32_t* runEnd = std::lower_bound(cursor.mOrder + cursor.mPosition, cursor.mOrder + cursor.mEvents.size(), limit);
+    const size_t runSize = static_cast<size_t>(runEnd - cursor.mOrder) - cursor.mPosition;
+    _dispatch(cursor.mType, cursor.mEvents.subspan(cursor.mPosition, runSize));
+
+    cursor.mPosition += runSize;
+    if(cursor.mPosition == cursor.mEvents.size()) {
+      mCursors[next] = mCursors.back();
+      mCursors.pop_back();
+    }
+  }
+}
+
+void EventHandler::_dispatch(size_t type, EventSpan<Event> events) {
+  //Handlers can register more, like the editor creating tools when systems are initialized, so look them up each time rather than holding on to them
+  for(size_t i = 0; i < mEventHandlers[type].size(); ++i)
+    mEventHandlers[type][i](events);
+}
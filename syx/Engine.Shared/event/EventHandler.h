@@ -1,24 +1,54 @@
 #pragma once
+#include "event/Event.h"
+#include "event/EventIndex.h"
 
-class Event;
 class EventBuffer;
 
 class EventHandler {
 public:
   using Callback = std::function<void(const Event&)>;
+  //Called with runs of consecutive events of the registered type
+  using BatchCallback = std::function<void(EventSpan<Event>)>;
 
   template<class EventType, class Func>
   void registerEventHandler(Func func) {
-    registerEventHandler(Event::typeId<EventType>(), [f = std::move(func)](const Event& e) {
-      f(static_cast<const EventType&>(e));
+    //Loop inside the batch so there's one std::function call per run of events rather than per event
+    registerBatchHandler(Event::typeId<EventType>(), [f = std::move(func)](EventSpan<Event> events) {
+      for(const EventType& e : events.as<EventType>())
+        f(e);
     });
   }
 
+  template<class EventType, class Func>
+  void registerBatchHandler(Func func) {
+    registerBatchHandler(Event::typeId<EventType>(), [f = std::move(func)](EventSpan<Event> events) {
+      f(events.as<EventType>());
+    });
+  }
+
+  //Multiple handlers for the same type are called in the order they were registered
   void registerEventHandler(size_t type, Callback h);
+  void registerBatchHandler(size_t type, BatchCallback h);
+  //Called for events with no handler for their type
   void registerGlobalHandler(Callback h);
   void handleEvents(const EventBuffer& buffer);
+  //Only visits the types there are handlers for, while still handling events in the order they were pushed
+  void handleEvents(const EventIndex& index);
 
 private:
-  TypeMap<Callback> mEventHandlers;
+  struct Cursor {
+    EventSpan<Event> mEvents;
+    const uint32_t* mOrder;
+    size_t mPosition;
+    size_t mType;
+  };
+
+  void _dispatch(size_t type, EventSpan<Event> events);
+
+  TypeMap<std::vector<BatchCallback>> mEventHandlers;
+  //Types in mEventHandlers that have handlers
+  std::vector<size_t> mHandledTypes;
   Callback mGlobalHandler;
-};
\ No newline at end of file
+  //Kept between calls to avoid allocating
+  std::vector<Cursor> mCursors;
+};
@@ -0,0 +1,46 @@
+#include "Precompile.h"
+#include "event/EventIndex.h"
+
+#include "event/Event.h"
+#include "event/EventBuffer.h"
+
+void EventIndex::build(const EventBuffer& buffer) {
+  clear();
+  mBuffer = &buffer;
+
+  uint32_t order = 0;
+  for(const Event& e : buffer) {
+    const size_t type = e.getType();
+    if(type >= mBuckets.size())
+      mBuckets.resize(type + 1);
+
+    Bucket& bucket = mBuckets[type];
+    if(bucket.mEvents.empty())
+      mUsedTypes.push_back(type);
+    bucket.mEvents.push_back(&e);
+    bucket.mOrder.push_back(order++);
+  }
+}
+
+void EventIndex::clear() {
+  for(size_t type : mUsedTypes) {
+    mBuckets[type].mEvents.clear();
+    mBuckets[type].mOrder.clear();
+  }
+  mUsedTypes.clear();
+  mBuffer = nullptr;
+}
+
+EventSpan<Event> EventIndex::getEvents(size_t type) const {
+  if(type < mBuckets.size())
+    return EventSpan<Event>(mBuckets[type].mEvents.data(), mBuckets[type].mEvents.size());
+  return EventSpan<Event>(nullptr, 0);
+}
+
+const uint32_t* EventIndex::getOrder(size_t type) const {
+  return type < mBuckets.size() ? mBuckets[type].mOrder.data() : nullptr;
+}
+
+const EventBuffer* EventIndex::getBuffer() const {
+  return mBuffer;
+}
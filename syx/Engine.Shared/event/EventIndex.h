@@ -0,0 +1,110 @@
+#pragma once
+
+class Event;
+class EventBuffer;
+
+//Contiguous run of events of one type, iterated as EventType
+template<class EventType>
+class EventSpan {
+public:
+  //Only steps forward, so it's tagged that way even though the storage is contiguous. Use operator[] for indexing
+  class Iterator : public std::iterator<std::forward_iterator_tag, const EventType> {
+  public:
+    Iterator(const Event* const* ptr)
+      : mPtr(ptr) {
+    }
+
+    Iterator& operator++() {
+      ++mPtr;
+      return *this;
+    }
+
+    Iterator operator++(int) {
+      Iterator copy = *this;
+      ++mPtr;
+      return copy;
+    }
+
+    bool operator==(Iterator rhs) const {
+      return mPtr == rhs.mPtr;
+    }
+
+    bool operator!=(Iterator rhs) const {
+      return mPtr != rhs.mPtr;
+    }
+
+    const EventType& operator*() const {
+      return static_cast<const EventType&>(**mPtr);
+    }
+
+  private:
+    const Event* const* mPtr;
+  };
+
+  EventSpan(const Event* const* begin, size_t size)
+    : mBegin(begin)
+    , mSize(size) {
+  }
+
+  EventSpan<EventType> subspan(size_t offset, size_t count) const {
+    return EventSpan<EventType>(mBegin + offset, count);
+  }
+
+  //Same events viewed as a different type. Only valid if they are that type
+  template<class OtherType>
+  EventSpan<OtherType> as() const {
+    return EventSpan<OtherType>(mBegin, mSize);
+  }
+
+  const EventType& operator[](size_t index) const {
+    return static_cast<const EventType&>(*mBegin[index]);
+  }
+
+  Iterator begin() const {
+    return Iterator(mBegin);
+  }
+
+  Iterator end() const {
+    return Iterator(mBegin + mSize);
+  }
+
+  size_t size() const {
+    return mSize;
+  }
+
+  bool empty() const {
+    return mSize == 0;
+  }
+
+private:
+  const Event* const* mBegin;
+  size_t mSize;
+};
+
+//Events in a buffer bucketed by type, built once after the buffer is filled so each EventHandler only visits the types it handles
+//Each event also has its position in the buffer so handlers can still see events of different types in the order they were pushed
+class EventIndex {
+public:
+  //Index all events in buffer, replacing any previous contents. The buffer must not change while the index is used
+  void build(const EventBuffer& buffer);
+  void clear();
+
+  //All events of the given type, in buffer order
+  EventSpan<Event> getEvents(size_t type) const;
+  //Position in the buffer of each event in getEvents(type)
+  const uint32_t* getOrder(size_t type) const;
+  //Buffer this was built from, or null if it hasn't been
+  const EventBuffer* getBuffer() const;
+
+private:
+  struct Bucket {
+    std::vector<const Event*> mEvents;
+    std::vector<uint32_t> mOrder;
+  };
+
+  //Indexed by type. Buckets are kept between builds to reuse their memory
+  std::vector<Bucket> mBuckets;
+  //Types with events in them, so clearing doesn't have to visit every bucket
+  std::vector<size_t> mUsedTypes;
+  const EventBuffer* mBuffer = nullptr;
+};
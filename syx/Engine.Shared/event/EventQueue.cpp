@@ -0,0 +1,63 @@
+#include "Precompile.h"
+#include "event/EventQueue.h"
+
+namespace {
+  std::atomic<uint64_t> sNextQueueId(1);
+}
+
+EventQueue::EventQueue()
+  : mProducers(nullptr)
+  , mId(sNextQueueId.fetch_add(1)) {
+}
+
+EventQueue::~EventQueue() {
+  Producer* producer = mProducers.load();
+  while(producer) {
+    Producer* next = producer->mNext;
+    delete producer;
+    producer = next;
+  }
+}
+
+MessageQueue EventQueue::getBuffer() {
+  Producer& producer = _getProducer();
+  return MessageQueue(producer.mBuffer, producer.mLock);
+}
+
+void EventQueue::takeAll(EventBuffer& result) {
+  for(Producer* producer = mProducers.load(); producer; producer = producer->mNext) {
+    //Only waits if the producer is in the middle of pushing
+    std::lock_guard<SpinLock> lock(producer->mLock);
+    result.splice(producer->mBuffer);
+  }
+}
+
+EventQueue::Producer& EventQueue::_getProducer() {
+  //Most pushes are from a thread that pushed to this same queue last time
+  struct Cache {
+    uint64_t mQueueId = 0;
+    Producer* mProducer = nullptr;
+  };
+  thread_local Cache cache;
+  if(cache.mQueueId == mId)
+    return *cache.mProducer;
+
+  const std::thread::id thread = std::this_thread::get_id();
+  Producer* head = mProducers.load();
+  Producer* found = head;
+  while(found && found->mThread != thread)
+    found = found->mNext;
+
+  if(!found) {
+    found = new Producer();
+    found->mThread = thread;
+    found->mNext = head;
+    //Other threads may be adding their own at the same time, in which case mNext is updated to the new head and this tries again
+    while(!mProducers.compare_exchange_weak(found->mNext, found)) {
+    }
+  }
+
+  cache.mQueueId = mId;
+  cache.mProducer = found;
+  return *found;
+}
@@ -0,0 +1,34 @@
+#pragma once
+#include "event/EventBuffer.h"
+#include "provider/MessageQueueProvider.h"
+#include "threading/SpinLock.h"
+
+//Queue any number of threads can push events to without waiting on each other. Each thread gets its own buffer, locked only against takeAll,
+//which links everything pushed so far onto another buffer once a frame. Events from the same thread keep their order, but there is no order between threads
+class EventQueue {
+public:
+  EventQueue();
+  EventQueue(const EventQueue&) = delete;
+  EventQueue& operator=(const EventQueue&) = delete;
+  ~EventQueue();
+
+  //The calling thread's buffer, which is locked for as long as the result is held
+  MessageQueue getBuffer();
+  //Move all pushed events onto the end of result
+  void takeAll(EventBuffer& result);
+
+private:
+  struct Producer {
+    EventBuffer mBuffer;
+    SpinLock mLock;
+    std::thread::id mThread;
+    Producer* mNext = nullptr;
+  };
+
+  Producer& _getProducer();
+
+  //Only ever added to until destruction, so it can be walked without locking
+  std::atomic<Producer*> mProducers;
+  //Unique for the lifetime of the process so a thread's cached producer can't be mistaken for one from a queue that used to be at the same address
+  const uint64_t mId;
+};
@@ -1,8 +1,105 @@
 #include "Precompile.h"
 #include "event/TransformEvent.h"
+#include "threading/SpinLock.h"
 
 DEFINE_EVENT(TransformEvent, Handle handle, Syx::Mat4 transform, size_t fromSystem)
   , mHandle(handle)
   , mTransform(transform)
   , mFromSystem(fromSystem) {
-}
\ No newline at end of file
+}
+
+const size_t TransformBatch::NO_MATRIX;
+
+uint64_t TransformBatch::newLayoutId() {
+  static std::atomic<uint64_t> nextId(INVALID_LAYOUT + 1);
+  return nextId++;
+}
+
+void TransformBatch::clear() {
+  mHandles.clear();
+  mPositions.clear();
+  mRotations.clear();
+  mScales.clear();
+  mMatrixIndices.clear();
+  mMatrices.clear();
+  mLayout = INVALID_LAYOUT;
+}
+
+void TransformBatch::push(Handle handle, const Syx::Vec3& pos, const Syx::Quat& rot, const Syx::Vec3& scale) {
+  mHandles.push_back(handle);
+  mPositions.push_back(pos);
+  mRotations.push_back(rot);
+  mScales.push_back(scale);
+  mMatrixIndices.push_back(NO_MATRIX);
+}
+
+void TransformBatch::push(Handle handle, const Syx::Mat4& transform) {
+  push(handle, Syx::Vec3::Zero, Syx::Quat::Identity, Syx::Vec3::Identity);
+  mMatrixIndices.back() = mMatrices.size();
+  mMatrices.push_back(transform);
+}
+
+size_t TransformBatch::size() const {
+  return mHandles.size();
+}
+
+bool TransformBatch::empty() const {
+  return mHandles.empty();
+}
+
+Syx::Mat4 TransformBatch::getTransform(size_t index) const {
+  if(mMatrixIndices[index] != NO_MATRIX)
+    return mMatrices[mMatrixIndices[index]];
+  //Transposed to match the layout of matrices from Mat4::operator*, which is how physics transforms have always been sent
+  return Syx::Mat4::transform(mScales[index], mRotations[index], mPositions[index]).transposed();
+}
+
+SyxToModel::SyxToModel(const Syx::Mat4& syxToModel)
+  : mTransform(syxToModel) {
+  Syx::Mat3 rot;
+  syxToModel.transposed().decompose(mModelScale, rot, mPos);
+  mRot = rot.toQuat();
+  mScale = Syx::Vec3::scale(mModelScale, syxToModel.getScale().reciprocal());
+  mDecomposed = std::abs(mModelScale.x - mModelScale.y) <= SYX_EPSILON*mModelScale.x && std::abs(mModelScale.x - mModelScale.z) <= SYX_EPSILON*mModelScale.x;
+}
+
+void SyxToModel::push(TransformBatch& batch, Handle handle, const Syx::Vec3& pos, const Syx::Quat& rot) const {
+  //Same result as the matrix product below, with the model part decomposed ahead of time
+  if(mDecomposed)
+    batch.push(handle, mPos + mRot*Syx::Vec3::scale(mModelScale, pos), mRot*rot, mScale);
+  else
+    batch.push(handle, Syx::Mat4::transform(mTransform.getScale().reciprocal(), rot, pos) * mTransform);
+}
+
+struct TransformBatchPool::Storage {
+  SpinLock mLock;
+  std::vector<std::unique_ptr<TransformBatch>> mFree;
+};
+
+TransformBatchPool::TransformBatchPool()
+  : mStorage(std::make_shared<Storage>()) {
+}
+
+std::shared_ptr<TransformBatch> TransformBatchPool::create() {
+  std::unique_ptr<TransformBatch> result;
+  mStorage->mLock.lock();
+  if(!mStorage->mFree.empty()) {
+    result = std::move(mStorage->mFree.back());
+    mStorage->mFree.pop_back();
+  }
+  mStorage->mLock.unlock();
+  if(!result)
+    result = std::make_unique<TransformBatch>();
+
+  return std::shared_ptr<TransformBatch>(result.release(), [storage = mStorage](TransformBatch* batch) {
+    batch->clear();
+    storage->mLock.lock();
+    storage->mFree.emplace_back(batch);
+    storage->mLock.unlock();
+  });
+}
+
+DEFINE_EVENT(TransformBatchEvent, std::shared_ptr<const TransformBatch> batch, size_t fromSystem)
+  , mBatch(std::move(batch))
+  , mFromSystem(fromSystem) {
+}
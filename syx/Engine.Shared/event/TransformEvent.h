@@ -9,3 +9,70 @@ public:
   Syx::Mat4 mTransform;
   size_t mFromSystem;
 };
+
+//Transforms for many objects with each part in its own array. The transform for mHandles[i] is built from mPositions[i], mRotations[i] and mScales[i],
+//unless it can't be expressed that way, in which case it's the full matrix mMatrices[mMatrixIndices[i]], see getTransform
+struct TransformBatch {
+  //Ids are never 0, so receivers can use that for nothing looked up yet
+  static const uint64_t INVALID_LAYOUT = 0;
+  static const size_t NO_MATRIX = static_cast<size_t>(-1);
+
+  static uint64_t newLayoutId();
+
+  void clear();
+  void push(Handle handle, const Syx::Vec3& pos, const Syx::Quat& rot, const Syx::Vec3& scale);
+  void push(Handle handle, const Syx::Mat4& transform);
+  size_t size() const;
+  bool empty() const;
+  Syx::Mat4 getTransform(size_t index) const;
+
+  std::vector<Handle> mHandles;
+  std::vector<Syx::Vec3> mPositions;
+  std::vector<Syx::Quat> mRotations;
+  std::vector<Syx::Vec3> mScales;
+  std::vector<size_t> mMatrixIndices;
+  std::vector<Syx::Mat4> mMatrices;
+  //Same id means the same mHandles in the same order, so receivers can reuse whatever they looked up for each index last time
+  uint64_t mLayout = INVALID_LAYOUT;
+};
+
+//Transform from syx to model space for one object, decomposed ahead of time when possible so updates can be added to a batch without building matrices
+struct SyxToModel {
+  SyxToModel(const Syx::Mat4& syxToModel = Syx::Mat4::identity());
+
+  //Adds the model transform of an object at the given syx position and rotation to the batch
+  void push(TransformBatch& batch, Handle handle, const Syx::Vec3& pos, const Syx::Quat& rot) const;
+
+  Syx::Mat4 mTransform;
+  Syx::Vec3 mPos;
+  Syx::Quat mRot;
+  Syx::Vec3 mModelScale;
+  //Scale of the resulting transform, the model scale with mTransform's own scale divided out
+  Syx::Vec3 mScale;
+  //Non-uniform model scale followed by the syx rotation can't be expressed as position, rotation and scale, so those send the whole matrix
+  bool mDecomposed;
+};
+
+//Hands out batches that go back to the pool when the last reference is dropped, keeping their capacity, so filling one each frame doesn't
+//allocate the arrays again. References can be dropped on any thread, and each batch holds on to the pool's storage so it can outlive the pool
+class TransformBatchPool {
+public:
+  TransformBatchPool();
+
+  //Empty batch with an invalid layout
+  std::shared_ptr<TransformBatch> create();
+
+private:
+  struct Storage;
+
+  std::shared_ptr<Storage> mStorage;
+};
+
+//A frame's worth of physics updates as one event applied in a single pass. The batch is shared rather than copied when the event is
+class TransformBatchEvent : public Event {
+public:
+  TransformBatchEvent(std::shared_ptr<const TransformBatch> batch = nullptr, size_t fromSystem = static_cast<size_t>(-1));
+
+  std::shared_ptr<const TransformBatch> mBatch;
+  size_t mFromSystem;
+};
@@ -70,7 +70,8 @@ GraphicsSystem::~GraphicsSystem() {
 }
 
 GraphicsSystem::GraphicsSystem(const SystemArgs& args)
-  : System(args) {
+  : System(args)
+  , mTransformBatchLayout(TransformBatch::INVALID_LAYOUT) {
 }
 
 void GraphicsSystem::init() {
@@ -96,6 +97,7 @@ void GraphicsSystem::init() {
   SYSTEM_EVENT_HANDLER(RemoveComponentEvent, _processRemoveEvent);
   SYSTEM_EVENT_HANDLER(RenderableUpdateEvent, _processRenderableEvent);
   SYSTEM_EVENT_HANDLER(TransformEvent, _processTransformEvent);
+  SYSTEM_EVENT_HANDLER(TransformBatchEvent, _processTransformBatchEvent);
   SYSTEM_EVENT_HANDLER(DrawLineEvent, _processDebugDrawEvent);
   SYSTEM_EVENT_HANDLER(DrawVectorEvent, _processDebugDrawEvent);
   SYSTEM_EVENT_HANDLER(DrawPointEvent, _processDebugDrawEvent);
@@ -112,7 +114,7 @@ void GraphicsSystem::init() {
 }
 
 void GraphicsSystem::update(float dt, IWorkerPool&, std::shared_ptr<Task>) {
-  mEventHandler->handleEvents(*mEventBuffer);
+  mEventHandler->handleEvents(*mEventIndex);
 
   bool updatePick = mPickRequests.size() && mFrameBuffer;
   if(updatePick) {
@@ -180,15 +182,19 @@ void GraphicsSystem::dispatchToRenderThread(std::function<void()> func) {
 }
 
 void GraphicsSystem::_processAddEvent(const AddComponentEvent& e) {
-  if(e.mCompType == Component::typeId<Renderable>() && !mLocalRenderables.get(e.mObj))
+  if(e.mCompType == Component::typeId<Renderable>() && !mLocalRenderables.get(e.mObj)) {
     mLocalRenderables.pushBack(LocalRenderable(e.mObj));
+    mTransformBatchLayout = TransformBatch::INVALID_LAYOUT;
+  }
   else if(e.mCompType == Component::typeId<CameraComponent>() && !_getCamera(e.mObj))
     mCameras.push_back(createCamera(e.mObj));
 }
 
 void GraphicsSystem::_processRemoveEvent(const RemoveComponentEvent& e) {
-  if(e.mCompType == Component::typeId<Renderable>())
+  if(e.mCompType == Component::typeId<Renderable>()) {
     mLocalRenderables.erase(e.mObj);
+    mTransformBatchLayout = TransformBatch::INVALID_LAYOUT;
+  }
   else if(e.mCompType == Component::typeId<CameraComponent>()) {
     //TODO: remove
   }
@@ -202,6 +208,23 @@ void GraphicsSystem::_processTransformEvent(const TransformEvent& e) {
   //TODO camera transform update
 }
 
+void GraphicsSystem::_processTransformBatchEvent(const TransformBatchEvent& e) {
+  if(!e.mBatch)
+    return;
+  const TransformBatch& batch = *e.mBatch;
+  if(batch.mLayout != mTransformBatchLayout) {
+    mTransformBatchTargets.clear();
+    for(Handle handle : batch.mHandles)
+      mTransformBatchTargets.push_back(mLocalRenderables.get(handle));
+    mTransformBatchLayout = batch.mLayout;
+  }
+
+  for(size_t i = 0; i < batch.size(); ++i) {
+    if(LocalRenderable* obj = mTransformBatchTargets[i])
+      obj->mTransform = batch.getTransform(i);
+  }
+}
+
 void GraphicsSystem::_processRenderableEvent(const RenderableUpdateEvent& e) {
   LocalRenderable* obj = mLocalRenderables.get(e.mObj);
   if(obj) {
@@ -291,6 +314,7 @@ void GraphicsSystem::_processClearSpaceEvent(const ClearSpaceEvent& e) {
 
   for(Handle h : removed)
     mLocalRenderables.erase(h);
+  mTransformBatchLayout = TransformBatch::INVALID_LAYOUT;
 }
 
 void GraphicsSystem::_processRenderThreadTasks() {
@@ -34,6 +34,7 @@ class SetViewportEvent;
 class Shader;
 class Texture;
 class TransformEvent;
+class TransformBatchEvent;
 class Viewport;
 
 struct RenderCommand;
@@ -75,6 +76,7 @@ private:
   void _processAddEvent(const AddComponentEvent& e);
   void _processRemoveEvent(const RemoveComponentEvent& e);
   void _processTransformEvent(const TransformEvent& e);
+  void _processTransformBatchEvent(const TransformBatchEvent& e);
   void _processRenderableEvent(const RenderableUpdateEvent& e);
   void _processDebugDrawEvent(const DrawLineEvent& e);
   void _processDebugDrawEvent(const DrawVectorEvent& e);
@@ -124,6 +126,9 @@ private:
 
   //Local state
   MappedBuffer<LocalRenderable> mLocalRenderables;
+  //Renderable for each handle of the last transform batch layout. Looked up again when the layout changes or mLocalRenderables does
+  std::vector<LocalRenderable*> mTransformBatchTargets;
+  uint64_t mTransformBatchLayout;
   std::vector<RenderCommand> mRenderCommands;
 
   std::vector<Camera> mCameras;
@@ -33,7 +33,8 @@ const std::string LuaGameSystem::INSTANCE_KEY = "LuaGameSystem";
 const char* LuaGameSystem::CLASS_NAME = "Game";
 
 LuaGameSystem::LuaGameSystem(const SystemArgs& args)
-  : System(args) {
+  : System(args)
+  , mTransformBatchLayout(TransformBatch::INVALID_LAYOUT) {
 }
 
 LuaGameSystem::~LuaGameSystem() {
@@ -50,6 +51,7 @@ void LuaGameSystem::init() {
   SYSTEM_EVENT_HANDLER(RemoveGameObjectEvent, _onRemoveGameObject);
   SYSTEM_EVENT_HANDLER(RenderableUpdateEvent, _onRenderableUpdate);
   SYSTEM_EVENT_HANDLER(TransformEvent, _onTransformUpdate);
+  SYSTEM_EVENT_HANDLER(TransformBatchEvent, _onTransformBatchUpdate);
   SYSTEM_EVENT_HANDLER(PhysicsCompUpdateEvent, _onPhysicsUpdate);
   SYSTEM_EVENT_HANDLER(SetComponentPropsEvent, _onSetComponentProps);
   SYSTEM_EVENT_HANDLER(AllSystemsInitialized, _onAllSystemsInit);
@@ -78,13 +80,14 @@ void LuaGameSystem::queueTasks(float dt, IWorkerPool& pool, std::shared_ptr<Task
   CallOnObserversPtr(mSubject, preUpdate, *this);
 
   mSafeToAccessObjects = false;
-  auto events = std::make_shared<FunctionTask>([this]() {
+  TaskPool& tasks = pool.getTaskPool();
+  auto events = tasks.create<FunctionTask>([this]() {
     mEventHandlerThread = std::this_thread::get_id();
-    mEventHandler->handleEvents(*mEventBuffer);
+    mEventHandler->handleEvents(*mEventIndex);
     mSafeToAccessObjects = true;
   });
 
-  auto update = std::make_shared<FunctionTask>([this, dt]() {
+  auto update = tasks.create<FunctionTask>([this, dt]() {
     _update(dt);
   });
 
@@ -261,6 +264,7 @@ const LuaGameObject* LuaGameSystem::getObject(Handle handle) const {
 
 void LuaGameSystem::uninit() {
   mObjects.clear();
+  mTransformBatchLayout = TransformBatch::INVALID_LAYOUT;
   mEventHandler = nullptr;
   mState = nullptr;
 }
@@ -340,14 +344,18 @@ void LuaGameSystem::_onAddGameObject(const AddGameObjectEvent& e) {
     }
   }
   mPendingObjectsLock.unlock();
-  if(mObjects.find(e.mObj) == mObjects.end())
+  if(mObjects.find(e.mObj) == mObjects.end()) {
     mObjects[e.mObj] = pending ? std::move(pending) : std::make_unique<LuaGameObject>(e.mObj);
+    mTransformBatchLayout = TransformBatch::INVALID_LAYOUT;
+  }
 }
 
 void LuaGameSystem::_onRemoveGameObject(const RemoveGameObjectEvent& e) {
   auto it = mObjects.find(e.mObj);
-  if(it != mObjects.end())
+  if(it != mObjects.end()) {
     mObjects.erase(it);
+    mTransformBatchLayout = TransformBatch::INVALID_LAYOUT;
+  }
 }
 
 void LuaGameSystem::_onRenderableUpdate(const RenderableUpdateEvent& e) {
@@ -363,6 +371,23 @@ void LuaGameSystem::_onTransformUpdate(const TransformEvent& e) {
     obj->getTransform().set(e.mTransform);
 }
 
+void LuaGameSystem::_onTransformBatchUpdate(const TransformBatchEvent& e) {
+  if(!e.mBatch)
+    return;
+  const TransformBatch& batch = *e.mBatch;
+  if(batch.mLayout != mTransformBatchLayout) {
+    mTransformBatchTargets.clear();
+    for(Handle handle : batch.mHandles)
+      mTransformBatchTargets.push_back(_getObj(handle));
+    mTransformBatchLayout = batch.mLayout;
+  }
+
+  for(size_t i = 0; i < batch.size(); ++i) {
+    if(LuaGameObject* obj = mTransformBatchTargets[i])
+      obj->getTransform().set(batch.getTransform(i));
+  }
+}
+
 void LuaGameSystem::_onPhysicsUpdate(const PhysicsCompUpdateEvent& e) {
   if(LuaGameObject* obj = _getObj(e.mOwner)) {
     if(Physics* c = obj->getComponent<Physics>()) {
@@ -385,6 +410,7 @@ void LuaGameSystem::_onSpaceClear(const ClearSpaceEvent& e) {
     if(it->second->getSpace() == e.mSpace) {
       LuaGameObject::invalidate(*mState, *it->second);
       it = mObjects.erase(it);
+      mTransformBatchLayout = TransformBatch::INVALID_LAYOUT;
     }
     else
       ++it;
@@ -35,6 +35,7 @@ class Space;
 class Task;
 class Toolbox;
 class TransformEvent;
+class TransformBatchEvent;
 
 struct LuaSceneDescription;
 struct lua_State;
@@ -111,6 +112,7 @@ private:
   void _onRemoveGameObject(const RemoveGameObjectEvent& e);
   void _onRenderableUpdate(const RenderableUpdateEvent& e);
   void _onTransformUpdate(const TransformEvent& e);
+  void _onTransformBatchUpdate(const TransformBatchEvent& e);
   void _onPhysicsUpdate(const PhysicsCompUpdateEvent& e);
   void _onSetComponentProps(const SetComponentPropsEvent& e);
   void _onSpaceClear(const ClearSpaceEvent& e);
@@ -121,6 +123,9 @@ private:
   static const std::string INSTANCE_KEY;
 
   HandleMap<std::unique_ptr<LuaGameObject>> mObjects;
+  //Object for each handle of the last transform batch layout. Looked up again when the layout changes or mObjects does
+  std::vector<LuaGameObject*> mTransformBatchTargets;
+  uint64_t mTransformBatchLayout;
   std::unique_ptr<Lua::State> mState;
   std::unique_ptr<Lua::LuaLibGroup> mLibs;
   std::unique_ptr<LuaComponentRegistry> mComponents;
@@ -31,6 +31,7 @@
 namespace Syx {
   namespace Interface {
     extern ::DebugDrawer* gDrawer;
+    extern IWorkerPool* gWorkerPool;
   }
 }
 
@@ -41,7 +42,8 @@ const std::string PhysicsSystem::DEFAULT_MATERIAL_NAME = "DefaultPhysicsMaterial
 
 
 PhysicsSystem::PhysicsSystem(const SystemArgs& args)
-  : System(args) {
+  : System(args)
+  , mTransformBatchPool(std::make_unique<TransformBatchPool>()) {
   assert(!Syx::testIslandAll() && "Physics tests failed");
 }
 
@@ -51,6 +53,7 @@ PhysicsSystem::~PhysicsSystem() {
 void PhysicsSystem::init() {
   mTimescale = 0;
   Syx::Interface::gDrawer = &mArgs.mSystems->getSystem<GraphicsSystem>()->getDebugDrawer();
+  Syx::Interface::gWorkerPool = mArgs.mPool;
   mSystem = std::make_unique<Syx::PhysicsSystem>();
 
   AssetRepo* assets = mArgs.mSystems->getSystem<AssetRepo>();
@@ -73,7 +76,6 @@ void PhysicsSystem::init() {
 
   mDefaultSpace = mSystem->addSpace();
 
-  mTransformUpdates = std::make_unique<EventBuffer>();
   mEventHandler = std::make_unique<EventHandler>();
 
   SYSTEM_EVENT_HANDLER(TransformEvent, _transformEvent);
@@ -86,15 +88,16 @@ void PhysicsSystem::init() {
 }
 
 void PhysicsSystem::queueTasks(float dt, IWorkerPool& pool, std::shared_ptr<Task> frameTask) {
-  auto game = std::make_shared<FunctionTask>([this]() {
-    mEventHandler->handleEvents(*mEventBuffer);
+  TaskPool& tasks = pool.getTaskPool();
+  auto game = tasks.create<FunctionTask>([this]() {
+    mEventHandler->handleEvents(*mEventIndex);
   });
 
-  auto update = std::make_shared<FunctionTask>([this, dt]() {
+  auto update = tasks.create<FunctionTask>([this, dt]() {
     mSystem->update(dt*mTimescale);
   });
 
-  auto events = std::make_shared<FunctionTask>([this]() {
+  auto events = tasks.create<FunctionTask>([this]() {
     _processSyxEvents();
   });
 
@@ -106,32 +109,35 @@ void PhysicsSystem::queueTasks(float dt, IWorkerPool& pool, std::shared_ptr<Task
 }
 
 void PhysicsSystem::_processSyxEvents() {
-  mTransformUpdates->clear();
   const Syx::EventListener<Syx::UpdateEvent>* updates = mSystem->getUpdateEvents(mDefaultSpace);
-  if(updates) {
-    for(const Syx::UpdateEvent& e : updates->mEvents) {
-      auto it = mFromSyx.find(e.mHandle);
-      if(it != mFromSyx.end()) {
-        const SyxData& data = mToSyx[it->second];
-        _updateObject(it->second, data, e);
-      }
-      else
-        printf("Failed to map physics object %u\n", e.mHandle);
-    }
-  }
-  else
+  if(!updates) {
     printf("Failed to get physics update events\n");
+    return;
+  }
 
-  {
-    MessageQueue m = mArgs.mMessages->getMessageQueue();
-    mTransformUpdates->appendTo(m);
+  //All updates go out as one event so receivers can apply them in a single pass instead of dispatching per object
+  std::shared_ptr<TransformBatch> batch = mTransformBatchPool->create();
+  for(const Syx::UpdateEvent& e : updates->mEvents) {
+    auto fromSyx = mFromSyx.find(e.mHandle);
+    if(fromSyx == mFromSyx.end()) {
+      printf("Failed to map physics object %u\n", e.mHandle);
+      continue;
+    }
+    auto toSyx = mToSyx.find(fromSyx->second);
+    if(toSyx == mToSyx.end())
+      continue;
+
+    toSyx->second.mSyxToModel.push(*batch, fromSyx->second, e.mPos, e.mRot);
   }
-  mTransformUpdates->clear();
-}
 
-void PhysicsSystem::_updateObject(Handle obj, const SyxData& data, const Syx::UpdateEvent& e) {
-  Syx::Mat4 newTransform = Syx::Mat4::transform(data.mSyxToModel.getScale().reciprocal(), e.mRot, e.mPos) * data.mSyxToModel;
-  mTransformUpdates->push(TransformEvent(obj, newTransform, typeId<PhysicsSystem>()));
+  if(batch->empty())
+    return;
+
+  //Usually the same objects move frame to frame, in which case receivers can keep what they looked up for the last batch
+  const bool sameLayout = mLastTransformBatch && mLastTransformBatch->mHandles == batch->mHandles;
+  batch->mLayout = sameLayout ? mLastTransformBatch->mLayout : TransformBatch::newLayoutId();
+  mLastTransformBatch = batch;
+  mArgs.mMessages->getMessageQueue().get().push(TransformBatchEvent(std::move(batch), typeId<PhysicsSystem>()));
 }
 
 void PhysicsSystem::_setComponentPropsEvent(const SetComponentPropsEvent& e) {
@@ -163,7 +169,7 @@ void PhysicsSystem::_setComponentPropsEvent(const SetComponentPropsEvent& e) {
           }
           break;
         }
-        case Util::constHash("physToModel"): syxData.mSyxToModel = data.mPhysToModel; break;
+        case Util::constHash("physToModel"): syxData.mSyxToModel = SyxToModel(data.mPhysToModel); break;
         default: assert(false && "Unhandled property setter"); break;
       }
     });
@@ -211,7 +217,7 @@ void PhysicsSystem::_updateFromData(Handle obj, const PhysicsData& data) {
   SyxData& syxData = _getSyxData(obj, data.mHasRigidbody, data.mHasCollider);
   Syx::Handle h = syxData.mHandle;
 
-  syxData.mSyxToModel = data.mPhysToModel;
+  syxData.mSyxToModel = SyxToModel(data.mPhysToModel);
 
   mSystem->setVelocity(mDefaultSpace, h, data.mLinVel);
   mSystem->setAngularVelocity(mDefaultSpace, h, data.mAngVel);
@@ -233,7 +239,7 @@ void PhysicsSystem::_updateTransform(Handle handle, const Syx::Mat4& mat) {
     Syx::Vec3 pos, scale;
     Syx::Mat3 rot;
     //Move the transform into syx space then decompose it
-    (mat * it->second.mSyxToModel.affineInverse()).decompose(scale, rot, pos);
+    (mat * it->second.mSyxToModel.mTransform.affineInverse()).decompose(scale, rot, pos);
     Syx::Handle h = it->second.mHandle;
     mSystem->setPosition(mDefaultSpace, h, pos);
     mSystem->setRotation(mDefaultSpace, h, rot.toQuat());
@@ -1,5 +1,6 @@
 #pragma once
 #include "System.h"
+#include "event/TransformEvent.h"
 
 namespace Syx {
   class PhysicsSystem;
@@ -10,8 +11,6 @@ namespace Syx {
 
 class ClearSpaceEvent;
 class Model;
-class EventBuffer;
-class TransformEvent;
 class PhysicsCompUpdateEvent;
 class SetComponentPropEvent;
 class SetComponentPropsEvent;
@@ -46,11 +45,10 @@ private:
   struct SyxData {
     Syx::Handle mHandle;
     //Transform from syx to model space
-    Syx::Mat4 mSyxToModel;
+    SyxToModel mSyxToModel;
   };
 
   void _processSyxEvents();
-  void _updateObject(Handle obj, const SyxData& data, const Syx::UpdateEvent& e);
   void _compUpdateEvent(const PhysicsCompUpdateEvent& e);
   void _transformEvent(const TransformEvent& e);
   void _updateTransform(Handle handle, const Syx::Mat4& mat);
@@ -65,10 +63,13 @@ private:
   void _updateFromData(Handle obj, const PhysicsData& data);
 
   std::unique_ptr<Syx::PhysicsSystem> mSystem;
-  std::unique_ptr<EventBuffer> mTransformUpdates;
 
   std::unordered_map<Handle, SyxData> mToSyx;
   std::unordered_map<Syx::Handle, Handle> mFromSyx;
+  //Batches are recycled once receivers are done with them so their arrays aren't allocated every frame
+  std::unique_ptr<TransformBatchPool> mTransformBatchPool;
+  //Last batch sent, to tell if the next one has the same layout
+  std::shared_ptr<const TransformBatch> mLastTransformBatch;
   Syx::Handle mDefaultSpace;
   float mTimescale;
 };
\ No newline at end of file
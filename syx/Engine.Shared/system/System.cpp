@@ -20,14 +20,15 @@ private:
 };
 
 System::System(const SystemArgs& args)
-  : mArgs(args) {
+  : mArgs(args)
+  , mEventIndex(nullptr) {
 }
 
 System::~System() {
 }
 
-void System::setEventBuffer(const EventBuffer* buffer) {
-  mEventBuffer = buffer;
+void System::setEventIndex(const EventIndex* index) {
+  mEventIndex = index;
 }
 
 SystemProvider& System::getSystemProvider() const {
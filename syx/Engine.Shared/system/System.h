@@ -6,6 +6,7 @@ class Task;
 class Event;
 class EventBuffer;
 class EventHandler;
+class EventIndex;
 class SystemProvider;
 class AppPlatform;
 class MessageQueueProvider;
@@ -13,8 +14,8 @@ class GameObjectHandleProvider;
 class ProjectLocator;
 
 //TODO: Update all uses to use template
-#define SYSTEM_EVENT_HANDLER(eventType, handler) mEventHandler->registerEventHandler(Event::typeId<eventType>(), [this](const Event& e) {\
-    handler(static_cast<const eventType&>(e));\
+#define SYSTEM_EVENT_HANDLER(eventType, handler) mEventHandler->registerEventHandler<eventType>([this](const eventType& e) {\
+    handler(e);\
   });
 
 struct SystemArgs {
@@ -39,8 +40,8 @@ public:
   virtual void update(float, IWorkerPool&, std::shared_ptr<Task>) {}
   virtual void uninit() {}
 
-  //Each frame this is updated to point at the message queue for that frame.
-  void setEventBuffer(const EventBuffer* buffer);
+  //Each frame this is updated to point at the index of the message queue for that frame.
+  void setEventIndex(const EventIndex* index);
 
   SystemProvider& getSystemProvider() const;
   MessageQueueProvider& getMessageQueueProvider() const;
@@ -54,7 +55,7 @@ protected:
   }
 
   SystemArgs mArgs;
-  const EventBuffer* mEventBuffer;
+  const EventIndex* mEventIndex;
   std::unique_ptr<EventHandler> mEventHandler;
 };
 
@@ -2,7 +2,7 @@
 #include "threading/FunctionTask.h"
 
 FunctionTask::FunctionTask(std::function<void(void)> func)
-  : mFunc(func) {
+  : mFunc(std::move(func)) {
 }
 
 void FunctionTask::_run() {
@@ -1,4 +1,6 @@
 #pragma once
+#include "threading/TaskPool.h"
+
 class Task;
 class TaskGroup;
 
@@ -7,9 +9,22 @@ public:
   // Frienship as the task calls taskReady for dependencies upon completion
   friend class Task;
 
+  virtual ~IWorkerPool() = default;
+
   virtual void queueTask(std::shared_ptr<Task> task) = 0;
+  //Run a ready task on the calling thread if there is one, returning true if one was run
+  //Lets a thread waiting on tasks help finish them instead of blocking, see TaskGroup::wait
+  virtual bool tryRunTask() = 0;
+
+  //Use for tasks that are made often, like every frame, to avoid allocating them
+  TaskPool& getTaskPool() {
+    return mTaskPool;
+  }
 
 protected:
   //Task will call this when it has no dependencies left to prevent it from starting
   virtual void taskReady(std::shared_ptr<Task> task) = 0;
+
+private:
+  TaskPool mTaskPool;
 };
\ No newline at end of file
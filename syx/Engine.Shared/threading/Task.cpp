@@ -5,7 +5,8 @@
 Task::Task()
   : mPool(nullptr)
   , mState(TaskState::Waiting)
-  , mDependencies(0) {
+  , mDependencies(0)
+  , mDependentCount(0) {
 }
 
 Task::~Task() {
@@ -15,11 +16,12 @@ void Task::run() {
   _run();
   mState = TaskState::Done;
 
-  assert(mPool);
   //RW lock would be good here, as it's only needed to protect against adding dependents while completing
   mDependentsMutex.lock();
+  assert(mPool);
   //Now that this task is complete, remove it as a dependency for all tasks waiting on it
-  for(Task* dep : mDependents) {
+  for(size_t i = 0; i < mDependentCount; ++i) {
+    Task* dep = i < mDependents.size() ? mDependents[i] : mMoreDependents[i - mDependents.size()];
     //If this was the last dependency on the task, it can run now
     if(dep->mDependencies.fetch_sub(1) == 1) {
       mPool->taskReady(dep->shared_from_this());
@@ -31,6 +33,11 @@ void Task::run() {
 }
 
 void Task::setWorkerPool(IWorkerPool& pool) {
+  //Queuing the task and its last dependency finishing can both get here at once, so only the first sets the pool and self reference.
+  //The other waits on the lock until that's done, so the task can't be run and drop mSelf before it's set
+  std::lock_guard<std::mutex> lock(mDependentsMutex);
+  if(mPool)
+    return;
   mPool = &pool;
   if(mState != TaskState::Done) {
     //Tasks manage their own lifetime while waiting in the pool, and drop this reference on completion
@@ -45,7 +52,11 @@ void Task::addDependent(std::shared_ptr<Task> dependent) {
 
   //RW lock would be great here as this is only needed if the task finishes while a dependency is added
   mDependentsMutex.lock();
-  mDependents.push_back(dependent.get());
+  if(mDependentCount < mDependents.size())
+    mDependents[mDependentCount] = dependent.get();
+  else
+    mMoreDependents.push_back(dependent.get());
+  ++mDependentCount;
   mDependentsMutex.unlock();
 
   if(mState != TaskState::Done)
@@ -66,10 +77,10 @@ bool Task::hasDependencies() {
   return mDependencies != 0;
 }
 
-void Task::setQueued() {
+bool Task::setQueued() {
   //Won't do anything if already queued
   TaskState expected = TaskState::Waiting;
-  mState.compare_exchange_strong(expected, TaskState::Queued);
+  return mState.compare_exchange_strong(expected, TaskState::Queued);
 }
 
 bool Task::hasBeenQueued() {
@@ -25,7 +25,8 @@ public:
   //Compose dependencies like a.then(b).then(c)
   std::shared_ptr<Task> then(std::shared_ptr<Task> next);
   bool hasDependencies();
-  void setQueued();
+  //Returns true if this call is what changed it to queued, so only one caller queues it when several race
+  bool setQueued();
   bool hasBeenQueued();
 
 protected:
@@ -34,8 +35,11 @@ protected:
   //Number of uncompleted tasks this still depends on
   std::atomic_int mDependencies;
   std::atomic<TaskState> mState;
-  //All tasks that depend on this
-  std::vector<Task*> mDependents;
+  //All tasks that depend on this. Most tasks have one or two so those are stored inline to avoid allocating, with the rest in mMoreDependents
+  std::array<Task*, 2> mDependents;
+  size_t mDependentCount;
+  std::vector<Task*> mMoreDependents;
+  //Guards the dependents and mPool against the task completing
   std::mutex mDependentsMutex;
   //Objects keep themselves alive while waiting to be executed with this reference
   //It is reasonable for the user to be holding a weak ptr to this task to be adding dependencies while it's in the pool
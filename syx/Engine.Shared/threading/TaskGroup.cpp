@@ -0,0 +1,24 @@
+#include "Precompile.h"
+#include "threading/TaskGroup.h"
+
+TaskGroup::TaskGroup(IWorkerPool& pool)
+  : mPool(pool)
+  , mPending(0) {
+}
+
+TaskGroup::~TaskGroup() {
+  wait();
+}
+
+void TaskGroup::wait() {
+  //Acquire pairs with the release when each task finishes so everything the tasks wrote is visible after waiting
+  while(mPending.load(std::memory_order_acquire)) {
+    //Nothing ready to help with means the remaining work is running elsewhere
+    if(!mPool.tryRunTask())
+      std::this_thread::yield();
+  }
+}
+
+IWorkerPool& TaskGroup::getPool() {
+  return mPool;
+}
@@ -0,0 +1,85 @@
+#pragma once
+#include "threading/IWorkerPool.h"
+#include "threading/Task.h"
+
+//Fork/join on top of the pool: run queues work and wait returns once all of it is done, including work run from other work in the group.
+//Waiting runs tasks from the pool on the calling thread instead of blocking, so it's fine to wait on a group from inside a task.
+//Tasks come from the pool's TaskPool, so running small work in a group doesn't allocate once the pool has warmed up
+class TaskGroup {
+public:
+  TaskGroup(IWorkerPool& pool);
+  TaskGroup(const TaskGroup&) = delete;
+  TaskGroup& operator=(const TaskGroup&) = delete;
+  //Waits, since the group's tasks refer to it
+  ~TaskGroup();
+
+  template<typename Func>
+  void run(Func&& func) {
+    mPending.fetch_add(1, std::memory_order_relaxed);
+    mPool.queueTask(mPool.getTaskPool().create<GroupTask<std::decay_t<Func>>>(*this, std::forward<Func>(func)));
+  }
+
+  void wait();
+
+  IWorkerPool& getPool();
+
+private:
+  //Like a FunctionTask but stores the function directly so it never allocates regardless of capture size
+  template<typename Func>
+  class GroupTask : public Task {
+  public:
+    GroupTask(TaskGroup& group, Func func)
+      : mGroup(group)
+      , mFunc(std::move(func)) {
+    }
+
+  protected:
+    void _run() override {
+      mFunc();
+      //Last use of the group, after this it may be destroyed by a wait returning
+      mGroup.mPending.fetch_sub(1, std::memory_order_release);
+    }
+
+  private:
+    TaskGroup& mGroup;
+    Func mFunc;
+  };
+
+  IWorkerPool& mPool;
+  //Work that has been run but not finished
+  std::atomic<size_t> mPending;
+};
+
+namespace Detail {
+  template<typename Func>
+  void parallelForRange(TaskGroup& group, size_t begin, size_t end, size_t grain, const Func& func) {
+    //Split off the top half for someone else until what's left is small enough, so the largest pieces are the oldest and get stolen first
+    while(end - begin > grain) {
+      const size_t mid = begin + (end - begin)/2;
+      group.run([&group, mid, end, grain, &func] {
+        parallelForRange(group, mid, end, grain, func);
+      });
+      end = mid;
+    }
+    for(size_t i = begin; i < end; ++i)
+      func(i);
+  }
+}
+
+//Call func(i) for every i in [begin, end) using the pool and the calling thread, returning once all calls are done
+//Ranges of grain or fewer indices run on a single thread, so raise it when each call is too cheap to be worth a task
+template<typename Func>
+void parallelFor(IWorkerPool& pool, size_t begin, size_t end, size_t grain, const Func& func) {
+  grain = std::max(grain, size_t(1));
+  if(end <= begin)
+    return;
+  if(end - begin <= grain) {
+    for(size_t i = begin; i < end; ++i)
+      func(i);
+    return;
+  }
+
+  TaskGroup group(pool);
+  Detail::parallelForRange(group, begin, end, grain, func);
+  group.wait();
+}
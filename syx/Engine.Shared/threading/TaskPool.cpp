@@ -0,0 +1,46 @@
+#include "Precompile.h"
+#include "threading/TaskPool.h"
+
+TaskPool::TaskPool()
+  : mStorage(std::make_shared<Storage>()) {
+}
+
+TaskPool::Storage::~Storage() {
+  //Only free blocks are left since every allocated block keeps this alive
+  for(FreeList& list : mFreeLists) {
+    while(FreeList::Block* block = list.mHead) {
+      list.mHead = block->mNext;
+      ::operator delete(block);
+    }
+  }
+}
+
+void* TaskPool::Storage::allocate(size_t bytes) {
+  const size_t sizeClass = (bytes + BLOCK_GRANULARITY - 1)/BLOCK_GRANULARITY - 1;
+  if(sizeClass >= SIZE_CLASSES)
+    return ::operator new(bytes);
+
+  FreeList& list = mFreeLists[sizeClass];
+  list.mLock.lock();
+  FreeList::Block* result = list.mHead;
+  if(result)
+    list.mHead = result->mNext;
+  list.mLock.unlock();
+  //Allocate the whole block so it can be reused for anything else in this size class
+  return result ? result : ::operator new((sizeClass + 1)*BLOCK_GRANULARITY);
+}
+
+void TaskPool::Storage::deallocate(void* p, size_t bytes) {
+  const size_t sizeClass = (bytes + BLOCK_GRANULARITY - 1)/BLOCK_GRANULARITY - 1;
+  if(sizeClass >= SIZE_CLASSES) {
+    ::operator delete(p);
+    return;
+  }
+
+  FreeList& list = mFreeLists[sizeClass];
+  FreeList::Block* block = static_cast<FreeList::Block*>(p);
+  list.mLock.lock();
+  block->mNext = list.mHead;
+  list.mHead = block;
+  list.mLock.unlock();
+}
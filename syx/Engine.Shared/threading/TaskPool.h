@@ -0,0 +1,80 @@
+#pragma once
+#include "threading/SpinLock.h"
+
+//Creates tasks whose memory, shared_ptr control block included, goes back to the pool instead of the heap when the last reference is dropped.
+//Once the same tasks have been made for a few frames, making them again no longer hits the allocator. References can be dropped on any thread,
+//and each task holds on to the pool's storage, so tasks are free to outlive the pool that made them
+class TaskPool {
+public:
+  TaskPool();
+
+  template<typename T, typename... Args>
+  std::shared_ptr<T> create(Args&&... args) {
+    return std::allocate_shared<T>(Allocator<T>(mStorage), std::forward<Args>(args)...);
+  }
+
+private:
+  //Free blocks of one size, linked through the blocks themselves
+  struct FreeList {
+    struct Block {
+      Block* mNext;
+    };
+
+    SpinLock mLock;
+    Block* mHead = nullptr;
+  };
+
+  struct Storage {
+    //Blocks are rounded up to a multiple of this and anything above the largest goes straight to the heap
+    static const size_t BLOCK_GRANULARITY = 64;
+    static const size_t SIZE_CLASSES = 8;
+
+    ~Storage();
+
+    void* allocate(size_t bytes);
+    void deallocate(void* p, size_t bytes);
+
+    std::array<FreeList, SIZE_CLASSES> mFreeLists;
+  };
+
+  template<typename T>
+  class Allocator {
+  public:
+    template<typename U>
+    friend class Allocator;
+
+    typedef T value_type;
+
+    Allocator(std::shared_ptr<Storage> storage)
+      : mStorage(std::move(storage)) {
+    }
+
+    template<typename U>
+    Allocator(const Allocator<U>& other)
+      : mStorage(other.mStorage) {
+    }
+
+    T* allocate(size_t n) {
+      return static_cast<T*>(mStorage->allocate(sizeof(T)*n));
+    }
+
+    void deallocate(T* p, size_t n) {
+      mStorage->deallocate(p, sizeof(T)*n);
+    }
+
+    template<typename U>
+    bool operator==(const Allocator<U>& rhs) const {
+      return mStorage == rhs.mStorage;
+    }
+
+    template<typename U>
+    bool operator!=(const Allocator<U>& rhs) const {
+      return mStorage != rhs.mStorage;
+    }
+
+  private:
+    std::shared_ptr<Storage> mStorage;
+  };
+
+  std::shared_ptr<Storage> mStorage;
+};
@@ -0,0 +1,117 @@
+#pragma once
+
+//Lock free deque where only the owning thread can push and pop from the bottom, while any thread can steal from the top.
+//Owner works LIFO for cache locality while thieves take the oldest work, which tends to be the largest.
+//Based on Chase-Lev with the memory orders from "Correct and Efficient Work-Stealing for Weak Memory Models" (Le et al. 2013)
+//T must be trivially copyable as items are read and written atomically
+template<typename T>
+class WorkStealingDeque {
+public:
+  WorkStealingDeque(size_t capacity = 256)
+    : mTop(0)
+    , mBottom(0) {
+    mBuffers.push_back(std::make_unique<Buffer>(_roundUpToPowerOfTwo(capacity)));
+    mBuffer.store(mBuffers.back().get(), std::memory_order_relaxed);
+  }
+
+  WorkStealingDeque(const WorkStealingDeque&) = delete;
+  WorkStealingDeque& operator=(const WorkStealingDeque&) = delete;
+
+  //Owner only
+  void push(T item) {
+    const int64_t bottom = mBottom.load(std::memory_order_relaxed);
+    const int64_t top = mTop.load(std::memory_order_acquire);
+    Buffer* buffer = mBuffer.load(std::memory_order_relaxed);
+    if(bottom - top > static_cast<int64_t>(buffer->mMask))
+      buffer = _grow(buffer, top, bottom);
+    buffer->put(bottom, item);
+    //Release so thieves that see the new bottom also see the item
+    mBottom.store(bottom + 1, std::memory_order_release);
+  }
+
+  //Owner only, takes the most recently pushed item
+  bool pop(T& result) {
+    const int64_t bottom = mBottom.load(std::memory_order_relaxed) - 1;
+    Buffer* buffer = mBuffer.load(std::memory_order_relaxed);
+    mBottom.store(bottom, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    int64_t top = mTop.load(std::memory_order_relaxed);
+
+    if(top > bottom) {
+      //Was already empty
+      mBottom.store(bottom + 1, std::memory_order_relaxed);
+      return false;
+    }
+
+    result = buffer->get(bottom);
+    bool success = true;
+    //Last item, race thieves for it
+    if(top == bottom) {
+      success = mTop.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+      mBottom.store(bottom + 1, std::memory_order_relaxed);
+    }
+    return success;
+  }
+
+  //Any thread, takes the oldest item. Can fail spuriously if another thread took the same item first
+  bool steal(T& result) {
+    int64_t top = mTop.load(std::memory_order_acquire);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    const int64_t bottom = mBottom.load(std::memory_order_acquire);
+    if(top >= bottom)
+      return false;
+
+    Buffer* buffer = mBuffer.load(std::memory_order_acquire);
+    T item = buffer->get(top);
+    if(!mTop.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+      return false;
+    result = item;
+    return true;
+  }
+
+  //Only a hint when called from other threads, as items could be pushed or taken right after
+  bool empty() const {
+    return mBottom.load(std::memory_order_seq_cst) <= mTop.load(std::memory_order_seq_cst);
+  }
+
+private:
+  struct Buffer {
+    Buffer(size_t capacity)
+      : mMask(capacity - 1)
+      , mItems(std::make_unique<std::atomic<T>[]>(capacity)) {
+    }
+
+    T get(int64_t index) const {
+      return mItems[static_cast<size_t>(index) & mMask].load(std::memory_order_relaxed);
+    }
+
+    void put(int64_t index, T item) {
+      mItems[static_cast<size_t>(index) & mMask].store(item, std::memory_order_relaxed);
+    }
+
+    size_t mMask;
+    std::unique_ptr<std::atomic<T>[]> mItems;
+  };
+
+  static size_t _roundUpToPowerOfTwo(size_t value) {
+    size_t result = 1;
+    while(result < value)
+      result <<= 1;
+    return result;
+  }
+
+  Buffer* _grow(Buffer* old, int64_t top, int64_t bottom) {
+    mBuffers.push_back(std::make_unique<Buffer>((old->mMask + 1)*2));
+    Buffer* result = mBuffers.back().get();
+    for(int64_t i = top; i < bottom; ++i)
+      result->put(i, old->get(i));
+    mBuffer.store(result, std::memory_order_release);
+    return result;
+  }
+
+  std::atomic<int64_t> mTop;
+  std::atomic<int64_t> mBottom;
+  std::atomic<Buffer*> mBuffer;
+  //Thieves may still be reading from old buffers after growing, so they're kept until the deque is destroyed. Owner only
+  std::vector<std::unique_ptr<Buffer>> mBuffers;
+};
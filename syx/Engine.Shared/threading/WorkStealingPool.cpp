@@ -0,0 +1,181 @@
+#include "Precompile.h"
+#include "threading/WorkStealingPool.h"
+#include "threading/Task.h"
+
+namespace {
+  //Attempts to find work before going to sleep, as sleeping and waking cost far more than a few failed steals
+  const size_t sSpinCount = 64;
+}
+
+thread_local WorkStealingPool::Worker* WorkStealingPool::sCurrentWorker = nullptr;
+
+size_t WorkStealingPool::getDefaultWorkerCount() {
+  //Can be zero if it isn't known
+  return std::max(size_t(1), static_cast<size_t>(std::thread::hardware_concurrency()));
+}
+
+WorkStealingPool::WorkStealingPool(size_t workerCount)
+  : mInjectedCount(0)
+  , mSleeping(0)
+  , mTerminate(false) {
+  //All workers must exist before any start, since they look at each other to steal
+  mWorkers.reserve(workerCount);
+  for(size_t i = 0; i < workerCount; ++i) {
+    mWorkers.push_back(std::make_unique<Worker>());
+    mWorkers.back()->mPool = this;
+    //Any nonzero seed works, this just keeps workers from all picking the same victims
+    mWorkers.back()->mRandom = static_cast<uint32_t>(i*2654435761u + 1);
+  }
+  for(std::unique_ptr<Worker>& worker : mWorkers)
+    worker->mThread = std::thread(&WorkStealingPool::_workerLoop, this, std::ref(*worker));
+}
+
+WorkStealingPool::~WorkStealingPool() {
+  mTerminate = true;
+
+  //Need to have mutex when notifying so a worker doesn't go to sleep right after notification
+  mSleepMutex.lock();
+  mSleepCV.notify_all();
+  mSleepMutex.unlock();
+
+  for(std::unique_ptr<Worker>& worker : mWorkers)
+    worker->mThread.join();
+}
+
+size_t WorkStealingPool::getWorkerCount() const {
+  return mWorkers.size();
+}
+
+void WorkStealingPool::queueTask(std::shared_ptr<Task> task) {
+  task->setWorkerPool(*this);
+  if(!task->hasDependencies())
+    _taskReady(std::move(task));
+}
+
+bool WorkStealingPool::tryRunTask() {
+  Task* task = nullptr;
+  if(Worker* worker = _getCurrentWorker())
+    task = _findTask(*worker);
+  else if(!(task = _popInjected()))
+    task = _stealAny();
+
+  if(task)
+    task->run();
+  return task != nullptr;
+}
+
+void WorkStealingPool::taskReady(std::shared_ptr<Task> task) {
+  _taskReady(std::move(task));
+}
+
+void WorkStealingPool::_taskReady(std::shared_ptr<Task> task) {
+  //Tasks can be queued on queueTask or when its dependencies are done, possibly at the same time, so only the first one adds it
+  if(!task->setQueued())
+    return;
+  //Dependent task could have finished between adding dependency and queuing, in which case set the pool now
+  task->setWorkerPool(*this);
+
+  if(Worker* worker = _getCurrentWorker())
+    worker->mTasks.push(task.get());
+  else {
+    std::lock_guard<std::mutex> lock(mInjectedMutex);
+    mInjected.push_back(task.get());
+    mInjectedCount.fetch_add(1);
+  }
+  _wakeWorker();
+}
+
+void WorkStealingPool::_wakeWorker() {
+  //Pairs with the increment of mSleeping before a worker's last check for work, so either it sees this task or this sees it sleeping
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  if(mSleeping.load()) {
+    std::lock_guard<std::mutex> lock(mSleepMutex);
+    mSleepCV.notify_one();
+  }
+}
+
+void WorkStealingPool::_workerLoop(Worker& worker) {
+  sCurrentWorker = &worker;
+  while(!mTerminate) {
+    Task* task = _findTask(worker);
+    for(size_t i = 0; !task && i < sSpinCount && !mTerminate; ++i) {
+      std::this_thread::yield();
+      task = _findTask(worker);
+    }
+
+    if(task) {
+      task->run();
+      continue;
+    }
+
+    std::unique_lock<std::mutex> lock(mSleepMutex);
+    mSleeping.fetch_add(1);
+    //Work queued between the last search and now wouldn't have woken anyone, so look once more before sleeping
+    if(!_hasWork() && !mTerminate)
+      mSleepCV.wait(lock);
+    mSleeping.fetch_sub(1);
+  }
+  sCurrentWorker = nullptr;
+}
+
+Task* WorkStealingPool::_findTask(Worker& worker) {
+  Task* result = nullptr;
+  if(worker.mTasks.pop(result))
+    return result;
+  result = _popInjected();
+  return result ? result : _steal(worker);
+}
+
+Task* WorkStealingPool::_steal(Worker& worker) {
+  const size_t count = mWorkers.size();
+  if(count < 2)
+    return nullptr;
+
+  //Start at a random victim so thieves spread out instead of all hitting the same one
+  worker.mRandom ^= worker.mRandom << 13;
+  worker.mRandom ^= worker.mRandom >> 17;
+  worker.mRandom ^= worker.mRandom << 5;
+  const size_t start = worker.mRandom % count;
+  Task* result = nullptr;
+  for(size_t i = 0; i < count; ++i) {
+    Worker& victim = *mWorkers[(start + i) % count];
+    if(&victim != &worker && victim.mTasks.steal(result))
+      return result;
+  }
+  return nullptr;
+}
+
+Task* WorkStealingPool::_stealAny() {
+  Task* result = nullptr;
+  for(std::unique_ptr<Worker>& victim : mWorkers)
+    if(victim->mTasks.steal(result))
+      return result;
+  return nullptr;
+}
+
+Task* WorkStealingPool::_popInjected() {
+  if(!mInjectedCount.load())
+    return nullptr;
+
+  std::lock_guard<std::mutex> lock(mInjectedMutex);
+  if(mInjected.empty())
+    return nullptr;
+  //Oldest first, same as stealing
+  Task* result = mInjected.front();
+  mInjected.pop_front();
+  mInjectedCount.fetch_sub(1);
+  return result;
+}
+
+bool WorkStealingPool::_hasWork() const {
+  if(mInjectedCount.load())
+    return true;
+  for(const std::unique_ptr<Worker>& worker : mWorkers)
+    if(!worker->mTasks.empty())
+      return true;
+  return false;
+}
+
+WorkStealingPool::Worker* WorkStealingPool::_getCurrentWorker() {
+  return sCurrentWorker && sCurrentWorker->mPool == this ? sCurrentWorker : nullptr;
+}
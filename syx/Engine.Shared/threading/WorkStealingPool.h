@@ -0,0 +1,64 @@
+#pragma once
+#include "threading/IWorkerPool.h"
+#include "threading/WorkStealingDeque.h"
+
+class Task;
+
+//Pool where each worker has its own deque of ready tasks. Tasks made ready on a worker, like dependents of the task it just finished,
+//go on that worker's deque and are taken newest first. Workers that run out steal the oldest tasks from others, then spin a bit before sleeping.
+//Tasks queued from threads outside the pool go in a shared queue that workers check when their own deque is empty
+class WorkStealingPool : public IWorkerPool {
+public:
+  //Number of workers used when none is specified
+  static size_t getDefaultWorkerCount();
+
+  WorkStealingPool(size_t workerCount = getDefaultWorkerCount());
+  ~WorkStealingPool();
+
+  void queueTask(std::shared_ptr<Task> task) override;
+  bool tryRunTask() override;
+
+  size_t getWorkerCount() const;
+
+protected:
+  void taskReady(std::shared_ptr<Task> task) override;
+
+private:
+  struct Worker {
+    WorkStealingPool* mPool;
+    //Tasks keep themselves alive while queued, so raw pointers are safe
+    WorkStealingDeque<Task*> mTasks;
+    std::thread mThread;
+    //State for picking victims to steal from
+    uint32_t mRandom;
+  };
+
+  void _taskReady(std::shared_ptr<Task> task);
+  void _workerLoop(Worker& worker);
+  Task* _findTask(Worker& worker);
+  Task* _steal(Worker& worker);
+  //Steal for threads that aren't workers, which don't have their own victim state
+  Task* _stealAny();
+  Task* _popInjected();
+  //True if there might be work anywhere, used to avoid sleeping through work queued while going to sleep
+  bool _hasWork() const;
+  void _wakeWorker();
+  //Worker belonging to this pool running on the calling thread, if any
+  Worker* _getCurrentWorker();
+
+  static thread_local Worker* sCurrentWorker;
+
+  std::vector<std::unique_ptr<Worker>> mWorkers;
+
+  //Tasks queued from outside the pool
+  std::deque<Task*> mInjected;
+  std::mutex mInjectedMutex;
+  //Size of mInjected, so workers can check it without the lock
+  std::atomic<size_t> mInjectedCount;
+
+  std::mutex mSleepMutex;
+  std::condition_variable mSleepCV;
+  //Workers that are asleep or about to be. Checked after queueing so work isn't left with everyone sleeping
+  std::atomic<size_t> mSleeping;
+  std::atomic_bool mTerminate;
+};
@@ -38,6 +38,16 @@ void WorkerPool::queueTask(std::shared_ptr<Task> task) {
   mTaskMutex.unlock();
 }
 
+bool WorkerPool::tryRunTask() {
+  mTaskMutex.lock();
+  std::shared_ptr<Task> task = _getTask();
+  mTaskMutex.unlock();
+
+  if(task)
+    task->run();
+  return task != nullptr;
+}
+
 void WorkerPool::taskReady(std::shared_ptr<Task> task) {
   mTaskMutex.lock();
   _taskReady(task);
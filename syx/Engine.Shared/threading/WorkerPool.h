@@ -8,6 +8,7 @@ public:
   ~WorkerPool();
 
   void queueTask(std::shared_ptr<Task> task) override;
+  bool tryRunTask() override;
 
 protected:
   void taskReady(std::shared_ptr<Task> task) override;
@@ -0,0 +1,280 @@
+#include "Precompile.h"
+#include "BenchInterface.h"
+#include "BenchMemory.h"
+#include "BenchScenes.h"
+
+#include "SyxPhysicsSystem.h"
+
+//Headless benchmark that steps the standard scenes through Syx::PhysicsSystem and reports timings.
+//Windows only, built through bench.vcxproj. There is no Linux build: the syx library relies on MSVC extensions like
+//__declspec alignment and __forceinline, and the tree has no build files other than the Visual Studio projects
+namespace Bench {
+  namespace {
+    struct Options {
+      std::vector<std::string> mScenes;
+      size_t mSteps = 600;
+      size_t mWarmup = 0;
+      float mScale = 1.0f;
+      size_t mThreads = 1;
+      size_t mSubsteps = 1;
+      int mIterations = Syx::ConstraintSystem::sIterations;
+      int mSimdFlags = Syx::SyxOptions::SIMD::ContactBatches;
+      bool mJson = false;
+      //Chrome traces are written to this followed by the scene name if not empty
+      std::string mTracePrefix;
+      //Copied to the output to tell runs apart, like a commit or build name
+      std::string mLabel;
+    };
+
+    struct Stage {
+      std::string mPath;
+      double mTotalMs;
+      //Blocks merged into this stage over all steps, more than the step count for blocks that run per island or batch
+      size_t mCount;
+    };
+
+    struct SceneResult {
+      const Scene* mScene;
+      size_t mBodies;
+      double mSetupSeconds;
+      double mTotalSeconds;
+      //Sorted milliseconds per step
+      std::vector<double> mStepMs;
+      std::vector<Stage> mStages;
+      size_t mPeakHeapBytes;
+      size_t mEndHeapBytes;
+    };
+
+    typedef std::chrono::steady_clock Clock;
+
+    double secondsSince(Clock::time_point start) {
+      return std::chrono::duration<double>(Clock::now() - start).count();
+    }
+
+    void printUsage() {
+      std::printf("Usage: bench [options]\n"
+        "  --scene <name>      Run only this scene, can be repeated. Defaults to all\n"
+        "  --steps <n>         Measured steps per scene, default 600\n"
+        "  --warmup <n>        Unmeasured steps before measuring, default 0\n"
+        "  --scale <f>         Multiplier on scene body counts, default 1\n"
+        "  --threads <n>       Threads for parallel work including the main one, default 1\n"
+        "  --substeps <n>      Space updates per step, default 1\n"
+        "  --iterations <n>    Maximum solver iterations per substep, default 10\n"
+        "  --simd <flags>      SyxOptions::SIMD bitmask, default ContactBatches\n"
+        "  --json              Machine readable output\n"
+        "  --trace <prefix>    Write a Chrome trace of the last steps of each scene to <prefix><scene>.json\n"
+        "  --label <text>      Included in the output to identify the run\n"
+        "  --list              List scenes\n"
+        "Heap high water marks are per scene since the peak is reset before each one is built\n");
+    }
+
+    bool parseOptions(int argc, char** argv, Options& options) {
+      for(int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        const bool hasValue = i + 1 < argc;
+        if(arg == "--list") {
+          for(const Scene& scene : getScenes())
+            std::printf("%-16s %s\n", scene.mName, scene.mDescription);
+          std::exit(0);
+        }
+        else if(arg == "--json")
+          options.mJson = true;
+        else if(arg == "--scene" && hasValue) {
+          if(!findScene(argv[++i])) {
+            std::fprintf(stderr, "Unknown scene %s\n", argv[i]);
+            return false;
+          }
+          options.mScenes.push_back(argv[i]);
+        }
+        else if(arg == "--steps" && hasValue)
+          options.mSteps = std::strtoul(argv[++i], nullptr, 10);
+        else if(arg == "--warmup" && hasValue)
+          options.mWarmup = std::strtoul(argv[++i], nullptr, 10);
+        else if(arg == "--scale" && hasValue)
+          options.mScale = static_cast<float>(std::atof(argv[++i]));
+        else if(arg == "--threads" && hasValue)
+          options.mThreads = std::max(1ul, std::strtoul(argv[++i], nullptr, 10));
+        else if(arg == "--substeps" && hasValue)
+          options.mSubsteps = std::max(1ul, std::strtoul(argv[++i], nullptr, 10));
+        else if(arg == "--iterations" && hasValue)
+          options.mIterations = std::atoi(argv[++i]);
+        else if(arg == "--simd" && hasValue)
+          options.mSimdFlags = std::atoi(argv[++i]);
+        else if(arg == "--trace" && hasValue)
+          options.mTracePrefix = argv[++i];
+        else if(arg == "--label" && hasValue)
+          options.mLabel = argv[++i];
+        else {
+          printUsage();
+          return false;
+        }
+      }
+
+      if(options.mScenes.empty())
+        for(const Scene& scene : getScenes())
+          options.mScenes.push_back(scene.mName);
+      return options.mSteps > 0 && options.mScale > 0.0f;
+    }
+
+    //Adds this step's profile blocks to the totals, naming stages by their path from the root block
+    void addStages(const std::vector<Syx::ProfileResult>& history, std::vector<Stage>& stages, std::vector<std::string>& pathStack) {
+      for(const Syx::ProfileResult& block : history) {
+        pathStack.resize(block.mDepth);
+        std::string path = pathStack.empty() ? std::string() : pathStack.back() + "/";
+        path += block.mName;
+        pathStack.push_back(path);
+
+        auto found = std::find_if(stages.begin(), stages.end(), [&path](const Stage& stage) { return stage.mPath == path; });
+        if(found == stages.end()) {
+          //Blocks that first show up on a later step go after their parent's existing children so the output stays a tree
+          auto where = stages.begin();
+          if(block.mDepth) {
+            const std::string prefix = pathStack[block.mDepth - 1] + "/";
+            where = std::find_if(stages.begin(), stages.end(), [&prefix](const Stage& stage) { return stage.mPath + "/" == prefix; });
+            if(where != stages.end())
+              ++where;
+            while(where != stages.end() && where->mPath.compare(0, prefix.size(), prefix) == 0)
+              ++where;
+          }
+          else
+            where = stages.end();
+          found = stages.insert(where, { path, 0.0, 0 });
+        }
+        Stage& stage = *found;
+        stage.mTotalMs += block.milliseconds();
+        stage.mCount += block.mCount;
+      }
+    }
+
+    SceneResult runScene(const Scene& scene, const Options& options) {
+      SceneResult result;
+      result.mScene = &scene;
+      Memory::resetPeak();
+
+      {
+        Clock::time_point setupStart = Clock::now();
+        Syx::PhysicsSystem system;
+        system.setSubsteps(options.mSubsteps);
+        system.setSolverIterations(options.mIterations);
+        Syx::Handle space = system.addSpace();
+        result.mBodies = scene.mCreate(system, space, options.mScale);
+        result.mSetupSeconds = secondsSince(setupStart);
+
+        //Update only takes whole steps, and one step's worth of time always runs exactly one
+        const float dt = Syx::PhysicsSystem::sSimRate;
+        for(size_t i = 0; i < options.mWarmup; ++i)
+          system.update(dt);
+
+        result.mStepMs.reserve(options.mSteps);
+        std::vector<std::string> pathStack;
+        Clock::time_point runStart = Clock::now();
+        for(size_t i = 0; i < options.mSteps; ++i) {
+          Clock::time_point stepStart = Clock::now();
+          system.update(dt);
+          result.mStepMs.push_back(secondsSince(stepStart)*1000.0);
+          addStages(*system.getProfileHistory(space), result.mStages, pathStack);
+        }
+        result.mTotalSeconds = secondsSince(runStart);
+
+        if(!options.mTracePrefix.empty()) {
+          std::ofstream trace(options.mTracePrefix + scene.mName + ".json");
+          system.writeProfileTrace(space, trace);
+        }
+        result.mPeakHeapBytes = Memory::getPeak();
+        result.mEndHeapBytes = Memory::getCurrent();
+      }
+
+      std::sort(result.mStepMs.begin(), result.mStepMs.end());
+      return result;
+    }
+
+    double percentile(const std::vector<double>& sorted, double p) {
+      size_t index = static_cast<size_t>(p*static_cast<double>(sorted.size() - 1) + 0.5);
+      return sorted[std::min(index, sorted.size() - 1)];
+    }
+
+    double mean(const std::vector<double>& values) {
+      double total = 0.0;
+      for(double value : values)
+        total += value;
+      return total/static_cast<double>(values.size());
+    }
+
+    void writeJsonString(const std::string& str) {
+      std::putchar('"');
+      for(char c : str) {
+        if(c == '"' || c == '\\')
+          std::putchar('\\');
+        if(static_cast<unsigned char>(c) >= ' ')
+          std::putchar(c);
+      }
+      std::putchar('"');
+    }
+
+    void writeJson(const Options& options, const std::vector<SceneResult>& results) {
+      std::printf("{\n  \"label\": ");
+      writeJsonString(options.mLabel);
+      std::printf(",\n  \"config\": {\"steps\": %zu, \"warmup\": %zu, \"scale\": %g, \"threads\": %zu, \"substeps\": %zu, \"iterations\": %d, \"simdFlags\": %d, \"dt\": %g},\n",
+        options.mSteps, options.mWarmup, options.mScale, options.mThreads, options.mSubsteps, options.mIterations, options.mSimdFlags, Syx::PhysicsSystem::sSimRate);
+      std::printf("  \"scenes\": [");
+      for(size_t i = 0; i < results.size(); ++i) {
+        const SceneResult& r = results[i];
+        const double steps = static_cast<double>(r.mStepMs.size());
+        std::printf("%s\n    {\"name\": \"%s\", \"bodies\": %zu, \"setupSeconds\": %.6f, \"totalSeconds\": %.6f, \"stepsPerSecond\": %.3f,\n",
+          i ? "," : "", r.mScene->mName, r.mBodies, r.mSetupSeconds, r.mTotalSeconds, steps/r.mTotalSeconds);
+        std::printf("     \"stepMs\": {\"mean\": %.6f, \"min\": %.6f, \"p50\": %.6f, \"p95\": %.6f, \"max\": %.6f},\n",
+          mean(r.mStepMs), r.mStepMs.front(), percentile(r.mStepMs, 0.5), percentile(r.mStepMs, 0.95), r.mStepMs.back());
+        std::printf("     \"peakHeapBytes\": %zu, \"endHeapBytes\": %zu,\n     \"stages\": [", r.mPeakHeapBytes, r.mEndHeapBytes);
+        for(size_t s = 0; s < r.mStages.size(); ++s) {
+          const Stage& stage = r.mStages[s];
+          std::printf("%s\n       {\"path\": ", s ? "," : "");
+          writeJsonString(stage.mPath);
+          std::printf(", \"meanMs\": %.6f, \"count\": %zu}", stage.mTotalMs/steps, stage.mCount);
+        }
+        std::printf("]}");
+      }
+      std::printf("\n  ]\n}\n");
+    }
+
+    void writeText(const Options& options, const std::vector<SceneResult>& results) {
+      std::printf("%s%s%zu steps, scale %g, %zu thread(s), %zu substep(s), %d iterations, simd flags %d\n", options.mLabel.c_str(), options.mLabel.empty() ? "" : ": ",
+        options.mSteps, options.mScale, options.mThreads, options.mSubsteps, options.mIterations, options.mSimdFlags);
+      for(const SceneResult& r : results) {
+        const double steps = static_cast<double>(r.mStepMs.size());
+        std::printf("\n%s: %zu bodies, setup %.3fs, %.1f steps/s, peak heap %.1f MB\n", r.mScene->mName, r.mBodies, r.mSetupSeconds,
+          steps/r.mTotalSeconds, static_cast<double>(r.mPeakHeapBytes)/(1024.0*1024.0));
+        std::printf("  step ms: mean %.3f min %.3f p50 %.3f p95 %.3f max %.3f\n", mean(r.mStepMs), r.mStepMs.front(),
+          percentile(r.mStepMs, 0.5), percentile(r.mStepMs, 0.95), r.mStepMs.back());
+        for(const Stage& stage : r.mStages) {
+          size_t depth = static_cast<size_t>(std::count(stage.mPath.begin(), stage.mPath.end(), '/'));
+          size_t nameStart = stage.mPath.rfind('/');
+          const char* name = stage.mPath.c_str() + (nameStart == std::string::npos ? 0 : nameStart + 1);
+          std::printf("  %*s%-*s %8.3f ms\n", static_cast<int>(depth*2), "", static_cast<int>(32 - depth*2), name, stage.mTotalMs/steps);
+        }
+      }
+    }
+  }
+}
+
+int main(int argc, char** argv) {
+  Bench::Options options;
+  if(!Bench::parseOptions(argc, argv, options))
+    return 1;
+
+  Bench::Interface::setSimdFlags(options.mSimdFlags);
+  Bench::Interface::setThreadCount(options.mThreads);
+
+  std::vector<Bench::SceneResult> results;
+  for(const std::string& name : options.mScenes) {
+    if(!options.mJson)
+      std::fprintf(stderr, "Running %s...\n", name.c_str());
+    results.push_back(Bench::runScene(*Bench::findScene(name), options));
+  }
+  Bench::Interface::shutdown();
+
+  if(options.mJson)
+    Bench::writeJson(options, results);
+  else
+    Bench::writeText(options, results);
+  return 0;
+}
@@ -0,0 +1,180 @@
+#include "Precompile.h"
+#include "BenchInterface.h"
+#include "BenchMemory.h"
+
+namespace Bench {
+  namespace Interface {
+    namespace {
+      //True on threads running a parallelFor callback, where nested calls run inline since the pool only runs one call at a time
+      thread_local bool sInCallback = false;
+
+      //Minimal pool for parallelFor. Workers sleep between calls and take indices from a shared counter while one is running
+      class Workers {
+      public:
+        ~Workers() {
+          stop();
+        }
+
+        void start(size_t helpers) {
+          stop();
+          mQuit = false;
+          for(size_t i = 0; i < helpers; ++i)
+            mThreads.emplace_back([this] { _workerLoop(); });
+        }
+
+        void stop() {
+          {
+            std::lock_guard<std::mutex> lock(mMutex);
+            mQuit = true;
+          }
+          mWake.notify_all();
+          for(std::thread& thread : mThreads)
+            thread.join();
+          mThreads.clear();
+        }
+
+        size_t getHelperCount() const {
+          return mThreads.size();
+        }
+
+        void parallelFor(size_t count, const std::function<void(size_t)>& callback) {
+          if(mThreads.empty() || count < 2 || sInCallback) {
+            for(size_t i = 0; i < count; ++i)
+              callback(i);
+            return;
+          }
+
+          {
+            std::lock_guard<std::mutex> lock(mMutex);
+            //Workers can only join a call while holding the lock, so once the stragglers from the last call leave it's safe to replace
+            while(mActive.load())
+              std::this_thread::yield();
+            mCallback = &callback;
+            mCount.store(count);
+            mDone.store(0);
+            mNext.store(0);
+            ++mGeneration;
+          }
+          mWake.notify_all();
+
+          _work();
+          while(mDone.load() != count)
+            std::this_thread::yield();
+        }
+
+      private:
+        void _workerLoop() {
+          size_t generation = 0;
+          while(true) {
+            {
+              std::unique_lock<std::mutex> lock(mMutex);
+              mWake.wait(lock, [this, generation] { return mQuit || mGeneration != generation; });
+              if(mQuit)
+                return;
+              generation = mGeneration;
+              mActive.fetch_add(1);
+            }
+            _work();
+            mActive.fetch_sub(1);
+          }
+        }
+
+        void _work() {
+          sInCallback = true;
+          for(size_t i = mNext.fetch_add(1); i < mCount.load(); i = mNext.fetch_add(1)) {
+            (*mCallback)(i);
+            mDone.fetch_add(1);
+          }
+          sInCallback = false;
+        }
+
+        std::vector<std::thread> mThreads;
+        std::mutex mMutex;
+        std::condition_variable mWake;
+        const std::function<void(size_t)>* mCallback = nullptr;
+        std::atomic<size_t> mNext{0};
+        std::atomic<size_t> mCount{0};
+        std::atomic<size_t> mDone{0};
+        //Workers inside _work, which may still be looking at the previous call after it returned
+        std::atomic<size_t> mActive{0};
+        size_t mGeneration = 0;
+        bool mQuit = false;
+      };
+
+      int sSimdFlags = 0;
+      Workers sWorkers;
+    }
+
+    void setSimdFlags(int flags) {
+      sSimdFlags = flags;
+    }
+
+    void setThreadCount(size_t threads) {
+      sWorkers.start(threads > 1 ? threads - 1 : 0);
+    }
+
+    size_t getThreadCount() {
+      return sWorkers.getHelperCount() + 1;
+    }
+
+    void shutdown() {
+      sWorkers.stop();
+    }
+  }
+}
+
+namespace Syx {
+  namespace Interface {
+    SyxOptions getOptions(void) {
+      SyxOptions result;
+      //Nothing is drawn headless
+      result.mDebugFlags = 0;
+      result.mSimdFlags = Bench::Interface::sSimdFlags;
+      result.mThreadingFlags = Bench::Interface::getThreadCount() > 1 ? SyxOptions::ParallelSolve | SyxOptions::ParallelNarrowphase | SyxOptions::ParallelQueries | SyxOptions::ParallelSpaces : 0;
+      result.mTest = 0;
+      return result;
+    }
+
+    void setColor(float, float, float) {
+    }
+
+    void drawLine(const Vec3&, const Vec3&) {
+    }
+
+    void drawVector(const Vec3&, const Vec3&) {
+    }
+
+    void drawSphere(const Vec3&, float, const Vec3&, const Vec3&) {
+    }
+
+    void drawCube(const Vec3&, const Vec3&, const Vec3&, const Vec3&) {
+    }
+
+    void drawPoint(const Vec3&, float) {
+    }
+
+    void* allocAligned(size_t size) {
+      return Bench::Memory::allocate(size, 16);
+    }
+
+    void freeAligned(void* p) {
+      Bench::Memory::free(p);
+    }
+
+    void* allocUnaligned(size_t size) {
+      return Bench::Memory::allocate(size, 1);
+    }
+
+    void freeUnaligned(void* p) {
+      Bench::Memory::free(p);
+    }
+
+    void log(const std::string& message) {
+      std::fputs(message.c_str(), stderr);
+    }
+
+    void parallelFor(size_t count, const std::function<void(size_t)>& callback) {
+      Bench::Interface::sWorkers.parallelFor(count, callback);
+    }
+  }
+}
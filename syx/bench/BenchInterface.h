@@ -0,0 +1,13 @@
+#pragma once
+
+namespace Bench {
+  //Settings the physics interface reports through Syx::Interface::getOptions
+  namespace Interface {
+    void setSimdFlags(int flags);
+    //Total threads to run parallel work on including the calling thread. 1 runs everything serially with threading disabled
+    void setThreadCount(size_t threads);
+    size_t getThreadCount();
+    //Joins the worker threads
+    void shutdown();
+  }
+}
@@ -0,0 +1,125 @@
+#include "Precompile.h"
+#include "BenchMemory.h"
+
+#include <cstddef>
+#include <new>
+
+namespace Bench {
+  namespace Memory {
+    namespace {
+      //Every allocation is prefixed by a header this large so frees know the size. Keeps the user pointer 16 byte aligned
+      const size_t sHeaderSize = 16;
+
+      struct Header {
+        size_t mSize;
+        //Offset from the start of the underlying allocation to the user pointer
+        size_t mOffset;
+      };
+
+      std::atomic<size_t> sCurrent(0);
+      std::atomic<size_t> sPeak(0);
+
+      void track(size_t size) {
+        size_t current = sCurrent.fetch_add(size, std::memory_order_relaxed) + size;
+        size_t peak = sPeak.load(std::memory_order_relaxed);
+        while(current > peak && !sPeak.compare_exchange_weak(peak, current, std::memory_order_relaxed)) {
+        }
+      }
+    }
+
+    size_t getCurrent() {
+      return sCurrent.load(std::memory_order_relaxed);
+    }
+
+    size_t getPeak() {
+      return sPeak.load(std::memory_order_relaxed);
+    }
+
+    void resetPeak() {
+      sPeak.store(getCurrent(), std::memory_order_relaxed);
+    }
+
+    void* allocate(size_t size, size_t alignment) {
+      alignment = std::max(alignment, sHeaderSize);
+      //Enough extra to fit the header and align the user pointer after it
+      unsigned char* base = static_cast<unsigned char*>(std::malloc(size + alignment + sHeaderSize));
+      if(!base)
+        return nullptr;
+
+      uintptr_t user = (reinterpret_cast<uintptr_t>(base) + sHeaderSize + alignment - 1) & ~static_cast<uintptr_t>(alignment - 1);
+      Header* header = reinterpret_cast<Header*>(user - sizeof(Header));
+      header->mSize = size;
+      header->mOffset = user - reinterpret_cast<uintptr_t>(base);
+      track(size);
+      return reinterpret_cast<void*>(user);
+    }
+
+    void free(void* p) {
+      if(!p)
+        return;
+      Header* header = reinterpret_cast<Header*>(static_cast<unsigned char*>(p) - sizeof(Header));
+      sCurrent.fetch_sub(header->mSize, std::memory_order_relaxed);
+      std::free(static_cast<unsigned char*>(p) - header->mOffset);
+    }
+  }
+}
+
+void* operator new(size_t size) {
+  if(void* result = Bench::Memory::allocate(size, alignof(std::max_align_t)))
+    return result;
+  throw std::bad_alloc();
+}
+
+void* operator new[](size_t size) {
+  return operator new(size);
+}
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept {
+  return Bench::Memory::allocate(size, alignof(std::max_align_t));
+}
+
+void* operator new[](size_t size, const std::nothrow_t&) noexcept {
+  return Bench::Memory::allocate(size, alignof(std::max_align_t));
+}
+
+void* operator new(size_t size, std::align_val_t alignment) {
+  if(void* result = Bench::Memory::allocate(size, static_cast<size_t>(alignment)))
+    return result;
+  throw std::bad_alloc();
+}
+
+void* operator new[](size_t size, std::align_val_t alignment) {
+  return operator new(size, alignment);
+}
+
+void operator delete(void* p) noexcept {
+  Bench::Memory::free(p);
+}
+
+void operator delete[](void* p) noexcept {
+  Bench::Memory::free(p);
+}
+
+void operator delete(void* p, size_t) noexcept {
+  Bench::Memory::free(p);
+}
+
+void operator delete[](void* p, size_t) noexcept {
+  Bench::Memory::free(p);
+}
+
+void operator delete(void* p, std::align_val_t) noexcept {
+  Bench::Memory::free(p);
+}
+
+void operator delete[](void* p, std::align_val_t) noexcept {
+  Bench::Memory::free(p);
+}
+
+void operator delete(void* p, size_t, std::align_val_t) noexcept {
+  Bench::Memory::free(p);
+}
+
+void operator delete[](void* p, size_t, std::align_val_t) noexcept {
+  Bench::Memory::free(p);
+}
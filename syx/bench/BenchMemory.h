@@ -0,0 +1,17 @@
+#pragma once
+
+namespace Bench {
+  //Tracks heap usage of the whole process through replaced global operator new and the physics interface allocators.
+  //Conflicts with SYX_COUNT_ALLOCATIONS since both replace operator new
+  namespace Memory {
+    //Bytes currently allocated
+    size_t getCurrent();
+    //Most bytes allocated at once since the last resetPeak
+    size_t getPeak();
+    //Starts a new high water mark from the current usage
+    void resetPeak();
+
+    void* allocate(size_t size, size_t alignment);
+    void free(void* p);
+  }
+}
@@ -0,0 +1,236 @@
+#include "Precompile.h"
+#include "BenchScenes.h"
+
+#include "SyxPhysicsSystem.h"
+#include "SyxModelParam.h"
+
+using namespace Syx;
+
+namespace Bench {
+  namespace {
+    const float sPi = 3.14159265f;
+
+    size_t scaled(size_t count, float scale) {
+      return std::max(size_t(1), static_cast<size_t>(static_cast<float>(count)*scale + 0.5f));
+    }
+
+    //Small deterministic generator so scenes are identical between runs and platforms
+    class Random {
+    public:
+      Random(uint32_t seed)
+        : mState(seed) {
+      }
+
+      //In [min, max)
+      float get(float min, float max) {
+        mState = mState*1664525u + 1013904223u;
+        float t = static_cast<float>(mState >> 8)/static_cast<float>(1 << 24);
+        return min + (max - min)*t;
+      }
+
+    private:
+      uint32_t mState;
+    };
+
+    Handle addObject(PhysicsSystem& system, Handle space, bool dynamic, Handle model, const Vec3& pos, const Vec3& scale, const Quat& rot = Quat::Identity) {
+      Handle result = system.addPhysicsObject(dynamic, true, space);
+      system.setObjectModel(space, result, model);
+      system.setScale(space, result, scale);
+      system.setRotation(space, result, rot);
+      system.setPosition(space, result, pos);
+      return result;
+    }
+
+    //Ground with its top at y=0, and walls around it if wallHeight is positive
+    void addContainer(PhysicsSystem& system, Handle space, float halfSize, float wallHeight) {
+      addObject(system, space, false, system.getCube(), Vec3(0.0f, -1.0f, 0.0f), Vec3(halfSize, 1.0f, halfSize));
+      if(wallHeight <= 0.0f)
+        return;
+
+      const float wall = halfSize - 0.5f;
+      addObject(system, space, false, system.getCube(), Vec3(wall, wallHeight, 0.0f), Vec3(0.5f, wallHeight, halfSize));
+      addObject(system, space, false, system.getCube(), Vec3(-wall, wallHeight, 0.0f), Vec3(0.5f, wallHeight, halfSize));
+      addObject(system, space, false, system.getCube(), Vec3(0.0f, wallHeight, wall), Vec3(halfSize, wallHeight, 0.5f));
+      addObject(system, space, false, system.getCube(), Vec3(0.0f, wallHeight, -wall), Vec3(halfSize, wallHeight, 0.5f));
+    }
+
+    //Two dimensional pyramid of unit boxes resting on the ground. Tests stacking stability and the solver on one big island
+    size_t createPyramid(PhysicsSystem& system, Handle space, float scale) {
+      const size_t rows = scaled(30, std::sqrt(scale));
+      const float spacing = 1.05f;
+      addContainer(system, space, rows*spacing, 0.0f);
+
+      size_t bodies = 0;
+      for(size_t row = 0; row < rows; ++row) {
+        const size_t count = rows - row;
+        for(size_t i = 0; i < count; ++i) {
+          float x = (static_cast<float>(i) - static_cast<float>(count - 1)*0.5f)*spacing;
+          addObject(system, space, true, system.getCube(), Vec3(x, 0.5f + row*1.0f, 0.0f), Vec3(0.5f));
+          ++bodies;
+        }
+      }
+      return bodies;
+    }
+
+    //Spheres dropped in columns into a walled box. Tests broadphase and narrowphase throughput with many small islands
+    size_t createSphereRain(PhysicsSystem& system, Handle space, float scale) {
+      const size_t count = scaled(10000, scale);
+      const size_t columns = 25;
+      const float spacing = 1.2f;
+      addContainer(system, space, columns*spacing*0.5f + 1.0f, 4.0f);
+
+      Random random(1);
+      for(size_t i = 0; i < count; ++i) {
+        size_t x = i % columns;
+        size_t z = (i / columns) % columns;
+        size_t layer = i / (columns*columns);
+        Vec3 pos((x - columns*0.5f + 0.5f)*spacing + random.get(-0.1f, 0.1f),
+          2.0f + layer*spacing,
+          (z - columns*0.5f + 0.5f)*spacing + random.get(-0.1f, 0.1f));
+        addObject(system, space, true, system.getSphere(), pos, Vec3(0.5f));
+      }
+      return count;
+    }
+
+    //Chains of capsules joined by alternating spherical and revolute joints dropped in crossing layers
+    size_t createRagdollChains(PhysicsSystem& system, Handle space, float scale) {
+      const size_t chains = scaled(64, scale);
+      const size_t segments = 10;
+      const size_t chainsPerLayer = 16;
+      const float radius = 0.2f;
+      const float segmentLength = radius*4.0f;
+      addContainer(system, space, segments*segmentLength, 0.0f);
+
+      std::vector<Handle> chain(segments);
+      for(size_t c = 0; c < chains; ++c) {
+        const size_t layer = c / chainsPerLayer;
+        const float across = (static_cast<float>(c % chainsPerLayer) - chainsPerLayer*0.5f + 0.5f)*1.0f;
+        //Alternate layers run along x and z so they fall across each other
+        const bool alongX = layer % 2 == 0;
+        const Vec3 dir = alongX ? Vec3::UnitX : Vec3::UnitZ;
+        const Vec3 side = alongX ? Vec3::UnitZ : Vec3::UnitX;
+        const Quat rot = alongX ? Quat::axisAngle(Vec3::UnitZ, sPi*0.5f) : Quat::axisAngle(Vec3::UnitX, sPi*0.5f);
+        const Vec3 start = side*across + Vec3(0.0f, 1.0f + layer*1.0f, 0.0f);
+
+        for(size_t s = 0; s < segments; ++s) {
+          Vec3 pos = start + dir*((static_cast<float>(s) - segments*0.5f + 0.5f)*segmentLength);
+          chain[s] = addObject(system, space, true, system.getCapsule(), pos, Vec3(radius), rot);
+        }
+
+        for(size_t s = 0; s + 1 < segments; ++s) {
+          Vec3 anchor = start + dir*((static_cast<float>(s) - segments*0.5f + 1.0f)*segmentLength);
+          if(s % 2 == 0) {
+            SphericalOps ops;
+            ops.set(chain[s], chain[s + 1], space);
+            ops.setWorldAnchor(anchor);
+            system.addSphericalConstraint(ops);
+          }
+          else {
+            RevoluteOps ops;
+            ops.set(chain[s], chain[s + 1], space);
+            ops.setWorldAnchor(anchor);
+            ops.mFreeAxis = side;
+            system.addRevoluteConstraint(ops);
+          }
+        }
+      }
+      return chains*segments;
+    }
+
+    //Dumbbells and L shapes piled into a walled box. Tests composite narrowphase through submodel trees
+    size_t createCompositePile(PhysicsSystem& system, Handle space, float scale) {
+      typedef CompositeModelParam::SubmodelInstance Instance;
+      CompositeModelParam dumbbell;
+      dumbbell.addSubmodelInstance(Instance(system.getSphere(), false, Transform(Vec3(0.35f), Quat::Identity, Vec3(-0.6f, 0.0f, 0.0f))));
+      dumbbell.addSubmodelInstance(Instance(system.getSphere(), false, Transform(Vec3(0.35f), Quat::Identity, Vec3(0.6f, 0.0f, 0.0f))));
+      dumbbell.addSubmodelInstance(Instance(system.getCube(), false, Transform(Vec3(0.5f, 0.12f, 0.12f), Quat::Identity, Vec3::Zero)));
+      CompositeModelParam lShape;
+      lShape.addSubmodelInstance(Instance(system.getCube(), false, Transform(Vec3(0.5f, 0.15f, 0.15f), Quat::Identity, Vec3(0.35f, 0.0f, 0.0f))));
+      lShape.addSubmodelInstance(Instance(system.getCube(), false, Transform(Vec3(0.15f, 0.5f, 0.15f), Quat::Identity, Vec3(0.0f, 0.35f, 0.0f))));
+      const Handle models[] = { system.addCompositeModel(dumbbell), system.addCompositeModel(lShape) };
+
+      const size_t count = scaled(400, scale);
+      const size_t columns = 10;
+      const float spacing = 1.8f;
+      addContainer(system, space, columns*spacing*0.5f + 1.0f, 3.0f);
+
+      Random random(2);
+      for(size_t i = 0; i < count; ++i) {
+        size_t x = i % columns;
+        size_t z = (i / columns) % columns;
+        size_t layer = i / (columns*columns);
+        Vec3 pos((x - columns*0.5f + 0.5f)*spacing, 1.0f + layer*spacing, (z - columns*0.5f + 0.5f)*spacing);
+        Quat rot = Quat::axisAngle(Vec3::UnitY, random.get(0.0f, 2.0f*sPi));
+        addObject(system, space, true, models[i % 2], pos, Vec3::Identity, rot);
+      }
+      return count;
+    }
+
+    float terrainHeight(float x, float z) {
+      return 1.5f*std::sin(x*0.35f)*std::cos(z*0.27f) + 0.5f*std::sin((x + z)*0.8f);
+    }
+
+    //Mixed shapes dropped onto a triangle mesh heightfield. Tests environment collision
+    size_t createMeshEnvironment(PhysicsSystem& system, Handle space, float scale) {
+      const size_t cells = 64;
+      const float half = cells*0.5f;
+      ModelParam terrain;
+      terrain.setEnvironment(true);
+      terrain.reserve((cells + 1)*(cells + 1), cells*cells*6);
+      for(size_t z = 0; z <= cells; ++z) {
+        for(size_t x = 0; x <= cells; ++x) {
+          float px = static_cast<float>(x) - half;
+          float pz = static_cast<float>(z) - half;
+          terrain.addVertex(Vec3(px, terrainHeight(px, pz), pz));
+        }
+      }
+      for(size_t z = 0; z < cells; ++z) {
+        for(size_t x = 0; x < cells; ++x) {
+          size_t a = z*(cells + 1) + x;
+          size_t b = a + 1;
+          size_t c = a + cells + 1;
+          size_t d = c + 1;
+          terrain.addTriangle(a, c, b);
+          terrain.addTriangle(b, c, d);
+        }
+      }
+      addObject(system, space, false, system.addModel(terrain), Vec3::Zero, Vec3::Identity);
+
+      const size_t count = scaled(1000, scale);
+      const size_t columns = 20;
+      const float spacing = 2.5f;
+      const Handle models[] = { system.getCube(), system.getSphere(), system.getCapsule() };
+      const Vec3 scales[] = { Vec3(0.4f), Vec3(0.4f), Vec3(0.25f) };
+      Random random(3);
+      for(size_t i = 0; i < count; ++i) {
+        size_t x = i % columns;
+        size_t z = (i / columns) % columns;
+        size_t layer = i / (columns*columns);
+        float px = (x - columns*0.5f + 0.5f)*spacing;
+        float pz = (z - columns*0.5f + 0.5f)*spacing;
+        Vec3 pos(px, terrainHeight(px, pz) + 3.0f + layer*1.5f, pz);
+        Quat rot = Quat::axisAngle(Vec3(random.get(-1.0f, 1.0f), 1.0f, random.get(-1.0f, 1.0f)).normalized(), random.get(0.0f, sPi));
+        addObject(system, space, true, models[i % 3], pos, scales[i % 3], rot);
+      }
+      return count;
+    }
+  }
+
+  const std::vector<Scene>& getScenes() {
+    static const std::vector<Scene> scenes = {
+      { "pyramid", "Box pyramid resting on the ground", &createPyramid },
+      { "sphereRain", "Spheres falling into a walled box", &createSphereRain },
+      { "ragdollChains", "Capsule chains with spherical and revolute joints", &createRagdollChains },
+      { "compositePile", "Composite dumbbells and L shapes in a walled box", &createCompositePile },
+      { "meshEnvironment", "Mixed shapes on a triangle mesh heightfield", &createMeshEnvironment }
+    };
+    return scenes;
+  }
+
+  const Scene* findScene(const std::string& name) {
+    for(const Scene& scene : getScenes())
+      if(name == scene.mName)
+        return &scene;
+    return nullptr;
+  }
+}
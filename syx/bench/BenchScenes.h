@@ -0,0 +1,18 @@
+#pragma once
+
+namespace Syx {
+  class PhysicsSystem;
+}
+
+namespace Bench {
+  struct Scene {
+    const char* mName;
+    const char* mDescription;
+    //Fills the space and returns how many dynamic bodies were created. Scale multiplies the body count, 1 is the standard size
+    size_t(*mCreate)(Syx::PhysicsSystem& system, Syx::Handle space, float scale);
+  };
+
+  //The standard scenes in the order they're run. Scenes are deterministic so results are comparable between builds
+  const std::vector<Scene>& getScenes();
+  const Scene* findScene(const std::string& name);
+}
@@ -0,0 +1 @@
+#include "Precompile.h"
@@ -0,0 +1,9 @@
+#pragma once
+#include "../syx/Precompile.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
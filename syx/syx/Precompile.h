@@ -5,6 +5,7 @@
 #include <xmmintrin.h>
 #endif
 #include <cmath>
+#include <cstring>
 #include <vector>
 #include <list>
 #include <stack>
@@ -39,6 +40,7 @@
 #include "SyxStaticIndexable.h"
 #include "SyxIntrusive.h"
 #include "SyxHandleMap.h"
+#include "SyxFrameArena.h"
 
 namespace Syx {
   extern Syx::SyxOptions gOptions;
@@ -2,7 +2,8 @@
 #include "SyxAABBTree.h"
 
 namespace Syx {
-  const float sBoxPadding = 0.0f;
+  //Leaves whose volume has become this many margins larger than needed are shrunk back down
+  const float sMaxExcessMargins = 4.0f;
 
   class AABBNode {
   public:
@@ -66,9 +67,71 @@ namespace Syx {
       return mIsLeaf;
     }
 
+    bool isFree() const {
+      return mHeight == static_cast<int>(Null);
+    }
+
     static const Handle Null = std::numeric_limits<size_t>::max();
   };
 
+  //Lines stored with one lane per line so a box can be tested against all of them at once
+  SAlign struct RayPacket {
+    RayPacket(const Vec3* starts, const Vec3* ends, size_t count)
+      : mActive((1 << count) - 1) {
+      for(size_t lane = 0; lane < BroadphaseContext::sPacketSize; ++lane) {
+        //Unused lanes repeat the last line, their results are masked out by mActive
+        size_t i = std::min(lane, count - 1);
+        for(int axis = 0; axis < 3; ++axis) {
+          float dir = ends[i][axis] - starts[i][axis];
+          mStart[axis][lane] = starts[i][axis];
+          //Lines parallel to an axis get a huge reciprocal so the slab test only passes if the start is between the planes
+          mInvDir[axis][lane] = std::abs(dir) > SYX_EPSILON ? 1.0f/dir : (dir < 0.0f ? -std::numeric_limits<float>::max() : std::numeric_limits<float>::max());
+        }
+      }
+    }
+
+    //Returns a bit for each line in mask that intersects the box
+    int intersect(const AABB& aabb, int mask) const {
+      const Vec3 boxMin = aabb.getMin();
+      const Vec3 boxMax = aabb.getMax();
+#ifdef SENABLED
+      //Slab test on the segment where t is in [0, 1]
+      SFloats tMin = SSetZero();
+      SFloats tMax = sLoadSplatFloats(1.0f);
+      for(int axis = 0; axis < 3; ++axis) {
+        SFloats start = SLoadAll(mStart[axis]);
+        SFloats invDir = SLoadAll(mInvDir[axis]);
+        SFloats t1 = SMulAll(SSubAll(SSetSplat(boxMin[axis]), start), invDir);
+        SFloats t2 = SMulAll(SSubAll(SSetSplat(boxMax[axis]), start), invDir);
+        tMin = SMaxAll(tMin, SMinAll(t1, t2));
+        tMax = SMinAll(tMax, SMaxAll(t1, t2));
+      }
+      return SMoveMask(SLessEqualAll(tMin, tMax)) & mask & mActive;
+#else
+      int result = 0;
+      for(size_t lane = 0; lane < BroadphaseContext::sPacketSize; ++lane) {
+        if(!(mask & mActive & (1 << lane)))
+          continue;
+        float tMin = 0.0f;
+        float tMax = 1.0f;
+        for(int axis = 0; axis < 3; ++axis) {
+          float t1 = (boxMin[axis] - mStart[axis][lane])*mInvDir[axis][lane];
+          float t2 = (boxMax[axis] - mStart[axis][lane])*mInvDir[axis][lane];
+          tMin = std::max(tMin, std::min(t1, t2));
+          tMax = std::min(tMax, std::max(t1, t2));
+        }
+        if(tMin <= tMax)
+          result |= 1 << lane;
+      }
+      return result;
+#endif
+    }
+
+    SAlign float mStart[3][BroadphaseContext::sPacketSize];
+    SAlign float mInvDir[3][BroadphaseContext::sPacketSize];
+    int mActive;
+  };
+
   class AABBTree;
 
   struct AABBTreeContext {
@@ -78,7 +141,11 @@ namespace Syx {
     }
 
     //Used during raycasting to keep track of things to cast against, stored here to save on re-allocations
-    std::queue<const AABBNode*> mNodeQueue;
+    std::vector<const AABBNode*> mNodeStack;
+    //Same as mNodeStack for packet raycasts, with a bit for each ray in the packet that hit the node's parent
+    std::vector<std::pair<const AABBNode*, int>> mPacketStack;
+    //Same as mNodeStack for tree queries, with a node from each tree
+    std::vector<std::pair<const AABBNode*, const AABBNode*>> mTreeStack;
     //Number of elements in use in m_toEvaluate
     size_t mEvalSize = 0;
     std::vector<std::pair<const AABBNode*, const AABBNode*>> mToEvaluate;
@@ -94,12 +161,26 @@ namespace Syx {
 
     virtual void queryRaycast(const Vec3& start, const Vec3& end) override;
     virtual void queryVolume(const BoundingVolume& volume) override;
+    virtual void queryRaycastPacket(const Vec3* starts, const Vec3* ends, size_t count) override;
+    virtual void queryTree(const Broadphase& other, const Transformer& otherToThis) override;
 
     const std::vector<ResultNode>& get() const override {
       return mQueryResults;
     }
   };
 
+  //Leaf whose bounds changed. Removed means the handle may now belong to a different leaf
+  struct AABBMove {
+    AABBMove(Handle handle, bool removed)
+      : mHandle(handle)
+      , mRemoved(removed) {
+    }
+
+    Handle mHandle;
+    bool mRemoved;
+  };
+
+  //Keeps pairs between queries and only recomputes them for leaves that moved since the last query
   struct AABBPairContext : public AABBTreeContext, public BroadphasePairContext {
     using AABBTreeContext::AABBTreeContext;
 
@@ -108,18 +189,48 @@ namespace Syx {
     const std::vector<std::pair<ResultNode, ResultNode>>& get() const override {
       return mQueryPairResults;
     }
+
+    const std::vector<std::pair<ResultNode, ResultNode>>& getAdded() const override {
+      return mAddedPairs;
+    }
+
+    const std::vector<std::pair<ResultNode, ResultNode>>& getRemoved() const override {
+      return mRemovedPairs;
+    }
+
+    void addPair(const ResultNode& a, const ResultNode& b);
+    void removePair(Handle a, Handle b);
+    bool hasPair(Handle a, Handle b) const;
+    void clearPairs();
+
+    //Total number of tree moves that have been applied to the pairs
+    size_t mMovesConsumed = 0;
+    std::vector<std::pair<ResultNode, ResultNode>> mAddedPairs;
+    std::vector<std::pair<ResultNode, ResultNode>> mRemovedPairs;
+    //Index into mQueryPairResults of each pair, keyed by lower handle first
+    std::unordered_map<std::pair<Handle, Handle>, size_t, PairHash<Handle, Handle>> mPairIndices;
+    //Indexed by leaf handle
+    std::vector<std::vector<Handle>> mPartners;
+    //Indexed by leaf handle, used to collapse multiple moves of the same leaf into one
+    std::vector<char> mMoveState;
+    std::vector<Handle> mMoved;
+    std::vector<Handle> mOverlaps;
   };
 
   class AABBTree: public Broadphase {
   public:
-    AABBTree(int startingSize = 1024)
-      : mRoot(AABBNode::Null)
+    AABBTree(const AABBTreeConfig& config, int startingSize = 1024)
+      : mConfig(config)
+      , mRoot(AABBNode::Null)
       , mExistenceTracker(std::make_shared<bool>())
       , mFreeList(AABBNode::Null) {
       mNodes.resize(startingSize);
       _constructFreeList();
     }
 
+    //Minimum number of moves kept for pair contexts before old ones are discarded
+    static const size_t sMinMoveLogSize = 256;
+
     ~AABBTree() {
       while(mExistenceTracker.use_count() > 1) {
         std::this_thread::yield();
@@ -131,12 +242,12 @@ namespace Syx {
       AABBNode& newNode = mNodes[newIndex];
       newNode.mLeafData.mHandle = newIndex;
       newNode.mLeafData.mUserdata = userdata;
-      newNode.mAABB = obj.mAABB;
-      newNode.mAABB.pad(sBoxPadding);
+      newNode.mAABB = _getFatAABB(obj);
       newNode.mHeight = 0;
       newNode.mIsLeaf = true;
 
-      _insertNode(newNode, newIndex);
+      _insertNode(newIndex);
+      _logMove(newIndex, false);
       return newIndex;
     }
 
@@ -145,39 +256,9 @@ namespace Syx {
       if(toRemove == AABBNode::Null)
         return;
       assert(mNodes[toRemove].isLeaf() && "Any publicly exposed nodes should be leaves");
-      //Remove object and replace its parent with its sibling
-      Handle parent = mNodes[toRemove].mParent;
-
+      _detachLeaf(toRemove);
       _freeNode(toRemove);
-
-      if(parent == AABBNode::Null) {
-        mRoot = AABBNode::Null;
-        return;
-      }
-
-      Handle grandParent = mNodes[parent].mParent;
-
-      //Get sibling
-      Handle sibling = mNodes[parent].mLeft;
-      if(sibling == toRemove)
-        sibling = mNodes[parent].mRight;
-
-      //Connect sibling to grandparent
-      mNodes[sibling].mParent = grandParent;
-      if(grandParent == AABBNode::Null) {
-        mRoot = sibling;
-        _freeNode(parent);
-        return;
-      }
-      else if(mNodes[grandParent].mLeft == parent)
-        mNodes[grandParent].mLeft = sibling;
-      else
-        mNodes[grandParent].mRight = sibling;
-
-      //Kill disconnected parent
-      _freeNode(parent);
-
-      _syncParents(grandParent);
+      _logMove(toRemove, true);
     }
 
     Handle update(const BoundingVolume& newVol, Handle handle) {
@@ -186,13 +267,15 @@ namespace Syx {
       if(!needsUpdate) {
         assert(mNodes[handle].isLeaf() && "Any publicly exposed nodes should be leaves");
         node = &_getNode(handle);
-        needsUpdate = !node->mAABB.isInside(newVol.mAABB);
+        needsUpdate = _shouldReinsert(*node, newVol);
       }
 
       if(needsUpdate && node) {
-        void* userdata = node->mLeafData.mUserdata;
-        remove(handle);
-        return insert(newVol, userdata);
+        //Reinsert the same node so the handle stays stable and pairs with it can persist
+        _detachLeaf(handle);
+        node->mAABB = _getFatAABB(newVol);
+        _insertNode(handle);
+        _logMove(handle, false);
       }
 
       return handle;
@@ -201,35 +284,33 @@ namespace Syx {
     void clear() {
       mRoot = mFreeList = AABBNode::Null;
       _constructFreeList();
-    }
-
-    void queryPairs(AABBTreeContext& c) const {
-      c.mQueryPairResults.clear();
-      if(mRoot == AABBNode::Null || mNodes[mRoot].isLeaf())
+      //Every handle is invalidated, so make all pair contexts start over
+      mMovesDiscarded += mMoveLog.size() + 1;
+      mMoveLog.clear();
+    }
+
+    //Updates the context's persistent pairs for the leaves that moved since its last query
+    void queryPairs(AABBPairContext& c) const {
+      c.mAddedPairs.clear();
+      c.mRemovedPairs.clear();
+      c.mMoved.clear();
+      c.mMoveState.resize(mNodes.size(), 0);
+      c.mPartners.resize(mNodes.size());
+
+      if(c.mMovesConsumed < mMovesDiscarded) {
+        //Moves this context hasn't seen were discarded, so rebuild all pairs from scratch
+        _rebuildPairs(c);
         return;
+      }
 
-      c.mTraversed.clear();
-      _pushToEval(mNodes[mRoot].mLeft, mNodes[mRoot].mRight, c);
+      for(size_t i = c.mMovesConsumed - mMovesDiscarded; i < mMoveLog.size(); ++i)
+        _markMoved(mMoveLog[i].mHandle, mMoveLog[i].mRemoved, c);
+      c.mMovesConsumed = mMovesDiscarded + mMoveLog.size();
 
-      while(!_evalEmpty(c)) {
-        std::pair<const AABBNode*, const AABBNode*> pair = _popFromEval(c);
-        if(pair.first->isLeaf()) {
-          if(pair.second->isLeaf())
-            _checkBounds(*pair.first, *pair.second, c);
-          else
-            _leafBranchCase(*pair.first, *pair.second, c);
-        }
-        else if(pair.second->isLeaf())
-          _leafBranchCase(*pair.second, *pair.first, c);
-        else {
-          _traverseChild(*pair.first, c);
-          _traverseChild(*pair.second, c);
-          _pushToEval(pair.first->mLeft, pair.second->mLeft, c);
-          _pushToEval(pair.first->mLeft, pair.second->mRight, c);
-          _pushToEval(pair.first->mRight, pair.second->mLeft, c);
-          _pushToEval(pair.first->mRight, pair.second->mRight, c);
-        }
-      }
+      for(Handle moved : c.mMoved)
+        _updateLeafPairs(moved, c);
+      for(Handle moved : c.mMoved)
+        c.mMoveState[moved] = 0;
     }
 
     void queryVolume(const BoundingVolume& volume, AABBSingleContext& context) const {
@@ -238,14 +319,44 @@ namespace Syx {
       _getCollidingHelper(mRoot, volume, context);
     }
 
+    //Descends both trees at once, splitting whichever node is bigger until reaching pairs of overlapping leaves
+    void queryTree(const AABBTree& other, const Transformer& otherToThis, AABBSingleContext& c, std::vector<std::pair<ResultNode, ResultNode>>& results) const {
+      results.clear();
+      c.mTreeStack.clear();
+      if(mRoot == AABBNode::Null || other.mRoot == AABBNode::Null)
+        return;
+
+      c.mTreeStack.push_back({ &mNodes[mRoot], &other.mNodes[other.mRoot] });
+      while(!c.mTreeStack.empty()) {
+        const AABBNode& a = *c.mTreeStack.back().first;
+        const AABBNode& b = *c.mTreeStack.back().second;
+        c.mTreeStack.pop_back();
+
+        AABB bInA = b.mAABB.transform(otherToThis);
+        if(!a.mAABB.overlapping(bInA))
+          continue;
+
+        if(a.isLeaf() && b.isLeaf())
+          results.push_back({ a.mLeafData, b.mLeafData });
+        else if(b.isLeaf() || (!a.isLeaf() && a.mAABB.getSurfaceArea() >= bInA.getSurfaceArea())) {
+          c.mTreeStack.push_back({ &mNodes[a.mRight], &b });
+          c.mTreeStack.push_back({ &mNodes[a.mLeft], &b });
+        }
+        else {
+          c.mTreeStack.push_back({ &a, &other.mNodes[b.mRight] });
+          c.mTreeStack.push_back({ &a, &other.mNodes[b.mLeft] });
+        }
+      }
+    }
+
     void queryRaycast(const Vec3& start, const Vec3& end, AABBSingleContext& c) const {
       c.mQueryResults.clear();
       if(mRoot != AABBNode::Null)
-        c.mNodeQueue.push(&mNodes[mRoot]);
+        c.mNodeStack.push_back(&mNodes[mRoot]);
 
-      while(!c.mNodeQueue.empty()) {
-        const AABBNode& curNode = *c.mNodeQueue.front();
-        c.mNodeQueue.pop();
+      while(!c.mNodeStack.empty()) {
+        const AABBNode& curNode = *c.mNodeStack.back();
+        c.mNodeStack.pop_back();
 
         const AABB& aabb = curNode.mAABB;
         float t;
@@ -254,13 +365,42 @@ namespace Syx {
             c.mQueryResults.push_back(ResultNode(curNode.mLeafData.mHandle, curNode.mLeafData.mUserdata));
           else//is branch
           {
-            c.mNodeQueue.push(&mNodes[curNode.mLeft]);
-            c.mNodeQueue.push(&mNodes[curNode.mRight]);
+            //Right first so left is traversed first, same as queryVolume
+            c.mNodeStack.push_back(&mNodes[curNode.mRight]);
+            c.mNodeStack.push_back(&mNodes[curNode.mLeft]);
           }
         }
       }
     }
 
+    //Same as queryRaycast, but each node is visited once for the whole packet and only tested against the rays that hit its parent
+    void queryRaycastPacket(const Vec3* starts, const Vec3* ends, size_t count, AABBTreeContext& c, std::vector<ResultNode>* results) const {
+      for(size_t i = 0; i < count; ++i)
+        results[i].clear();
+      if(mRoot == AABBNode::Null || !count)
+        return;
+
+      RayPacket packet(starts, ends, count);
+      c.mPacketStack.push_back({ &mNodes[mRoot], packet.mActive });
+      while(!c.mPacketStack.empty()) {
+        const AABBNode& curNode = *c.mPacketStack.back().first;
+        int hits = packet.intersect(curNode.mAABB, c.mPacketStack.back().second);
+        c.mPacketStack.pop_back();
+        if(!hits)
+          continue;
+
+        if(curNode.isLeaf()) {
+          for(size_t i = 0; i < count; ++i)
+            if(hits & (1 << i))
+              results[i].push_back(ResultNode(curNode.mLeafData.mHandle, curNode.mLeafData.mUserdata));
+        }
+        else {
+          c.mPacketStack.push_back({ &mNodes[curNode.mRight], hits });
+          c.mPacketStack.push_back({ &mNodes[curNode.mLeft], hits });
+        }
+      }
+    }
+
     void draw(void) {
       DebugDrawer::get().setColor(0.0f, 0.0f, 1.0f);
       if(mRoot != AABBNode::Null)
@@ -268,6 +408,10 @@ namespace Syx {
       _drawHelper(mRoot);
     }
 
+    int getType() const {
+      return BroadphaseType::AABBTree;
+    }
+
     std::unique_ptr<BroadphaseContext> createHitContext() const {
       return std::make_unique<AABBSingleContext>(*this, std::weak_ptr<bool>(mExistenceTracker));
     }
@@ -280,14 +424,15 @@ namespace Syx {
     inline const AABBNode& _getNode(Handle handle) const { return mNodes[handle]; }
     inline AABBNode& _getNode(Handle handle) { return mNodes[handle]; }
 
-    void _insertNode(AABBNode& newNode, Handle newIndex) {
+    void _insertNode(Handle newIndex) {
       if(mRoot == AABBNode::Null) {
-        newNode.mParent = AABBNode::Null;
+        mNodes[newIndex].mParent = AABBNode::Null;
         mRoot = newIndex;
         return;
       }
 
-      AABB& newBox = newNode.mAABB;
+      //Copied since creating the new parent below can grow mNodes
+      const AABB newBox = mNodes[newIndex].mAABB;
 
       //Find best sibling to pair aabb with based on surface area heuristic
       Handle curIndex = mRoot;
@@ -344,12 +489,178 @@ namespace Syx {
       mNodes[newParent].mLeft = sibling;
       mNodes[newParent].mRight = newIndex;
       mNodes[sibling].mParent = newParent;
-      newNode.mParent = newParent;
+      mNodes[newIndex].mParent = newParent;
 
       //Balances and updates aabbs of all parents
       _syncParents(newParent);
     }
 
+    AABB _getFatAABB(const BoundingVolume& volume) const {
+      Vec3 min = volume.mAABB.getMin() - Vec3(mConfig.mMargin);
+      Vec3 max = volume.mAABB.getMax() + Vec3(mConfig.mMargin);
+      //Stretch in the direction of movement so the object stays inside for the next few updates
+      const Vec3 displacement = volume.mDisplacement*mConfig.mDisplacementScale;
+      for(int i = 0; i < 3; ++i) {
+        if(displacement[i] < 0.0f)
+          min[i] += displacement[i];
+        else
+          max[i] += displacement[i];
+      }
+      return AABB(min, max);
+    }
+
+    bool _shouldReinsert(const AABBNode& leaf, const BoundingVolume& newVol) const {
+      if(!leaf.mAABB.isInside(newVol.mAABB))
+        return true;
+      if(mConfig.mMargin <= 0.0f)
+        return false;
+      //Still inside, but shrink the leaf if it's far bigger than it needs to be, like after a fast object slows down
+      AABB largest = _getFatAABB(newVol);
+      const Vec3 excess(sMaxExcessMargins*mConfig.mMargin);
+      largest.setMin(largest.getMin() - excess);
+      largest.setMax(largest.getMax() + excess);
+      return !largest.isInside(leaf.mAABB);
+    }
+
+    //Every pair is reported as removed then added again since all handles may have changed
+    void _rebuildPairs(AABBPairContext& c) const {
+      c.mRemovedPairs.swap(c.mQueryPairResults);
+      c.mPairIndices.clear();
+      for(std::vector<Handle>& partners : c.mPartners)
+        partners.clear();
+
+      _queryAllPairs(c);
+      for(size_t i = 0; i < c.mQueryPairResults.size(); ++i) {
+        const std::pair<ResultNode, ResultNode>& pair = c.mQueryPairResults[i];
+        c.mPairIndices[{std::min(pair.first.mHandle, pair.second.mHandle), std::max(pair.first.mHandle, pair.second.mHandle)}] = i;
+        c.mPartners[pair.first.mHandle].push_back(pair.second.mHandle);
+        c.mPartners[pair.second.mHandle].push_back(pair.first.mHandle);
+      }
+      c.mAddedPairs = c.mQueryPairResults;
+      c.mMovesConsumed = mMovesDiscarded + mMoveLog.size();
+    }
+
+    //Finds all overlapping pairs by traversing the whole tree
+    void _queryAllPairs(AABBTreeContext& c) const {
+      c.mQueryPairResults.clear();
+      if(mRoot == AABBNode::Null || mNodes[mRoot].isLeaf())
+        return;
+
+      c.mTraversed.clear();
+      _pushToEval(mNodes[mRoot].mLeft, mNodes[mRoot].mRight, c);
+
+      while(!_evalEmpty(c)) {
+        std::pair<const AABBNode*, const AABBNode*> pair = _popFromEval(c);
+        if(pair.first->isLeaf()) {
+          if(pair.second->isLeaf())
+            _checkBounds(*pair.first, *pair.second, c);
+          else
+            _leafBranchCase(*pair.first, *pair.second, c);
+        }
+        else if(pair.second->isLeaf())
+          _leafBranchCase(*pair.second, *pair.first, c);
+        else {
+          _traverseChild(*pair.first, c);
+          _traverseChild(*pair.second, c);
+          _pushToEval(pair.first->mLeft, pair.second->mLeft, c);
+          _pushToEval(pair.first->mLeft, pair.second->mRight, c);
+          _pushToEval(pair.first->mRight, pair.second->mLeft, c);
+          _pushToEval(pair.first->mRight, pair.second->mRight, c);
+        }
+      }
+    }
+
+    //Remove leaf from the hierarchy, replacing its parent with its sibling, without freeing the leaf itself
+    void _detachLeaf(Handle toRemove) {
+      Handle parent = mNodes[toRemove].mParent;
+      if(parent == AABBNode::Null) {
+        mRoot = AABBNode::Null;
+        return;
+      }
+
+      Handle grandParent = mNodes[parent].mParent;
+
+      //Get sibling
+      Handle sibling = mNodes[parent].mLeft;
+      if(sibling == toRemove)
+        sibling = mNodes[parent].mRight;
+
+      //Connect sibling to grandparent
+      mNodes[sibling].mParent = grandParent;
+      if(grandParent == AABBNode::Null) {
+        mRoot = sibling;
+        _freeNode(parent);
+        return;
+      }
+      else if(mNodes[grandParent].mLeft == parent)
+        mNodes[grandParent].mLeft = sibling;
+      else
+        mNodes[grandParent].mRight = sibling;
+
+      //Kill disconnected parent
+      _freeNode(parent);
+
+      _syncParents(grandParent);
+    }
+
+    void _logMove(Handle handle, bool removed) {
+      //Discard the older half once the log gets big. Contexts that hadn't seen those moves will rebuild
+      const size_t maxSize = std::max(sMinMoveLogSize, mNodes.size());
+      if(mMoveLog.size() >= maxSize) {
+        const size_t toDiscard = mMoveLog.size()/2;
+        mMoveLog.erase(mMoveLog.begin(), mMoveLog.begin() + toDiscard);
+        mMovesDiscarded += toDiscard;
+      }
+      mMoveLog.push_back(AABBMove(handle, removed));
+    }
+
+    void _markMoved(Handle handle, bool removed, AABBPairContext& c) const {
+      char& state = c.mMoveState[handle];
+      if(!state)
+        c.mMoved.push_back(handle);
+      //1 for moved, 2 for removed, which takes priority since all old pairs need to go
+      state = std::max(state, static_cast<char>(removed ? 2 : 1));
+    }
+
+    void _updateLeafPairs(Handle handle, AABBPairContext& c) const {
+      c.mOverlaps.clear();
+      const AABBNode& node = mNodes[handle];
+      const bool isLive = !node.isFree() && node.isLeaf();
+      if(isLive)
+        _getOverlappingLeaves(mRoot, node, c.mOverlaps);
+
+      //Drop old pairs that no longer overlap. All of them if the handle was removed, since it may be a different leaf now
+      std::vector<Handle>& partners = c.mPartners[handle];
+      for(size_t i = 0; i < partners.size();) {
+        Handle partner = partners[i];
+        if(c.mMoveState[handle] == 2 || std::find(c.mOverlaps.begin(), c.mOverlaps.end(), partner) == c.mOverlaps.end())
+          c.removePair(handle, partner);
+        else
+          ++i;
+      }
+
+      for(Handle other : c.mOverlaps) {
+        if(!c.hasPair(handle, other)) {
+          const AABBNode& otherNode = mNodes[other];
+          c.addPair(node.mLeafData, otherNode.mLeafData);
+        }
+      }
+    }
+
+    void _getOverlappingLeaves(Handle curNode, const AABBNode& leaf, std::vector<Handle>& results) const {
+      if(curNode == AABBNode::Null)
+        return;
+      const AABBNode& node = _getNode(curNode);
+      if(&node == &leaf || !node.mAABB.overlapping(leaf.mAABB))
+        return;
+      if(node.isLeaf())
+        results.push_back(curNode);
+      else {
+        _getOverlappingLeaves(node.mLeft, leaf, results);
+        _getOverlappingLeaves(node.mRight, leaf, results);
+      }
+    }
+
     void _checkBounds(const AABBNode& nodeA, const AABBNode& nodeB, AABBTreeContext& context) const {
       if(nodeA.mAABB.overlapping(nodeB.mAABB)) {
         ResultNode resultA(nodeA.mLeafData.mHandle, nodeA.mLeafData.mUserdata);
@@ -566,7 +877,7 @@ namespace Syx {
     }
 
     //Returns cost of traversing down to "traversal" while inserting "insertBox"
-    float _traversalCost(AABBNode& traversal, AABB& insertBox) const {
+    float _traversalCost(AABBNode& traversal, const AABB& insertBox) const {
       float result;
       AABB combined = AABB::combined(insertBox, traversal.mAABB);
       float combinedArea = combined.getSurfaceArea();
@@ -579,10 +890,15 @@ namespace Syx {
       return result;
     }
 
+    AABBTreeConfig mConfig;
     Handle mRoot;
     Handle mFreeList;
     std::vector<AABBNode> mNodes;
     std::shared_ptr<bool> mExistenceTracker;
+    //Leaves changed since the oldest move any pair context may still need
+    std::vector<AABBMove> mMoveLog;
+    //Number of moves dropped from the front of mMoveLog over the tree's lifetime
+    size_t mMovesDiscarded = 0;
   };
 
   void AABBSingleContext::queryRaycast(const Vec3& start, const Vec3& end) {
@@ -594,6 +910,26 @@ namespace Syx {
     }
   }
 
+  void AABBSingleContext::queryRaycastPacket(const Vec3* starts, const Vec3* ends, size_t count) {
+    if(auto e = mExistenceTracker.lock()) {
+      mBroadphase.queryRaycastPacket(starts, ends, count, *this, mPacketResults);
+    }
+    else {
+      for(size_t i = 0; i < count; ++i)
+        mPacketResults[i].clear();
+    }
+  }
+
+  void AABBSingleContext::queryTree(const Broadphase& other, const Transformer& otherToThis) {
+    SyxAssertError(other.getType() == BroadphaseType::AABBTree, "Tree queries are only supported between trees");
+    if(auto e = mExistenceTracker.lock()) {
+      mBroadphase.queryTree(static_cast<const AABBTree&>(other), otherToThis, *this, mTreePairs);
+    }
+    else {
+      mTreePairs.clear();
+    }
+  }
+
   void AABBSingleContext::queryVolume(const BoundingVolume& volume) {
     if(auto e = mExistenceTracker.lock()) {
       mBroadphase.queryVolume(volume, *this);
@@ -608,13 +944,56 @@ namespace Syx {
       mBroadphase.queryPairs(*this);
     }
     else {
-      mQueryPairResults.clear();
+      clearPairs();
     }
   }
 
+  void AABBPairContext::addPair(const ResultNode& a, const ResultNode& b) {
+    mPairIndices[{std::min(a.mHandle, b.mHandle), std::max(a.mHandle, b.mHandle)}] = mQueryPairResults.size();
+    mQueryPairResults.push_back({a, b});
+    mPartners[a.mHandle].push_back(b.mHandle);
+    mPartners[b.mHandle].push_back(a.mHandle);
+    mAddedPairs.push_back({a, b});
+  }
+
+  void AABBPairContext::removePair(Handle a, Handle b) {
+    auto it = mPairIndices.find({std::min(a, b), std::max(a, b)});
+    if(it == mPairIndices.end())
+      return;
+
+    //Swap the last pair into the removed slot so the list stays packed
+    const size_t index = it->second;
+    mPairIndices.erase(it);
+    mRemovedPairs.push_back(mQueryPairResults[index]);
+    if(index + 1 != mQueryPairResults.size()) {
+      mQueryPairResults[index] = mQueryPairResults.back();
+      const std::pair<ResultNode, ResultNode>& moved = mQueryPairResults[index];
+      mPairIndices[{std::min(moved.first.mHandle, moved.second.mHandle), std::max(moved.first.mHandle, moved.second.mHandle)}] = index;
+    }
+    mQueryPairResults.pop_back();
+
+    std::vector<Handle>& partnersA = mPartners[a];
+    std::vector<Handle>& partnersB = mPartners[b];
+    swapRemove(partnersA, static_cast<int>(std::find(partnersA.begin(), partnersA.end(), b) - partnersA.begin()));
+    swapRemove(partnersB, static_cast<int>(std::find(partnersB.begin(), partnersB.end(), a) - partnersB.begin()));
+  }
+
+  bool AABBPairContext::hasPair(Handle a, Handle b) const {
+    return mPairIndices.find({std::min(a, b), std::max(a, b)}) != mPairIndices.end();
+  }
+
+  void AABBPairContext::clearPairs() {
+    mQueryPairResults.clear();
+    mAddedPairs.clear();
+    mRemovedPairs.clear();
+    mPairIndices.clear();
+    mPartners.clear();
+    mMovesConsumed = 0;
+  }
+
   namespace Create {
-    std::unique_ptr<Broadphase> aabbTree() {
-      return std::make_unique<AABBTree>();
+    std::unique_ptr<Broadphase> aabbTree(const AABBTreeConfig& config) {
+      return std::make_unique<AABBTree>(config);
     }
   }
 }
\ No newline at end of file
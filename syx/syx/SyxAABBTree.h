@@ -2,7 +2,20 @@
 #include "SyxBroadphase.h"
 
 namespace Syx {
+  //Leaves are stored with enlarged volumes so they only need to be reinserted once the object escapes them
+  struct AABBTreeConfig {
+    AABBTreeConfig(float margin = 0.1f, float displacementScale = 2.0f)
+      : mMargin(margin)
+      , mDisplacementScale(displacementScale) {
+    }
+
+    //Distance added to every side of a leaf's volume
+    float mMargin;
+    //Leaf volumes are stretched along BoundingVolume::mDisplacement scaled by this
+    float mDisplacementScale;
+  };
+
   namespace Create {
-    std::unique_ptr<Broadphase> aabbTree();
+    std::unique_ptr<Broadphase> aabbTree(const AABBTreeConfig& config = AABBTreeConfig());
   }
 }
@@ -39,11 +39,12 @@ namespace Syx {
     }
 
     inline pointer allocate(size_type n) {
-      return (pointer)_aligned_malloc(n*sizeof(value_type), N);
+      //Aligned operator new rather than _aligned_malloc so replacements of it see these allocations too
+      return (pointer)::operator new(n*sizeof(value_type), std::align_val_t(N));
     }
 
     inline void deallocate(pointer p, size_type) {
-      _aligned_free(p);
+      ::operator delete(p, std::align_val_t(N));
     }
 
     inline void construct(pointer p, const value_type& wert) {
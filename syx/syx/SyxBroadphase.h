@@ -2,14 +2,34 @@
 #include "SyxSmallIndexSet.h"
 
 namespace Syx {
+  struct Transformer;
+  class Broadphase;
+
+  namespace BroadphaseType {
+    enum {
+      AABBTree,
+      SweepAndPrune,
+      //Types above can be used for spaces
+      Count,
+      //Can only be built statically, used for environment models
+      QuantizedBVH
+    };
+  }
+
   //Always use this as parameters to give the possibility of trying different volumes
   struct BoundingVolume {
     BoundingVolume() {}
     BoundingVolume(const AABB& aabb)
       : mAABB(aabb) {
     }
+    BoundingVolume(const AABB& aabb, const Vec3& displacement)
+      : mAABB(aabb)
+      , mDisplacement(displacement) {
+    }
 
     AABB mAABB;
+    //How far the volume is expected to move before the next update, for broadphases that enlarge volumes in anticipation
+    Vec3 mDisplacement;
   };
 
   //Result given from queries
@@ -36,21 +56,58 @@ namespace Syx {
 
   class BroadphaseContext {
   public:
+    //Most rays queryRaycastPacket takes at once
+    static const size_t sPacketSize = 4;
+
     virtual ~BroadphaseContext() = default;
     virtual const std::vector<ResultNode>& get() const = 0;
     virtual void queryRaycast(const Vec3& start, const Vec3& end) = 0;
     virtual void queryVolume(const BoundingVolume& volume) = 0;
+
+    //Raycasts up to sPacketSize lines at once, results for each are retrieved with getPacket
+    virtual void queryRaycastPacket(const Vec3* starts, const Vec3* ends, size_t count) {
+      //Up to derived classes to do something clever
+      for(size_t i = 0; i < count; ++i) {
+        queryRaycast(starts[i], ends[i]);
+        mPacketResults[i] = get();
+      }
+    }
+
+    const std::vector<ResultNode>& getPacket(size_t ray) const {
+      return mPacketResults[ray];
+    }
+
+    //Finds overlapping leaves between this context's broadphase and other, where otherToThis takes other's volumes into this one's space.
+    //First of each pair is from this broadphase. Only supported between trees
+    virtual void queryTree(const Broadphase& /*other*/, const Transformer& /*otherToThis*/) {
+      SyxAssertError(false, "Broadphase doesn't support tree queries");
+      mTreePairs.clear();
+    }
+
+    const std::vector<std::pair<ResultNode, ResultNode>>& getTreePairs() const {
+      return mTreePairs;
+    }
+
+  protected:
+    std::vector<ResultNode> mPacketResults[sPacketSize];
+    std::vector<std::pair<ResultNode, ResultNode>> mTreePairs;
   };
 
   class BroadphasePairContext {
   public:
     virtual ~BroadphasePairContext() = default;
+    //All overlapping pairs as of the last query
     virtual const std::vector<std::pair<ResultNode, ResultNode>>& get() const = 0;
+    //Pairs that started or stopped overlapping during the last query
+    virtual const std::vector<std::pair<ResultNode, ResultNode>>& getAdded() const = 0;
+    virtual const std::vector<std::pair<ResultNode, ResultNode>>& getRemoved() const = 0;
     virtual void queryPairs() = 0;
   };
 
   class Broadphase {
   public:
+    virtual ~Broadphase() = default;
+
     //Builds a broadphase optimized for being static. Handles provided if a container is given, but likely aren't needed since nodes are static
     virtual void buildStatic(const std::vector<InsertParam>& nodes, std::vector<Handle>* resultHandles = nullptr) {
       //Up to derived classes to do something clever
@@ -67,6 +124,8 @@ namespace Syx {
 
     virtual void draw() {}
     virtual Handle update(const BoundingVolume& newVol, Handle handle) = 0;
+    //One of BroadphaseType
+    virtual int getType() const = 0;
 
     virtual std::unique_ptr<BroadphaseContext> createHitContext() const = 0;
     virtual std::unique_ptr<BroadphasePairContext> createPairContext() const = 0;
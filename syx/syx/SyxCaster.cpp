@@ -3,8 +3,72 @@
 #include "SyxPhysicsObject.h"
 #include "SyxModel.h"
 #include "SyxSimplex.h"
+#include "SyxBroadphase.h"
 
 namespace Syx {
+  namespace {
+    //Casts the line from start to end against the convex shape given by support, a function taking a direction and returning the
+    //furthest point on the shape in that direction. insidePoint is any point in the shape, used to pick the first search direction.
+    //Returns the fraction along the line where it hit or a negative number if it missed, and the surface normal in normal
+    template<typename Support>
+    float castSupport(const Support& support, const Vec3& start, const Vec3& end, const Vec3& insidePoint, Vec3& normal) {
+      normal = Vec3::Zero;
+      Vec3 rayDir = end - start;
+      Vec3 curSearchDir = start - insidePoint;
+      if(curSearchDir == Vec3::Zero)
+        curSearchDir = -rayDir;
+      SupportPoint curSupport;
+      Simplex simplex;
+      //A safeguard against infinite loops. Shouldn't happen, but just in case
+      unsigned iteration = 0;
+      float lowerBound = 0.0f;
+
+      while(iteration++ < 20) {
+        Vec3 lowerBoundPoint = Vec3::lerp(start, end, lowerBound);
+
+        //Support is in CSO, this is just on the collider
+        Vec3 supportOnC = support(curSearchDir);
+        curSupport.mPointB = supportOnC;
+        curSupport.mSupport = lowerBoundPoint - supportOnC;
+
+        float searchDotSupport = curSearchDir.dot(curSupport.mSupport);
+        float searchDotRay = curSearchDir.dot(rayDir);
+
+        if(searchDotSupport > 0.0f) {
+          if(searchDotRay >= 0.0)
+            return -1.0f;
+
+          lowerBound -= searchDotSupport/searchDotRay;
+          if(lowerBound > 1.0f)
+            return -1.0f;
+          normal = curSearchDir;
+          Vec3 newLowerBoundPoint = Vec3::lerp(start, end, lowerBound);
+
+          //Lower bound updated, translate support points along ray
+          for(unsigned i = 0; i < simplex.size(); ++i) {
+            SupportPoint& point = simplex.getSupport(i);
+            point.mSupport = newLowerBoundPoint - point.mPointB;
+          }
+          curSupport.mSupport = newLowerBoundPoint - curSupport.mPointB;
+        }
+
+        //Add to simplex and evaluate it, removing points in the wrong direction and finding new search direction
+        simplex.add(curSupport, true);
+        //Solve returns vector from closest point to origin, so subtract origin back off
+        Vec3 closestToOrigin = -simplex.solve();
+
+        //Simplex contains origin, hit found
+        if(simplex.containsOrigin() || simplex.isDegenerate())
+          break;
+
+        curSearchDir = closestToOrigin;
+      }
+      return lowerBound;
+    }
+  }
+
+  float Caster::sSweepCoreScale = 0.5f;
+
   void CasterContext::sortResults(void) {
     std::sort(mResults.begin(), mResults.end());
   }
@@ -34,55 +98,10 @@ namespace Syx {
 
   void Caster::_lineCastGJK(const Model& model, const Transformer& toWorld, const Vec3& start, const Vec3& end, CasterContext& context) const {
     SAlign Vec3 curNormal;
-    Vec3 rayDir = end - start;
-    //start - Arbitrary point in object. Support towards the start of the ray
-    Vec3 curSearchDir = start - model.getSupport(start);
-    SupportPoint curSupport;
-    Simplex simplex;
-    //A safeguard against infinite loops. Shouldn't happen, but just in case
-    unsigned iteration = 0;
-    float lowerBound = 0.0f;
-
-    while(iteration++ < 20) {
-      Vec3 lowerBoundPoint = Vec3::lerp(start, end, lowerBound);
-
-      //Support is in CSO, this is just on the collider
-      Vec3 supportOnC = model.getSupport(curSearchDir);
-      curSupport.mPointB = supportOnC;
-      curSupport.mSupport = lowerBoundPoint - supportOnC;
-
-      float searchDotSupport = curSearchDir.dot(curSupport.mSupport);
-      float searchDotRay = curSearchDir.dot(rayDir);
-
-      if(searchDotSupport > 0.0f) {
-        if(searchDotRay >= 0.0)
-          return;
-
-        lowerBound -= searchDotSupport/searchDotRay;
-        if(lowerBound > 1.0f)
-          return;
-        curNormal = curSearchDir;
-        Vec3 newLowerBoundPoint = Vec3::lerp(start, end, lowerBound);
-
-        //Lower bound updated, translate support points along ray
-        for(unsigned i = 0; i < simplex.size(); ++i) {
-          SupportPoint& support = simplex.getSupport(i);
-          support.mSupport = newLowerBoundPoint - support.mPointB;
-        }
-        curSupport.mSupport = newLowerBoundPoint - curSupport.mPointB;
-      }
-
-      //Add to simplex and evaluate it, removing points in the wrong direction and finding new search direction
-      simplex.add(curSupport, true);
-      //Solve returns vector from closest point to origin, so subtract origin back off
-      Vec3 closestToOrigin = -simplex.solve();
-
-      //Simplex contains origin, hit found
-      if(simplex.containsOrigin() || simplex.isDegenerate())
-        break;
-
-      curSearchDir = closestToOrigin;
-    }
+    //Support towards the start of the ray as an arbitrary point in the object
+    float lowerBound = castSupport([&model](const Vec3& dir) { return model.getSupport(dir); }, start, end, model.getSupport(start), curNormal);
+    if(lowerBound < 0.0f)
+      return;
 
     SAlign Vec3 localPoint = Vec3::lerp(start, end, lowerBound);
     Vec3 worldPoint = toWorld.transformPoint(localPoint);
@@ -119,9 +138,20 @@ namespace Syx {
     }
   }
 
+  BroadphaseContext& Caster::_getEnvironmentContext(const Broadphase& broadphase, CasterContext& context) const {
+    if(context.mEnvironmentBroadphase != &broadphase) {
+      context.mEnvironmentBroadphase = &broadphase;
+      context.mEnvironmentContext = broadphase.createHitContext();
+    }
+    return *context.mEnvironmentContext;
+  }
+
   void Caster::_lineCastEnvironment(const Model& model, const Transformer& toWorld, const Vec3& start, const Vec3& end, CasterContext& context) const {
     const auto& tris = model.getTriangles();
-    for(size_t i = 0; i + 2 < tris.size(); i += 3) {
+    BroadphaseContext& candidates = _getEnvironmentContext(model.getBroadphase(), context);
+    candidates.queryRaycast(start, end);
+    for(const ResultNode& candidate : candidates.get()) {
+      size_t i = reinterpret_cast<size_t>(candidate.mUserdata);
       const Vec3& a = tris[i];
       const Vec3& b = tris[i + 1];
       const Vec3& c = tris[i + 2];
@@ -141,4 +171,121 @@ namespace Syx {
       context.pushResult(result);
     }
   }
+
+  Caster::SweepShape::SweepShape(ModelInstance& inst)
+    : mInst(inst)
+    //Models are centered around their origin, so it's a point inside them
+    , mCenter(inst.getModelToWorld().transformPoint(Vec3::Zero))
+    , mCoreRadius(std::numeric_limits<float>::max()) {
+    //Half widths along the model's axes, the smallest of which fits inside primitives whatever their rotation
+    for(int i = 0; i < 3; ++i) {
+      SAlign Vec3 localAxis = Vec3::Zero;
+      localAxis[i] = 1.0f;
+      Vec3 axis = inst.getModelToWorld().transformVector(localAxis).normalized();
+      mCoreRadius = std::min(mCoreRadius, (inst.getSupport(axis) - mCenter).dot(axis));
+    }
+    mCoreRadius = std::max(0.0f, mCoreRadius*sSweepCoreScale);
+  }
+
+  void Caster::sweep(PhysicsObject& obj, const Vec3& displacement, PhysicsObject& other, float margin, CasterContext& context) const {
+    Collider* collider = obj.getCollider();
+    Collider* otherCollider = other.getCollider();
+    if(!collider || !otherCollider)
+      return;
+
+    ModelInstance& inst = collider->getModelInstance();
+    ModelInstance& otherInst = otherCollider->getModelInstance();
+    const AABB& bounds = collider->getAABB();
+    AABB sweptBounds = AABB::combined(bounds, AABB(bounds.getMin() + displacement, bounds.getMax() + displacement));
+    context.mWorldStart = &obj.getTransform().mPos;
+    context.mWorldEnd = nullptr;
+    context.mCurObj = &other;
+
+    switch(inst.getModelType()) {
+      //Environments don't move
+      case ModelType::Environment: break;
+      case ModelType::Composite: {
+        //Pieces are swept separately but all from the same starting position, so their results compare directly
+        const auto& submodels = inst.getModel().getSubmodelInstances();
+        for(size_t i = 0; i < submodels.size(); ++i) {
+          ModelInstance subInst = ModelInstance::combined(inst, submodels[i], submodels[i], inst.getSubmodelInstHandle(i));
+          _sweepInstance(SweepShape(subInst), displacement, otherInst, sweptBounds, margin, context);
+        }
+        break;
+      }
+      default: _sweepInstance(SweepShape(inst), displacement, otherInst, sweptBounds, margin, context); break;
+    }
+  }
+
+  template<typename Support>
+  void Caster::_sweepGJK(const SweepShape& shape, const Support& support, const Vec3& center, const Vec3& displacement, float margin, CasterContext& context) const {
+    //Moving the shape along displacement first touches the other where the line from the origin along displacement enters other - shape
+    ModelInstance& inst = shape.mInst;
+    auto difference = [&inst, &support](const Vec3& dir) { return support(dir) - inst.getSupport(-dir); };
+    SAlign Vec3 normal;
+    const float length = displacement.length();
+    float t = castSupport(difference, Vec3::Zero, displacement, center - shape.mCenter, normal);
+    if(t > 0.0f)
+      t += margin/length;
+    else if(t == 0.0f) {
+      //Already touching, which contacts deal with unless they fail to stop it. Sweep the core so it can't sink much further than that
+      const Vec3& coreCenter = shape.mCenter;
+      const float coreRadius = shape.mCoreRadius;
+      auto coreDifference = [&support, &coreCenter, coreRadius](const Vec3& dir) {
+        return support(dir) - (coreCenter - dir.safeNormalized()*coreRadius);
+      };
+      t = castSupport(coreDifference, Vec3::Zero, displacement, center - shape.mCenter, normal);
+      if(t == 0.0f)
+        return;
+      t = std::max(0.0f, t - margin/length);
+    }
+    if(t < 0.0f || t >= 1.0f)
+      return;
+
+    Vec3 offset = displacement*t;
+    context.pushResult(CastResult(context.mCurObj->getHandle(), *context.mWorldStart + offset, normal.normalized(), offset.length2()));
+  }
+
+  void Caster::_sweepInstance(const SweepShape& shape, const Vec3& displacement, ModelInstance& other, const AABB& sweptBounds, float margin, CasterContext& context) const {
+    switch(other.getModelType()) {
+      case ModelType::Environment: _sweepEnvironment(shape, displacement, other, sweptBounds, margin, context); break;
+      case ModelType::Composite: {
+        const auto& submodels = other.getModel().getSubmodelInstances();
+        for(size_t i = 0; i < submodels.size(); ++i) {
+          if(!submodels[i].getAABB().transform(other.getModelToWorld()).overlapping(sweptBounds))
+            continue;
+          ModelInstance subInst = ModelInstance::combined(other, submodels[i], submodels[i], other.getSubmodelInstHandle(i));
+          const Vec3 subCenter = subInst.getModelToWorld().transformPoint(Vec3::Zero);
+          _sweepGJK(shape, [&subInst](const Vec3& dir) { return subInst.getSupport(dir); }, subCenter, displacement, margin, context);
+        }
+        break;
+      }
+      default: {
+        const Vec3 otherCenter = other.getModelToWorld().transformPoint(Vec3::Zero);
+        _sweepGJK(shape, [&other](const Vec3& dir) { return other.getSupport(dir); }, otherCenter, displacement, margin, context);
+        break;
+      }
+    }
+  }
+
+  void Caster::_sweepEnvironment(const SweepShape& shape, const Vec3& displacement, ModelInstance& env, const AABB& sweptBounds, float margin, CasterContext& context) const {
+    BroadphaseContext& candidates = _getEnvironmentContext(env.getModel().getBroadphase(), context);
+    candidates.queryVolume(sweptBounds.transform(env.getWorldToModel()));
+
+    const Vec3Vec& tris = env.getModel().getTriangles();
+    const Transformer& toWorld = env.getModelToWorld();
+    for(const ResultNode& result : candidates.get()) {
+      size_t triIndex = reinterpret_cast<size_t>(result.mUserdata);
+      const Vec3 tri[3] = { toWorld.transformPoint(tris[triIndex]), toWorld.transformPoint(tris[triIndex + 1]), toWorld.transformPoint(tris[triIndex + 2]) };
+      auto triSupport = [&tri](const Vec3& dir) {
+        float a = dir.dot(tri[0]);
+        float b = dir.dot(tri[1]);
+        float c = dir.dot(tri[2]);
+        if(a >= b && a >= c)
+          return tri[0];
+        return b >= c ? tri[1] : tri[2];
+      };
+      _sweepGJK(shape, triSupport, (tri[0] + tri[1] + tri[2])*(1.0f/3.0f), displacement, margin, context);
+    }
+  }
 }
\ No newline at end of file
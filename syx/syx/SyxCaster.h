@@ -3,34 +3,75 @@
 namespace Syx {
   class PhysicsObject;
   class ModelInstance;
+  class Broadphase;
+  class BroadphaseContext;
+  struct AABB;
   struct Transformer;
   class Model;
   struct Vec3;
 
+  namespace CastMode {
+    enum {
+      //The hit nearest the start of the line
+      Closest,
+      //The first hit found, for when only whether there was a hit matters
+      Any
+    };
+  }
+
   class CasterContext {
   public:
     const std::vector<CastResult>& getResults(void) { return mResults; }
     void pushResult(const CastResult& result) { mResults.push_back(result); }
     void clearResults(void) { mResults.clear(); }
+    void clearEnvironment(void) { mEnvironmentContext.reset(); mEnvironmentBroadphase = nullptr; }
     void sortResults(void);
 
     const Vec3* mWorldStart;
     const Vec3* mWorldEnd;
     PhysicsObject* mCurObj;
+    //Query context for the environment last cast or swept against, kept so casts don't create one each time
+    std::unique_ptr<BroadphaseContext> mEnvironmentContext;
+    const Broadphase* mEnvironmentBroadphase = nullptr;
   private:
     std::vector<CastResult> mResults;
   };
 
   class Caster {
   public:
+    //Radius of the core swept instead of the full shape when a sweep starts out touching, relative to the shape's smallest half width
+    static float sSweepCoreScale;
+
     void lineCast(PhysicsObject& obj, const Vec3& start, const Vec3& end, CasterContext& context) const;
+    //Moves obj's shape along displacement without rotating it and adds a result if it touches other on the way.
+    //The result's point is where obj's position can go, which is margin past the first touch so contacts are found there.
+    //If it starts out touching, a sphere in its core is swept instead and stops margin short of touching so it never sinks further in.
+    //The normal points from other towards obj
+    void sweep(PhysicsObject& obj, const Vec3& displacement, PhysicsObject& other, float margin, CasterContext& context) const;
 
   private:
+    //A piece of the swept object
+    struct SweepShape {
+      SweepShape(ModelInstance& inst);
+
+      ModelInstance& mInst;
+      Vec3 mCenter;
+      float mCoreRadius;
+    };
+
     // Model space raycast, then toWorld is used to put the final results in world space
     void _lineCastGJK(const Model& model, const Transformer& toWorld, const Vec3& start, const Vec3& end, CasterContext& context) const;
     void _lineCastCube(const Model& model, const Transformer& toWorld, const Vec3& start, const Vec3& end, CasterContext& context) const;
     void _lineCastLocal(const Model& model, const Transformer& toWorld, const Vec3& start, const Vec3& end, CasterContext& context) const;
     void _lineCastComposite(const Model& model, const Transformer& toWorld, const Vec3& start, const Vec3& end, CasterContext& context) const;
+    //Cached in the context since the same environment is usually tested repeatedly
+    BroadphaseContext& _getEnvironmentContext(const Broadphase& broadphase, CasterContext& context) const;
     void _lineCastEnvironment(const Model& model, const Transformer& toWorld, const Vec3& start, const Vec3& end, CasterContext& context) const;
+
+    void _sweepInstance(const SweepShape& shape, const Vec3& displacement, ModelInstance& other, const AABB& sweptBounds, float margin, CasterContext& context) const;
+    void _sweepEnvironment(const SweepShape& shape, const Vec3& displacement, ModelInstance& env, const AABB& sweptBounds, float margin, CasterContext& context) const;
+    //Sweep shape against the convex shape given by its world space support function and a point inside it
+    template<typename Support>
+    void _sweepGJK(const SweepShape& shape, const Support& support, const Vec3& center, const Vec3& displacement, float margin, CasterContext& context) const;
   };
 }
\ No newline at end of file
@@ -4,10 +4,10 @@
 #include "SyxPhysicsSystem.h"
 
 namespace Syx {
-  const float LocalConstraint::sVelBaumgarteTerm = 0.1f/PhysicsSystem::sSimRate;
+  const float LocalConstraint::sBaumgarteTerm = 0.1f;
   const float LocalConstraint::sMaxVelCorrection = 10.0f;
 
-  float Constraint::sDT;
+  thread_local float Constraint::sDT;
 
   LocalObject::LocalObject()
     : mOwner(nullptr) {}
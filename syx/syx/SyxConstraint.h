@@ -72,8 +72,8 @@ namespace Syx {
   class Constraint {
   public:
 
-    // Updated by solve loop and static for easy access wherever it's needed
-    static float sDT;
+    // Set by the island solver on the thread solving it, static for easy access wherever it's needed
+    static thread_local float sDT;
 
     Constraint(ConstraintType type, PhysicsObject* a = nullptr, PhysicsObject* b = nullptr, Handle handle = SyxInvalidHandle)
       : mA(a)
@@ -136,9 +136,15 @@ namespace Syx {
       EnforceNeg
     };
 
-    static const float sVelBaumgarteTerm;
+    //Fraction of the position error corrected each step
+    static const float sBaumgarteTerm;
     static const float sMaxVelCorrection;
 
+    //Velocity bias per unit of position error for the step being solved on this thread, which depends on the space's timestep and substeps
+    static float getVelBaumgarteTerm() {
+      return sBaumgarteTerm/Constraint::sDT;
+    }
+
     LocalConstraint()
       : mA(nullptr)
       , mB(nullptr)
@@ -1,61 +1,134 @@
 #include "Precompile.h"
 #include "SyxConstraintSystem.h"
+#include "SyxRigidbodyStore.h"
 
 namespace Syx {
   int ConstraintSystem::sIterations = 10;
   float ConstraintSystem::sEarlyOutThreshold = 0.00001f;
+  size_t ConstraintSystem::sMinParallelConstraints = 64;
 
   void ConstraintSystem::solve(float dt) {
-    _createSolvers();
-    for(size_t i = 0; i < mSolverCount; ++i) {
-      IslandSolver& solver = mSolvers[i];
-      solver.solve(dt);
-      for(Constraint* toRemove : solver.getToRemove())
-        _removeContact(*static_cast<ContactConstraint*>(toRemove));
-      mIslandGraph->updateIslandState(solver.getIslandKey(), solver.getNewIslandState(), dt);
-    }
+    _solve(dt, false);
   }
 
   void ConstraintSystem::sSolve(float dt) {
-    _createSolvers();
+    _solve(dt, true);
+  }
+
+  void ConstraintSystem::_solve(float dt, bool simd) {
+    {
+      AutoProfileBlock block(mProfiler, "Gather Islands");
+      _createSolvers();
+    }
+    if(_shouldSolveParallel())
+      _solveParallel(dt, simd);
+    else {
+      for(size_t i = 0; i < mSolverCount; ++i) {
+        AutoProfileBlock block(mProfiler, "Solve Island");
+        if(simd)
+          mSolvers[i].sSolve(dt, mIterations);
+        else
+          mSolvers[i].solve(dt, mIterations);
+      }
+    }
+
+    //Results are always applied in island order so the outcome doesn't depend on how the islands were solved
+    for(size_t i = 0; i < mSolverCount; ++i)
+      _applySolverResults(mSolvers[i], dt);
+    _removeStaleAwakeContacts();
+  }
+
+  void ConstraintSystem::_removeStaleAwakeContacts() {
+    mRemovedContacts.clear();
     for(size_t i = 0; i < mSolverCount; ++i) {
-      IslandSolver& solver = mSolvers[i];
-      solver.sSolve(dt);
-      for(Constraint* toRemove : solver.getToRemove())
-        _removeContact(*static_cast<ContactConstraint*>(toRemove));
-      mIslandGraph->updateIslandState(solver.getIslandKey(), solver.getNewIslandState(), dt);
+      const std::vector<Constraint*>& removed = mSolvers[i].getToRemove();
+      mRemovedContacts.insert(mRemovedContacts.end(), removed.begin(), removed.end());
     }
+    if(mRemovedContacts.empty())
+      return;
+
+    std::sort(mRemovedContacts.begin(), mRemovedContacts.end());
+    mAwakeContacts.erase(std::remove_if(mAwakeContacts.begin(), mAwakeContacts.end(), [this](ContactConstraint* contact) {
+      return std::binary_search(mRemovedContacts.begin(), mRemovedContacts.end(), static_cast<Constraint*>(contact));
+    }), mAwakeContacts.end());
+  }
+
+  void ConstraintSystem::_solveParallel(float dt, bool simd) {
+    //Dispatch largest islands first so a big one doesn't start last and hold up the whole frame
+    mSolveOrder.resize(mSolverCount);
+    for(size_t i = 0; i < mSolverCount; ++i)
+      mSolveOrder[i] = i;
+    std::sort(mSolveOrder.begin(), mSolveOrder.end(), [this](size_t l, size_t r) {
+      size_t sizeL = mSolvers[l].getConstraintCount();
+      size_t sizeR = mSolvers[r].getConstraintCount();
+      return sizeL == sizeR ? l < r : sizeL > sizeR;
+    });
+
+    Interface::parallelFor(mSolverCount, [this, dt, simd](size_t i) {
+      AutoProfileBlock block(mProfiler, "Solve Island");
+      IslandSolver& solver = mSolvers[mSolveOrder[i]];
+      if(simd)
+        solver.sSolve(dt, mIterations);
+      else
+        solver.solve(dt, mIterations);
+    });
+  }
+
+  bool ConstraintSystem::_shouldSolveParallel() {
+    if(!(gOptions.mThreadingFlags & SyxOptions::ParallelSolve) || mSolverCount < 2)
+      return false;
+    if(gOptions.mDebugFlags & (SyxOptions::DrawManifolds | SyxOptions::DrawJoints))
+      return false;
+
+    size_t constraints = 0;
+    for(size_t i = 0; i < mSolverCount && constraints < sMinParallelConstraints; ++i)
+      constraints += mSolvers[i].getConstraintCount();
+    return constraints >= sMinParallelConstraints;
+  }
+
+  void ConstraintSystem::_applySolverResults(IslandSolver& solver, float dt) {
+    for(Constraint* toRemove : solver.getToRemove())
+      _removeContact(*static_cast<ContactConstraint*>(toRemove));
+    mIslandGraph->updateIslandState(solver.getIslandKey(), solver.getNewIslandState(), dt);
   }
 
   Manifold* ConstraintSystem::getManifold(PhysicsObject& objA, PhysicsObject& objB, ModelInstance& instA, ModelInstance& instB) {
-    size_t oldSize = mPairToManifold.size();
     std::pair<Handle, Handle> pair = {instA.getHandle(), instB.getHandle()};
-    Manifold*& foundManifold = mPairToManifold[pair];
-
-    //Size didn't change, meaning nothing was inserted, so we found a manifold
-    if(oldSize == mPairToManifold.size())
-      return foundManifold;
+    auto found = mPairToManifold.find(pair);
+    if(found != mPairToManifold.end())
+      return found->second;
 
-    //There's going to be many more whitelisted pairs than blacklisted, so optimize for former
-    if(_isBlacklistPair(objA.getHandle(), objB.getHandle())) {
-      mPairToManifold.erase(pair);
+    //Checked before inserting so blacklisted pairs don't insert and erase a node every frame
+    if(isBlacklistPair(objA.getHandle(), objB.getHandle()))
       return nullptr;
-    }
 
     //Didn't find a manifold. Make one and return it
     ContactConstraint* newConstraint = _createContact(&objA, &objB, instA.getHandle(), instB.getHandle());
-    foundManifold = &newConstraint->mManifold;
+    Manifold* foundManifold = &newConstraint->mManifold;
+    mPairToManifold[pair] = foundManifold;
     mIslandGraph->add(*newConstraint);
     return foundManifold;
   }
 
+  Manifold* ConstraintSystem::findManifold(Handle instA, Handle instB) const {
+    auto found = mPairToManifold.find({instA, instB});
+    return found != mPairToManifold.end() ? found->second : nullptr;
+  }
+
+  void ConstraintSystem::clearManifolds(void) {
+    for(ContactConstraint& contact : mContacts)
+      contact.mManifold.clear();
+  }
+
   void ConstraintSystem::updateManifolds(void) {
-    for(auto it = mContacts.begin(); it != mContacts.end(); ++it)
-      (*it).mManifold.update();
+    //Sleeping objects didn't move, so their contacts are still valid
+    for(ContactConstraint* contact : mAwakeContacts)
+      contact->mManifold.update();
   }
 
   void ConstraintSystem::clear(void) {
     mContacts.clear();
+    mAwakeContacts.clear();
     mDistances.clear();
     mRevolutes.clear();
     mSphericals.clear();
@@ -70,11 +143,28 @@ namespace Syx {
     //Don't want to resize down because that would destruct solvers whose memory could be re-used later
     if(mSolvers.size() < mSolverCount) {
       mSolvers.resize(mSolverCount);
+      mContents.resize(mSolverCount);
     }
 
+    mAwakeContacts.clear();
     for(size_t i = 0; i < mSolverCount; ++i) {
-      mIslandGraph->getIsland(i, mContents);
-      mSolvers[i].set(mContents);
+      IslandContents& contents = mContents[i];
+      mIslandGraph->getIsland(i, contents);
+      const SleepState state = contents.mSleepState;
+      //Objects follow their island when it falls asleep or wakes up, which keeps the store's awake bodies current
+      if(state == SleepState::Asleep || state == SleepState::Awake) {
+        for(Constraint* constraint : contents.mConstraints) {
+          mRigidbodies->setAsleep(*constraint->getObjA(), state == SleepState::Asleep);
+          mRigidbodies->setAsleep(*constraint->getObjB(), state == SleepState::Asleep);
+        }
+      }
+      //Inactive islands have no constraints gathered, so this is only the awake ones
+      if(state != SleepState::Asleep) {
+        for(Constraint* constraint : contents.mConstraints)
+          if(constraint->getType() == ConstraintType::Contact)
+            mAwakeContacts.push_back(static_cast<ContactConstraint*>(constraint));
+      }
+      mSolvers[i].set(contents, *mFrameArena);
     }
   }
 
@@ -141,7 +231,7 @@ namespace Syx {
       std::swap(a, b);
   }
 
-  bool ConstraintSystem::_isBlacklistPair(Handle a, Handle b) {
+  bool ConstraintSystem::isBlacklistPair(Handle a, Handle b) const {
     OrderHandlePair(a, b);
     return mCollisionBlacklist.find({a, b}) != mCollisionBlacklist.end();
   }
@@ -181,8 +271,8 @@ namespace Syx {
   }
 
   void ConstraintSystem::removeConstraint(Constraint& constraint) {
-      constraint.getObjA()->setAsleep(false);
-      constraint.getObjB()->setAsleep(false);
+      mRigidbodies->setAsleep(*constraint.getObjA(), false);
+      mRigidbodies->setAsleep(*constraint.getObjB(), false);
       switch(constraint.getType()) {
         case ConstraintType::Contact: _removeContact(static_cast<ContactConstraint&>(constraint)); break;
         case ConstraintType::Distance: RemoveConstraintType(mDistances, DistanceConstraint); break;
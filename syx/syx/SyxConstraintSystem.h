@@ -9,14 +9,25 @@ namespace Syx {
   class Rigidbody;
   class Manifold;
   class PhysicsObject;
+  class RigidbodyStore;
+  class SimulationTest;
 
   class ConstraintSystem {
   public:
+    friend SimulationTest;
+
+    //Default for new constraint systems
     static int sIterations;
     static float sEarlyOutThreshold;
+    //Frames with fewer constraints than this are solved on the calling thread as dispatch would cost more than it saves
+    static size_t sMinParallelConstraints;
 
     ConstraintSystem()
-      : mIslandGraph(nullptr) {}
+      : mIslandGraph(nullptr)
+      , mRigidbodies(nullptr)
+      , mFrameArena(nullptr)
+      , mProfiler(nullptr)
+      , mIterations(sIterations) {}
 
     void solve(float dt);
     void sSolve(float dt);
@@ -25,9 +36,39 @@ namespace Syx {
       mIslandGraph = &graph;
     }
 
+    //Store of the space's bodies, which is told whenever objects fall asleep or wake up
+    void setRigidbodyStore(RigidbodyStore& store) {
+      mRigidbodies = &store;
+    }
+
+    //Arena for memory only needed while solving, must not be reset during a solve
+    void setFrameArena(FrameArena& arena) {
+      mFrameArena = &arena;
+    }
+
+    //Optional, blocks are recorded on whichever thread solves each island
+    void setProfiler(Profiler& profiler) {
+      mProfiler = &profiler;
+    }
+
+    //Maximum velocity iterations per solve, fewer if impulses get small enough first
+    void setIterations(int iterations) {
+      mIterations = iterations;
+    }
+
+    int getIterations() const {
+      return mIterations;
+    }
+
     //Gets the existing manifold on the constraint between these two, or creates the constraint and returns the new manifold if there wasn't one
     Manifold* getManifold(PhysicsObject& objA, PhysicsObject& objB, ModelInstance& instA, ModelInstance& instB);
-    //Update penetration values and discard invalid points
+    //Gets the existing manifold between these instances or null. Doesn't modify anything so it's safe during parallel narrowphase
+    Manifold* findManifold(Handle instA, Handle instB) const;
+    //If a constraint between these objects disabled collision between them
+    bool isBlacklistPair(Handle a, Handle b) const;
+    //Empties every contact's manifold. Needed when models change in place, as contact points and narrowphase caches were found with the old shapes
+    void clearManifolds(void);
+    //Update penetration values and discard invalid points of contacts in islands that were awake for the last solve
     //This won't be needed if objects know what constraints they have, because then it can be done when their position is integrated
     void updateManifolds(void);
     void clear(void);
@@ -50,9 +91,14 @@ namespace Syx {
     void _removeContact(ContactConstraint& toRemove);
     void _addBlacklistPair(Handle a, Handle b);
     void _removeBlacklistPair(Handle a, Handle b);
-    bool _isBlacklistPair(Handle a, Handle b);
 
     void _createSolvers();
+    void _solve(float dt, bool simd);
+    void _solveParallel(float dt, bool simd);
+    bool _shouldSolveParallel();
+    void _applySolverResults(IslandSolver& solver, float dt);
+    //Drops contacts that were removed while applying solver results from mAwakeContacts
+    void _removeStaleAwakeContacts();
 
     VecList<WeldConstraint> mWelds;
     VecList<ContactConstraint> mContacts;
@@ -66,9 +112,20 @@ namespace Syx {
     //Pairs that are not allowed to collide. int for every constraint preventing it.
     std::unordered_map<std::pair<Handle, Handle>, int, PairHash<Handle, Handle>> mCollisionBlacklist;
     IslandGraph* mIslandGraph;
+    RigidbodyStore* mRigidbodies;
+    FrameArena* mFrameArena;
+    Profiler* mProfiler;
     std::vector<IslandSolver, AlignmentAllocator<IslandSolver>> mSolvers;
-    IslandContents mContents;
+    //Solver indices sorted largest first for parallel dispatch
+    std::vector<size_t> mSolveOrder;
+    //One per solver so islands that keep their index can skip copying unchanged constraints
+    std::vector<IslandContents> mContents;
+    //Contacts in islands that aren't asleep, rebuilt each solve
+    std::vector<ContactConstraint*> mAwakeContacts;
+    //Sorted contacts removed during the last solve, only used while pruning mAwakeContacts
+    std::vector<Constraint*> mRemovedContacts;
     HandleGenerator mConstraintHandleGen;
     size_t mSolverCount;
+    int mIterations;
   };
 }
\ No newline at end of file
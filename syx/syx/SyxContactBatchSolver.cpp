@@ -0,0 +1,267 @@
+#include "Precompile.h"
+#include "SyxContactBatchSolver.h"
+#include "SyxContactConstraint.h"
+
+namespace Syx {
+  size_t ContactBatchSolver::sMinContacts = 16;
+
+  namespace {
+    void _setLaneVec(ContactBatch::LaneVec3& dst, size_t lane, const Vec3& v) {
+      dst[0][lane] = v.x;
+      dst[1][lane] = v.y;
+      dst[2][lane] = v.z;
+    }
+  }
+
+  void ContactBatchSolver::clear() {
+    mBatches.clear();
+    mUnbatched.clear();
+    for(std::vector<LocalContactConstraint*>& color : mColors)
+      color.clear();
+  }
+
+  void ContactBatchSolver::set(LocalContactConstraint* contacts, size_t contactCount, const LocalObject* objects, size_t objectCount) {
+    clear();
+    mObjectColors.assign(objectCount, 0);
+
+    //Greedily give each contact the first color neither of its objects has been used in
+    for(size_t i = 0; i < contactCount; ++i) {
+      LocalContactConstraint& contact = contacts[i];
+      size_t indexA = contact.mA - objects;
+      size_t indexB = contact.mB - objects;
+      //Solving never changes static objects, so any number of contacts in a color can share them
+      bool movableA = !contact.mA->mOwner->isStatic();
+      bool movableB = !contact.mB->mOwner->isStatic();
+      unsigned used = (movableA ? mObjectColors[indexA] : 0) | (movableB ? mObjectColors[indexB] : 0);
+
+      size_t color = 0;
+      while(color < sMaxColors && (used & (1u << color)))
+        ++color;
+      if(color == sMaxColors) {
+        mUnbatched.push_back(&contact);
+        continue;
+      }
+
+      mColors[color].push_back(&contact);
+      if(movableA)
+        mObjectColors[indexA] |= 1u << color;
+      if(movableB)
+        mObjectColors[indexB] |= 1u << color;
+    }
+
+    for(std::vector<LocalContactConstraint*>& color : mColors) {
+      size_t full = (color.size()/ContactBatch::sLanes)*ContactBatch::sLanes;
+      for(size_t i = 0; i < full; i += ContactBatch::sLanes)
+        _addBatch(&color[i], ContactBatch::sLanes);
+
+      //A batch less than half full costs more than solving its contacts one at a time
+      size_t remaining = color.size() - full;
+      if(remaining*2 >= ContactBatch::sLanes)
+        _addBatch(&color[full], remaining);
+      else
+        mUnbatched.insert(mUnbatched.end(), color.begin() + full, color.end());
+    }
+  }
+
+  void ContactBatchSolver::_addBatch(LocalContactConstraint** contacts, size_t count) {
+    //Value initialized so unused lanes and points are all zero
+    mBatches.push_back(ContactBatch());
+    ContactBatch& batch = mBatches.back();
+    for(size_t lane = 0; lane < count; ++lane)
+      _setLane(batch, lane, *contacts[lane]);
+  }
+
+  void ContactBatchSolver::_setLane(ContactBatch& batch, size_t lane, LocalContactConstraint& contact) {
+    const ContactBlock& cb = contact.mContactBlock;
+    const FrictionBlock& fb = contact.mFrictionBlock;
+    batch.mConstraints[lane] = &contact;
+
+    _setLaneVec(batch.mNormal, lane, cb.mNormal);
+    _setLaneVec(batch.mNormalTMass[0], lane, cb.mNormalTMass[0]);
+    _setLaneVec(batch.mNormalTMass[1], lane, cb.mNormalTMass[1]);
+    for(int axis = 0; axis < 2; ++axis) {
+      const FrictionAxisBlock& ab = fb.mAxes[axis];
+      _setLaneVec(batch.mAxis[axis], lane, ab.mAxis);
+      _setLaneVec(batch.mLinearA[axis], lane, ab.mLinearA);
+      _setLaneVec(batch.mLinearB[axis], lane, ab.mLinearB);
+    }
+
+    for(int i = 0; i < 4; ++i) {
+      //Points that aren't enforced are left zeroed so they apply nothing
+      if(!cb.mEnforce[i])
+        continue;
+
+      batch.mEnforce[i][lane] = 1.0f;
+      _setLaneVec(batch.mRCrossNA[i], lane, cb.mRCrossNA[i]);
+      _setLaneVec(batch.mRCrossNB[i], lane, cb.mRCrossNB[i]);
+      _setLaneVec(batch.mRCrossNATInertia[i], lane, cb.mRCrossNATInertia[i]);
+      _setLaneVec(batch.mRCrossNBTInertia[i], lane, cb.mRCrossNBTInertia[i]);
+      batch.mPenetrationBias[i][lane] = cb.mPenetrationBias[i];
+      batch.mContactMass[i][lane] = cb.mContactMass[i];
+      batch.mLambdaSum[i][lane] = cb.mLambdaSum[i];
+
+      for(int axis = 0; axis < 2; ++axis) {
+        const FrictionAxisBlock& ab = fb.mAxes[axis];
+        _setLaneVec(batch.mRCrossAxisA[axis][i], lane, ab.mRCrossAxisA[i]);
+        _setLaneVec(batch.mRCrossAxisB[axis][i], lane, ab.mRCrossAxisB[i]);
+        _setLaneVec(batch.mAngularA[axis][i], lane, ab.mAngularA[i]);
+        _setLaneVec(batch.mAngularB[axis][i], lane, ab.mAngularB[i]);
+        batch.mFrictionMass[axis][i][lane] = ab.mConstraintMass[i];
+        batch.mFrictionLambdaSum[axis][i][lane] = ab.mLambdaSum[i];
+      }
+    }
+  }
+
+  float ContactBatchSolver::solve() {
+    float result = 0.0f;
+    for(ContactBatch& batch : mBatches)
+      result = std::max(result, _solveBatch(batch));
+    return result;
+  }
+
+  const std::vector<LocalContactConstraint*>& ContactBatchSolver::getUnbatched() const {
+    return mUnbatched;
+  }
+
+#ifdef SENABLED
+  namespace {
+    FInline SFloats _dot(const ContactBatch::LaneVec3& j, const SFloats* v) {
+      return SAddAll(SAddAll(SMulAll(SLoadAll(j[0]), v[0]), SMulAll(SLoadAll(j[1]), v[1])), SMulAll(SLoadAll(j[2]), v[2]));
+    }
+
+    FInline void _applyImpulse(const SFloats& lambda, const ContactBatch::LaneVec3& j, SFloats* v) {
+      for(int axis = 0; axis < 3; ++axis)
+        v[axis] = SAddAll(v[axis], SMulAll(lambda, SLoadAll(j[axis])));
+    }
+
+    //Same as SConstraints::clampLambda but lanes that aren't enforced keep their sum and get no impulse
+    FInline SFloats _clampLambda(const SFloats& lambda, float* lambdaSum, const SFloats& minBound, const SFloats& maxBound, const SFloats& enforce) {
+      SFloats oldSum = SLoadAll(lambdaSum);
+      SFloats newSum = SMaxAll(minBound, SMinAll(SAddAll(oldSum, lambda), maxBound));
+      newSum = sSelectIf(enforce, newSum, oldSum);
+      SStoreAll(lambdaSum, newSum);
+      return SSubAll(newSum, oldSum);
+    }
+  }
+
+  float ContactBatchSolver::_solveBatch(ContactBatch& batch) {
+    //Linear and angular velocity of a then b, one lane per contact
+    SAlign float velStore[4][3][ContactBatch::sLanes] = {};
+    for(size_t lane = 0; lane < ContactBatch::sLanes; ++lane) {
+      if(const LocalContactConstraint* contact = batch.mConstraints[lane]) {
+        for(int axis = 0; axis < 3; ++axis) {
+          velStore[0][axis][lane] = contact->mA->mLinVel[axis];
+          velStore[1][axis][lane] = contact->mA->mAngVel[axis];
+          velStore[2][axis][lane] = contact->mB->mLinVel[axis];
+          velStore[3][axis][lane] = contact->mB->mAngVel[axis];
+        }
+      }
+    }
+    SFloats vel[4][3];
+    for(int v = 0; v < 4; ++v)
+      for(int axis = 0; axis < 3; ++axis)
+        vel[v][axis] = SLoadAll(velStore[v][axis]);
+    SFloats* linVelA = vel[0];
+    SFloats* angVelA = vel[1];
+    SFloats* linVelB = vel[2];
+    SFloats* angVelB = vel[3];
+
+    const SFloats zero = SSetZero();
+    const SFloats noLimit = sLoadSplatFloats(std::numeric_limits<float>::max());
+    //This is supposed to come from the material, same as LocalContactConstraint
+    const SFloats frictionCoeff = sLoadSplatFloats(0.9f);
+    SFloats result = zero;
+
+    //Solve friction first because it's less important, and the last constraint wins
+    for(int i = 0; i < 4; ++i) {
+      SFloats enforce = SGreaterAll(SLoadAll(batch.mEnforce[i]), zero);
+      if(!SMoveMask(enforce))
+        continue;
+
+      SFloats upperBound = sAbsAll(SMulAll(SLoadAll(batch.mLambdaSum[i]), frictionCoeff));
+      SFloats lowerBound = SSubAll(zero, upperBound);
+      for(int j = 0; j < 2; ++j) {
+        SFloats jv = SAddAll(SSubAll(_dot(batch.mAxis[j], linVelA), _dot(batch.mAxis[j], linVelB)),
+          SAddAll(_dot(batch.mRCrossAxisA[j][i], angVelA), _dot(batch.mRCrossAxisB[j][i], angVelB)));
+        //No bias term for friction
+        SFloats lambda = SMulAll(SSubAll(zero, jv), SLoadAll(batch.mFrictionMass[j][i]));
+        //Clamp lambda term so friction doesn't work harder than normal force
+        lambda = _clampLambda(lambda, batch.mFrictionLambdaSum[j][i], lowerBound, upperBound, enforce);
+
+        _applyImpulse(lambda, batch.mLinearA[j], linVelA);
+        _applyImpulse(lambda, batch.mAngularA[j][i], angVelA);
+        _applyImpulse(lambda, batch.mLinearB[j], linVelB);
+        _applyImpulse(lambda, batch.mAngularB[j][i], angVelB);
+        result = SAddAll(result, sAbsAll(lambda));
+      }
+    }
+
+    for(int i = 0; i < 4; ++i) {
+      SFloats enforce = SGreaterAll(SLoadAll(batch.mEnforce[i]), zero);
+      if(!SMoveMask(enforce))
+        continue;
+
+      //J = jacobian, V = velocity vector, b = bias term, M = Jacobian mass
+      //Calculate lambda = -(JV + b)*M^1
+      SFloats jv = SAddAll(SSubAll(_dot(batch.mNormal, linVelA), _dot(batch.mNormal, linVelB)),
+        SAddAll(_dot(batch.mRCrossNA[i], angVelA), _dot(batch.mRCrossNB[i], angVelB)));
+      SFloats lambda = SMulAll(SSubAll(zero, SAddAll(jv, SLoadAll(batch.mPenetrationBias[i]))), SLoadAll(batch.mContactMass[i]));
+      //Clamp lambda term so contacts don't pull objects back together
+      lambda = _clampLambda(lambda, batch.mLambdaSum[i], zero, noLimit, enforce);
+
+      _applyImpulse(lambda, batch.mNormalTMass[0], linVelA);
+      _applyImpulse(lambda, batch.mRCrossNATInertia[i], angVelA);
+      _applyImpulse(lambda, batch.mNormalTMass[1], linVelB);
+      _applyImpulse(lambda, batch.mRCrossNBTInertia[i], angVelB);
+      result = SAddAll(result, sAbsAll(lambda));
+    }
+
+    for(int v = 0; v < 4; ++v)
+      for(int axis = 0; axis < 3; ++axis)
+        SStoreAll(velStore[v][axis], vel[v][axis]);
+    SAlign float resultStore[ContactBatch::sLanes];
+    SStoreAll(resultStore, result);
+
+    //No lanes share a movable object so writing them back in any order is the same as solving them one at a time
+    float maxResult = 0.0f;
+    for(size_t lane = 0; lane < ContactBatch::sLanes; ++lane) {
+      if(LocalContactConstraint* contact = batch.mConstraints[lane]) {
+        for(int axis = 0; axis < 3; ++axis) {
+          contact->mA->mLinVel[axis] = velStore[0][axis][lane];
+          contact->mA->mAngVel[axis] = velStore[1][axis][lane];
+          contact->mB->mLinVel[axis] = velStore[2][axis][lane];
+          contact->mB->mAngVel[axis] = velStore[3][axis][lane];
+        }
+        maxResult = std::max(maxResult, resultStore[lane]);
+      }
+    }
+    return maxResult;
+  }
+
+  void ContactBatchSolver::storeResults() {
+    for(const ContactBatch& batch : mBatches) {
+      for(size_t lane = 0; lane < ContactBatch::sLanes; ++lane) {
+        LocalContactConstraint* contact = batch.mConstraints[lane];
+        if(!contact)
+          continue;
+        for(int i = 0; i < 4; ++i) {
+          contact->mContactBlock.mLambdaSum[i] = batch.mLambdaSum[i][lane];
+          contact->mFrictionBlock.mAxes[0].mLambdaSum[i] = batch.mFrictionLambdaSum[0][i][lane];
+          contact->mFrictionBlock.mAxes[1].mLambdaSum[i] = batch.mFrictionLambdaSum[1][i][lane];
+        }
+      }
+    }
+  }
+#else
+  float ContactBatchSolver::_solveBatch(ContactBatch& batch) {
+    float result = 0.0f;
+    for(LocalContactConstraint* contact : batch.mConstraints)
+      if(contact)
+        result = std::max(result, contact->solve());
+    return result;
+  }
+
+  //Without SIMD the contacts were solved directly, so their sums are already up to date
+  void ContactBatchSolver::storeResults() {}
+#endif
+}
\ No newline at end of file
@@ -0,0 +1,72 @@
+#pragma once
+
+namespace Syx {
+  class LocalContactConstraint;
+  struct LocalObject;
+
+  //Up to sLanes contact manifolds that share no movable bodies, stored so each SIMD operation does the same step of all of them.
+  //Vectors are split into x, y and z arrays with one element per lane, lanes without a manifold hold zeroes
+  SAlign struct ContactBatch {
+    static const size_t sLanes = 4;
+    typedef float Lanes[sLanes];
+    typedef Lanes LaneVec3[3];
+
+    //Same as ContactBlock, across lanes
+    SAlign LaneVec3 mNormal;
+    LaneVec3 mNormalTMass[2];
+    LaneVec3 mRCrossNA[4];
+    LaneVec3 mRCrossNB[4];
+    LaneVec3 mRCrossNATInertia[4];
+    LaneVec3 mRCrossNBTInertia[4];
+    Lanes mPenetrationBias[4];
+    Lanes mContactMass[4];
+    Lanes mLambdaSum[4];
+    //1 where the point is enforced and 0 otherwise, turned into a mask when solving. Friction uses the same flags
+    Lanes mEnforce[4];
+
+    //Same as FrictionAxisBlock for both axes, across lanes
+    LaneVec3 mAxis[2];
+    LaneVec3 mLinearA[2];
+    LaneVec3 mLinearB[2];
+    LaneVec3 mRCrossAxisA[2][4];
+    LaneVec3 mRCrossAxisB[2][4];
+    LaneVec3 mAngularA[2][4];
+    LaneVec3 mAngularB[2][4];
+    Lanes mFrictionMass[2][4];
+    Lanes mFrictionLambdaSum[2][4];
+
+    //Null in lanes without a manifold
+    LocalContactConstraint* mConstraints[sLanes];
+  };
+
+  //Colors an island's contacts so that no two of the same color share a movable body, then packs each color into batches that are solved sLanes contacts at a time.
+  //Contacts that couldn't be colored or would leave a batch mostly empty are left to be solved individually
+  class ContactBatchSolver {
+  public:
+    //Colors are tracked as bits of an unsigned per object
+    static const size_t sMaxColors = 32;
+    //Islands with fewer contacts than this aren't worth coloring
+    static size_t sMinContacts;
+
+    //Contacts must have had firstIteration called and objects must be the ones the contacts point at
+    void set(LocalContactConstraint* contacts, size_t contactCount, const LocalObject* objects, size_t objectCount);
+    void clear();
+    //Returns the largest impulse applied by any contact, like LocalContactConstraint::solve
+    float solve();
+    //Copy accumulated impulses back to the contacts so lastIteration can store them as warm starts
+    void storeResults();
+
+    const std::vector<LocalContactConstraint*>& getUnbatched() const;
+
+  private:
+    void _addBatch(LocalContactConstraint** contacts, size_t count);
+    void _setLane(ContactBatch& batch, size_t lane, LocalContactConstraint& contact);
+    float _solveBatch(ContactBatch& batch);
+
+    std::vector<ContactBatch, AlignmentAllocator<ContactBatch>> mBatches;
+    std::vector<LocalContactConstraint*> mUnbatched;
+    //Bit per color the object has been used in
+    std::vector<unsigned> mObjectColors;
+    std::vector<LocalContactConstraint*> mColors[sMaxColors];
+  };
+}
\ No newline at end of file
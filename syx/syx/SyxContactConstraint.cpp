@@ -39,7 +39,7 @@ namespace Syx {
       mContactBlock.mEnforce[i] = c.mPenetration > 0.0f;
       float posError = -std::max(0.0f, c.mPenetration);
       //Position error is always negative
-      mContactBlock.mPenetrationBias[i] = Constraints::computeBiasNeg(posError, sPositionSlop*0.5f, sVelBaumgarteTerm, sMaxVelCorrection);
+      mContactBlock.mPenetrationBias[i] = Constraints::computeBiasNeg(posError, sPositionSlop*0.5f, getVelBaumgarteTerm(), sMaxVelCorrection);
 
       if(mContactBlock.mEnforce[i]) {
         *mInactiveTime = 0.0f;
@@ -78,6 +78,8 @@ namespace Syx {
 
   SAlign class LocalContactConstraint: public LocalConstraint {
   public:
+    friend class ContactBatchSolver;
+
     static float sPositionSlop;
     static float sTimeToRemove;
 
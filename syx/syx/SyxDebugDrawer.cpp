@@ -147,8 +147,25 @@ namespace Syx {
     mCommands.clear();
   }
 
+  void DebugDrawer::append(const DebugDrawer& other) {
+    mCommands.insert(mCommands.end(), other.mCommands.begin(), other.mCommands.end());
+  }
+
+  namespace {
+    thread_local DebugDrawer* sTarget = nullptr;
+  }
+
+  DebugDrawer::ScopedTarget::ScopedTarget(DebugDrawer& target)
+    : mPrevious(sTarget) {
+    sTarget = &target;
+  }
+
+  DebugDrawer::ScopedTarget::~ScopedTarget() {
+    sTarget = mPrevious;
+  }
+
   DebugDrawer& DebugDrawer::get(void) {
     static DebugDrawer singleton;
-    return singleton;
+    return sTarget ? *sTarget : singleton;
   }
 }
\ No newline at end of file
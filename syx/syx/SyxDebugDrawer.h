@@ -28,6 +28,16 @@ namespace Syx {
   //Since physics is updated at a different rate than graphics, this will keep submitting
   class DebugDrawer {
   public:
+    //Sends everything drawn on this thread to another drawer while in scope, so work running concurrently can record into its own
+    class ScopedTarget {
+    public:
+      ScopedTarget(DebugDrawer& target);
+      ~ScopedTarget();
+    private:
+      DebugDrawer* mPrevious;
+    };
+
+    //The shared drawer, or this thread's current ScopedTarget
     static DebugDrawer& get(void);
 
     void setColor(float r, float g, float b);
@@ -44,6 +54,9 @@ namespace Syx {
 
     void draw(void);
     void clear(void);
+    //Adds other's commands after this drawer's own
+    void append(const DebugDrawer& other);
+    const std::vector<Command>& getCommands() const { return mCommands; }
   private:
     std::vector<Command> mCommands;
   };
@@ -30,7 +30,7 @@ namespace Syx {
       j.mLinear *= 1.0f/linLen;
     }
 
-    mBlock.mBias = Constraints::computeBias(linLen - owner->mDistance, sSlop*0.5f, sVelBaumgarteTerm, sMaxVelCorrection);
+    mBlock.mBias = Constraints::computeBias(linLen - owner->mDistance, sSlop*0.5f, getVelBaumgarteTerm(), sMaxVelCorrection);
 
     //Premultiply jacobian and compute mass
     Vec3 linearB = -j.mLinear;
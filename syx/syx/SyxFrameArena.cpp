@@ -0,0 +1,65 @@
+#include "Precompile.h"
+#include "SyxFrameArena.h"
+
+namespace Syx {
+  FrameArena::FrameArena(size_t pageSize)
+    : mCurPage(0)
+    , mTop(0)
+    , mPageSize(pageSize)
+    , mHostAllocations(0) {
+  }
+
+  FrameArena::~FrameArena() {
+    _freePages();
+  }
+
+  void* FrameArena::allocate(size_t size, size_t alignment) {
+    SyxAssertError(alignment <= SAlignment, "Pages are only aligned to SAlignment");
+    while(mCurPage < mPages.size()) {
+      Page& page = mPages[mCurPage];
+      size_t alignedTop = (mTop + alignment - 1) & ~(alignment - 1);
+      if(alignedTop + size <= page.mSize) {
+        mTop = alignedTop + size;
+        return page.mBuffer + alignedTop;
+      }
+      //Doesn't fit in the rest of this page, move on to the next one
+      ++mCurPage;
+      mTop = 0;
+    }
+
+    _addPage(size + alignment);
+    return allocate(size, alignment);
+  }
+
+  void FrameArena::reset() {
+    if(mPages.size() > 1) {
+      size_t totalSize = 0;
+      for(const Page& page : mPages)
+        totalSize += page.mSize;
+      _freePages();
+      _addPage(totalSize);
+    }
+    mCurPage = 0;
+    mTop = 0;
+  }
+
+  size_t FrameArena::getHostAllocations() const {
+    return mHostAllocations;
+  }
+
+  void FrameArena::_addPage(size_t minSize) {
+    Page page;
+    page.mSize = std::max(minSize, mPageSize);
+    page.mBuffer = static_cast<uint8_t*>(Interface::allocAligned(page.mSize));
+    mPages.push_back(page);
+    mCurPage = mPages.size() - 1;
+    mTop = 0;
+    ++mHostAllocations;
+  }
+
+  void FrameArena::_freePages() {
+    for(Page& page : mPages)
+      Interface::freeAligned(page.mBuffer);
+    mPages.clear();
+  }
+}
@@ -0,0 +1,79 @@
+#pragma once
+
+namespace Syx {
+  //Bump allocator for memory that only needs to live for one step. Individual deallocations do nothing, everything is freed at once by reset.
+  //Pages come from Interface::allocAligned, and once the arena has grown to fit a whole step it stops asking for more
+  class FrameArena {
+  public:
+    static const size_t sDefaultPageSize = 64*1024;
+
+    FrameArena(size_t pageSize = sDefaultPageSize);
+    FrameArena(const FrameArena&) = delete;
+    ~FrameArena();
+
+    FrameArena& operator=(const FrameArena&) = delete;
+
+    void* allocate(size_t size, size_t alignment = SAlignment);
+    //Frees everything allocated since the last reset. If that took multiple pages they are replaced with one that fits all of it
+    void reset();
+
+    //Number of pages requested from Interface::allocAligned over the arena's lifetime
+    size_t getHostAllocations() const;
+
+  private:
+    struct Page {
+      uint8_t* mBuffer;
+      size_t mSize;
+    };
+
+    void _addPage(size_t minSize);
+    void _freePages();
+
+    std::vector<Page> mPages;
+    size_t mCurPage;
+    //Offset of the next free byte in the current page
+    size_t mTop;
+    size_t mPageSize;
+    size_t mHostAllocations;
+  };
+
+  //Standard allocator that takes its memory from a FrameArena, for containers that are destroyed before the arena is reset
+  template <typename T>
+  class ArenaAllocator {
+  public:
+    typedef T value_type;
+
+    ArenaAllocator(FrameArena& arena)
+      : mArena(&arena) {
+    }
+
+    template <typename U>
+    ArenaAllocator(const ArenaAllocator<U>& rhs)
+      : mArena(rhs.mArena) {
+    }
+
+    T* allocate(size_t n) {
+      return static_cast<T*>(mArena->allocate(sizeof(T)*n, std::max(alignof(T), sizeof(void*))));
+    }
+
+    void deallocate(T*, size_t) {
+      //Freed when the arena is reset
+    }
+
+    template <typename U>
+    bool operator==(const ArenaAllocator<U>& rhs) const {
+      return mArena == rhs.mArena;
+    }
+
+    template <typename U>
+    bool operator!=(const ArenaAllocator<U>& rhs) const {
+      return mArena != rhs.mArena;
+    }
+
+  private:
+    template <typename U>
+    friend class ArenaAllocator;
+
+    FrameArena* mArena;
+  };
+}
@@ -212,6 +212,52 @@ namespace Syx {
     tb = (pq*qab - qq*pab)*invDenom;
   }
 
+  //Real-Time Collision Detection 5.1.9
+  void closestOnLines(const Vec3& aStart, const Vec3& aEnd, const Vec3& bStart, const Vec3& bEnd, Vec3& resultA, Vec3& resultB) {
+    Vec3 aDir = aEnd - aStart;
+    Vec3 bDir = bEnd - bStart;
+    Vec3 bToA = aStart - bStart;
+    float aa = aDir.length2();
+    float bb = bDir.length2();
+    float bDotBToA = bDir.dot(bToA);
+    float ta, tb;
+
+    if(aa < SYX_EPSILON && bb < SYX_EPSILON) {
+      resultA = aStart;
+      resultB = bStart;
+      return;
+    }
+    if(aa < SYX_EPSILON) {
+      ta = 0.0f;
+      tb = clamp(bDotBToA/bb, 0.0f, 1.0f);
+    }
+    else {
+      float aDotBToA = aDir.dot(bToA);
+      if(bb < SYX_EPSILON) {
+        tb = 0.0f;
+        ta = clamp(-aDotBToA/aa, 0.0f, 1.0f);
+      }
+      else {
+        float ab = aDir.dot(bDir);
+        float denom = aa*bb - ab*ab;
+        //Parallel lines have no unique answer, so any point on a will do
+        ta = denom > SYX_EPSILON ? clamp((ab*bDotBToA - aDotBToA*bb)/denom, 0.0f, 1.0f) : 0.0f;
+        tb = (ab*ta + bDotBToA)/bb;
+        //Clamp b and recompute a from the clamped point
+        if(tb < 0.0f) {
+          tb = 0.0f;
+          ta = clamp(-aDotBToA/aa, 0.0f, 1.0f);
+        }
+        else if(tb > 1.0f) {
+          tb = 1.0f;
+          ta = clamp((ab - aDotBToA)/aa, 0.0f, 1.0f);
+        }
+      }
+    }
+    resultA = aStart + aDir*ta;
+    resultB = bStart + bDir*tb;
+  }
+
   //Moller-Trumbore intersection algorithm
   float triangleLineIntersect(const Vec3& a, const Vec3& b, const Vec3& c, const Vec3& start, const Vec3& end) {
     Vec3 dir = end - start;
@@ -11,5 +11,7 @@ namespace Syx {
   float pointRayDist2(const Vec3& p, const Vec3& a, const Vec3& b);
   float pointLineDist2(const Vec3& p, const Vec3& a, const Vec3& b);
   void closestOnRays(const Vec3& aStart, const Vec3& aDir, const Vec3& bStart, const Vec3& bDir, float& ta, float& tb);
+  //Closest points between line segments a and b
+  void closestOnLines(const Vec3& aStart, const Vec3& aEnd, const Vec3& bStart, const Vec3& bEnd, Vec3& resultA, Vec3& resultB);
   float triangleLineIntersect(const Vec3& a, const Vec3& b, const Vec3& c, const Vec3& start, const Vec3& end);
 }
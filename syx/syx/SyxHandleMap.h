@@ -77,4 +77,86 @@ namespace Syx {
     std::unordered_map<Handle, Value*> mKeyToValue;
     HandleGenerator mKeygen;
   };
+
+  //Same as HandleMap, but handles are slot indices with a generation, so lookup is an array access and removed handles are detected by their generation
+  template <typename Value>
+  class SlotHandleMap {
+  public:
+    typedef typename HandleMap<Value>::Iterator Iterator;
+
+    Iterator begin() {
+      return mValueStore.begin();
+    }
+
+    Iterator end() {
+      return mValueStore.end();
+    }
+
+    size_t size() {
+      return mValueStore.size();
+    }
+
+    Value* get(Handle key) const {
+      size_t slot = SlotHandle::getSlot(key);
+      if(slot >= mSlots.size())
+        return nullptr;
+      const Slot& found = mSlots[slot];
+      return found.mGeneration == SlotHandle::getGeneration(key) ? found.mValue : nullptr;
+    }
+
+    Value* add() {
+      size_t slot;
+      if(!mFreeSlots.empty()) {
+        slot = mFreeSlots.back();
+        mFreeSlots.pop_back();
+      }
+      else {
+        slot = mSlots.size();
+        //The slot with all bits set is never used so no handle can come out as SyxInvalidHandle
+        SyxAssertError(slot < SlotHandle::sSlotMask, "More slots than fit in a slot handle");
+        mSlots.push_back(Slot());
+      }
+
+      Slot& newSlot = mSlots[slot];
+      Handle newKey = SlotHandle::make(slot, newSlot.mGeneration);
+      newSlot.mValue = mValueStore.push(Value(newKey));
+      return newSlot.mValue;
+    }
+
+    void remove(Handle key) {
+      size_t slot = SlotHandle::getSlot(key);
+      if(!get(key))
+        return;
+
+      Slot& found = mSlots[slot];
+      mValueStore.freeObj(found.mValue);
+      found.mValue = nullptr;
+      //Invalidate all handles to this slot before it's reused. Wraps to the bits available in the handle
+      found.mGeneration = (found.mGeneration + 1) & SlotHandle::sSlotMask;
+      mFreeSlots.push_back(slot);
+    }
+
+    void clear() {
+      mSlots.clear();
+      mFreeSlots.clear();
+      mValueStore.clear();
+    }
+
+    void reserve(size_t size) {
+      mSlots.reserve(size);
+    }
+
+  private:
+    struct Slot {
+      Slot(): mValue(nullptr), mGeneration(0) {}
+
+      //Null if the slot is free
+      Value* mValue;
+      size_t mGeneration;
+    };
+
+    VecList<Value> mValueStore;
+    std::vector<Slot> mSlots;
+    std::vector<size_t> mFreeSlots;
+  };
 }
\ No newline at end of file
@@ -26,6 +26,25 @@ namespace Syx {
     Handle mNewKey;
   };
 
+  //Handles given out by SlotHandleMap hold the slot index in the low half and how many times the slot has been reused in the high half,
+  //so a handle to a removed value doesn't find whatever reuses its slot. Half of a 32 bit handle only fits 65535 slots, which SlotHandleMap asserts on
+  namespace SlotHandle {
+    const size_t sSlotBits = sizeof(Handle)*4;
+    const Handle sSlotMask = (static_cast<Handle>(1) << sSlotBits) - 1;
+
+    inline Handle make(size_t slot, size_t generation) {
+      return (static_cast<Handle>(generation) << sSlotBits) | (slot & sSlotMask);
+    }
+
+    inline size_t getSlot(Handle handle) {
+      return handle & sSlotMask;
+    }
+
+    inline size_t getGeneration(Handle handle) {
+      return handle >> sSlotBits;
+    }
+  }
+
   struct CastResult {
     CastResult()
       : mObj(SyxInvalidHandle) {
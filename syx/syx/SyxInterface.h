@@ -11,7 +11,9 @@ namespace Syx {
       Transforms = 1 << 3,
       ConstraintSolve = 1 << 4,
       GJK = 1 << 5,
-      EPA = 1 << 6
+      EPA = 1 << 6,
+      //Color contacts within islands and solve them several at a time, independent of ConstraintSolve
+      ContactBatches = 1 << 7
     };
 
     enum Debug {
@@ -29,8 +31,21 @@ namespace Syx {
       DrawJoints = 1 << 11
     };
 
+    //Parallel paths within a space fall back to one thread while anything they'd draw is enabled, since drawing goes through the single Interface drawer
+    enum Threading {
+      //Solve islands concurrently through Interface::parallelFor
+      ParallelSolve = 1 << 0,
+      //Split narrowphase pairs into batches processed concurrently through Interface::parallelFor
+      ParallelNarrowphase = 1 << 1,
+      //Split batched line casts and overlap queries across Interface::parallelFor
+      ParallelQueries = 1 << 2,
+      //Update spaces concurrently through Interface::parallelFor, each recording its debug drawing to be submitted in order afterwards
+      ParallelSpaces = 1 << 3
+    };
+
     int mSimdFlags;
     int mDebugFlags;
+    int mThreadingFlags;
     int mTest;
   };
 
@@ -54,5 +69,9 @@ namespace Syx {
     void freeUnaligned(void* p);
 
     void log(const std::string& message);
+
+    //Calls callback once for every index in [0, count), spread across the host's worker threads.
+    //The calling thread helps with the work and this returns once every index is complete
+    void parallelFor(size_t count, const std::function<void(size_t)>& callback);
   }
 }
\ No newline at end of file
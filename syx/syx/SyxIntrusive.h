@@ -218,7 +218,7 @@ namespace Syx {
         //Need to explicitly call destructors since malloc won't do it
         for(size_t j = 0; j < mPageSize; ++j)
           mPagePool[i][j].~T();
-        AlignedFree(mPagePool[i]);
+        Interface::freeAligned(mPagePool[i]);
       }
       //delete the pointers to the pages
       delete[] mPagePool;
@@ -19,6 +19,8 @@ namespace Syx {
     , mSize(0)
     , mInactiveTime(0.0f)
     , mSleepState(SleepState::Awake)
+    , mVersion(0)
+    , mDirty(true)
   {
   }
 
@@ -27,6 +29,8 @@ namespace Syx {
     , mSize(0)
     , mInactiveTime(0.0f)
     , mSleepState(SleepState::Awake)
+    , mVersion(0)
+    , mDirty(true)
   {
   }
 
@@ -162,6 +166,8 @@ namespace Syx {
       mIslands[nodeA.mIsland].setActive();
     else
       mIslands[nodeB.mIsland].setActive();
+    //Both are in the same island now, so this covers it
+    _markDirty(nodeA.mIsland != sStaticNodeIndex ? nodeA : nodeB);
 
     VALIDATE_ISLAND
   }
@@ -212,10 +218,10 @@ namespace Syx {
     mIslandIndicesDirty = true;
 
     _clearTraversed();
-    mToProcess.push(from);
+    _pushToProcess(from);
 
     //Walk all nodes in from and set their island to to's island
-    while(!mToProcess.empty()) {
+    while(_hasToProcess()) {
       IslandIndex nodeIndex = _popToProcess();
       //Add duplicates of static nodes to reference count the edges
       if(_hasTraversedNode(nodeIndex))
@@ -232,7 +238,7 @@ namespace Syx {
         if(_hasTraversedEdge(edgeIndex))
           continue;
         const IslandEdge& curEdge = mEdges[edgeIndex];
-        mToProcess.push(curEdge.getOther(nodeIndex));
+        _pushToProcess(curEdge.getOther(nodeIndex));
       }
     }
 
@@ -280,6 +286,10 @@ namespace Syx {
       _splitIsland(indexA, indexB);
     }
 
+    //Nodes could have been left in the same island, different ones after a split, or none if it was removed
+    _markDirty(nodeA);
+    _markDirty(nodeB);
+
     VALIDATE_ISLAND
   }
 
@@ -348,13 +358,13 @@ namespace Syx {
 
     //If all nodes can still be reached that means the island can remain as is
     //Island only tracks non-static nodes, so add them on when comparing
-    if(mTraversedNodes.size() == islandA->mSize + staticNodes)
+    if(mTraversedNodeCount == islandA->mSize + staticNodes)
       return;
 
     //Find the other side to give it a new island. It's the one we haven't traversed
     IslandIndex otherSide = a;
     //Don't need to check both because we know we only traversed one of the two
-    if(mTraversedNodes.find(a) != mTraversedNodes.end())
+    if(a < mTraversedNodes.size() && mTraversedNodes[a] == mTraversalID)
       otherSide = b;
 
     _gatherNodes(otherSide, mGatheredNodes);
@@ -382,8 +392,8 @@ namespace Syx {
 
     size_t staticNodes = 0;
     //For each node in island
-    mToProcess.push(start);
-    while(!mToProcess.empty()) {
+    _pushToProcess(start);
+    while(_hasToProcess()) {
       IslandIndex nodeIndex = _popToProcess();
       if(_hasTraversedNode(nodeIndex))
         continue;
@@ -402,7 +412,7 @@ namespace Syx {
         if(_hasTraversedEdge(edgeIndex))
           continue;
         const IslandEdge& edge = mEdges[edgeIndex];
-        mToProcess.push(edge.getOther(nodeIndex));
+        _pushToProcess(edge.getOther(nodeIndex));
       }
     }
     return staticNodes;
@@ -471,36 +481,53 @@ namespace Syx {
     IndexableKey islandKey = _getIslandIndices()[index];
     Island& island = mIslands[islandKey];
     IslandIndex root = mIslands[islandKey].mRoot;
-    _clearTraversed();
 
-    result.clear();
     result.mIslandKey = islandKey;
     result.mSleepState = island.mSleepState;
-    if(!fillInactive && island.mSleepState == SleepState::Inactive)
+    if(!fillInactive && island.mSleepState == SleepState::Inactive) {
+      result.clear();
       return;
+    }
 
-    //For each node in island
-    mToProcess.push(root);
-    while(!mToProcess.empty()) {
-      IslandIndex nodeIndex = _popToProcess();
-      if(_hasTraversedNode(nodeIndex))
-        continue;
+    if(island.mDirty) {
+      island.mConstraints.clear();
+      _clearTraversed();
+      //For each node in island
+      _pushToProcess(root);
+      while(_hasToProcess()) {
+        IslandIndex nodeIndex = _popToProcess();
+        if(_hasTraversedNode(nodeIndex))
+          continue;
 
-      const IslandNode& node = mNodes[nodeIndex];
-      if(node.mIsland == sStaticNodeIndex)
-        continue;
-      //For each edge in node, push new constraints and the nodes they lead to
-      for(size_t i = 0; i < node.mEdges.size(); ++i) {
-        IslandIndex edgeIndex = node.mEdges[i];
-        if(_hasTraversedEdge(edgeIndex))
+        const IslandNode& node = mNodes[nodeIndex];
+        if(node.mIsland == sStaticNodeIndex)
           continue;
-        const IslandEdge& edge = mEdges[edgeIndex];
-        result.mConstraints.push_back(edge.mConstraint);
-        mToProcess.push(edge.getOther(nodeIndex));
+        //For each edge in node, push new constraints and the nodes they lead to
+        for(size_t i = 0; i < node.mEdges.size(); ++i) {
+          IslandIndex edgeIndex = node.mEdges[i];
+          if(_hasTraversedEdge(edgeIndex))
+            continue;
+          const IslandEdge& edge = mEdges[edgeIndex];
+          island.mConstraints.push_back(edge.mConstraint);
+          _pushToProcess(edge.getOther(nodeIndex));
+        }
       }
+      island.mDirty = false;
+      island.mVersion = ++mLastVersion;
+    }
+
+    //Versions are never reused, so a match means result already holds these constraints
+    if(result.mVersion != island.mVersion) {
+      result.mConstraints = island.mConstraints;
+      result.mVersion = island.mVersion;
     }
   }
 
+  void IslandGraph::_markDirty(const IslandNode& node) {
+    if(node.mIsland != sStaticNodeIndex && node.mIsland != sInvalidIslandIndex)
+      mIslands[node.mIsland].mDirty = true;
+  }
+
   std::vector<IndexableKey>& IslandGraph::_getIslandIndices() {
     if(mIslandIndicesDirty)
       mIslands.getIndices(mIslandIndices);
@@ -509,21 +536,51 @@ namespace Syx {
   }
 
   void IslandGraph::_clearTraversed() {
-    mTraversedEdges.clear();
-    mTraversedNodes.clear();
+    //Start a new traversal instead of clearing the marks. Old marks would match again once the id wraps, so clear them then
+    if(++mTraversalID == 0) {
+      std::fill(mTraversedNodes.begin(), mTraversedNodes.end(), 0);
+      std::fill(mTraversedEdges.begin(), mTraversedEdges.end(), 0);
+      mTraversalID = 1;
+    }
+    mTraversedNodeCount = 0;
+  }
+
+  //Marks the index as traversed and returns whether it already was
+  static bool markTraversed(std::vector<size_t>& traversed, size_t index, size_t traversalID) {
+    if(index >= traversed.size())
+      traversed.resize(index + 1, 0);
+    if(traversed[index] == traversalID)
+      return true;
+    traversed[index] = traversalID;
+    return false;
   }
 
   bool IslandGraph::_hasTraversedNode(IslandIndex node) {
-    return !mTraversedNodes.insert(node).second;
+    if(markTraversed(mTraversedNodes, node, mTraversalID))
+      return true;
+    ++mTraversedNodeCount;
+    return false;
   }
 
   bool IslandGraph::_hasTraversedEdge(IslandIndex edge) {
-    return !mTraversedEdges.insert(edge).second;
+    return markTraversed(mTraversedEdges, edge, mTraversalID);
+  }
+
+  void IslandGraph::_pushToProcess(IslandIndex node) {
+    mToProcess.push_back(node);
+  }
+
+  bool IslandGraph::_hasToProcess() const {
+    return mToProcessFront < mToProcess.size();
   }
 
   IslandIndex IslandGraph::_popToProcess() {
-    IslandIndex result = mToProcess.front();
-    mToProcess.pop();
+    IslandIndex result = mToProcess[mToProcessFront++];
+    //Start over once everything is processed so the queue doesn't keep growing
+    if(mToProcessFront == mToProcess.size()) {
+      mToProcess.clear();
+      mToProcessFront = 0;
+    }
     return result;
   }
 
@@ -568,7 +625,7 @@ namespace Syx {
       size_t staticNodes = _gatherNodes(island.mRoot, mGatheredNodes);
 
       //Make sure island count matches traversed count
-      if(island.mSize + staticNodes != mTraversedNodes.size())
+      if(island.mSize + staticNodes != mTraversedNodeCount)
         return false;
 
       for(IslandIndex inIslandIndex : mGatheredNodes) {
@@ -78,13 +78,20 @@ namespace Syx {
 
   //Not sure what I'll want to be tacking on here, so wrapping it in a struct
   struct IslandContents {
+    IslandContents()
+      : mVersion(0) {
+    }
+
     void clear() {
       mConstraints.clear();
+      mVersion = 0;
     }
 
     std::vector<Constraint*> mConstraints;
     IndexableKey mIslandKey;
     SleepState mSleepState;
+    //Changes whenever the island's constraints do and is never reused, so anything derived from mConstraints can be kept while this matches
+    size_t mVersion;
   };
 
   struct Island {
@@ -103,12 +110,20 @@ namespace Syx {
     size_t mSize;
     SleepState mSleepState;
     float mInactiveTime;
+    //Constraints as of the last gather, only valid if not dirty
+    std::vector<Constraint*> mConstraints;
+    size_t mVersion;
+    bool mDirty;
   };
 
   class IslandGraph {
   public:
     IslandGraph()
-      : mIslandIndicesDirty(true) {}
+      : mIslandIndicesDirty(true)
+      , mTraversalID(1)
+      , mTraversedNodeCount(0)
+      , mToProcessFront(0)
+      , mLastVersion(0) {}
 
     void add(Constraint& constraint);
     void remove(Constraint& constraint);
@@ -121,6 +136,7 @@ namespace Syx {
     void updateIslandState(IndexableKey islandKey, SleepState stateThisFrame, float dt);
 
     size_t islandCount();
+    //Constraints are only gathered again if the island changed since the last call
     void getIsland(size_t index, IslandContents& result, bool fillInactive = false);
 
     bool validate();
@@ -130,6 +146,8 @@ namespace Syx {
     void _clearTraversed();
     bool _hasTraversedNode(IslandIndex node);
     bool _hasTraversedEdge(IslandIndex edge);
+    void _pushToProcess(IslandIndex node);
+    bool _hasToProcess() const;
     IslandIndex _popToProcess();
 
     IslandIndex _getNode(PhysicsObject& obj);
@@ -152,6 +170,8 @@ namespace Syx {
     IndexableKey _newIsland(IslandIndex root);
     void _wakeIslandsWithStaticNode(IslandIndex staticIndex);
     void _removeEdge(IndexableKey edgeIndex);
+    //Marks the island the node is in as needing its constraints gathered again, if it's in one
+    void _markDirty(const IslandNode& node);
 
     StaticIndexable<IslandNode> mNodes;
     StaticIndexable<IslandEdge> mEdges;
@@ -159,11 +179,18 @@ namespace Syx {
     std::vector<IndexableKey> mIslandIndices;
     bool mIslandIndicesDirty;
 
-    //Temporary containers used while traversing graph
-    std::unordered_set<IslandIndex> mTraversedNodes;
-    std::unordered_set<IslandIndex> mTraversedEdges;
-    std::queue<IslandIndex> mToProcess;
+    //Temporary containers used while traversing graph. All are vectors so their memory is reused between traversals
+    //Indexed by node or edge, which has been traversed if it holds the current mTraversalID, so clearing is incrementing the id
+    std::vector<size_t> mTraversedNodes;
+    std::vector<size_t> mTraversedEdges;
+    size_t mTraversalID;
+    size_t mTraversedNodeCount;
+    //Queue of nodes starting at mToProcessFront
+    std::vector<IslandIndex> mToProcess;
+    size_t mToProcessFront;
     std::vector<IslandIndex> mGatheredNodes;
+    //Last version given to an island's constraints
+    size_t mLastVersion;
 
     //Handle mappings. IndexableKey is also IslandIndex for edges and nodes
     std::unordered_map<Handle, IslandIndex> mObjectToNode;
@@ -11,11 +11,14 @@ namespace Syx {
     mSphericals.clear();
   }
 
-  void IslandSolver::set(const IslandContents& island) {
+  IslandSolver::IslandSolver()
+    : mCachedVersion(0) {
+  }
+
+  void IslandSolver::set(const IslandContents& island, FrameArena& arena) {
     _clearLocalConstraints();
     mObjects.clear();
     mToRemove.clear();
-    mObjHandleToIndex.clear();
 
     mIslandKey = island.mIslandKey;
     mNewIslandState = SleepState::Inactive;
@@ -27,34 +30,42 @@ namespace Syx {
 
     //Maximum number of objects this could be so we can hold pointers without worrying about a resize
     mObjects.reserve(island.mConstraints.size()*2);
-    for(Constraint* constraint : island.mConstraints) {
+    const bool cached = island.mVersion == mCachedVersion;
+    if(cached) {
+      //Same constraints as last time, so objects are in the same order
+      for(PhysicsObject* obj : mObjectSources)
+        mObjects.push_back(LocalObject(*obj));
+    }
+    else {
+      mObjectSources.clear();
+      mConstraintObjects.clear();
+    }
+    ObjectIndexMap objectIndices(cached ? 0 : island.mConstraints.size()*2, std::hash<Handle>(), std::equal_to<Handle>(), ArenaAllocator<std::pair<const Handle, size_t>>(arena));
+    for(size_t i = 0; i < island.mConstraints.size(); ++i) {
+      Constraint* constraint = island.mConstraints[i];
       PhysicsObject* objA = constraint->getObjA();
       PhysicsObject* objB = constraint->getObjB();
       //Island is inactive if all objects in it are inactive
       if(mNewIslandState == SleepState::Inactive && (!objA->isInactive() || !objB->isInactive()))
         mNewIslandState = SleepState::Active;
 
-      //Update sleep state while we have the objects
+      //Objects' sleep flags were already updated for the island's state by the constraint system
       switch(island.mSleepState) {
         case SleepState::Asleep:
-          objA->setAsleep(true);
-          objB->setAsleep(true);
           continue;
 
-        case SleepState::Awake:
-          objA->setAsleep(false);
-          objB->setAsleep(false);
-          break;
-
         case SleepState::Active:
           SyxAssertError(objA->isStatic() || !objA->getAsleep(), "Object should be awake");
           break;
       }
-      size_t indexA = _getObjectIndex(*objA);
-      size_t indexB = _getObjectIndex(*objB);
+      if(!cached)
+        mConstraintObjects.push_back({ _getObjectIndex(*objA, objectIndices), _getObjectIndex(*objB, objectIndices) });
+      const std::pair<size_t, size_t>& indices = mConstraintObjects[i];
 
-      _pushLocalConstraint(*constraint, indexA, indexB);
+      _pushLocalConstraint(*constraint, indices.first, indices.second);
     }
+    //Objects aren't gathered for sleeping islands, so the cache would be incomplete
+    mCachedVersion = island.mSleepState == SleepState::Asleep ? 0 : island.mVersion;
   }
 
 #define PushConstraintType(constraintType, container) {\
@@ -80,15 +91,16 @@ namespace Syx {
     }
   }
 
-  size_t IslandSolver::_getObjectIndex(PhysicsObject& obj) {
-    auto it = mObjHandleToIndex.find(obj.getHandle());
-    if(it != mObjHandleToIndex.end()) {
+  size_t IslandSolver::_getObjectIndex(PhysicsObject& obj, ObjectIndexMap& objectIndices) {
+    auto it = objectIndices.find(obj.getHandle());
+    if(it != objectIndices.end()) {
       return it->second;
     }
 
     size_t newIndex = mObjects.size();
-    mObjHandleToIndex[obj.getHandle()] = newIndex;
+    objectIndices[obj.getHandle()] = newIndex;
     mObjects.push_back(LocalObject(obj));
+    mObjectSources.push_back(&obj);
     return newIndex;
   }
 
@@ -99,17 +111,21 @@ namespace Syx {
     }
   }
 
-  void IslandSolver::solve(float dt) {
+  void IslandSolver::solve(float dt, int iterations) {
     if(mCurIslandState == SleepState::Inactive)
       return;
-    preSolve(dt);
-    for(int i = 0; i < ConstraintSystem::sIterations; ++i) {
+    Constraint::sDT = dt;
+    preSolve();
+    for(int i = 0; i < iterations; ++i) {
       float maxImpulse = 0.0f;
       solveContainer(mSphericals, maxImpulse);
       solveContainer(mRevolutes, maxImpulse);
       solveContainer(mDistances, maxImpulse);
       solveContainer(mWelds, maxImpulse);
-      solveContainer(mContacts, maxImpulse);
+      if(mBatchContacts)
+        _solveContactBatches(maxImpulse, false);
+      else
+        solveContainer(mContacts, maxImpulse);
 
       if(maxImpulse < ConstraintSystem::sEarlyOutThreshold)
         break;
@@ -125,17 +141,21 @@ namespace Syx {
     }
   }
 
-  void IslandSolver::sSolve(float dt) {
+  void IslandSolver::sSolve(float dt, int iterations) {
     if(mCurIslandState == SleepState::Inactive)
       return;
-    preSolve(dt);
-    for(int i = 0; i < ConstraintSystem::sIterations; ++i) {
+    Constraint::sDT = dt;
+    preSolve();
+    for(int i = 0; i < iterations; ++i) {
       float maxImpulse = 0.0f;
       sSolveContainer(mSphericals, maxImpulse);
       sSolveContainer(mRevolutes, maxImpulse);
       sSolveContainer(mDistances, maxImpulse);
       sSolveContainer(mWelds, maxImpulse);
-      sSolveContainer(mContacts, maxImpulse);
+      if(mBatchContacts)
+        _solveContactBatches(maxImpulse, true);
+      else
+        sSolveContainer(mContacts, maxImpulse);
 
       if(maxImpulse < ConstraintSystem::sEarlyOutThreshold)
         break;
@@ -144,6 +164,12 @@ namespace Syx {
     storeObjects();
   }
 
+  void IslandSolver::_solveContactBatches(float& maxImpulse, bool simd) {
+    maxImpulse = std::max(maxImpulse, mContactBatches.solve());
+    for(LocalContactConstraint* contact : mContactBatches.getUnbatched())
+      maxImpulse = std::max(maxImpulse, simd ? contact->sSolve() : contact->solve());
+  }
+
   void IslandSolver::storeObjects() {
     for(LocalObject& obj : mObjects) {
       //Static objects won't change, so don't write them, also, multiple islands share these, so when multi-threaded, writes to these could be bad
@@ -175,10 +201,9 @@ namespace Syx {
     }
   }
 
-  void IslandSolver::preSolve(float dt) {
-    Constraint::sDT = dt;
-    bool shouldDrawContacts = (Interface::getOptions().mDebugFlags & SyxOptions::DrawManifolds) != 0;
-    bool shouldDrawJoints = (Interface::getOptions().mDebugFlags & SyxOptions::DrawJoints) != 0;
+  void IslandSolver::preSolve() {
+    bool shouldDrawContacts = (gOptions.mDebugFlags & SyxOptions::DrawManifolds) != 0;
+    bool shouldDrawJoints = (gOptions.mDebugFlags & SyxOptions::DrawJoints) != 0;
     mToRemove.clear();
 
     _preSolveContainer(mSphericals, mToRemove, shouldDrawJoints);
@@ -186,6 +211,11 @@ namespace Syx {
     _preSolveContainer(mDistances, mToRemove, shouldDrawJoints);
     _preSolveContainer(mWelds, mToRemove, shouldDrawJoints);
     _preSolveContainer(mContacts, mToRemove, shouldDrawContacts);
+
+    //Batches are built after removal since removing reorders the contacts
+    mBatchContacts = (gOptions.mSimdFlags & SyxOptions::SIMD::ContactBatches) && mContacts.size() >= ContactBatchSolver::sMinContacts;
+    if(mBatchContacts)
+      mContactBatches.set(mContacts.data(), mContacts.size(), mObjects.data(), mObjects.size());
   }
 
   template <typename Container>
@@ -195,6 +225,8 @@ namespace Syx {
   }
 
   void IslandSolver::postSolve() {
+    if(mBatchContacts)
+      mContactBatches.storeResults();
     _postSolveContainer(mSphericals);
     _postSolveContainer(mRevolutes);
     _postSolveContainer(mDistances);
@@ -213,4 +245,8 @@ namespace Syx {
   SleepState IslandSolver::getNewIslandState() {
     return mNewIslandState;
   }
+
+  size_t IslandSolver::getConstraintCount() {
+    return mSphericals.size() + mRevolutes.size() + mDistances.size() + mWelds.size() + mContacts.size();
+  }
 }
\ No newline at end of file
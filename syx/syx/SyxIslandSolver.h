@@ -5,24 +5,32 @@
 #include "SyxWeldConstraint.h"
 #include "SyxRevoluteConstraint.h"
 #include "SyxIslandGraph.h"
+#include "SyxContactBatchSolver.h"
 
 namespace Syx {
   SAlign class IslandSolver {
   public:
-    void set(const IslandContents& island);
-    void solve(float dt);
-    void sSolve(float dt);
-    void preSolve(float dt);
+    IslandSolver();
+
+    //Arena is used for lookups only needed while building the solver. Object lookups are skipped if the island is the same version as last time
+    void set(const IslandContents& island, FrameArena& arena);
+    void solve(float dt, int iterations);
+    void sSolve(float dt, int iterations);
+    void preSolve();
     void postSolve();
     void storeObjects();
     const std::vector<Constraint*>& getToRemove();
     IndexableKey getIslandKey();
     SleepState getNewIslandState();
+    size_t getConstraintCount();
 
   private:
-    size_t _getObjectIndex(PhysicsObject& obj);
+    typedef std::unordered_map<Handle, size_t, std::hash<Handle>, std::equal_to<Handle>, ArenaAllocator<std::pair<const Handle, size_t>>> ObjectIndexMap;
+
+    size_t _getObjectIndex(PhysicsObject& obj, ObjectIndexMap& objectIndices);
     void _pushLocalConstraint(Constraint& constraint, size_t indexA, size_t indexB);
     void _clearLocalConstraints();
+    void _solveContactBatches(float& maxImpulse, bool simd);
 
     std::vector<LocalObject, AlignmentAllocator<LocalObject>> mObjects;
     std::vector<LocalWeldConstraint, AlignmentAllocator<LocalWeldConstraint>> mWelds;
@@ -31,11 +39,17 @@ namespace Syx {
     std::vector<LocalSphericalConstraint, AlignmentAllocator<LocalSphericalConstraint>> mSphericals;
     std::vector<LocalDistanceConstraint, AlignmentAllocator<LocalDistanceConstraint>> mDistances;
     std::vector<Constraint*> mToRemove;
-    std::unordered_map<Handle, size_t> mObjHandleToIndex;
+    //Source of each of mObjects and the index of each constraint's objects in it, kept while the island stays at mCachedVersion
+    std::vector<PhysicsObject*> mObjectSources;
+    std::vector<std::pair<size_t, size_t>> mConstraintObjects;
+    size_t mCachedVersion;
     IndexableKey mIslandKey;
     SleepState mNewIslandState;
     SleepState mCurIslandState;
-    SPadClass(SVectorSize*7 + SMapSize + sizeof(IndexableKey) + sizeof(SleepState)*2);
+    ContactBatchSolver mContactBatches;
+    //Set during preSolve if contacts are solved through mContactBatches this frame
+    bool mBatchContacts;
+    SPadClass(SVectorSize*9 + sizeof(size_t) + sizeof(IndexableKey) + sizeof(SleepState)*2 + sizeof(ContactBatchSolver) + sizeof(bool));
   };
 
 }
\ No newline at end of file
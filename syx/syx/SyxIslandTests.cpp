@@ -514,6 +514,69 @@ namespace Syx {
     return TEST_FAILED;
   }
 
+  TEST_FUNC(islandTests, testIslandVersion) {
+    TEST_FAILED = false;
+    Handle id = 0;
+    PhysicsObject a(id++);
+    PhysicsObject b(id++);
+    PhysicsObject c(id++);
+    PhysicsObject staticA(id++);
+    staticA.setRigidbodyEnabled(false);
+
+    IslandContents contents;
+    IslandGraph graph;
+
+    Constraint ab(ConstraintType::Invalid, &a, &b, id++);
+    Constraint bc(ConstraintType::Invalid, &b, &c, id++);
+    Constraint saa(ConstraintType::Invalid, &staticA, &a, id++);
+
+    graph.add(ab);
+    graph.add(saa);
+    graph.getIsland(0, contents);
+    size_t version = contents.mVersion;
+    checkResult(Match(contents, { &ab, &saa }));
+
+    //Nothing changed, so the same gathered constraints should be reused
+    graph.getIsland(0, contents);
+    checkResult(contents.mVersion == version);
+    checkResult(Match(contents, { &ab, &saa }));
+
+    //Cleared contents are refilled even though the island didn't change
+    contents.clear();
+    graph.getIsland(0, contents);
+    checkResult(contents.mVersion == version);
+    checkResult(Match(contents, { &ab, &saa }));
+
+    graph.add(bc);
+    graph.getIsland(0, contents);
+    checkResult(contents.mVersion != version);
+    checkResult(Match(contents, { &ab, &saa, &bc }));
+    version = contents.mVersion;
+
+    //Removing a leaf keeps the island but changes its constraints
+    graph.remove(bc);
+    graph.getIsland(0, contents);
+    checkResult(contents.mVersion != version);
+    checkResult(Match(contents, { &ab, &saa }));
+    version = contents.mVersion;
+
+    //Splitting gives both sides new versions
+    graph.add(bc);
+    graph.remove(ab);
+    IslandContents other;
+    graph.getIsland(0, contents);
+    graph.getIsland(1, other);
+    checkResult(contents.mVersion != version && other.mVersion != version && contents.mVersion != other.mVersion);
+    checkResult(Match(contents, other, { &saa }, { &bc }));
+
+    //Reading the other island into the same contents replaces its constraints
+    graph.getIsland(1, contents);
+    checkResult(contents.mVersion == other.mVersion);
+    checkResult(Match(contents, { &bc }));
+
+    return TEST_FAILED;
+  }
+
   bool testIslandAll() {
     bool failed = false;
     for(auto func : islandTests)
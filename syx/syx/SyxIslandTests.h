@@ -5,5 +5,6 @@ namespace Syx {
   bool testIslandRemoveConstraint();
   bool testIslandRemoveObject();
   bool testIslandSleep();
+  bool testIslandVersion();
   bool testIslandAll();
 }
\ No newline at end of file
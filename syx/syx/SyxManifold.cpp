@@ -180,6 +180,11 @@ namespace Syx {
     }
   }
 
+  void Manifold::clear(void) {
+    mSize = 0;
+    mNarrowphaseCache.mValid = false;
+  }
+
   void Manifold::_pushContact(const ContactPoint& contact) {
     SyxAssertError(mSize < MAX_CONTACTS);
     mContacts[mSize++] = contact;
@@ -1,10 +1,12 @@
 #pragma once
+#include "SyxTransform.h"
 
 #define MAX_CONTACTS 4
 
 namespace Syx {
   class Collider;
   class PhysicsObject;
+  class Model;
 
   SAlign struct ContactObject {
     ContactObject() {}
@@ -41,6 +43,25 @@ namespace Syx {
     float mWarmFriction[2];
   };
 
+  //What the narrowphase found the last time it tested a pair, so it can skip or warm start the next test
+  SAlign struct NarrowphaseCache {
+    NarrowphaseCache()
+      : mModelA(nullptr)
+      , mModelB(nullptr)
+      , mValid(false)
+      , mColliding(false) {
+    }
+
+    //B's model space to A's model space at the time of the test
+    SAlign Transformer mBToA;
+    //Separating axis if they weren't colliding, otherwise the direction of least penetration
+    SAlign Vec3 mAxis;
+    const Model* mModelA;
+    const Model* mModelB;
+    bool mValid;
+    bool mColliding;
+  };
+
   SAlign class Manifold {
   public:
     Manifold()
@@ -57,16 +78,20 @@ namespace Syx {
     void addContact(const ContactPoint& contact, const Vec3& normal);
     //Update penetration info and discard invalid points
     void update();
+    //Forget all contacts and what the narrowphase found, so the pair is tested as if it just started touching
+    void clear();
     void draw();
 
     SAlign ContactPoint mContacts[MAX_CONTACTS];
     SAlign Vec3 mNormal;
     SAlign Vec3 mTangentA;
     SAlign Vec3 mTangentB;
+    //Only written by the narrowphase that tests this manifold's pair
+    SAlign NarrowphaseCache mNarrowphaseCache;
     Collider* mA;
     Collider* mB;
     size_t mSize;
-    SPadClass(sizeof(ContactPoint)*MAX_CONTACTS + sizeof(Vec3)*3 + SPtrSize*2 + sizeof(size_t));
+    SPadClass(sizeof(ContactPoint)*MAX_CONTACTS + sizeof(Vec3)*3 + sizeof(NarrowphaseCache) + SPtrSize*2 + sizeof(size_t));
 
   private:
     void _pushContact(const ContactPoint& contact);
@@ -3,8 +3,20 @@
 #include "SyxTransform.h"
 #include "SyxDebugHelpers.h"
 #include "SyxAABBTree.h"
+#include "SyxQuantizedBVH.h"
 
 namespace Syx {
+  //Model trees are built once and never move, so leaves don't need enlarging
+  const AABBTreeConfig sModelTreeConfig(0.0f, 0.0f);
+  //Sine of the largest convex angle between neighboring triangles where their shared edge is still considered internal
+  const float sInternalEdgeSin = 0.087f;
+  //Same as above but for an edge to be considered flat
+  const float sFlatEdgeSin = 0.0001f;
+  //Internal edge flags are in the low bits, concave ones after them
+  const int sConcaveEdgeShift = 3;
+  //Fraction of the model's size a point can be in front of a face before the mesh is considered concave
+  const float sConvexTolerance = 0.0001f;
+
 #ifdef SENABLED
   SFloats Model::sGetSupport(SFloats dir) const {
     switch(mType) {
@@ -12,7 +24,7 @@ namespace Syx {
       case ModelType::Cone: return _sGetConeSupport(dir);
       case ModelType::Cube: return _sGetCubeSupport(dir);
       case ModelType::Cylinder: return _sGetCylinderSupport(dir);
-      case ModelType::Mesh: return _sGetMeshSupport(dir);
+      case ModelType::Mesh: return _sGetMeshSupport(dir, nullptr);
       case ModelType::Sphere: return _sGetSphereSupport(dir);
       case ModelType::Triangle: return _sGetTriSupport(dir);
       default: SyxAssertError(false, "Invalid shape type");
@@ -20,23 +32,74 @@ namespace Syx {
     return SVec3::Zero;
   }
 
-  SFloats Model::_sGetMeshSupport(SFloats dir) const {
+  SFloats Model::sGetSupport(SFloats dir, SupportHint& hint) const {
+    if(mType == ModelType::Mesh)
+      return _sGetMeshSupport(dir, &hint);
+    return sGetSupport(dir);
+  }
+
+  SFloats Model::_sGetMeshSupport(SFloats dir, SupportHint* hint) const {
     if(mPoints.empty())
       return SVec3::Zero;
-
-    SFloats bestPoint = SLoadAll(&mPoints[0].x);
-    SFloats bestDot = SVec3::dot(bestPoint, dir);
-
-    for(size_t i = 1; i < mPoints.size(); ++i) {
-      SFloats curPoint = SLoadAll(&mPoints[i].x);
-      SFloats curDot = SVec3::dot(curPoint, dir);
-
-      if(SIGreaterLower(curDot, bestDot)) {
-        bestPoint = curPoint;
-        bestDot = curDot;
+    if(!_canHillClimb())
+      return _sGetMeshSupportBruteForce(dir);
+
+    //Move to whichever neighbor is furthest along dir until none are further. Hull is convex so this is the global maximum
+    uint32_t current = _getClimbStart(hint);
+    SFloats bestDot = SVec3::dot(SLoadAll(&mPoints[current].x), dir);
+    uint32_t previous;
+    do {
+      previous = current;
+      const uint32_t end = mAdjacencyOffsets[previous + 1];
+      for(uint32_t i = mAdjacencyOffsets[previous]; i < end; ++i) {
+        uint32_t neighbor = mAdjacency[i];
+        SFloats curDot = SVec3::dot(SLoadAll(&mPoints[neighbor].x), dir);
+        if(SIGreaterLower(curDot, bestDot)) {
+          bestDot = curDot;
+          current = neighbor;
+        }
       }
     }
-    return SFloats(bestPoint);
+    while(current != previous);
+
+    if(hint)
+      hint->set(current);
+    return SLoadAll(&mPoints[current].x);
+  }
+
+  SFloats Model::_sGetMeshSupportBruteForce(SFloats dir) const {
+    SFloats dirX = SShuffle(dir, 0, 0, 0, 0);
+    SFloats dirY = SShuffle(dir, 1, 1, 1, 1);
+    SFloats dirZ = SShuffle(dir, 2, 2, 2, 2);
+    SFloats step = SSetSplat(4.0f);
+    //Alternate between two sets of lanes so consecutive groups don't wait on each other, making it 8 points at a time
+    SFloats bestDots[2] = { SSetSplat(std::numeric_limits<float>::lowest()), SSetSplat(std::numeric_limits<float>::lowest()) };
+    SFloats bestIndices[2] = { SSetZero(), SSetZero() };
+    SFloats indices = SSetAll(0.0f, 1.0f, 2.0f, 3.0f);
+
+    for(size_t i = 0; i < mSupportGroups.size(); ++i) {
+      const SupportGroup& group = mSupportGroups[i];
+      SFloats dots = SAddAll(SAddAll(SMulAll(SLoadAll(group.mX), dirX), SMulAll(SLoadAll(group.mY), dirY)), SMulAll(SLoadAll(group.mZ), dirZ));
+      SFloats& laneDots = bestDots[i & 1];
+      SFloats& laneIndices = bestIndices[i & 1];
+      SFloats greater = SGreaterAll(dots, laneDots);
+      laneDots = SOr(SAnd(greater, dots), SAndNot(greater, laneDots));
+      laneIndices = SOr(SAnd(greater, indices), SAndNot(greater, laneIndices));
+      indices = SAddAll(indices, step);
+    }
+
+    SFloats greater = SGreaterAll(bestDots[1], bestDots[0]);
+    SAlign float dots[4];
+    SAlign float bestIndex[4];
+    SStoreAll(dots, SOr(SAnd(greater, bestDots[1]), SAndNot(greater, bestDots[0])));
+    SStoreAll(bestIndex, SOr(SAnd(greater, bestIndices[1]), SAndNot(greater, bestIndices[0])));
+    int best = 0;
+    for(int i = 1; i < 4; ++i)
+      if(dots[i] > dots[best])
+        best = i;
+    //Padding lanes at the end duplicate the last point, so their indices clamp back to it
+    size_t index = std::min(static_cast<size_t>(bestIndex[best]), mPoints.size() - 1);
+    return SLoadAll(&mPoints[index].x);
   }
 
   SFloats Model::_sGetCubeSupport(SFloats dir) const {
@@ -110,16 +173,18 @@ namespace Syx {
     , mPoints(points)
     , mTriangles(triangles)
     , mAABB(aabb) {
+    if(mType == ModelType::Mesh)
+      _buildSupportGroups();
   }
 
 
   Model::Model(const Vec3Vec& points, const Vec3Vec& triangles, bool environment)
-    : Model(environment ? ModelType::Environment : ModelType::Mesh, points, triangles, Create::aabbTree(), AABB(points)) {
+    : Model(environment ? ModelType::Environment : ModelType::Mesh, points, triangles, Create::aabbTree(sModelTreeConfig), AABB(points)) {
   }
 
   //All primitives are from -1.0 to 1.0 so I don't need to multiply by 0.5 when getting support points
   Model::Model(int type)
-    : Model(type, {}, {}, Create::aabbTree(), AABB(-Vec3::Identity, Vec3::Identity)) {
+    : Model(type, {}, {}, Create::aabbTree(sModelTreeConfig), AABB(-Vec3::Identity, Vec3::Identity)) {
     switch(mType) {
       case ModelType::Triangle:
         mPoints.resize(3);
@@ -138,7 +203,7 @@ namespace Syx {
       case ModelType::Cone: return _getConeSupport(dir);
       case ModelType::Cube: return _getCubeSupport(dir);
       case ModelType::Cylinder: return _getCylinderSupport(dir);
-      case ModelType::Mesh: return _getMeshSupport(dir);
+      case ModelType::Mesh: return _getMeshSupport(dir, nullptr);
       case ModelType::Sphere: return _getSphereSupport(dir);
       case ModelType::Triangle: return _getTriSupport(dir);
       default: SyxAssertError(false, "Invalid shape type");
@@ -146,10 +211,39 @@ namespace Syx {
     return Vec3::Zero;
   }
 
-  Vec3 Model::_getMeshSupport(const Vec3& dir) const {
+  Vec3 Model::getSupport(const Vec3& dir, SupportHint& hint) const {
+    if(mType == ModelType::Mesh)
+      return _getMeshSupport(dir, &hint);
+    return getSupport(dir);
+  }
+
+  Vec3 Model::_getMeshSupport(const Vec3& dir, SupportHint* hint) const {
     if(mPoints.empty())
       return Vec3::Zero;
 
+    if(_canHillClimb()) {
+      uint32_t current = _getClimbStart(hint);
+      float bestDot = mPoints[current].dot(dir);
+      uint32_t previous;
+      do {
+        previous = current;
+        const uint32_t end = mAdjacencyOffsets[previous + 1];
+        for(uint32_t i = mAdjacencyOffsets[previous]; i < end; ++i) {
+          uint32_t neighbor = mAdjacency[i];
+          float curDot = mPoints[neighbor].dot(dir);
+          if(curDot > bestDot) {
+            bestDot = curDot;
+            current = neighbor;
+          }
+        }
+      }
+      while(current != previous);
+
+      if(hint)
+        hint->set(current);
+      return mPoints[current];
+    }
+
     float bestDot = mPoints[0].dot(dir);
     const Vec3* bestPoint = &mPoints[0];
 
@@ -164,6 +258,116 @@ namespace Syx {
     return *bestPoint;
   }
 
+  uint32_t Model::_getClimbStart(const SupportHint* hint) const {
+    uint32_t start = hint ? hint->get() : mClimbStart;
+    //Hint could be from a different model or a point that isn't on the hull, so has no neighbors
+    if(start >= mPoints.size() || mAdjacencyOffsets[start] == mAdjacencyOffsets[start + 1])
+      return mClimbStart;
+    return start;
+  }
+
+  void Model::initMesh(const std::vector<size_t>& indices) {
+    mAdjacencyOffsets.clear();
+    mAdjacency.clear();
+    mClimbStart = 0;
+    if(mPoints.size() < sHillClimbMinPoints || indices.empty() || indices.size() % 3)
+      return;
+
+    //Loaded meshes often duplicate vertices for different normals or uvs, so weld them by position to find shared edges
+    std::vector<uint32_t> order(mPoints.size());
+    for(uint32_t i = 0; i < order.size(); ++i)
+      order[i] = i;
+    std::sort(order.begin(), order.end(), [this](uint32_t l, uint32_t r) {
+      const Vec3& a = mPoints[l];
+      const Vec3& b = mPoints[r];
+      if(a.x != b.x)
+        return a.x < b.x;
+      if(a.y != b.y)
+        return a.y < b.y;
+      return a.z < b.z;
+    });
+    std::vector<uint32_t> welded(mPoints.size());
+    for(size_t i = 0; i < order.size(); ++i) {
+      const Vec3& cur = mPoints[order[i]];
+      bool duplicate = false;
+      if(i) {
+        const Vec3& prev = mPoints[order[i - 1]];
+        duplicate = cur.x == prev.x && cur.y == prev.y && cur.z == prev.z;
+      }
+      welded[order[i]] = duplicate ? welded[order[i - 1]] : order[i];
+    }
+
+    //Climbing can get stuck on a local maximum unless all points are behind every face
+    const float tolerance = sConvexTolerance*mAABB.getDiagonal().length();
+    std::vector<std::pair<uint32_t, uint32_t>> edges;
+    edges.reserve(indices.size());
+    for(size_t t = 0; t < indices.size(); t += 3) {
+      if(indices[t] >= mPoints.size() || indices[t + 1] >= mPoints.size() || indices[t + 2] >= mPoints.size())
+        return;
+      uint32_t tri[3] = { welded[indices[t]], welded[indices[t + 1]], welded[indices[t + 2]] };
+      if(tri[0] == tri[1] || tri[1] == tri[2] || tri[0] == tri[2])
+        continue;
+
+      const Vec3& a = mPoints[tri[0]];
+      Vec3 normal = (mPoints[tri[1]] - a).cross(mPoints[tri[2]] - a);
+      float faceTolerance = tolerance*normal.length();
+      //Winding isn't known, so points only need to all be on the same side
+      bool anyFront = false;
+      bool anyBack = false;
+      for(const Vec3& p : mPoints) {
+        float d = normal.dot(p - a);
+        anyFront = anyFront || d > faceTolerance;
+        anyBack = anyBack || d < -faceTolerance;
+      }
+      if(anyFront && anyBack)
+        return;
+
+      for(int e = 0; e < 3; ++e) {
+        uint32_t from = tri[e];
+        uint32_t to = tri[(e + 1) % 3];
+        edges.push_back({ std::min(from, to), std::max(from, to) });
+      }
+    }
+
+    //A closed hull has every edge shared by exactly two faces, otherwise there could be extreme points the graph can't reach
+    std::sort(edges.begin(), edges.end());
+    size_t uniqueEdges = 0;
+    for(size_t i = 0; i < edges.size(); i += 2) {
+      if(i + 1 >= edges.size() || edges[i] != edges[i + 1] || (i + 2 < edges.size() && edges[i] == edges[i + 2]))
+        return;
+      edges[uniqueEdges++] = edges[i];
+    }
+    edges.resize(uniqueEdges);
+    if(edges.empty())
+      return;
+
+    mAdjacencyOffsets.resize(mPoints.size() + 1, 0);
+    for(const auto& edge : edges) {
+      ++mAdjacencyOffsets[edge.first + 1];
+      ++mAdjacencyOffsets[edge.second + 1];
+    }
+    for(size_t i = 1; i < mAdjacencyOffsets.size(); ++i)
+      mAdjacencyOffsets[i] += mAdjacencyOffsets[i - 1];
+    mAdjacency.resize(edges.size()*2);
+    std::vector<uint32_t> filled(mAdjacencyOffsets.begin(), mAdjacencyOffsets.end() - 1);
+    for(const auto& edge : edges) {
+      mAdjacency[filled[edge.first]++] = edge.second;
+      mAdjacency[filled[edge.second]++] = edge.first;
+    }
+    mClimbStart = edges.front().first;
+  }
+
+  void Model::_buildSupportGroups() {
+    mSupportGroups.resize((mPoints.size() + 3)/4);
+    for(size_t i = 0; i < mSupportGroups.size()*4; ++i) {
+      const Vec3& p = mPoints[std::min(i, mPoints.size() - 1)];
+      SupportGroup& group = mSupportGroups[i/4];
+      group.mX[i % 4] = p.x;
+      group.mY[i % 4] = p.y;
+      group.mZ[i % 4] = p.z;
+    }
+  }
+
   Vec3 Model::_getCubeSupport(const Vec3& dir) const {
     Vec3 result;
     for(int i = 0; i < 3; ++i)
@@ -471,6 +675,10 @@ namespace Syx {
       inst.setSubmodelInstLocalTransform(t);
     }
     mAABB.move(offset);
+    if(!mSupportGroups.empty())
+      _buildSupportGroups();
+    if(mType == ModelType::Composite)
+      _buildCompositeTree();
   }
 
   Model::Model(const Model& rhs)
@@ -481,7 +689,13 @@ namespace Syx {
     , mHandle(rhs.mHandle)
     , mInstances(rhs.mInstances)
     , mSubmodels(rhs.mSubmodels)
-    , mBroadphase(Create::aabbTree()) {
+    , mBroadphase(_copyBroadphase(rhs))
+    , mAdjacencyOffsets(rhs.mAdjacencyOffsets)
+    , mAdjacency(rhs.mAdjacency)
+    , mClimbStart(rhs.mClimbStart)
+    , mSupportGroups(rhs.mSupportGroups) {
+    if(mType == ModelType::Composite)
+      _buildCompositeTree();
   }
 
   Model& Model::operator=(const Model& rhs) {
@@ -492,11 +706,17 @@ namespace Syx {
     mHandle = rhs.mHandle;
     mInstances = rhs.mInstances;
     mSubmodels = rhs.mSubmodels;
-    mBroadphase = Create::aabbTree();
+    mBroadphase = _copyBroadphase(rhs);
+    mAdjacencyOffsets = rhs.mAdjacencyOffsets;
+    mAdjacency = rhs.mAdjacency;
+    mClimbStart = rhs.mClimbStart;
+    mSupportGroups = rhs.mSupportGroups;
+    if(mType == ModelType::Composite)
+      _buildCompositeTree();
     return *this;
   }
 
-  void Model::initComposite(const CompositeModelParam& param, const HandleMap<Model>& modelMap) {
+  void Model::initComposite(const CompositeModelParam& param, const SlotHandleMap<Model>& modelMap) {
     mSubmodels.resize(param.mSubmodels.size());
     mInstances.reserve(param.mInstances.size());
 
@@ -524,12 +744,22 @@ namespace Syx {
 
       mInstances.push_back(newInstance);
     }
+    _buildCompositeTree();
+  }
+
+  void Model::_buildCompositeTree() {
+    std::vector<InsertParam> params;
+    params.reserve(mInstances.size());
+    for(size_t i = 0; i < mInstances.size(); ++i)
+      params.push_back(InsertParam(BoundingVolume(mInstances[i].getAABB()), reinterpret_cast<void*>(i)));
+    mBroadphase->clear();
+    mBroadphase->buildStatic(params);
   }
 
   void Model::initEnvironment() {
-    //Should use allocator that is in cache instead of static nonsense
-    static std::vector<InsertParam> params;
-    params.clear();
+    //Only needed while building, so don't hold on to it afterwards since meshes can be huge
+    std::vector<InsertParam> params;
+    params.reserve(mTriangles.size()/3);
 
     for(size_t i = 0; i + 2 < mTriangles.size(); i += 3) {
       AABB bb;
@@ -542,5 +772,103 @@ namespace Syx {
       mTriangles[i].w = *reinterpret_cast<float*>(&handle);
     }
     mBroadphase->buildStatic(params);
+    _computeInternalEdges();
+  }
+
+  void Model::_computeInternalEdges() {
+    //Exact comparison since shared edges come from the same indexed points
+    auto pointLess = [](const Vec3& lhs, const Vec3& rhs) {
+      if(lhs.x != rhs.x)
+        return lhs.x < rhs.x;
+      if(lhs.y != rhs.y)
+        return lhs.y < rhs.y;
+      return lhs.z < rhs.z;
+    };
+    //Edges are the index of their first point in mTriangles, with the second being the next point in the triangle
+    auto getEnd = [](uint32_t edge) {
+      return edge - edge % 3 + (edge + 1) % 3;
+    };
+    //Ends ordered so the same edge from either triangle compares equal
+    auto edgeLess = [this, &pointLess, &getEnd](uint32_t lhs, uint32_t rhs) {
+      const Vec3* l[2] = { &mTriangles[lhs], &mTriangles[getEnd(lhs)] };
+      const Vec3* r[2] = { &mTriangles[rhs], &mTriangles[getEnd(rhs)] };
+      if(pointLess(*l[1], *l[0]))
+        std::swap(l[0], l[1]);
+      if(pointLess(*r[1], *r[0]))
+        std::swap(r[0], r[1]);
+      if(pointLess(*l[0], *r[0]) || pointLess(*r[0], *l[0]))
+        return pointLess(*l[0], *r[0]);
+      return pointLess(*l[1], *r[1]);
+    };
+
+    //Indices rather than points keep this small, since environments can have hundreds of thousands of triangles
+    std::vector<uint32_t> edges(mTriangles.size() - mTriangles.size() % 3);
+    for(size_t i = 0; i < edges.size(); ++i)
+      edges[i] = static_cast<uint32_t>(i);
+    std::sort(edges.begin(), edges.end(), edgeLess);
+
+    std::vector<int> flags(mTriangles.size()/3, 0);
+    for(size_t begin = 0; begin < edges.size();) {
+      size_t end = begin + 1;
+      while(end < edges.size() && !edgeLess(edges[begin], edges[end]))
+        ++end;
+      //Edges on the boundary or shared by more than two triangles are always real
+      if(end - begin == 2) {
+        for(size_t j = 0; j < 2; ++j) {
+          const uint32_t edge = edges[begin + j];
+          const uint32_t other = edges[begin + 1 - j];
+          const uint32_t triangle = edge - edge % 3;
+          const Vec3& a = mTriangles[triangle];
+          const Vec3& b = mTriangles[triangle + 1];
+          const Vec3& c = mTriangles[triangle + 2];
+          Vec3 normal = Vec3::ccwTriangleNormal(a, b, c).safeNormalized();
+          const Vec3& edgeStart = mTriangles[edge];
+          const Vec3& edgeEnd = mTriangles[getEnd(edge)];
+          //Neighbor's point that isn't on the shared edge
+          const Vec3& opposite = mTriangles[getEnd(getEnd(other))];
+          Vec3 toOpposite = opposite - edgeStart;
+          float height = -toOpposite.dot(normal);
+          float distance = std::sqrt(pointRayDist2(opposite, edgeStart, edgeEnd));
+          //Concave, flat, or only slightly convex, so the neighbor covers anything that would hit the edge
+          if(height <= distance*sInternalEdgeSin)
+            flags[triangle/3] |= 1 << (edge % 3);
+          if(height <= distance*sFlatEdgeSin)
+            flags[triangle/3] |= 1 << (edge % 3 + sConcaveEdgeShift);
+        }
+      }
+      begin = end;
+    }
+
+    //Second point's fourth component is unused like the first, so store the flags there
+    for(size_t i = 0; i < flags.size(); ++i)
+      std::memcpy(&mTriangles[i*3 + 1].w, &flags[i], sizeof(float));
+  }
+
+  Handle Model::getTriangleHandle(size_t triangle) const {
+    //Only the lower bits of the handle fit in the float
+    uint32_t result;
+    std::memcpy(&result, &mTriangles[triangle].w, sizeof(result));
+    return static_cast<Handle>(result);
+  }
+
+  int Model::getInternalEdges(size_t triangle) const {
+    int result;
+    std::memcpy(&result, &mTriangles[triangle + 1].w, sizeof(result));
+    return result & ((1 << sConcaveEdgeShift) - 1);
+  }
+
+  int Model::getConcaveEdges(size_t triangle) const {
+    int result;
+    std::memcpy(&result, &mTriangles[triangle + 1].w, sizeof(result));
+    return result >> sConcaveEdgeShift;
+  }
+
+  std::unique_ptr<Broadphase> Model::_copyBroadphase(const Model& rhs) {
+    if(rhs.mType == ModelType::Environment) {
+      if(rhs.mBroadphase)
+        return std::make_unique<QuantizedBVH>(static_cast<const QuantizedBVH&>(*rhs.mBroadphase));
+      return Create::quantizedBVH();
+    }
+    return Create::aabbTree(sModelTreeConfig);
   }
 }
\ No newline at end of file
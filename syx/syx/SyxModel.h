@@ -46,8 +46,10 @@ namespace Syx {
     Model& operator=(const Model& rhs);
 
     //Links pointers to local objects, so this needs to be at its final location
-    void initComposite(const CompositeModelParam& param, const HandleMap<Model>& modelMap);
+    void initComposite(const CompositeModelParam& param, const SlotHandleMap<Model>& modelMap);
     void initEnvironment();
+    //Precomputes what mesh support queries need. Indices are the triangles as indices into the points
+    void initMesh(const std::vector<size_t>& indices);
 
     void draw(const Transformer& toWorld) const;
 
@@ -59,6 +61,13 @@ namespace Syx {
     const std::vector<ModelInstance, AlignmentAllocator<ModelInstance>>& getSubmodelInstances() const { return mInstances; }
     const Broadphase& getBroadphase() const { return *mBroadphase; }
     const Vec3Vec& getTriangles() const { return mTriangles; }
+    //For environments, where triangle is the index of its first point in getTriangles
+    Handle getTriangleHandle(size_t triangle) const;
+    //Bit i is set if the edge from point i to point i + 1 of the triangle is shared with a neighbor at a concave, flat, or nearly flat angle,
+    //so anything hitting the edge from outside would also hit the neighbor
+    int getInternalEdges(size_t triangle) const;
+    //Subset of internal edges where the neighbor is flat or concave, so it also covers anything beyond the edge
+    int getConcaveEdges(size_t triangle) const;
 
     const AABB& getAABB(void) const { return mAABB; }
     AABB getWorldAABB(const Transformer& toWorld) const;
@@ -70,13 +79,26 @@ namespace Syx {
     //Input should have been transformed to alter primary axis, as from here it will be assumed to be y
 #ifdef SENABLED
     SFloats sGetSupport(SFloats dir) const;
+    //Same as above but meshes start searching from the hint and update it with the result
+    SFloats sGetSupport(SFloats dir, SupportHint& hint) const;
 #endif
 
     Vec3 getSupport(const Vec3& dir) const;
+    Vec3 getSupport(const Vec3& dir, SupportHint& hint) const;
   private:
+    //Points of a mesh transposed 4 at a time for brute force support queries
+    SAlign struct SupportGroup {
+      float mX[4];
+      float mY[4];
+      float mZ[4];
+    };
+
+    //Below this brute force over the support groups beats hill climbing
+    static const size_t sHillClimbMinPoints = 32;
 
 #ifdef SENABLED
-    SFloats _sGetMeshSupport(SFloats dir) const;
+    SFloats _sGetMeshSupport(SFloats dir, SupportHint* hint) const;
+    SFloats _sGetMeshSupportBruteForce(SFloats dir) const;
     //Shapes -1 to 1
     SFloats _sGetCubeSupport(SFloats dir) const;
     SFloats _sGetSphereSupport(SFloats dir) const;
@@ -91,7 +113,11 @@ namespace Syx {
     //Offset all model points by the given vector
     void _offset(const Vec3& offset);
 
-    Vec3 _getMeshSupport(const Vec3& dir) const;
+    Vec3 _getMeshSupport(const Vec3& dir, SupportHint* hint) const;
+    //Vertex to start hill climbing from, falling back to mClimbStart if the hint isn't on the hull
+    uint32_t _getClimbStart(const SupportHint* hint) const;
+    bool _canHillClimb() const { return !mAdjacencyOffsets.empty(); }
+    void _buildSupportGroups();
     Vec3 _getCubeSupport(const Vec3& dir) const;
     Vec3 _getSphereSupport(const Vec3& dir) const;
     Vec3 _getCylinderSupport(const Vec3& dir) const;
@@ -99,6 +125,13 @@ namespace Syx {
     Vec3 _getConeSupport(const Vec3& dir) const;
     Vec3 _getTriSupport(const Vec3& dir) const;
 
+    //Fills mBroadphase with the submodel instances so narrowphase can query them in model space
+    void _buildCompositeTree();
+    //Finds which triangle edges are shared with a neighbor that makes them internal, storing flags for getInternalEdges
+    void _computeInternalEdges();
+    //Environment hierarchies are copied since they're expensive to rebuild, other types get an empty tree to be filled after copying
+    static std::unique_ptr<Broadphase> _copyBroadphase(const Model& rhs);
+
     AABB _getCompositeWorldAABB(const Transformer& toWorld) const;
     AABB _getEnvironmentWorldAABB(const Transformer& toWorld) const;
     AABB _getSphereWorldAABB(const Transformer& toWorld) const;
@@ -122,5 +155,12 @@ namespace Syx {
     std::vector<Model, AlignmentAllocator<Model>> mSubmodels;
     //Composite and environment
     std::unique_ptr<Broadphase> mBroadphase;
+
+    //Only for meshes. Neighbors of point i are mAdjacency[mAdjacencyOffsets[i]] to mAdjacency[mAdjacencyOffsets[i + 1]].
+    //Empty if the mesh is too small, not convex, or not closed, in which case queries use brute force
+    std::vector<uint32_t> mAdjacencyOffsets;
+    std::vector<uint32_t> mAdjacency;
+    uint32_t mClimbStart = 0;
+    std::vector<SupportGroup, AlignmentAllocator<SupportGroup>> mSupportGroups;
   };
 }
\ No newline at end of file
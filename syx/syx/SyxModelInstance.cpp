@@ -34,7 +34,7 @@ namespace Syx {
 
   Vec3 ModelInstance::getSupport(const Vec3& dir) {
     SAlign Vec3 localDir = mWorldToModel.transformVector(dir);
-    SAlign Vec3 localSupport = mModel->getSupport(localDir);
+    SAlign Vec3 localSupport = mModel->getSupport(localDir, mSupportHint);
     return mModelToWorld.transformPoint(localSupport);
   }
 
@@ -44,6 +44,7 @@ namespace Syx {
 
   void ModelInstance::setModel(const Model& model) {
     mModel = &model;
+    mSupportHint.set(0);
     mSubmodelInstHandles.clear();
     if(mModel->getType() == ModelType::Composite) {
       for(size_t i = 0; i < mModel->getSubmodelInstances().size(); ++i)
@@ -82,7 +83,7 @@ namespace Syx {
 #ifdef SENABLED
   SFloats ModelInstance::sGetSupport(SFloats dir) {
     //Transform world vector to model space, get model space support point, and transform it back into world space
-    return mModelToWorld.toSIMDPoint().transformPoint(mModel->sGetSupport(mWorldToModel.toSIMDVector().transformVector(dir)));
+    return mModelToWorld.toSIMDPoint().transformPoint(mModel->sGetSupport(mWorldToModel.toSIMDVector().transformVector(dir), mSupportHint));
   }
 #else
   SVec3 ModelInstance::sGetSupport(const SVec3& dir) { return dir; }
@@ -1,10 +1,25 @@
 #pragma once
 #include "SyxTransform.h"
 #include "SyxMaterial.h"
+#include <atomic>
 
 namespace Syx {
   class Model;
 
+  //Mesh vertex that the last support query landed on, used as the starting point for the next one.
+  //Instances can be queried by multiple narrowphase threads at once, which is fine since a stale value only costs a few extra steps
+  struct SupportHint {
+    SupportHint() = default;
+    SupportHint(const SupportHint& rhs): mIndex(rhs.get()) {}
+    SupportHint& operator=(const SupportHint& rhs) { set(rhs.get()); return *this; }
+
+    uint32_t get() const { return mIndex.load(std::memory_order_relaxed); }
+    void set(uint32_t index) { mIndex.store(index, std::memory_order_relaxed); }
+
+  private:
+    std::atomic<uint32_t> mIndex{0};
+  };
+
   class ModelInstance {
   public:
     friend class Model;
@@ -56,5 +71,6 @@ namespace Syx {
     AABB mAABB;
     Handle mHandle;
     std::vector<Handle> mSubmodelInstHandles;
+    SupportHint mSupportHint;
   };
 }
\ No newline at end of file
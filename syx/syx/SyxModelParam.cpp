@@ -13,11 +13,13 @@ namespace Syx {
   void ModelParam::reserve(size_t size) {
     mPoints.reserve(size);
     mTriangles.reserve(size/3 + 1);
+    mIndices.reserve(size/3 + 1);
   }
 
   void ModelParam::reserve(size_t verts, size_t indices) {
     mPoints.reserve(verts);
     mTriangles.reserve(indices);
+    mIndices.reserve(indices);
   }
 
   void ModelParam::addVertex(const Vec3& v) {
@@ -28,14 +30,21 @@ namespace Syx {
     mTriangles.push_back(mPoints[a]);
     mTriangles.push_back(mPoints[b]);
     mTriangles.push_back(mPoints[c]);
+    mIndices.push_back(a);
+    mIndices.push_back(b);
+    mIndices.push_back(c);
   }
 
   void ModelParam::addIndex(size_t i) {
     mTriangles.push_back(mPoints[i]);
+    mIndices.push_back(i);
   }
 
   Model ModelParam::toModel(void) const {
-    return Model(mPoints, mTriangles, mEnvironment);
+    Model result(mPoints, mTriangles, mEnvironment);
+    if(!mEnvironment)
+      result.initMesh(mIndices);
+    return result;
   }
 
   void CompositeModelParam::reserve(size_t submodels, size_t instances) {
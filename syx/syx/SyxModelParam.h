@@ -19,6 +19,8 @@ namespace Syx {
   private:
     Vec3Vec mPoints;
     Vec3Vec mTriangles;
+    //Same triangles as mTriangles but as indices into mPoints, needed to find vertex adjacency
+    std::vector<size_t> mIndices;
     bool mEnvironment;
   };
 
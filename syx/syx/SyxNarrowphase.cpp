@@ -15,9 +15,12 @@
 
 namespace Syx {
   float Narrowphase::sepaEpsilon = SYX_EPSILON;
+  float Narrowphase::sCacheTolerance = 0.005f;
+  float Narrowphase::sEdgeTolerance = 0.001f;
 
   Narrowphase::Narrowphase()
-    : mTempTri(ModelType::Triangle) {
+    : mTempTri(ModelType::Triangle)
+    , mDeferContacts(false) {
     _initHandlers();
   }
 
@@ -40,6 +43,8 @@ namespace Syx {
     mEdges = rhs.mEdges;
     mVerts = rhs.mVerts;
     mTempTri = rhs.mTempTri;
+    mDeferContacts = rhs.mDeferContacts;
+    mDeferredContacts = rhs.mDeferredContacts;
     _initHandlers();
     return *this;
   }
@@ -55,10 +60,19 @@ namespace Syx {
   }
 
   bool Narrowphase::_gjk(void) {
-    mSimplex.initialize();
     //Arbitrary start direction
-    SAlign Vec3 curDir(Vec3::UnitY);
+    return _gjk(Vec3::UnitY);
+  }
+
+  bool Narrowphase::_gjk(const Vec3& startDir) {
+    mSimplex.initialize();
+    SAlign Vec3 curDir(startDir);
     SupportPoint support = _getSupport(curDir);
+    //Any direction can show they're separate, and one cached from last time usually does
+    if(support.mSupport.dot(curDir) < 0.0f) {
+      mGJKAxis = curDir;
+      return false;
+    }
 
     int iterationCap = 100;
     int iteration = 0;
@@ -67,6 +81,7 @@ namespace Syx {
       mSimplex.add(support, false);
       curDir = mSimplex.solve();
 
+      mGJKAxis = curDir;
       if(mSimplex.containsOrigin())
         return true;
       else if(mSimplex.isDegenerate())
@@ -251,11 +266,25 @@ namespace Syx {
   }
 
   void Narrowphase::_gjkEPAHandler(void) {
+    //Pairs that touched recently still have a manifold, which remembers what was found last time
+    Manifold* manifold = mSpace->findManifold(*mInstA, *mInstB);
+    SAlign Transformer bToA = Transformer::combined(mInstB->getModelToWorld(), mInstA->getWorldToModel());
+    SAlign Vec3 startDir = Vec3::UnitY;
+    if(manifold && manifold->mNarrowphaseCache.mValid) {
+      const NarrowphaseCache& cache = manifold->mNarrowphaseCache;
+      //The same placement would give the same result. Colliding pairs add a contact per test, so are only skipped once that can't add anything new
+      if(_isPairUnchanged(cache, bToA) && (!cache.mColliding || manifold->mSize == MAX_CONTACTS))
+        return;
+      if(cache.mAxis.length2() > SYX_EPSILON)
+        startDir = cache.mAxis;
+    }
+
     bool collision;
     if(gOptions.mSimdFlags & SyxOptions::SIMD::GJK)
-      collision = _sGJK();
+      collision = _sGJK(startDir);
     else
-      collision = _gjk();
+      collision = _gjk(startDir);
+    SAlign Vec3 axis = mGJKAxis;
 
     if(collision) {
       if(gOptions.mDebugFlags & SyxOptions::Debug::DrawCollidingPairs)
@@ -268,16 +297,50 @@ namespace Syx {
       else
         normal = _epa(resultPoint);
 
-      if(normal != Vec3::Zero)
+      if(normal != Vec3::Zero) {
         _submitContact(resultPoint, normal);
+        //If they separate it'll most likely be along the normal
+        axis = -normal;
+      }
       else
         Interface::log("Invalid contact normal");
     }
+
+    //New manifolds aren't cached until their next test since they might not exist yet if contacts are deferred
+    if(manifold) {
+      NarrowphaseCache& cache = manifold->mNarrowphaseCache;
+      cache.mBToA = bToA;
+      cache.mAxis = axis;
+      cache.mModelA = &mInstA->getModel();
+      cache.mModelB = &mInstB->getModel();
+      cache.mColliding = collision;
+      cache.mValid = true;
+    }
+  }
+
+  bool Narrowphase::_isPairUnchanged(const NarrowphaseCache& cache, const Transformer& bToA) const {
+    if(cache.mModelA != &mInstA->getModel() || cache.mModelB != &mInstB->getModel())
+      return false;
+
+    //Bound how far any point in B's bounds moved relative to A, in world space so A's scale doesn't change the tolerance
+    const Transformer& aToWorld = mInstA->getModelToWorld();
+    const AABB& boundsB = mInstB->getModel().getAABB();
+    float drift = aToWorld.transformVector(bToA.mPos - cache.mBToA.mPos).length();
+    for(int i = 0; i < 3; ++i) {
+      float extent = std::max(std::abs(boundsB.getMin()[i]), std::abs(boundsB.getMax()[i]));
+      drift += aToWorld.transformVector(bToA.mScaleRot.getCol(i) - cache.mBToA.mScaleRot.getCol(i)).length()*extent;
+    }
+    return drift <= sCacheTolerance;
   }
 
   void Narrowphase::processPairQuery(const std::vector<std::pair<ResultNode, ResultNode>>& pairs, Space& space) {
+    processPairQuery(pairs, 0, pairs.size(), space);
+  }
+
+  void Narrowphase::processPairQuery(const std::vector<std::pair<ResultNode, ResultNode>>& pairs, size_t begin, size_t end, Space& space) {
     mSpace = &space;
-    for(auto& pair : pairs) {
+    for(size_t i = begin; i < end; ++i) {
+      const auto& pair = pairs[i];
       mA = reinterpret_cast<PhysicsObject*>(pair.first.mUserdata);
       mB = reinterpret_cast<PhysicsObject*>(pair.second.mUserdata);
       //Eventually broadphase shouldn't even return these in the query
@@ -287,15 +350,28 @@ namespace Syx {
       if(mA->getHandle() < mB->getHandle())
         std::swap(mA, mB);
 
-      //Update these values in case the primitive narrowphase is used for this
-      mPrimitive.set(mInstA, mInstB, mSpace, this);
       mInstA = &mA->getCollider()->getModelInstance();
       mInstB = &mB->getCollider()->getModelInstance();
+      //Update these values in case the primitive narrowphase is used for this
+      mPrimitive.set(mInstA, mInstB, mSpace, this);
 
       _handlePair();
     }
   }
 
+  void Narrowphase::setDeferContacts(bool defer) {
+    mDeferContacts = defer;
+  }
+
+  void Narrowphase::submitDeferredContacts(Space& space) {
+    for(const DeferredContact& deferred : mDeferredContacts) {
+      Manifold* manifold = space.getManifold(*deferred.mA, *deferred.mB, *deferred.mInstA, *deferred.mInstB);
+      if(manifold)
+        manifold->addContact(deferred.mContact, deferred.mNormal);
+    }
+    mDeferredContacts.clear();
+  }
+
   void Narrowphase::_swapAB() {
     std::swap(mA, mB);
     std::swap(mInstA, mInstB);
@@ -303,11 +379,34 @@ namespace Syx {
   }
 
   BroadphaseContext& Narrowphase::_getBroadphaseContext(const Broadphase& broadphase) {
-    // TODO: better solution for re-use
-    mBroadphaseContext = broadphase.createHitContext();
+    if(mContextBroadphase != &broadphase) {
+      mContextBroadphase = &broadphase;
+      mBroadphaseContext = broadphase.createHitContext();
+    }
     return *mBroadphaseContext;
   }
 
+  BroadphaseContext& Narrowphase::_pushCompositeContext(const Broadphase& broadphase) {
+    if(mCompositeDepth == mCompositeContexts.size())
+      mCompositeContexts.emplace_back();
+    CompositeContext& level = mCompositeContexts[mCompositeDepth++];
+    if(level.mBroadphase != &broadphase) {
+      level.mBroadphase = &broadphase;
+      level.mContext = broadphase.createHitContext();
+    }
+    return *level.mContext;
+  }
+
+  void Narrowphase::_popCompositeContext() {
+    --mCompositeDepth;
+  }
+
+  void Narrowphase::clearContexts() {
+    mBroadphaseContext.reset();
+    mContextBroadphase = nullptr;
+    mCompositeContexts.clear();
+  }
+
   void Narrowphase::processRayQuery(const std::vector<ResultNode>& /*objs*/, const Vec3& /*start*/, const Vec3& /*end*/, Space& /*space*/) {
 
   }
@@ -336,23 +435,40 @@ namespace Syx {
     mPrimitive.sphereSphere();
   }
 
+  void Narrowphase::_triangleSphereHandler() {
+    if(!mPrimitive.triangleSphere(mEnvTri))
+      _gjkEPAHandler();
+  }
+
+  void Narrowphase::_triangleCapsuleHandler() {
+    if(!mPrimitive.triangleCapsule(mEnvTri))
+      _gjkEPAHandler();
+  }
+
+  void Narrowphase::_triangleCubeHandler() {
+    if(!mPrimitive.triangleCube(mEnvTri))
+      _gjkEPAHandler();
+  }
+
   void Narrowphase::_compositeOtherHandler() {
     //Transform b's bounding box into a's space so it can test against all a's submodels
     AABB localB = mB->getCollider()->getAABB().transform(mInstA->getWorldToModel());
     ModelInstance* compositeRoot = mInstA;
 
-    //This would be the place to have a local space broadphase for composite models, but we're doing them all now
+    //Not _getBroadphaseContext since submodels could be composites that query their own trees while these results are in use
+    BroadphaseContext& context = _pushCompositeContext(compositeRoot->getModel().getBroadphase());
+    context.queryVolume(localB);
     auto& subInsts = compositeRoot->getModel().getSubmodelInstances();
-    for(size_t i = 0; i < subInsts.size(); ++i) {
+    for(const ResultNode& result : context.get()) {
+      size_t i = reinterpret_cast<size_t>(result.mUserdata);
       const ModelInstance& subInst = subInsts[i];
-      if(localB.overlapping(subInst.getAABB())) {
-        //Construct a model instance with the combined transforms so there aren't extra transforms when getting supports
-        ModelInstance tempWorldInst = ModelInstance::combined(*compositeRoot, subInst, subInst, compositeRoot->getSubmodelInstHandle(i));
-        mInstA = &tempWorldInst;
-        mPrimitive.set(mInstA, mInstB, mSpace, this);
-        _handlePair();
-      }
+      //Construct a model instance with the combined transforms so there aren't extra transforms when getting supports
+      ModelInstance tempWorldInst = ModelInstance::combined(*compositeRoot, subInst, subInst, compositeRoot->getSubmodelInstHandle(i));
+      mInstA = &tempWorldInst;
+      mPrimitive.set(mInstA, mInstB, mSpace, this);
+      _handlePair();
     }
+    _popCompositeContext();
   }
 
   void Narrowphase::_otherCompositeHandler() {
@@ -370,25 +486,24 @@ namespace Syx {
     ModelInstance* rootA = mInstA;
     ModelInstance* rootB = mInstB;
 
-    //N^2 composite to composite. Needs broadphase!
+    //Traverse both submodel trees together to find overlapping submodel pairs
+    BroadphaseContext& context = _pushCompositeContext(rootA->getModel().getBroadphase());
+    context.queryTree(rootB->getModel().getBroadphase(), localBToLocalA);
+    auto& subInstsA = rootA->getModel().getSubmodelInstances();
     auto& subInstsB = rootB->getModel().getSubmodelInstances();
-    for(size_t i = 0; i < subInstsB.size(); ++i) {
+    for(const std::pair<ResultNode, ResultNode>& pair : context.getTreePairs()) {
+      size_t j = reinterpret_cast<size_t>(pair.first.mUserdata);
+      size_t i = reinterpret_cast<size_t>(pair.second.mUserdata);
+      const ModelInstance& subInstA = subInstsA[j];
       const ModelInstance& subInstB = subInstsB[i];
-      AABB bInA = subInstB.getAABB().transform(localBToLocalA);
+      ModelInstance tempWorldInstA = ModelInstance::combined(*rootA, subInstA, subInstA, rootA->getSubmodelInstHandle(j));
       ModelInstance tempWorldInstB = ModelInstance::combined(*rootB, subInstB, subInstB, rootB->getSubmodelInstHandle(i));
-
-      auto& subInstsA = rootA->getModel().getSubmodelInstances();
-      for(size_t j = 0; j < subInstsA.size(); ++j) {
-        const ModelInstance& subInstA = subInstsA[j];
-        if(subInstA.getAABB().overlapping(bInA)) {
-          ModelInstance tempWorldInstA = ModelInstance::combined(*rootA, subInstA, subInstA, rootA->getSubmodelInstHandle(j));
-          mInstA = &tempWorldInstA;
-          mInstB = &tempWorldInstB;
-          mPrimitive.set(mInstA, mInstB, mSpace, this);
-          _handlePair();
-        }
-      }
+      mInstA = &tempWorldInstA;
+      mInstB = &tempWorldInstB;
+      mPrimitive.set(mInstA, mInstB, mSpace, this);
+      _handlePair();
     }
+    _popCompositeContext();
   }
 
   void Narrowphase::_envOtherHandler() {
@@ -396,21 +511,26 @@ namespace Syx {
     AABB localB = mB->getCollider()->getAABB().transform(mInstA->getWorldToModel());
     ModelInstance* envRoot = mInstA;
     _getBroadphaseContext(mInstA->getModel().getBroadphase()).queryVolume(localB);
-    const Vec3Vec& tris = mInstA->getModel().getTriangles();
 
     ModelInstance tempInst(mTempTri, envRoot->getModelToWorld(), envRoot->getWorldToModel());
-
-    for(const ResultNode& result : mBroadphaseContext->get()) {
-      size_t triIndex = reinterpret_cast<size_t>(result.mUserdata);
-      const Vec3& a = tris[triIndex];
-      Handle instHandle = *reinterpret_cast<const Handle*>(&a.w);
-
-      tempInst.setHandle(instHandle);
-      mTempTri.setTriangle(a, tris[triIndex + 1], tris[triIndex + 2]);
-      mInstA = &tempInst;
-      mPrimitive.set(mInstA, mInstB, mSpace, this);
-      _handlePair();
-    }
+    for(const ResultNode& result : mBroadphaseContext->get())
+      _handleEnvTriangle(tempInst, envRoot->getModel(), reinterpret_cast<size_t>(result.mUserdata));
+  }
+
+  void Narrowphase::_handleEnvTriangle(ModelInstance& triInst, const Model& env, size_t triIndex) {
+    const Vec3Vec& tris = env.getTriangles();
+    const Transformer& toWorld = triInst.getModelToWorld();
+    for(int i = 0; i < 3; ++i)
+      mEnvTri.mPoints[i] = toWorld.transformPoint(tris[triIndex + i]);
+    mEnvTri.mNormal = Vec3::ccwTriangleNormal(mEnvTri.mPoints[0], mEnvTri.mPoints[1], mEnvTri.mPoints[2]).safeNormalized();
+    mEnvTri.mInternalEdges = env.getInternalEdges(triIndex);
+    mEnvTri.mConcaveEdges = env.getConcaveEdges(triIndex);
+
+    triInst.setHandle(env.getTriangleHandle(triIndex));
+    mTempTri.setTriangle(tris[triIndex], tris[triIndex + 1], tris[triIndex + 2]);
+    mInstA = &triInst;
+    mPrimitive.set(mInstA, mInstB, mSpace, this);
+    _handlePair();
   }
 
   void Narrowphase::_otherEnvHandler() {
@@ -428,7 +548,6 @@ namespace Syx {
     //Local composite to local environment
     Transformer compToEnv = Transformer::combined(compRoot->getModelToWorld(), envRoot->getWorldToModel());
     ModelInstance tempTriInst(mTempTri, envRoot->getModelToWorld(), envRoot->getWorldToModel());
-    const Vec3Vec& tris = mInstA->getModel().getTriangles();
 
     auto& subInsts = compRoot->getModel().getSubmodelInstances();
     //Transform each submodel aabb into env local space and query broadphase, handle pairs of results
@@ -444,17 +563,8 @@ namespace Syx {
 
       ModelInstance tempSubInst = ModelInstance::combined(*compRoot, subInst, subInst, compRoot->getSubmodelInstHandle(i));
       mInstB = &tempSubInst;
-      for(const ResultNode& result : context.get()) {
-        size_t triIndex = reinterpret_cast<size_t>(result.mUserdata);
-        const Vec3& a = tris[triIndex];
-        Handle instHandle = *reinterpret_cast<const Handle*>(&a.w);
-
-        tempTriInst.setHandle(instHandle);
-        mTempTri.setTriangle(a, tris[triIndex + 1], tris[triIndex + 2]);
-        mInstA = &tempTriInst;
-        mPrimitive.set(mInstA, mInstB, mSpace, this);
-        _handlePair();
-      }
+      for(const ResultNode& result : context.get())
+        _handleEnvTriangle(tempTriInst, envRoot->getModel(), reinterpret_cast<size_t>(result.mUserdata));
     }
   }
 
@@ -487,6 +597,11 @@ namespace Syx {
     _getHandler(ModelType::Composite, ModelType::Environment) = &Narrowphase::_compositeEnvHandler;
 
     _getHandler(ModelType::Sphere, ModelType::Sphere) = &Narrowphase::_sphereSphereHandler;
+
+    //Environment triangles are always a
+    _getHandler(ModelType::Triangle, ModelType::Sphere) = &Narrowphase::_triangleSphereHandler;
+    _getHandler(ModelType::Triangle, ModelType::Capsule) = &Narrowphase::_triangleCapsuleHandler;
+    _getHandler(ModelType::Triangle, ModelType::Cube) = &Narrowphase::_triangleCubeHandler;
   }
 
   CollisionHandler& Narrowphase::_getHandler(int modelTypeA, int modelTypeB) {
@@ -506,9 +621,56 @@ namespace Syx {
   }
 
   void Narrowphase::_submitContact(const ContactPoint& contact, const Vec3& normal) {
+    SAlign ContactPoint result = contact;
+    SAlign Vec3 resultNormal = normal;
+    if(mInstA->getModelType() == ModelType::Triangle && !_filterInternalEdge(result, resultNormal))
+      return;
+
+    if(mDeferContacts) {
+      mDeferredContacts.emplace_back(mA, mB, mInstA, mInstB, result, resultNormal);
+      return;
+    }
+
     Manifold* manifold = mSpace->getManifold(*mA, *mB, *mInstA, *mInstB);
     if(manifold)
-      manifold->addContact(contact, normal);
+      manifold->addContact(result, resultNormal);
+  }
+
+  //Shapes sliding over a seam between triangles can hit the edge of the next one, giving a normal that bumps them up.
+  //Neighbors already cover anything that could hit an internal edge, so those contacts use the face normal instead
+  bool Narrowphase::_filterInternalEdge(ContactPoint& contact, Vec3& normal) const {
+    if(!mEnvTri.mInternalEdges)
+      return true;
+
+    const Vec3* points = mEnvTri.mPoints;
+    float s, t;
+    closestOnTri(contact.mObjA.mCurrentWorld, points[0], points[1], points[2], &s, &t);
+    //Edges the contact is on, with the same bits as the internal edge flags. On two edges means it's on the vertex between them
+    int onEdges = 0;
+    if(t <= sEdgeTolerance)
+      onEdges |= 1 << 0;
+    if(1.0f - s - t <= sEdgeTolerance)
+      onEdges |= 1 << 1;
+    if(s <= sEdgeTolerance)
+      onEdges |= 1 << 2;
+    if(!onEdges || (onEdges & mEnvTri.mInternalEdges) != onEdges)
+      return true;
+
+    //Normal points from b into the triangle, so if it points inwards across a concave edge b is beyond it, where the neighbor gives the same contact
+    for(int i = 0; i < 3; ++i) {
+      const int edge = 1 << i;
+      if(onEdges & mEnvTri.mConcaveEdges & edge) {
+        Vec3 inwards = mEnvTri.mNormal.cross(points[(i + 1) % 3] - points[i]).safeNormalized();
+        if(normal.dot(inwards) > sEdgeTolerance)
+          return false;
+      }
+    }
+
+    //Normal points from b into the triangle, so keep it on the same side of the face
+    const Vec3 faceNormal = normal.dot(mEnvTri.mNormal) >= 0.0f ? mEnvTri.mNormal : -mEnvTri.mNormal;
+    normal = faceNormal;
+    contact.mPenetration = (contact.mObjB.mCurrentWorld - contact.mObjA.mCurrentWorld).dot(faceNormal);
+    return contact.mPenetration > 0.0f;
   }
 
 #ifdef SENABLED
@@ -539,10 +701,14 @@ namespace Syx {
     return _sGetSupport(dir, unused);
   }
 
-  bool Narrowphase::_sGJK(void) {
+  bool Narrowphase::_sGJK(const Vec3& startDir) {
     mSimplex.initialize();
-    //Arbitrary start direction
-    SupportPoint support = _sGetSupport(SVec3::UnitY);
+    SupportPoint support = _sGetSupport(startDir);
+    //Any direction can show they're separate, and one cached from last time usually does
+    if(support.mSupport.dot(startDir) < 0.0f) {
+      mGJKAxis = startDir;
+      return false;
+    }
 
     int iterationCap = 100;
     int iteration = 0;
@@ -551,6 +717,7 @@ namespace Syx {
       mSimplex.add(support, false);
 
       SFloats newDir = mSimplex.sSolve();
+      SVec3::store(newDir, mGJKAxis);
 
       if(mSimplex.containsOrigin())
         return true;
@@ -6,6 +6,7 @@
 #include "SyxAlignmentAllocator.h"
 #include "SyxModel.h"
 #include "SyxPrimitiveNarrowphase.h"
+#include "SyxManifold.h"
 
 namespace Syx {
   class Space;
@@ -18,6 +19,35 @@ namespace Syx {
   class Narrowphase;
   typedef void(Narrowphase::*CollisionHandler)(void);
 
+  //Contact found while manifold lookup is deferred, applied later by Narrowphase::submitDeferredContacts
+  SAlign struct DeferredContact {
+    DeferredContact(PhysicsObject* a, PhysicsObject* b, ModelInstance* instA, ModelInstance* instB, const ContactPoint& contact, const Vec3& normal)
+      : mA(a)
+      , mB(b)
+      , mInstA(instA)
+      , mInstB(instB)
+      , mContact(contact)
+      , mNormal(normal) {
+    }
+
+    PhysicsObject* mA;
+    PhysicsObject* mB;
+    ModelInstance* mInstA;
+    ModelInstance* mInstB;
+    SAlign ContactPoint mContact;
+    SAlign Vec3 mNormal;
+  };
+
+  //Environment triangle currently being tested, in world space
+  SAlign struct EnvTriangle {
+    SAlign Vec3 mPoints[3];
+    //Unit length normal of counterclockwise points
+    SAlign Vec3 mNormal;
+    //Same as Model::getInternalEdges and Model::getConcaveEdges
+    int mInternalEdges;
+    int mConcaveEdges;
+  };
+
   class Narrowphase {
   public:
     friend Simplex;
@@ -32,9 +62,18 @@ namespace Syx {
     Narrowphase& operator=(const Narrowphase& rhs);
 
     void processPairQuery(const std::vector<std::pair<ResultNode, ResultNode>>& pairs, Space& space);
+    //Process pairs in [begin, end). Safe to call concurrently on different narrowphases if contacts are deferred
+    void processPairQuery(const std::vector<std::pair<ResultNode, ResultNode>>& pairs, size_t begin, size_t end, Space& space);
     void processRayQuery(const std::vector<ResultNode>& objs, const Vec3& start, const Vec3& end, Space& space);
     void processVolumeQuery(const std::vector<ResultNode>& objs, const BoundingVolume& volume, Space& space);
 
+    //When deferred, contacts are stored instead of going straight to the space's manifolds, since creating manifolds isn't thread safe
+    void setDeferContacts(bool defer);
+    //Add all deferred contacts to their manifolds in the order they were found, then clear them
+    void submitDeferredContacts(Space& space);
+    //Drops cached broadphase contexts, since a model's broadphase could be replaced by one at the same address
+    void clearContexts();
+
   private:
     //Once m_a, m_b, m_space are set, this is called to find the right pair function and call it, which takes care of everything
     void _handlePair(void);
@@ -42,6 +81,9 @@ namespace Syx {
 
     void _gjkEPAHandler();
     void _sphereSphereHandler();
+    void _triangleSphereHandler();
+    void _triangleCapsuleHandler();
+    void _triangleCubeHandler();
     void _compositeOtherHandler();
     void _otherCompositeHandler();
     void _compositeCompositeHandler();
@@ -50,10 +92,13 @@ namespace Syx {
     void _envEnvHandler();
     void _envCompositeHandler();
     void _compositeEnvHandler();
+    //Sets up mEnvTri and the triangle instance from the environment's triangle then handles it against mInstB
+    void _handleEnvTriangle(ModelInstance& triInst, const Model& env, size_t triIndex);
 
     void _initHandlers(void);
 
     bool _gjk(void);
+    bool _gjk(const Vec3& startDir);
 
     Vec3 _epa(ContactPoint& result);
     void _initEPASimplex(void);
@@ -65,6 +110,8 @@ namespace Syx {
     void _submitContact(const Vec3& worldA, const Vec3& worldB, const Vec3& normal);
     void _submitContact(const Vec3& worldA, const Vec3& worldB, const Vec3& normal, float penetration);
     void _submitContact(const ContactPoint& contact, const Vec3& normal);
+    //Moves contacts on internal edges of mEnvTri to the face normal. False if the contact should be discarded
+    bool _filterInternalEdge(ContactPoint& contact, Vec3& normal) const;
 
     SupportPoint _getSupport(const Vec3& dir);
 
@@ -74,18 +121,31 @@ namespace Syx {
     void _sDeleteInteriorTris(SFloats newPoint);
     void _sReconstructTriangles(SFloats newSupport);
 
-    bool _sGJK(void);
+    bool _sGJK(const Vec3& startDir);
     Vec3 _sEPA(ContactPoint& result);
 
     void _drawEPA(SupportTri* bestTri);
 
+    //True if the current pair is the same models in nearly the same relative placement as when the cache was stored
+    bool _isPairUnchanged(const NarrowphaseCache& cache, const Transformer& bToA) const;
+
     void _swapAB();
     //Returns a cached context if available, otherwise creates a new one
     BroadphaseContext& _getBroadphaseContext(const Broadphase& broadphase);
+    //Same as _getBroadphaseContext but for composite submodel queries, which nest when submodels are composites themselves.
+    //Each call must be matched by _popCompositeContext once its results are no longer in use
+    BroadphaseContext& _pushCompositeContext(const Broadphase& broadphase);
+    void _popCompositeContext();
 
     static float sepaEpsilon;
+    //How far any point on a pair can move relative to the other before a cached result is recomputed
+    static float sCacheTolerance;
+    //Barycentric distance from an edge for a contact to be considered on it, and how far a normal can lean across an edge before it's beyond it
+    static float sEdgeTolerance;
 
     Simplex mSimplex;
+    //Last search direction of GJK, which separates the shapes when it returns false
+    SAlign Vec3 mGJKAxis;
     PhysicsObject* mA;
     PhysicsObject* mB;
     ModelInstance* mInstA;
@@ -99,7 +159,18 @@ namespace Syx {
     std::vector<SupportEdge, AlignmentAllocator<SupportEdge>> mEdges;
     std::vector<SupportPoint, AlignmentAllocator<SupportPoint>> mVerts;
     std::unique_ptr<BroadphaseContext> mBroadphaseContext;
+    const Broadphase* mContextBroadphase = nullptr;
+    struct CompositeContext {
+      std::unique_ptr<BroadphaseContext> mContext;
+      const Broadphase* mBroadphase = nullptr;
+    };
+    //One per level of composite nesting, each only recreated when the broadphase queried at that level changes
+    std::vector<CompositeContext> mCompositeContexts;
+    size_t mCompositeDepth = 0;
     Model mTempTri;
+    EnvTriangle mEnvTri;
+    bool mDeferContacts;
+    std::vector<DeferredContact, AlignmentAllocator<DeferredContact>> mDeferredContacts;
 
     static const int sHandlerCount = ModelType::Count*ModelType::Count;
     static const int sHandlerRowCount = ModelType::Count;
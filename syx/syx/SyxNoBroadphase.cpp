@@ -42,9 +42,10 @@ namespace Syx {
 
   class PairContext : public BroadphasePairContext, public ContextBase {
   public:
-    PairContext(const NoBroadphase& broadphase, std::weak_ptr<bool> existenceTracker, const std::vector<std::pair<ResultNode, ResultNode>>& res)
+    PairContext(const NoBroadphase& broadphase, std::weak_ptr<bool> existenceTracker, const std::vector<std::pair<ResultNode, ResultNode>>& res, const std::vector<std::pair<ResultNode, ResultNode>>& previous)
       : ContextBase(broadphase, std::move(existenceTracker))
-      , mResult(res) {
+      , mResult(res)
+      , mPrevious(previous) {
     }
 
     void queryPairs() override {
@@ -57,8 +58,18 @@ namespace Syx {
       return mResult;
     }
 
+    // Everything is recomputed each query, so all old pairs are removed and all new ones added
+    const std::vector<std::pair<ResultNode, ResultNode>>& getAdded() const override {
+      return mResult;
+    }
+
+    const std::vector<std::pair<ResultNode, ResultNode>>& getRemoved() const override {
+      return mPrevious;
+    }
+
   private:
     const std::vector<std::pair<ResultNode, ResultNode>>& mResult;
+    const std::vector<std::pair<ResultNode, ResultNode>>& mPrevious;
   };
 
   NoBroadphase::NoBroadphase()
@@ -86,6 +97,7 @@ namespace Syx {
   void NoBroadphase::clear() {
     mHits.clear();
     mPairs.clear();
+    mPreviousPairs.clear();
   }
 
   //This isn't a real broadphase, so there's nothing to update
@@ -95,6 +107,7 @@ namespace Syx {
 
   //Contexts are all just pointing at the internal container so just need to update it
   void NoBroadphase::queryPairs(BroadphasePairContext&) const {
+    mPreviousPairs.swap(mPairs);
     mPairs.clear();
     for(size_t i = 0; i + 1 < mHits.size(); ++i)
       for(size_t j = i + 1; j < mHits.size(); ++j)
@@ -114,6 +127,6 @@ namespace Syx {
   }
 
   std::unique_ptr<BroadphasePairContext> NoBroadphase::createPairContext() const {
-    return std::make_unique<PairContext>(*this, mExistenceTracker, mPairs);
+    return std::make_unique<PairContext>(*this, mExistenceTracker, mPairs, mPreviousPairs);
   }
 }
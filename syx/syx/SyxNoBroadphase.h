@@ -23,6 +23,7 @@ namespace Syx {
   private:
     std::vector<ResultNode> mHits;
     mutable std::vector<std::pair<ResultNode, ResultNode>> mPairs;
+    mutable std::vector<std::pair<ResultNode, ResultNode>> mPreviousPairs;
     std::shared_ptr<bool> mExistenceTracker;
   };
 }
\ No newline at end of file
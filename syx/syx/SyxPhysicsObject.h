@@ -31,6 +31,7 @@ namespace Syx {
 
     bool isStatic();
 
+    //Objects in a space should go through RigidbodyStore::setAsleep so the space's awake bodies stay current
     void setAsleep(bool asleep);
     bool getAsleep();
     //If this is inactive enough that it could go to sleep if everything else was in place
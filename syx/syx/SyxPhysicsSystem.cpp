@@ -7,7 +7,10 @@ namespace Syx {
 
   float PhysicsSystem::sSimRate = 1.0f/60.0f;
 
-  PhysicsSystem::PhysicsSystem() {
+  PhysicsSystem::PhysicsSystem()
+    : mAccumulated(0.0f)
+    , mSubsteps(1)
+    , mSolverIterations(ConstraintSystem::sIterations) {
     mCubeModel = _addModel(Model(ModelType::Cube));
     mSphereModel = _addModel(Model(ModelType::Sphere));
     mCylinderModel = _addModel(Model(ModelType::Cylinder));
@@ -18,24 +21,25 @@ namespace Syx {
   }
 
   void PhysicsSystem::update(float dt) {
-    static float accumulated = 0.0f;
+    update(dt, Interface::getOptions());
+  }
+
+  void PhysicsSystem::update(float dt, const SyxOptions& options) {
     int maxUpdates = 5;
     int updates = 0;
     DebugDrawer& drawer = DebugDrawer::get();
 
-    gOptions = Interface::getOptions();
+    gOptions = options;
 
-    accumulated += dt;
-    while(accumulated >= sSimRate && updates++ < maxUpdates) {
-      drawer.clear();
-      accumulated -= sSimRate;
-      for(auto it = mSpaces.begin(); it != mSpaces.end(); ++it)
-        (*it).update(sSimRate);
+    mAccumulated += dt;
+    while(mAccumulated >= sSimRate && updates++ < maxUpdates) {
+      mAccumulated -= sSimRate;
+      _stepSpaces(sSimRate/static_cast<float>(mSubsteps));
     }
 
     //Subtract off the rest of the rest of the time if we hit the update cap to keep time from building up
-    while(accumulated >= sSimRate)
-      accumulated -= sSimRate;
+    while(mAccumulated >= sSimRate)
+      mAccumulated -= sSimRate;
 
     //Update when game is paused to populate debug drawing
     if(dt == 0.0f) {
@@ -120,6 +124,55 @@ namespace Syx {
     pSpace->removeConstraint(constraint);
   }
 
+  void PhysicsSystem::_stepSpaces(float dt) {
+    mSpaceList.clear();
+    for(auto it = mSpaces.begin(); it != mSpaces.end(); ++it)
+      mSpaceList.push_back(&*it);
+
+    DebugDrawer& drawer = DebugDrawer::get();
+    //Spaces don't share anything they modify while updating except the debug drawer, so each draws into its own while in parallel
+    if(mSpaceList.size() > 1 && (gOptions.mThreadingFlags & SyxOptions::ParallelSpaces)) {
+      mSpaceDrawers.resize(mSpaceList.size());
+      Interface::parallelFor(mSpaceList.size(), [this, dt](size_t i) {
+        DebugDrawer::ScopedTarget target(mSpaceDrawers[i]);
+        for(size_t s = 0; s < mSubsteps; ++s) {
+          mSpaceDrawers[i].clear();
+          mSpaceList[i]->update(dt);
+        }
+      });
+
+      //In space order, the same as what updating them one at a time would leave
+      drawer.clear();
+      for(size_t i = 0; i < mSpaceList.size(); ++i)
+        drawer.append(mSpaceDrawers[i]);
+      return;
+    }
+
+    for(size_t s = 0; s < mSubsteps; ++s) {
+      drawer.clear();
+      for(Space* space : mSpaceList)
+        space->update(dt);
+    }
+  }
+
+  void PhysicsSystem::setSubsteps(size_t substeps) {
+    mSubsteps = std::max(size_t(1), substeps);
+  }
+
+  size_t PhysicsSystem::getSubsteps() const {
+    return mSubsteps;
+  }
+
+  void PhysicsSystem::setSolverIterations(int iterations) {
+    mSolverIterations = iterations;
+    for(auto it = mSpaces.begin(); it != mSpaces.end(); ++it)
+      (*it).setSolverIterations(iterations);
+  }
+
+  int PhysicsSystem::getSolverIterations() const {
+    return mSolverIterations;
+  }
+
   void PhysicsSystem::updateModel(Handle handle, const Model& updated) {
     Model* model = mModels.get(handle);
     if(!model)
@@ -127,6 +180,7 @@ namespace Syx {
 
     *model = updated;
     model->mHandle = handle;
+    _clearModelContexts();
   }
 
   void PhysicsSystem::updateMaterial(Handle handle, const Material& updated) {
@@ -148,6 +202,12 @@ namespace Syx {
 
   void PhysicsSystem::removeModel(Handle handle) {
     mModels.remove(handle);
+    _clearModelContexts();
+  }
+
+  void PhysicsSystem::_clearModelContexts() {
+    for(auto it = mSpaces.begin(); it != mSpaces.end(); ++it)
+      (*it).clearModelContexts();
   }
 
   void PhysicsSystem::removeMaterial(Handle handle) {
@@ -156,6 +216,7 @@ namespace Syx {
 
   Handle PhysicsSystem::addSpace(void) {
     Space* newSpace = mSpaces.add();
+    newSpace->setSolverIterations(mSolverIterations);
     return newSpace->getHandle();
   }
 
@@ -169,6 +230,12 @@ namespace Syx {
       space->clear();
   }
 
+  void PhysicsSystem::setSpaceBroadphase(Handle handle, int type) {
+    Space* space = mSpaces.get(handle);
+    if(space)
+      space->setBroadphaseType(type);
+  }
+
   Handle PhysicsSystem::addPhysicsObject(bool hasRigidbody, bool hasCollider, Handle space) {
     Space* pSpace = mSpaces.get(space);
     if(!pSpace)
@@ -323,6 +390,16 @@ namespace Syx {
     return rigidbody->mAngVel;
   }
 
+  void PhysicsSystem::setContinuous(Handle space, Handle object, bool continuous) {
+    if(Rigidbody* rigidbody = _getRigidbody(space, object))
+      rigidbody->setFlag(RigidbodyFlags::Continuous, continuous);
+  }
+
+  bool PhysicsSystem::getContinuous(Handle space, Handle object) {
+    Rigidbody* rigidbody = _getRigidbody(space, object);
+    return rigidbody && rigidbody->getFlag(RigidbodyFlags::Continuous);
+  }
+
   void PhysicsSystem::setPosition(Handle space, Handle object, const Vec3& pos) {
     PhysicsObject* obj = _getObject(space, object);
     if(!obj)
@@ -400,6 +477,21 @@ namespace Syx {
     return &s->getProfileHistory();
   }
 
+  bool PhysicsSystem::writeProfileTrace(Handle space, std::ostream& stream) {
+    Space* s = mSpaces.get(space);
+    if(!s)
+      return false;
+
+    s->writeProfileTrace(stream);
+    return true;
+  }
+
+  void PhysicsSystem::setProfileEnabled(Handle space, bool enabled) {
+    Space* s = mSpaces.get(space);
+    if(s)
+      s->setProfileEnabled(enabled);
+  }
+
   void PhysicsSystem::getAABB(Handle space, Handle object, Vec3& min, Vec3& max) {
     PhysicsObject* obj = _getObject(space, object);
     if(!obj || !obj->getCollider())
@@ -423,4 +515,29 @@ namespace Syx {
     SAlign Vec3 sEnd = end;
     return s->lineCastAll(sStart, sEnd);
   }
+
+  void PhysicsSystem::lineCastBatch(Handle space, const Vec3* starts, const Vec3* ends, size_t count, int mode, std::vector<CastResult>& results) {
+    if(Space* s = mSpaces.get(space))
+      s->lineCastBatch(starts, ends, count, mode, results);
+    else
+      results.assign(count, CastResult());
+  }
+
+  void PhysicsSystem::overlapBatch(Handle space, const AABB* volumes, size_t count, std::vector<Handle>& results, std::vector<size_t>& offsets) {
+    if(Space* s = mSpaces.get(space))
+      s->overlapBatch(volumes, count, results, offsets);
+    else {
+      results.clear();
+      offsets.assign(count + 1, 0);
+    }
+  }
+
+  void PhysicsSystem::overlapBatch(Handle space, const Vec3* centers, const float* radii, size_t count, std::vector<Handle>& results, std::vector<size_t>& offsets) {
+    if(Space* s = mSpaces.get(space))
+      s->overlapBatch(centers, radii, count, results, offsets);
+    else {
+      results.clear();
+      offsets.assign(count + 1, 0);
+    }
+  }
 }
\ No newline at end of file
@@ -10,17 +10,29 @@ namespace Syx {
   class ModelParam;
   class CompositeModelParam;
   class NarrowphaseTest;
+  class SimulationTest;
   class DistanceOps;
 
   class PhysicsSystem {
   public:
     friend class NarrowphaseTest;
+    friend class SimulationTest;
 
     static float sSimRate;
 
     PhysicsSystem();
 
+    //Runs as many steps of sSimRate as dt adds up to, keeping the remainder for next time
     void update(float dt);
+    //Same as update but with options other than what Interface::getOptions reports, so tests can compare paths
+    void update(float dt, const SyxOptions& options);
+
+    //Each step is split into this many equal updates of every space. More are more stable and accurate but cost more
+    void setSubsteps(size_t substeps);
+    size_t getSubsteps() const;
+    //Maximum constraint solver iterations per substep for all spaces, including ones added later
+    void setSolverIterations(int iterations);
+    int getSolverIterations() const;
 
     //Adding resources this way leaves the possibility of adding a resource layer on top of it that would call these,
     //which is probably what should happen to reduce dependencies
@@ -47,6 +59,8 @@ namespace Syx {
     Handle addSpace();
     void removeSpace(Handle handle);
     void clearSpace(Handle handle);
+    //Type is one of BroadphaseType
+    void setSpaceBroadphase(Handle handle, int type);
 
     Handle addPhysicsObject(bool hasRigidbody, bool hasCollider, Handle space);
     void removePhysicsObject(Handle space, Handle object);
@@ -65,6 +79,10 @@ namespace Syx {
     void setAngularVelocity(Handle space, Handle object, const Vec3& angVel);
     Vec3 getAngularVelocity(Handle space, Handle object);
 
+    //Continuous objects are swept along their path each step so they can't pass through things when moving fast
+    void setContinuous(Handle space, Handle object, bool continuous);
+    bool getContinuous(Handle space, Handle object);
+
     void setPosition(Handle space, Handle object, const Vec3& pos);
     Vec3 getPosition(Handle space, Handle object);
 
@@ -79,6 +97,10 @@ namespace Syx {
     const EventListener<UpdateEvent>* getUpdateEvents(Handle space);
 
     CastResult lineCastAll(Handle space, const Vec3& start, const Vec3& end);
+    //Batched queries, see Space::lineCastBatch and Space::overlapBatch
+    void lineCastBatch(Handle space, const Vec3* starts, const Vec3* ends, size_t count, int mode, std::vector<CastResult>& results);
+    void overlapBatch(Handle space, const AABB* volumes, size_t count, std::vector<Handle>& results, std::vector<size_t>& offsets);
+    void overlapBatch(Handle space, const Vec3* centers, const float* radii, size_t count, std::vector<Handle>& results, std::vector<size_t>& offsets);
 
     Handle getCube(void) { return mCubeModel; }
     Handle getSphere(void) { return mSphereModel; }
@@ -89,17 +111,30 @@ namespace Syx {
 
     const std::string* getProfileReport(Handle space, const std::string& indent);
     const std::vector<ProfileResult>* getProfileHistory(Handle space);
+    //Writes the space's recent profile blocks from all threads as Chrome trace event json. False if the space doesn't exist
+    bool writeProfileTrace(Handle space, std::ostream& stream);
+    void setProfileEnabled(Handle space, bool enabled);
 
   private:
     Handle _addModel(const Model& newModel);
+    //Updates every space substep times
+    void _stepSpaces(float dt);
+    void _clearModelContexts();
 
     PhysicsObject* _getObject(Handle space, Handle object);
     Rigidbody* _getRigidbody(Handle space, Handle object);
     Collider* _getCollider(Handle space, Handle object);
 
-    HandleMap<Material> mMaterials;
-    HandleMap<Model> mModels;
+    SlotHandleMap<Material> mMaterials;
+    SlotHandleMap<Model> mModels;
     HandleMap<Space> mSpaces;
+    //Spaces being stepped, kept to avoid allocating each step
+    std::vector<Space*> mSpaceList;
+    //What each space drew while they were updated in parallel, matching mSpaceList
+    std::vector<DebugDrawer> mSpaceDrawers;
+    float mAccumulated;
+    size_t mSubsteps;
+    int mSolverIterations;
 
     Handle mCubeModel;
     Handle mSphereModel;
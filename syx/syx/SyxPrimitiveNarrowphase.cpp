@@ -4,6 +4,14 @@
 #include "SyxModelInstance.h"
 
 namespace Syx {
+  namespace {
+    //Relative difference in scale still considered uniform
+    const float sUniformScaleTolerance = 0.001f;
+    //Edge axes are only used if they're this much shallower than face axes, as face contacts are more stable
+    const float sEdgeAxisBias = 1.05f;
+    const float sBoxFaceAxisBias = 1.01f;
+  }
+
   void PrimitiveNarrowphase::set(ModelInstance* a, ModelInstance* b, Space* space, Narrowphase* narrowphase) {
     mA = a;
     mB = b;
@@ -39,4 +47,237 @@ namespace Syx {
     Vec3 worldB = posB + normalA*radiusB;
     mNarrowphase->_submitContact(worldA, worldB, normalA, penetration);
   }
+
+  bool PrimitiveNarrowphase::_getUniformScale(const Transformer& transform, float& scale) {
+    const Mat3& m = transform.mScaleRot;
+    float x = m.mbx.length();
+    float y = m.mby.length();
+    float z = m.mbz.length();
+    scale = x;
+    return std::abs(x - y) <= x*sUniformScaleTolerance && std::abs(x - z) <= x*sUniformScaleTolerance;
+  }
+
+  bool PrimitiveNarrowphase::_getBoxAxes(const Transformer& transform, Vec3* axes, float* extents) {
+    const Vec3* columns[3] = { &transform.mScaleRot.mbx, &transform.mScaleRot.mby, &transform.mScaleRot.mbz };
+    for(int i = 0; i < 3; ++i) {
+      extents[i] = columns[i]->length();
+      if(extents[i] < SYX_EPSILON)
+        return false;
+      axes[i] = *columns[i]/extents[i];
+    }
+    //Non-uniformly scaled parents of rotated submodels skew them
+    return std::abs(axes[0].dot(axes[1])) <= sUniformScaleTolerance &&
+      std::abs(axes[0].dot(axes[2])) <= sUniformScaleTolerance &&
+      std::abs(axes[1].dot(axes[2])) <= sUniformScaleTolerance;
+  }
+
+  bool PrimitiveNarrowphase::_triangleSphere(const EnvTriangle& tri, const Vec3& center, float radius) {
+    Vec3 onTri = closestOnTri(center, tri.mPoints[0], tri.mPoints[1], tri.mPoints[2]);
+    Vec3 triToCenter = center - onTri;
+    float dist = triToCenter.length2();
+    if(dist > radius*radius)
+      return false;
+
+    Vec3 normal;
+    //Center is on the triangle, so push out along the face normal
+    if(dist < SYX_EPSILON) {
+      dist = 0.0f;
+      normal = -tri.mNormal;
+    }
+    else {
+      dist = std::sqrt(dist);
+      normal = -triToCenter/dist;
+    }
+    mNarrowphase->_submitContact(onTri, center + normal*radius, normal, radius - dist);
+    return true;
+  }
+
+  bool PrimitiveNarrowphase::triangleSphere(const EnvTriangle& tri) {
+    const Transformer& tb = mB->getModelToWorld();
+    float radius;
+    if(!_getUniformScale(tb, radius))
+      return false;
+    _triangleSphere(tri, tb.mPos, radius);
+    return true;
+  }
+
+  bool PrimitiveNarrowphase::triangleCapsule(const EnvTriangle& tri) {
+    const Transformer& tb = mB->getModelToWorld();
+    float radius;
+    if(!_getUniformScale(tb, radius))
+      return false;
+
+    //Capsules are a segment from -1 to 1 on y with a radius of 1
+    const Vec3 ends[2] = { tb.transformPoint(-Vec3::UnitY), tb.transformPoint(Vec3::UnitY) };
+    //Segment through the triangle has no closest points, so leave it to epa
+    if(triangleLineIntersect(tri.mPoints[0], tri.mPoints[1], tri.mPoints[2], ends[0], ends[1]) >= 0.0f)
+      return false;
+
+    //Contacts for each end keep a capsule lying on the triangle from rocking between single contacts
+    bool endContact = false;
+    for(const Vec3& end : ends)
+      endContact = _triangleSphere(tri, end, radius) || endContact;
+    if(endContact)
+      return true;
+
+    //Ends are too far, but the middle of the segment may still be close to an edge
+    Vec3 bestOnTri, bestOnSegment;
+    float bestDist = std::numeric_limits<float>::max();
+    for(int i = 0; i < 3; ++i) {
+      Vec3 onTri, onSegment;
+      closestOnLines(tri.mPoints[i], tri.mPoints[(i + 1) % 3], ends[0], ends[1], onTri, onSegment);
+      float dist = onTri.distance2(onSegment);
+      if(dist < bestDist) {
+        bestDist = dist;
+        bestOnTri = onTri;
+        bestOnSegment = onSegment;
+      }
+    }
+    if(bestDist <= radius*radius && bestDist > SYX_EPSILON) {
+      bestDist = std::sqrt(bestDist);
+      Vec3 normal = (bestOnTri - bestOnSegment)/bestDist;
+      mNarrowphase->_submitContact(bestOnTri, bestOnSegment + normal*radius, normal, radius - bestDist);
+    }
+    return true;
+  }
+
+  bool PrimitiveNarrowphase::triangleCube(const EnvTriangle& tri) {
+    const Transformer& tb = mB->getModelToWorld();
+    Vec3 axes[3];
+    float extents[3];
+    if(!_getBoxAxes(tb, axes, extents))
+      return false;
+
+    const Vec3& center = tb.mPos;
+    const Vec3* points = tri.mPoints;
+    const Vec3 edges[3] = { points[1] - points[0], points[2] - points[1], points[0] - points[2] };
+
+    //Separating axis test on the triangle normal, box face normals, and cross products of their edges.
+    //The axis of least penetration is kept, pointing from the triangle towards the box
+    Vec3 bestAxis;
+    float bestDepth = 0.0f;
+    float bestScore = std::numeric_limits<float>::max();
+    //-1 for triangle face, 0-2 for box faces, 3 + 3*triEdge + boxAxis for edge pairs
+    int bestFeature = -1;
+    auto testAxis = [&](Vec3 axis, int feature, float bias) {
+      float length = axis.length2();
+      //Parallel edges don't give an axis
+      if(length < SYX_EPSILON)
+        return true;
+      axis /= std::sqrt(length);
+
+      float triMin = points[0].dot(axis);
+      float triMax = triMin;
+      for(int i = 1; i < 3; ++i) {
+        float p = points[i].dot(axis);
+        triMin = std::min(triMin, p);
+        triMax = std::max(triMax, p);
+      }
+      float boxCenter = center.dot(axis);
+      float boxRadius = 0.0f;
+      for(int i = 0; i < 3; ++i)
+        boxRadius += extents[i]*std::abs(axes[i].dot(axis));
+
+      //Orient towards the side with less overlap
+      float depth = triMax - (boxCenter - boxRadius);
+      float otherDepth = boxCenter + boxRadius - triMin;
+      if(otherDepth < depth) {
+        depth = otherDepth;
+        axis = -axis;
+      }
+      if(depth <= 0.0f)
+        return false;
+      if(depth*bias < bestScore) {
+        bestScore = depth*bias;
+        bestDepth = depth;
+        bestAxis = axis;
+        bestFeature = feature;
+      }
+      return true;
+    };
+
+    //Triangle face is oriented by which side the box center is on rather than overlap, so boxes don't get pulled through
+    Vec3 faceNormal = (center - points[0]).dot(tri.mNormal) >= 0.0f ? tri.mNormal : -tri.mNormal;
+    float faceDepth = 0.0f;
+    for(int i = 0; i < 3; ++i)
+      faceDepth += extents[i]*std::abs(axes[i].dot(faceNormal));
+    faceDepth -= (center - points[0]).dot(faceNormal);
+    if(faceDepth <= 0.0f)
+      return true;
+    bestAxis = faceNormal;
+    bestDepth = bestScore = faceDepth;
+
+    for(int i = 0; i < 3; ++i)
+      if(!testAxis(axes[i], i, sBoxFaceAxisBias))
+        return true;
+    for(int e = 0; e < 3; ++e)
+      for(int i = 0; i < 3; ++i)
+        if(!testAxis(edges[e].cross(axes[i]), 3 + e*3 + i, sEdgeAxisBias))
+          return true;
+
+    const Vec3 normal = -bestAxis;
+    if(bestFeature == -1) {
+      //Box corners below the triangle that are within its edges, which for a box resting on it gives a whole face of contacts
+      Vec3 deepest;
+      float deepestHeight = std::numeric_limits<float>::max();
+      bool anyInside = false;
+      for(int corner = 0; corner < 8; ++corner) {
+        Vec3 point = center;
+        for(int i = 0; i < 3; ++i)
+          point += axes[i]*(corner & (1 << i) ? extents[i] : -extents[i]);
+        float height = (point - points[0]).dot(bestAxis);
+        if(height >= 0.0f)
+          continue;
+        if(height < deepestHeight) {
+          deepestHeight = height;
+          deepest = point;
+        }
+        bool inside = true;
+        for(int e = 0; e < 3 && inside; ++e)
+          inside = edges[e].cross(point - points[e]).dot(tri.mNormal) >= 0.0f;
+        if(inside) {
+          mNarrowphase->_submitContact(point - bestAxis*height, point, normal, -height);
+          anyInside = true;
+        }
+      }
+      if(!anyInside && deepestHeight < 0.0f)
+        mNarrowphase->_submitContact(deepest - bestAxis*deepestHeight, deepest, normal, -deepestHeight);
+    }
+    else if(bestFeature < 3) {
+      //Triangle points inside the box, or the deepest one if the triangle is bigger than the face
+      const float faceMin = center.dot(bestAxis) - extents[bestFeature];
+      int deepest = 0;
+      bool anyInside = false;
+      for(int p = 0; p < 3; ++p) {
+        float depth = points[p].dot(bestAxis) - faceMin;
+        if(depth > points[deepest].dot(bestAxis) - faceMin)
+          deepest = p;
+        if(depth <= 0.0f)
+          continue;
+        Vec3 local = points[p] - center;
+        bool inside = true;
+        for(int i = 0; i < 3 && inside; ++i)
+          inside = i == bestFeature || std::abs(local.dot(axes[i])) <= extents[i];
+        if(inside) {
+          mNarrowphase->_submitContact(points[p], points[p] - bestAxis*depth, normal, depth);
+          anyInside = true;
+        }
+      }
+      if(!anyInside)
+        mNarrowphase->_submitContact(points[deepest], points[deepest] - bestAxis*bestDepth, normal, bestDepth);
+    }
+    else {
+      //Closest points between the triangle edge and the box edge nearest to the triangle
+      const int e = (bestFeature - 3)/3;
+      const int axis = (bestFeature - 3) % 3;
+      Vec3 edgeCenter = center;
+      for(int i = 0; i < 3; ++i)
+        if(i != axis)
+          edgeCenter += axes[i]*(axes[i].dot(bestAxis) > 0.0f ? -extents[i] : extents[i]);
+      Vec3 onTri, onBox;
+      closestOnLines(points[e], points[(e + 1) % 3], edgeCenter - axes[axis]*extents[axis], edgeCenter + axes[axis]*extents[axis], onTri, onBox);
+      mNarrowphase->_submitContact(onTri, onBox, normal, bestDepth);
+    }
+    return true;
+  }
 }
\ No newline at end of file
@@ -4,14 +4,28 @@ namespace Syx {
   class ModelInstance;
   class Space;
   class Narrowphase;
+  struct EnvTriangle;
+  struct Transformer;
 
   class PrimitiveNarrowphase {
   public:
     void set(ModelInstance* a, ModelInstance* b, Space* space, Narrowphase* narrowphase);
 
     void sphereSphere(void);
+    //Triangle is a and in world space. False if b's shape isn't supported, like non-uniformly scaled spheres or deeply penetrating shapes,
+    //in which case the pair should fall back to gjk
+    bool triangleSphere(const EnvTriangle& tri);
+    bool triangleCapsule(const EnvTriangle& tri);
+    bool triangleCube(const EnvTriangle& tri);
 
   private:
+    //Radius if all axes of the transform are scaled the same, used for spheres and capsules
+    static bool _getUniformScale(const Transformer& transform, float& scale);
+    //Unit axes and half extents of a cube, if the transform doesn't skew it
+    static bool _getBoxAxes(const Transformer& transform, Vec3* axes, float* extents);
+    //Contact between the triangle and a sphere at center, if close enough
+    bool _triangleSphere(const EnvTriangle& tri, const Vec3& center, float radius);
+
     ModelInstance* mA;
     ModelInstance* mB;
     Space* mSpace;
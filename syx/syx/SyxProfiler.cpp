@@ -1,35 +1,316 @@
 #include "Precompile.h"
 
 namespace Syx {
-  ProfileBlock& Profiler::_getBlock(size_t index) {
-    while(mBlockStack.size() <= index)
-      mBlockStack.emplace_back();
-    return mBlockStack[index];
+  namespace {
+    const size_t sNoParent = static_cast<size_t>(-1);
   }
 
-  void Profiler::pushBlock(const std::string& name) {
-    //If we're back at zero we must be starting over, so clear the history from last frame
-    if(!mCurDepth)
-      mHistory.clear();
-    ProfileBlock& block = _getBlock(mCurDepth++);
+  struct ProfileEvent {
+    //Id of the profiler that recorded it
+    size_t mOwner;
+    const char* mName;
+    Time mStart;
+    Time mEnd;
+    //Number of blocks from the same profiler that were open on this thread when this one was pushed
+    size_t mDepth;
+    //Only set on copies, to the position in the thread's history the event was copied from
+    size_t mIndex;
+  };
+
+  namespace {
+    struct OpenBlock {
+      size_t mOwner;
+      const char* mName;
+      Time mStart;
+      size_t mDepth;
+    };
+
+    //Completed blocks for a single thread. Only the owning thread writes, so recording needs no locking
+    struct ProfileThread {
+      static const size_t sCapacity = 4096;
+      static const size_t sMaxDepth = 64;
+
+      ProfileEvent mEvents[sCapacity];
+      //Total events ever written, so the newest is at (mWritten - 1) % sCapacity and older ones are overwritten
+      std::atomic<size_t> mWritten{0};
+      //Total events the owner has started writing. Runs one ahead of mWritten while a slot is being overwritten
+      std::atomic<size_t> mStarted{0};
+      OpenBlock mStack[sMaxDepth];
+      size_t mDepth = 0;
+      //Pushes past sMaxDepth that weren't recorded, so their pops can be ignored
+      size_t mOverflow = 0;
+      size_t mIndex = 0;
+      std::atomic<bool> mInUse{true};
+    };
+
+    std::mutex& getThreadsMutex() {
+      static std::mutex mutex;
+      return mutex;
+    }
+
+    //Buffers are never freed since other threads may be reading them. Exiting threads hand theirs to the next new thread
+    std::vector<ProfileThread*>& getThreads() {
+      static std::vector<ProfileThread*> threads;
+      return threads;
+    }
+
+    struct ThreadOwner {
+      ~ThreadOwner() {
+        if(mThread)
+          mThread->mInUse = false;
+      }
+
+      ProfileThread* mThread = nullptr;
+    };
+
+    ProfileThread& getThread() {
+      thread_local ThreadOwner owner;
+      if(!owner.mThread) {
+        std::lock_guard<std::mutex> lock(getThreadsMutex());
+        std::vector<ProfileThread*>& threads = getThreads();
+        for(ProfileThread* thread : threads) {
+          bool inUse = false;
+          if(thread->mInUse.compare_exchange_strong(inUse, true)) {
+            thread->mDepth = thread->mOverflow = 0;
+            owner.mThread = thread;
+            break;
+          }
+        }
+
+        if(!owner.mThread) {
+          owner.mThread = new ProfileThread();
+          owner.mThread->mIndex = threads.size();
+          threads.push_back(owner.mThread);
+        }
+      }
+      return *owner.mThread;
+    }
+
+    //Appends copies of the thread's events that pass filter. Other threads can read while the owner records, so only published slots
+    //are read, and any the owner may have started overwriting during the copy are dropped since they could be torn
+    template<class Filter>
+    void copyEvents(const ProfileThread& thread, const Filter& filter, std::vector<ProfileEvent>& result) {
+      const size_t begin = result.size();
+      const size_t written = thread.mWritten.load(std::memory_order_acquire);
+      for(size_t i = written - std::min(written, ProfileThread::sCapacity); i < written; ++i) {
+        const ProfileEvent& e = thread.mEvents[i % ProfileThread::sCapacity];
+        if(filter(e)) {
+          result.push_back(e);
+          result.back().mIndex = i;
+        }
+      }
+
+      //Pairs with the release fence in popBlock, so a copy that saw any part of an overwrite also sees it started
+      std::atomic_thread_fence(std::memory_order_acquire);
+      const size_t started = thread.mStarted.load(std::memory_order_relaxed);
+      //Slot for event i is reused by event i + sCapacity
+      result.erase(std::remove_if(result.begin() + begin, result.end(), [started](const ProfileEvent& e) {
+        return e.mIndex + ProfileThread::sCapacity < started;
+      }), result.end());
+    }
+
+    size_t getNextProfilerId() {
+      static std::atomic<size_t> next(0);
+      return next++;
+    }
+
+    Time getTime() {
+      return std::chrono::high_resolution_clock::now();
+    }
+
+    void writeEscaped(std::ostream& stream, const char* str) {
+      for(; *str; ++str) {
+        if(*str == '"' || *str == '\\')
+          stream << '\\';
+        if(static_cast<unsigned char>(*str) >= ' ')
+          stream << *str;
+      }
+    }
+  }
+
+  Profiler::Profiler(void)
+    : mEnabled(true)
+    , mId(getNextProfilerId())
+    , mFrameThread(nullptr) {
+  }
+
+  Profiler::Profiler(const Profiler& rhs)
+    : mEnabled(rhs.mEnabled)
+    , mId(getNextProfilerId())
+    , mFrameThread(nullptr)
+    , mHistory(rhs.mHistory)
+    , mReport(rhs.mReport) {
+  }
+
+  Profiler::~Profiler() {
+  }
+
+  Profiler& Profiler::operator=(const Profiler& rhs) {
+    SyxAssertError(!mFrameThread.load(), "Profiler can't be assigned during a frame");
+    mEnabled = rhs.mEnabled;
+    mHistory = rhs.mHistory;
+    mReport = rhs.mReport;
+    return *this;
+  }
+
+  void Profiler::setEnabled(bool enabled) {
+    SyxAssertError(!mFrameThread.load(), "Profiler can't be toggled during a frame");
+    mEnabled = enabled;
+  }
+
+  void Profiler::pushBlock(const char* name) {
+    if(!mEnabled)
+      return;
+
+    ProfileThread& thread = getThread();
+    if(thread.mDepth >= ProfileThread::sMaxDepth) {
+      SyxAssertError(false, "Profile blocks nested too deeply");
+      ++thread.mOverflow;
+      return;
+    }
+
+    size_t depth = 0;
+    for(size_t i = thread.mDepth; i > 0; --i) {
+      const OpenBlock& open = thread.mStack[i - 1];
+      if(open.mOwner == mId) {
+        depth = open.mDepth + 1;
+        break;
+      }
+    }
+
+    OpenBlock& block = thread.mStack[thread.mDepth++];
+    block.mOwner = mId;
     block.mName = name;
-    block.mStartTime = _getTime();
-    block.mHistoryBlock = mHistory.size();
-    mHistory.push_back(ProfileResult());
+    block.mDepth = depth;
+    block.mStart = getTime();
+
+    //No frame open means this is the first block of a new frame
+    const void* noFrame = nullptr;
+    if(!mFrameThread.load(std::memory_order_relaxed) && mFrameThread.compare_exchange_strong(noFrame, &thread))
+      mFrameStart = block.mStart;
+  }
+
+  void Profiler::popBlock(const char* name) {
+    if(!mEnabled)
+      return;
+
+    Time end = getTime();
+    ProfileThread& thread = getThread();
+    if(thread.mOverflow) {
+      --thread.mOverflow;
+      return;
+    }
+
+    SyxAssertError(thread.mDepth > 0);
+    const OpenBlock& block = thread.mStack[--thread.mDepth];
+    SyxAssertError(block.mOwner == mId && !std::strcmp(block.mName, name));
+
+    size_t written = thread.mWritten.load(std::memory_order_relaxed);
+    //Other threads may be copying the slot this overwrites, so mark it as started before touching it, see copyEvents
+    thread.mStarted.store(written + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    ProfileEvent& e = thread.mEvents[written % ProfileThread::sCapacity];
+    e.mOwner = mId;
+    e.mName = block.mName;
+    e.mStart = block.mStart;
+    e.mEnd = end;
+    e.mDepth = block.mDepth;
+    thread.mWritten.store(written + 1, std::memory_order_release);
+
+    if(mFrameThread.load() == &thread && !block.mDepth)
+      _endFrame(end);
+  }
+
+  void Profiler::_endFrame(Time end) {
+    const void* frameThread = mFrameThread.exchange(nullptr);
+    mNodes.clear();
+    mFrameBlocks.clear();
+
+    {
+      std::lock_guard<std::mutex> lock(getThreadsMutex());
+      //Frame thread goes first so blocks from other threads can be placed under the block it had open at the time
+      _gatherEvents(frameThread, true, end);
+      for(ProfileThread* thread : getThreads())
+        if(thread != frameThread)
+          _gatherEvents(thread, false, end);
+    }
+
+    mHistory.clear();
+    _writeHistory(sNoParent);
+  }
+
+  void Profiler::_gatherEvents(const void* threadPtr, bool isFrameThread, Time end) {
+    const ProfileThread& thread = *static_cast<const ProfileThread*>(threadPtr);
+    mEventScratch.clear();
+    copyEvents(thread, [this, end](const ProfileEvent& e) {
+      return e.mOwner == mId && e.mStart >= mFrameStart && e.mEnd <= end;
+    }, mEventScratch);
+    if(mEventScratch.empty())
+      return;
+
+    //Events are recorded as they end, so sort by start to visit parents before their children
+    std::sort(mEventScratch.begin(), mEventScratch.end(), [](const ProfileEvent& l, const ProfileEvent& r) {
+      return l.mStart == r.mStart ? l.mDepth < r.mDepth : l.mStart < r.mStart;
+    });
+
+    mStackScratch.clear();
+    for(const ProfileEvent& e : mEventScratch) {
+      size_t parent = sNoParent;
+      if(e.mDepth && e.mDepth <= mStackScratch.size())
+        parent = mStackScratch[e.mDepth - 1];
+      else if(!e.mDepth && !isFrameThread)
+        parent = _findFrameParent(e);
+
+      size_t node = _addToNode(parent, e.mName, std::chrono::duration_cast<Duration>(e.mEnd - e.mStart));
+      //Parents can be missing if they were overwritten in the ring buffer, in which case children go at the top
+      mStackScratch.resize(e.mDepth, sNoParent);
+      mStackScratch.push_back(node);
+      if(isFrameThread)
+        mFrameBlocks.push_back({ e.mStart, e.mEnd, node });
+    }
   }
 
-  void Profiler::popBlock(const std::string& name) {
-    SyxAssertError(mCurDepth > 0);
-    ProfileBlock& block = _getBlock(--mCurDepth);
-    SyxAssertError(block.mName == name);
+  size_t Profiler::_findFrameParent(const ProfileEvent& e) {
+    size_t result = sNoParent;
+    for(const FrameBlock& block : mFrameBlocks)
+      if(block.mStart <= e.mStart && e.mEnd <= block.mEnd && (result == sNoParent || mNodes[block.mNode].mDepth > mNodes[result].mDepth))
+        result = block.mNode;
+
+    //The frame's thread helps with parallel work, so a same named block there is a sibling rather than a parent
+    for(size_t node = result; node != sNoParent; node = mNodes[node].mParent)
+      if(!std::strcmp(mNodes[node].mName, e.mName))
+        result = mNodes[node].mParent;
+    return result;
+  }
+
+  size_t Profiler::_addToNode(size_t parent, const char* name, Duration duration) {
+    for(size_t i = 0; i < mNodes.size(); ++i) {
+      Node& node = mNodes[i];
+      if(node.mParent == parent && (node.mName == name || !std::strcmp(node.mName, name))) {
+        node.mDuration += duration;
+        ++node.mCount;
+        return i;
+      }
+    }
+
+    size_t depth = parent == sNoParent ? 0 : mNodes[parent].mDepth + 1;
+    mNodes.push_back({ name, parent, depth, duration, 1 });
+    return mNodes.size() - 1;
+  }
 
-    auto duration = std::chrono::duration_cast<Duration>(_getTime() - block.mStartTime);
-    mHistory[block.mHistoryBlock] = ProfileResult(name, duration, mCurDepth);
+  void Profiler::_writeHistory(size_t parent) {
+    for(size_t i = 0; i < mNodes.size(); ++i) {
+      const Node& node = mNodes[i];
+      if(node.mParent == parent) {
+        mHistory.push_back(ProfileResult(node.mName, node.mDuration, node.mDepth, node.mCount));
+        _writeHistory(i);
+      }
+    }
   }
 
-  const ProfileResult* Profiler::getBlock(const std::string& name) {
+  const ProfileResult* Profiler::getBlock(const char* name) {
     for(ProfileResult& block : mHistory)
-      if(block.mName == name)
+      if(!std::strcmp(block.mName, name))
         return &block;
     return nullptr;
   }
@@ -40,4 +321,53 @@ namespace Syx {
       mReport += block.getReportString(indent) + "\n";
     return mReport;
   }
-}//Syx
\ No newline at end of file
+
+  void Profiler::writeTrace(std::ostream& stream) const {
+    //Copied up front so the timestamps and output come from the same events even if threads keep recording
+    std::vector<std::vector<ProfileEvent>> threadEvents;
+    std::vector<size_t> threadIndices;
+    {
+      std::lock_guard<std::mutex> lock(getThreadsMutex());
+      for(const ProfileThread* thread : getThreads()) {
+        threadEvents.emplace_back();
+        threadIndices.push_back(thread->mIndex);
+        copyEvents(*thread, [this](const ProfileEvent& e) { return e.mOwner == mId; }, threadEvents.back());
+      }
+    }
+
+    //Timestamps are relative to the oldest block so they stay small enough to print precisely
+    bool found = false;
+    Time base;
+    for(const std::vector<ProfileEvent>& events : threadEvents) {
+      for(const ProfileEvent& e : events) {
+        if(!found || e.mStart < base) {
+          base = e.mStart;
+          found = true;
+        }
+      }
+    }
+
+    std::ios::fmtflags flags = stream.flags();
+    std::streamsize precision = stream.precision();
+    stream.setf(std::ios::fixed, std::ios::floatfield);
+    stream.precision(3);
+
+    const char* separator = "";
+    stream << "{\"traceEvents\":[";
+    for(size_t t = 0; t < threadEvents.size(); ++t) {
+      for(const ProfileEvent& e : threadEvents[t]) {
+        double start = std::chrono::duration<double, std::micro>(e.mStart - base).count();
+        double duration = std::chrono::duration<double, std::micro>(e.mEnd - e.mStart).count();
+        stream << separator << "\n{\"name\":\"";
+        writeEscaped(stream, e.mName);
+        stream << "\",\"cat\":\"syx\",\"ph\":\"X\",\"pid\":0,\"tid\":" << threadIndices[t]
+          << ",\"ts\":" << start << ",\"dur\":" << duration << "}";
+        separator = ",";
+      }
+    }
+    stream << "\n]}\n";
+
+    stream.flags(flags);
+    stream.precision(precision);
+  }
+}//Syx
@@ -1,23 +1,22 @@
 #pragma once
+#include <atomic>
+//Comment out to compile AutoProfileBlock away entirely
+#define SYX_PROFILE
+
 namespace Syx {
   typedef std::chrono::nanoseconds Duration;
   typedef std::chrono::high_resolution_clock::time_point Time;
-
-  struct ProfileBlock {
-    std::string mName;
-    Time mStartTime;
-    size_t mHistoryBlock;
-  };
+  struct ProfileEvent;
 
   struct ProfileResult {
     ProfileResult() {}
-    ProfileResult(const std::string& name, Duration duration, size_t depth) :
-      mName(name), mDuration(duration), mDepth(depth) {
+    ProfileResult(const char* name, Duration duration, size_t depth, size_t count = 1) :
+      mName(name), mDuration(duration), mDepth(depth), mCount(count) {
     }
 
     std::string getReportString(const std::string& indent, float time) {
       std::string result;
-      result.reserve(indent.size()*mDepth + mName.size() + 10);
+      result.reserve(indent.size()*mDepth + std::strlen(mName) + 20);
 
       for(size_t i = 0; i < mDepth; ++i)
         result += indent;
@@ -25,6 +24,11 @@ namespace Syx {
       result += mName;
       result += ": ";
       result += std::to_string(time);
+      if(mCount > 1) {
+        result += " (";
+        result += std::to_string(mCount);
+        result += ")";
+      }
       return result;
     }
 
@@ -42,49 +46,110 @@ namespace Syx {
       return static_cast<float>(static_cast<double>(mDuration.count()) / million);
     }
 
-    std::string mName;
+    const char* mName;
+    //Summed across all blocks merged into this one, so blocks from several threads can add up to more than their parent
     Duration mDuration;
     size_t mDepth;
+    //How many blocks with this name were merged under the same parent
+    size_t mCount;
   };
 
+  //Blocks are recorded into per thread ring buffers so any thread can push and pop without locking.
+  //The first block pushed while no frame is open starts a frame, and popping it gathers every block from every thread
+  //recorded during that frame into the history, nesting blocks from other threads under whichever block was open on
+  //the frame's thread when they ran
   class Profiler {
   public:
-    Profiler(void) : mCurDepth(0) {}
+    Profiler(void);
+    //Copies settings and results. The copy records under its own id so it never picks up blocks recorded by rhs
+    Profiler(const Profiler& rhs);
+    ~Profiler();
 
-    void pushBlock(const std::string& name);
+    Profiler& operator=(const Profiler& rhs);
+
+    //Name is used as the block's id, so is expected to be a literal or otherwise outlive the profiler
+    void pushBlock(const char* name);
     //This will pop the next block on the stack, but throw an error if it's not the block you think it is
-    void popBlock(const std::string& name);
+    void popBlock(const char* name);
+
+    //Disabled profilers ignore pushes and pops. Must not be changed while a frame is open
+    void setEnabled(bool enabled);
+    bool isEnabled() const { return mEnabled; }
 
-    const std::vector<ProfileResult> getBlocks() { return mHistory; }
+    const std::vector<ProfileResult>& getBlocks() { return mHistory; }
     //Returns first block with given name
-    const ProfileResult* getBlock(const std::string& name);
+    const ProfileResult* getBlock(const char* name);
 
     const std::string& getReport(const std::string& indent);
     const std::vector<ProfileResult>& getHistory() { return mHistory; }
 
-  private:
-    ProfileBlock& _getBlock(size_t index);
-    Time _getTime() { return std::chrono::high_resolution_clock::now(); }
+    //Writes every block of this profiler still in the thread buffers as Chrome trace event json, for chrome://tracing
+    void writeTrace(std::ostream& stream) const;
 
-    size_t mCurDepth;
-    std::vector<ProfileBlock> mBlockStack;
+  private:
+    struct Node {
+      const char* mName;
+      size_t mParent;
+      size_t mDepth;
+      Duration mDuration;
+      size_t mCount;
+    };
+
+    //A block recorded on the frame's thread, used to find where blocks from other threads go
+    struct FrameBlock {
+      Time mStart;
+      Time mEnd;
+      size_t mNode;
+    };
+
+    void _endFrame(Time end);
+    void _gatherEvents(const void* thread, bool isFrameThread, Time end);
+    size_t _findFrameParent(const ProfileEvent& e);
+    size_t _addToNode(size_t parent, const char* name, Duration duration);
+    void _writeHistory(size_t parent);
+
+    bool mEnabled;
+    //Identifies this profiler's blocks in the thread buffers. Unlike its address, an id is never reused by a later profiler
+    size_t mId;
+    //Thread the current frame was started on, null if no frame is open. Any thread's first block can start a frame
+    std::atomic<const void*> mFrameThread;
+    Time mFrameStart;
+    //Scratch space for gathering a frame, kept to avoid allocating every frame
+    //Events are copied out since their owning threads may overwrite them while they're being gathered
+    std::vector<ProfileEvent> mEventScratch;
+    std::vector<size_t> mStackScratch;
+    std::vector<FrameBlock> mFrameBlocks;
+    std::vector<Node> mNodes;
     std::vector<ProfileResult> mHistory;
     std::string mReport;
   };
 
   struct AutoProfileBlock {
-    AutoProfileBlock(Profiler& profiler, const std::string& name)
-      : mProfiler(profiler)
+    //Name is expected to be a literal, so it isn't copied
+    AutoProfileBlock(Profiler& profiler, const char* name)
+      : AutoProfileBlock(&profiler, name) {
+    }
+
+    //Does nothing if profiler is null
+    AutoProfileBlock(Profiler* profiler, const char* name)
+#ifdef SYX_PROFILE
+      : mProfiler(profiler && profiler->isEnabled() ? profiler : nullptr)
       , mName(name) {
-      //Need to fix this, it isn't thread safe
-      //mProfiler.pushBlock(mName);
+      if(mProfiler)
+        mProfiler->pushBlock(mName);
     }
+#else
+    {}
+#endif
 
+#ifdef SYX_PROFILE
     ~AutoProfileBlock(void) {
-      //mProfiler.popBlock(mName);
+      if(mProfiler)
+        mProfiler->popBlock(mName);
     }
 
-    Profiler& mProfiler;
-    std::string mName;
+    Profiler* mProfiler;
+    const char* mName;
+#endif
   };
-}
\ No newline at end of file
+}
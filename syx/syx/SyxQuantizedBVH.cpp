@@ -0,0 +1,239 @@
+#include "Precompile.h"
+#include "SyxQuantizedBVH.h"
+
+namespace Syx {
+  namespace {
+    const float sQuantizeMax = 65535.0f;
+  }
+
+  class QBVHHitContext : public BroadphaseContext {
+  public:
+    QBVHHitContext(const QuantizedBVH& broadphase, std::weak_ptr<bool> existenceTracker)
+      : mBroadphase(broadphase)
+      , mExistenceTracker(std::move(existenceTracker)) {
+    }
+
+    void queryRaycast(const Vec3& start, const Vec3& end) override {
+      mResults.clear();
+      if(auto e = mExistenceTracker.lock()) {
+        mBroadphase.queryRaycast(start, end, mResults);
+      }
+    }
+
+    void queryVolume(const BoundingVolume& volume) override {
+      mResults.clear();
+      if(auto e = mExistenceTracker.lock()) {
+        mBroadphase.queryVolume(volume, mResults);
+      }
+    }
+
+    const std::vector<ResultNode>& get() const override {
+      return mResults;
+    }
+
+  private:
+    const QuantizedBVH& mBroadphase;
+    std::weak_ptr<bool> mExistenceTracker;
+    std::vector<ResultNode> mResults;
+  };
+
+  //Volumes in a static hierarchy never move relative to each other, so there are never pairs to report
+  class QBVHPairContext : public BroadphasePairContext {
+  public:
+    const std::vector<std::pair<ResultNode, ResultNode>>& get() const override {
+      return mEmpty;
+    }
+
+    const std::vector<std::pair<ResultNode, ResultNode>>& getAdded() const override {
+      return mEmpty;
+    }
+
+    const std::vector<std::pair<ResultNode, ResultNode>>& getRemoved() const override {
+      return mEmpty;
+    }
+
+    void queryPairs() override {
+    }
+
+  private:
+    std::vector<std::pair<ResultNode, ResultNode>> mEmpty;
+  };
+
+  QuantizedBVH::QuantizedBVH()
+    : mExistenceTracker(std::make_shared<bool>()) {
+  }
+
+  QuantizedBVH::QuantizedBVH(const QuantizedBVH& rhs)
+    : mNodes(rhs.mNodes)
+    , mLeaves(rhs.mLeaves)
+    , mOrigin(rhs.mOrigin)
+    , mScale(rhs.mScale)
+    , mInvScale(rhs.mInvScale)
+    , mExistenceTracker(std::make_shared<bool>()) {
+  }
+
+  QuantizedBVH::~QuantizedBVH() {
+    while(mExistenceTracker.use_count() > 1) {
+      std::this_thread::yield();
+    }
+  }
+
+  void QuantizedBVH::buildStatic(const std::vector<InsertParam>& nodes, std::vector<Handle>* resultHandles) {
+    clear();
+    if(nodes.empty())
+      return;
+
+    AABB bounds = nodes[0].mVolume.mAABB;
+    std::vector<Vec3> centers(nodes.size());
+    std::vector<size_t> order(nodes.size());
+    for(size_t i = 0; i < nodes.size(); ++i) {
+      bounds = AABB::combined(bounds, nodes[i].mVolume.mAABB);
+      centers[i] = nodes[i].mVolume.mAABB.getCenter();
+      order[i] = i;
+    }
+
+    mOrigin = bounds.getMin();
+    const Vec3 diagonal = bounds.getDiagonal();
+    for(int i = 0; i < 3; ++i) {
+      //Flat along this axis, everything quantizes to zero
+      mScale[i] = diagonal[i] > SYX_EPSILON ? sQuantizeMax/diagonal[i] : 0.0f;
+      mInvScale[i] = diagonal[i] > SYX_EPSILON ? diagonal[i]/sQuantizeMax : 0.0f;
+    }
+
+    //One leaf per volume and a binary tree, so this is exact
+    mNodes.reserve(nodes.size()*2 - 1);
+    mLeaves.reserve(nodes.size());
+    _build(nodes, centers, order, 0, nodes.size());
+
+    if(resultHandles) {
+      //Handles are in build order, so map them back to the order they were given in
+      resultHandles->resize(nodes.size());
+      for(size_t i = 0; i < order.size(); ++i)
+        (*resultHandles)[order[i]] = mLeaves[i].mHandle;
+    }
+  }
+
+  void QuantizedBVH::_build(const std::vector<InsertParam>& nodes, const std::vector<Vec3>& centers, std::vector<size_t>& order, size_t begin, size_t end) {
+    const size_t nodeIndex = mNodes.size();
+    mNodes.emplace_back();
+
+    AABB bounds = nodes[order[begin]].mVolume.mAABB;
+    for(size_t i = begin + 1; i < end; ++i)
+      bounds = AABB::combined(bounds, nodes[order[i]].mVolume.mAABB);
+    _quantize(bounds, mNodes[nodeIndex].mMin, mNodes[nodeIndex].mMax);
+
+    if(end - begin == 1) {
+      mNodes[nodeIndex].mData = static_cast<int32_t>(mLeaves.size());
+      mLeaves.push_back(ResultNode(_getNewHandle(), nodes[order[begin]].mUserdata));
+      return;
+    }
+
+    //Split at the median along the axis the centers are most spread out on
+    AABB centerBounds;
+    centerBounds.init(centers[order[begin]]);
+    for(size_t i = begin + 1; i < end; ++i)
+      centerBounds.add(centers[order[i]]);
+    const int axis = centerBounds.getDiagonal().mostSignificantAxis();
+    const size_t mid = begin + (end - begin)/2;
+    std::nth_element(order.begin() + begin, order.begin() + mid, order.begin() + end, [&centers, axis](size_t lhs, size_t rhs) {
+      return centers[lhs][axis] < centers[rhs][axis];
+    });
+
+    _build(nodes, centers, order, begin, mid);
+    _build(nodes, centers, order, mid, end);
+    mNodes[nodeIndex].mData = ~static_cast<int32_t>(mNodes.size());
+  }
+
+  //Rounds outwards so the quantized bounds always contain the original
+  void QuantizedBVH::_quantize(const AABB& aabb, uint16_t* min, uint16_t* max) const {
+    const Vec3 low = aabb.getMin() - mOrigin;
+    const Vec3 high = aabb.getMax() - mOrigin;
+    for(int i = 0; i < 3; ++i) {
+      min[i] = static_cast<uint16_t>(clamp(std::floor(low[i]*mScale[i]), 0.0f, sQuantizeMax));
+      max[i] = static_cast<uint16_t>(clamp(std::ceil(high[i]*mScale[i]), 0.0f, sQuantizeMax));
+    }
+  }
+
+  AABB QuantizedBVH::_dequantize(const Node& node) const {
+    Vec3 min, max;
+    for(int i = 0; i < 3; ++i) {
+      min[i] = mOrigin[i] + static_cast<float>(node.mMin[i])*mInvScale[i];
+      max[i] = mOrigin[i] + static_cast<float>(node.mMax[i])*mInvScale[i];
+    }
+    return AABB(min, max);
+  }
+
+  Handle QuantizedBVH::insert(const BoundingVolume&, void*) {
+    SyxAssertError(false, "QuantizedBVH can only be built with buildStatic");
+    return SyxInvalidHandle;
+  }
+
+  void QuantizedBVH::remove(Handle) {
+    SyxAssertError(false, "QuantizedBVH can only be built with buildStatic");
+  }
+
+  Handle QuantizedBVH::update(const BoundingVolume&, Handle handle) {
+    SyxAssertError(false, "QuantizedBVH can only be built with buildStatic");
+    return handle;
+  }
+
+  void QuantizedBVH::clear() {
+    mNodes.clear();
+    mLeaves.clear();
+  }
+
+  void QuantizedBVH::queryRaycast(const Vec3& start, const Vec3& end, std::vector<ResultNode>& results) const {
+    size_t i = 0;
+    while(i < mNodes.size()) {
+      const Node& node = mNodes[i];
+      const bool hit = _dequantize(node).lineIntersect(start, end);
+      if(node.isLeaf()) {
+        if(hit)
+          results.push_back(mLeaves[node.mData]);
+        ++i;
+      }
+      else
+        i = hit ? i + 1 : static_cast<size_t>(~node.mData);
+    }
+  }
+
+  void QuantizedBVH::queryVolume(const BoundingVolume& volume, std::vector<ResultNode>& results) const {
+    if(mNodes.empty())
+      return;
+    //Clamping would make volumes entirely outside the root look like they touch its edge, so rule those out first
+    if(!_dequantize(mNodes[0]).overlapping(volume.mAABB))
+      return;
+
+    //Quantize the query once so all node tests are integer comparisons
+    uint16_t min[3], max[3];
+    _quantize(volume.mAABB, min, max);
+    size_t i = 0;
+    while(i < mNodes.size()) {
+      const Node& node = mNodes[i];
+      const bool hit = node.mMin[0] <= max[0] && node.mMax[0] >= min[0] &&
+        node.mMin[1] <= max[1] && node.mMax[1] >= min[1] &&
+        node.mMin[2] <= max[2] && node.mMax[2] >= min[2];
+      if(node.isLeaf()) {
+        if(hit)
+          results.push_back(mLeaves[node.mData]);
+        ++i;
+      }
+      else
+        i = hit ? i + 1 : static_cast<size_t>(~node.mData);
+    }
+  }
+
+  std::unique_ptr<BroadphaseContext> QuantizedBVH::createHitContext() const {
+    return std::make_unique<QBVHHitContext>(*this, mExistenceTracker);
+  }
+
+  std::unique_ptr<BroadphasePairContext> QuantizedBVH::createPairContext() const {
+    return std::make_unique<QBVHPairContext>();
+  }
+
+  namespace Create {
+    std::unique_ptr<Broadphase> quantizedBVH() {
+      return std::make_unique<QuantizedBVH>();
+    }
+  }
+}
@@ -0,0 +1,61 @@
+#pragma once
+#include "SyxBroadphase.h"
+
+namespace Syx {
+  //Static bounding volume hierarchy for large triangle meshes. Nodes store their bounds as 16 bit integers relative to the root's
+  //bounds and are laid out depth first with an escape index instead of child pointers, so traversal is a linear walk without a stack.
+  //Can only be built with buildStatic, inserting, updating or removing individual volumes isn't supported
+  class QuantizedBVH: public Broadphase {
+  public:
+    QuantizedBVH();
+    //Copies the hierarchy but not contexts, which stay with the original
+    QuantizedBVH(const QuantizedBVH& rhs);
+    ~QuantizedBVH();
+
+    QuantizedBVH& operator=(const QuantizedBVH& rhs) = delete;
+
+    void buildStatic(const std::vector<InsertParam>& nodes, std::vector<Handle>* resultHandles = nullptr) override;
+    Handle insert(const BoundingVolume& obj, void* userdata) override;
+    void remove(Handle handle) override;
+    void clear() override;
+
+    Handle update(const BoundingVolume& newVol, Handle handle) override;
+    int getType() const override { return BroadphaseType::QuantizedBVH; }
+
+    void queryRaycast(const Vec3& start, const Vec3& end, std::vector<ResultNode>& results) const;
+    void queryVolume(const BoundingVolume& volume, std::vector<ResultNode>& results) const;
+
+    std::unique_ptr<BroadphaseContext> createHitContext() const override;
+    std::unique_ptr<BroadphasePairContext> createPairContext() const override;
+
+    size_t getNodeCount() const { return mNodes.size(); }
+
+  private:
+    struct Node {
+      bool isLeaf() const { return mData >= 0; }
+
+      uint16_t mMin[3];
+      uint16_t mMax[3];
+      //Index into mLeaves for leaves, or for internal nodes the bitwise not of the node after this subtree
+      int32_t mData;
+    };
+
+    //Builds the subtree of volumes in [begin, end) of order, appending its nodes depth first
+    void _build(const std::vector<InsertParam>& nodes, const std::vector<Vec3>& centers, std::vector<size_t>& order, size_t begin, size_t end);
+    void _quantize(const AABB& aabb, uint16_t* min, uint16_t* max) const;
+    AABB _dequantize(const Node& node) const;
+
+    std::vector<Node> mNodes;
+    //Leaves in traversal order
+    std::vector<ResultNode> mLeaves;
+    Vec3 mOrigin;
+    //Multiplies offsets from mOrigin to get quantized values, and the inverse to get back
+    Vec3 mScale;
+    Vec3 mInvScale;
+    std::shared_ptr<bool> mExistenceTracker;
+  };
+
+  namespace Create {
+    std::unique_ptr<Broadphase> quantizedBVH();
+  }
+}
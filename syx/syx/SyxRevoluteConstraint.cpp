@@ -69,7 +69,7 @@ namespace Syx {
     mAngularBlock.getFixedErrors(worldBasisB, error);
     float halfSlop = RevoluteBlock::sSlop*0.5f;
     for(int i = 0; i < 2; ++i)
-      mAngularBlock.mBias[i] = Constraints::computeBias(error[i], halfSlop, sVelBaumgarteTerm, sMaxVelCorrection);
+      mAngularBlock.mBias[i] = Constraints::computeBias(error[i], halfSlop, getVelBaumgarteTerm(), sMaxVelCorrection);
 
     const Vec3& x = mAngularBlock.mAngular[0]; const Vec3& y = mAngularBlock.mAngular[1];
     Vec3 xia = ia*x; Vec3 xib = ib*x;
@@ -98,7 +98,7 @@ namespace Syx {
         Constraints::computeAngularLimitError(owner.mMinRads, owner.mMaxRads, enforceFree, freeError, mAngularBlock.mFreeEnforceDir);
 
         if(mAngularBlock.mFreeEnforceDir == LocalConstraint::EnforcePos || mAngularBlock.mFreeEnforceDir == LocalConstraint::EnforceNeg)
-          mAngularBlock.mBias[2] = -Constraints::computeBias(freeError, halfSlop, sVelBaumgarteTerm, sMaxVelCorrection);
+          mAngularBlock.mBias[2] = -Constraints::computeBias(freeError, halfSlop, getVelBaumgarteTerm(), sMaxVelCorrection);
       }
 
       if(mAngularBlock.mFreeEnforceDir != LocalConstraint::NoEnforce) {
@@ -13,7 +13,9 @@ namespace Syx {
       LockAngY = 1 << 4,
       LockAngZ = 1 << 5,
       Kinematic = 1 << 6,
-      Disabled = 1 << 7
+      Disabled = 1 << 7,
+      //Sweep along the path each step and stop short of anything that would be passed through
+      Continuous = 1 << 8
     };
   }
 
@@ -0,0 +1,86 @@
+#include "Precompile.h"
+#include "SyxRigidbodyStore.h"
+#include "SyxPhysicsObject.h"
+
+namespace Syx {
+  void RigidbodyStore::add(PhysicsObject& obj) {
+    if(contains(obj))
+      return;
+    mHandleToIndex[obj.getHandle()] = mBodies.size();
+    mBodies.push_back(&obj);
+    if(!obj.getAsleep())
+      _swap(mBodies.size() - 1, mAwakeCount++);
+  }
+
+  void RigidbodyStore::remove(PhysicsObject& obj) {
+    auto it = mHandleToIndex.find(obj.getHandle());
+    if(it == mHandleToIndex.end())
+      return;
+
+    size_t index = it->second;
+    mHandleToIndex.erase(it);
+    //Fill the gap with the last awake body, moving the gap to the start of the sleeping bodies
+    if(index < mAwakeCount) {
+      --mAwakeCount;
+      if(index != mAwakeCount)
+        _place(index, mBodies[mAwakeCount]);
+      index = mAwakeCount;
+    }
+    //Then swap the last body into it so the list stays packed
+    if(index + 1 != mBodies.size())
+      _place(index, mBodies.back());
+    mBodies.pop_back();
+  }
+
+  void RigidbodyStore::setAsleep(PhysicsObject& obj, bool asleep) {
+    obj.setAsleep(asleep);
+    auto it = mHandleToIndex.find(obj.getHandle());
+    if(it == mHandleToIndex.end())
+      return;
+
+    const size_t index = it->second;
+    if(asleep && index < mAwakeCount)
+      _swap(index, --mAwakeCount);
+    else if(!asleep && index >= mAwakeCount)
+      _swap(index, mAwakeCount++);
+  }
+
+  RigidbodyStore::BodyRange RigidbodyStore::getAwake() const {
+    return { mBodies.begin(), mBodies.begin() + mAwakeCount };
+  }
+
+  RigidbodyStore::BodyRange RigidbodyStore::getAsleep() const {
+    return { mBodies.begin() + mAwakeCount, mBodies.end() };
+  }
+
+  void RigidbodyStore::_place(size_t index, PhysicsObject* obj) {
+    mBodies[index] = obj;
+    mHandleToIndex[obj->getHandle()] = index;
+  }
+
+  void RigidbodyStore::_swap(size_t a, size_t b) {
+    if(a == b)
+      return;
+    PhysicsObject* objA = mBodies[a];
+    _place(a, mBodies[b]);
+    _place(b, objA);
+  }
+
+  bool RigidbodyStore::contains(PhysicsObject& obj) const {
+    return mHandleToIndex.find(obj.getHandle()) != mHandleToIndex.end();
+  }
+
+  void RigidbodyStore::clear() {
+    mBodies.clear();
+    mAwakeCount = 0;
+    mHandleToIndex.clear();
+  }
+
+  size_t RigidbodyStore::size() const {
+    return mBodies.size();
+  }
+
+  const std::vector<PhysicsObject*>& RigidbodyStore::getBodies() const {
+    return mBodies;
+  }
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+namespace Syx {
+  class PhysicsObject;
+
+  //Packed list of the dynamic bodies in a space, partitioned by sleep state so per step loops only visit awake bodies
+  class RigidbodyStore {
+  public:
+    typedef std::vector<PhysicsObject*>::const_iterator BodyIterator;
+    //Contiguous run of bodies, usable in range based for loops
+    struct BodyRange {
+      BodyIterator begin() const { return mBegin; }
+      BodyIterator end() const { return mEnd; }
+      size_t size() const { return static_cast<size_t>(mEnd - mBegin); }
+
+      BodyIterator mBegin;
+      BodyIterator mEnd;
+    };
+
+    RigidbodyStore()
+      : mAwakeCount(0) {
+    }
+
+    void add(PhysicsObject& obj);
+    void remove(PhysicsObject& obj);
+    bool contains(PhysicsObject& obj) const;
+    void clear();
+    size_t size() const;
+    const std::vector<PhysicsObject*>& getBodies() const;
+    //Sets the object's sleep flag and moves it between the awake and sleeping bodies if it's in the store
+    void setAsleep(PhysicsObject& obj, bool asleep);
+    BodyRange getAwake() const;
+    BodyRange getAsleep() const;
+
+  private:
+    void _place(size_t index, PhysicsObject* obj);
+    void _swap(size_t a, size_t b);
+
+    //Partitioned with the first mAwakeCount awake, so per step loops skip sleeping bodies without looking at them
+    std::vector<PhysicsObject*> mBodies;
+    size_t mAwakeCount;
+    std::unordered_map<Handle, size_t> mHandleToIndex;
+  };
+}
\ No newline at end of file
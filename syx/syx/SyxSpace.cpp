@@ -1,22 +1,26 @@
 #include "Precompile.h"
 #include "SyxSpace.h"
 #include "SyxAABBTree.h"
+#include "SyxSweepAndPrune.h"
 
 namespace Syx {
+  size_t Space::sNarrowphaseBatchSize = 32;
+  size_t Space::sQueryBatchSize = 64;
+
   Space::Space(Handle handle)
     : mMyHandle(handle)
-    , mBroadphase(Create::aabbTree())
-    , mBroadphaseContext(mBroadphase->createHitContext())
-    , mBroadphasePairContext(mBroadphase->createPairContext()) {
+    , mBroadphaseType(BroadphaseType::AABBTree) {
+    _createBroadphase();
     mConstraintSystem.setIslandGraph(mIslandGraph);
+    mConstraintSystem.setRigidbodyStore(mRigidbodies);
+    mConstraintSystem.setFrameArena(mFrameArena);
+    mConstraintSystem.setProfiler(mProfiler);
   }
 
   Space::Space(const Space& rhs) {
     *this = rhs;
     mObjects.reserve(100);
-    mBroadphase = Create::aabbTree();
-    mBroadphaseContext = mBroadphase->createHitContext();
-    mBroadphasePairContext = mBroadphase->createPairContext();
+    _rebuildRigidbodyStore();
   }
 
   Space::~Space() {
@@ -30,10 +34,47 @@ namespace Syx {
     mObjects = rhs.mObjects;
     mProfiler = rhs.mProfiler;
     mConstraintSystem.setIslandGraph(mIslandGraph);
-    mBroadphase = Create::aabbTree();
+    mConstraintSystem.setRigidbodyStore(mRigidbodies);
+    mConstraintSystem.setFrameArena(mFrameArena);
+    mConstraintSystem.setProfiler(mProfiler);
+    mBroadphaseType = rhs.mBroadphaseType;
+    _createBroadphase();
+    _rebuildRigidbodyStore();
+    return *this;
+  }
+
+  void Space::setBroadphaseType(int type) {
+    if(type == mBroadphaseType || type < 0 || type >= BroadphaseType::Count)
+      return;
+
+    mBroadphaseType = type;
+    _createBroadphase();
+    for(auto it = mObjects.begin(); it != mObjects.end(); ++it) {
+      Collider* collider = (*it).getCollider();
+      if(collider && collider->mBroadHandle != SyxInvalidHandle)
+        collider->initialize(*this);
+    }
+  }
+
+  void Space::_createBroadphase() {
+    //Contexts reference the broadphase so must go first
+    mBroadphaseContext = nullptr;
+    mBroadphasePairContext = nullptr;
+    mQueryContexts.clear();
+    switch(mBroadphaseType) {
+      case BroadphaseType::SweepAndPrune: mBroadphase = Create::sweepAndPrune(); break;
+      default: mBroadphase = Create::aabbTree(); break;
+    }
     mBroadphaseContext = mBroadphase->createHitContext();
     mBroadphasePairContext = mBroadphase->createPairContext();
-    return *this;
+  }
+
+  void Space::_rebuildRigidbodyStore() {
+    //Store holds pointers into mObjects, so it can't be copied along with it
+    mRigidbodies.clear();
+    for(auto it = mObjects.begin(); it != mObjects.end(); ++it)
+      if((*it).getRigidbody())
+        mRigidbodies.add(*it);
   }
 
   PhysicsObject* Space::createObject(void) {
@@ -48,6 +89,7 @@ namespace Syx {
       if(Collider* c = obj->getCollider()) {
         c->uninitialize(*this);
       }
+      mRigidbodies.remove(*obj);
     }
     mObjects.remove(handle);
   }
@@ -58,18 +100,34 @@ namespace Syx {
 
   void Space::clear(void) {
     mObjects.clear();
+    mRigidbodies.clear();
     mBroadphase->clear();
     mConstraintSystem.clear();
     mIslandGraph.clear();
   }
 
+  void Space::clearModelContexts() {
+    mNarrowphase.clearContexts();
+    for(Narrowphase& batch : mNarrowphaseBatches)
+      batch.clearContexts();
+    mCasterContext.clearEnvironment();
+    for(QueryContext& query : mQueryContexts)
+      query.mCasterContext.clearEnvironment();
+    mConstraintSystem.clearManifolds();
+  }
+
   void Space::update(float dt) {
     AutoProfileBlock block(mProfiler, "Update Space");
+    //Nothing from the last update is still using arena memory
+    mFrameArena.reset();
 
+    const bool collision = (Interface::getOptions().mDebugFlags & SyxOptions::DisableCollision) == 0;
     _integrateVelocity(dt);
-    if((Interface::getOptions().mDebugFlags & SyxOptions::DisableCollision) == 0)
+    if(collision)
       _collisionDetection();
     _solveConstraints(dt);
+    if(collision)
+      _sweepContinuous(dt);
     _integratePosition(dt);
   }
 
@@ -82,21 +140,15 @@ namespace Syx {
   }
 
   void Space::_integrateAllVelocity(float dt) {
-    for(auto it = mObjects.begin(); it != mObjects.end(); ++it) {
-      PhysicsObject& obj = *it;
-      if(obj.getAsleep())
-        continue;
-      Rigidbody* rigidbody = obj.getRigidbody();
-      if(rigidbody)
-        rigidbody->integrateVelocity(dt);
-    }
+    for(PhysicsObject* obj : mRigidbodies.getAwake())
+      obj->getRigidbody()->integrateVelocity(dt);
   }
 
-  void Space::updateMovedObject(PhysicsObject& obj) {
+  void Space::updateMovedObject(PhysicsObject& obj, const Vec3& displacement) {
     obj.updateModelInst();
     Collider* collider = obj.getCollider();
     if(collider)
-      collider->mBroadHandle = mBroadphase->update(BoundingVolume(collider->getAABB()), collider->mBroadHandle);
+      collider->mBroadHandle = mBroadphase->update(BoundingVolume(collider->getAABB(), displacement), collider->mBroadHandle);
   }
 
   void Space::wakeObject(PhysicsObject& obj) {
@@ -111,6 +163,24 @@ namespace Syx {
         _sIntegrateAllPositions(dt);
       else
         _integrateAllPositions(dt);
+
+      //Clamped bodies keep their speed so they hit what stopped them next step instead of drifting into it
+      //Clamps and events were both made in awake order, so one pass over the events finds all of them
+      std::vector<UpdateEvent>& events = mUpdateEvents.mEvents;
+      size_t nextEvent = 0;
+      for(const auto& clamp : mContinuousClamps) {
+        clamp.first->getRigidbody()->mLinVel = clamp.second;
+        const Handle handle = clamp.first->getHandle();
+        size_t e = nextEvent;
+        while(e < events.size() && events[e].mHandle != handle)
+          ++e;
+        //Bodies that didn't fire an event leave the search where it was for the next clamp
+        if(e < events.size()) {
+          events[e].mLinVel = clamp.second;
+          nextEvent = e + 1;
+        }
+      }
+      mContinuousClamps.clear();
     }
 
     {
@@ -123,16 +193,17 @@ namespace Syx {
       AutoProfileBlock draw(mProfiler, "Debug Draw");
       Vec3 color = Vec3::Zero;
       color[mMyHandle % 3] = 1.0f;
-      if(Interface::getOptions().mDebugFlags & (SyxOptions::Debug::DrawModels | SyxOptions::Debug::DrawPersonalBBs))
-        for(auto it = mObjects.begin(); it != mObjects.end(); ++it) {
-          PhysicsObject& obj = *it;
-          d.setColor(color.x, color.y, color.z);
-          obj.drawModel();
-          if((Interface::getOptions().mDebugFlags & SyxOptions::Debug::DrawSleeping) && obj.getAsleep()) {
-            d.setColor(1.0f, 1.0f, 1.0f);
-            d.drawPoint(obj.getTransform().mPos, 0.1f);
-          }
+      if(Interface::getOptions().mDebugFlags & (SyxOptions::Debug::DrawModels | SyxOptions::Debug::DrawPersonalBBs)) {
+        d.setColor(color.x, color.y, color.z);
+        for(auto it = mObjects.begin(); it != mObjects.end(); ++it)
+          (*it).drawModel();
+
+        if(Interface::getOptions().mDebugFlags & SyxOptions::Debug::DrawSleeping) {
+          d.setColor(1.0f, 1.0f, 1.0f);
+          for(PhysicsObject* obj : mRigidbodies.getAsleep())
+            d.drawPoint(obj->getTransform().mPos, 0.1f);
         }
+      }
 
       if(Interface::getOptions().mDebugFlags & SyxOptions::Debug::DrawBroadphase)
         mBroadphase->draw();
@@ -163,15 +234,11 @@ namespace Syx {
   }
 
   void Space::_integrateAllPositions(float dt) {
-    for(auto it = mObjects.begin(); it != mObjects.end(); ++it) {
-      PhysicsObject& obj = *it;
-      if(obj.getAsleep())
-        continue;
-      Rigidbody* rigidbody = obj.getRigidbody();
-      if(obj.shouldIntegrate()) {
-        obj.getRigidbody()->integratePosition(dt);
-        _fireUpdateEvent(obj);
-        updateMovedObject(*it);
+    for(PhysicsObject* obj : mRigidbodies.getAwake()) {
+      if(obj->shouldIntegrate()) {
+        obj->getRigidbody()->integratePosition(dt);
+        _fireUpdateEvent(*obj);
+        updateMovedObject(*obj, obj->getRigidbody()->mLinVel*dt);
       }
     }
   }
@@ -179,16 +246,92 @@ namespace Syx {
   void Space::_collisionDetection(void) {
     AutoProfileBlock detection(mProfiler, "Collision Detection");
 
-    mProfiler.pushBlock("Broadphase");
-    mBroadphasePairContext->queryPairs();
-    mProfiler.popBlock("Broadphase");
+    {
+      AutoProfileBlock broad(mProfiler, "Broadphase");
+      mBroadphasePairContext->queryPairs();
+    }
 
     {
       AutoProfileBlock narrow(mProfiler, "Narrowphase");
-      mNarrowphase.processPairQuery(mBroadphasePairContext->get(), *this);
+      const auto& pairs = mBroadphasePairContext->get();
+      if(_shouldNarrowphaseParallel(pairs.size()))
+        _parallelNarrowphase(pairs);
+      else
+        mNarrowphase.processPairQuery(pairs, *this);
+    }
+  }
+
+  void Space::_sweepContinuous(float dt) {
+    AutoProfileBlock block(mProfiler, "Continuous Collision");
+    const float slop = LocalContactConstraint::sPositionSlop;
+    for(PhysicsObject* obj : mRigidbodies.getAwake()) {
+      Rigidbody* rb = obj->getRigidbody();
+      Collider* collider = obj->getCollider();
+      if(!rb->getFlag(RigidbodyFlags::Continuous) || !collider || !obj->shouldIntegrate())
+        continue;
+
+      const Vec3 displacement = rb->mLinVel*dt;
+      //Moves this short can't overlap more than contacts already allow, so the narrowphase will catch them
+      if(displacement.length2() <= slop*slop)
+        continue;
+
+      const AABB& bounds = collider->getAABB();
+      mBroadphaseContext->queryVolume(AABB::combined(bounds, AABB(bounds.getMin() + displacement, bounds.getMax() + displacement)));
+      float fraction = 1.0f;
+      for(const ResultNode& node : mBroadphaseContext->get()) {
+        PhysicsObject* other = reinterpret_cast<PhysicsObject*>(node.mUserdata);
+        //Same pairs the narrowphase wouldn't make contacts for
+        if(other == obj || mConstraintSystem.isBlacklistPair(obj->getHandle(), other->getHandle()))
+          continue;
+
+        //Sweep relative to the other body's motion, then limit this body by how far along that it got
+        Vec3 relative = displacement;
+        Rigidbody* otherRb = other->getRigidbody();
+        if(otherRb && other->shouldIntegrate())
+          relative -= otherRb->mLinVel*dt;
+        const float distance = relative.length();
+        if(distance <= slop)
+          continue;
+
+        //Going slop past the first touch makes it a contact next step rather than stopping just short of it every step
+        mCasterContext.clearResults();
+        mCaster.sweep(*obj, relative, *other, slop, mCasterContext);
+        for(const CastResult& hit : mCasterContext.getResults())
+          fraction = std::min(fraction, std::sqrt(hit.mDistSq)/distance);
+      }
+
+      if(fraction < 1.0f) {
+        mContinuousClamps.push_back(std::make_pair(obj, rb->mLinVel));
+        rb->mLinVel *= fraction;
+      }
     }
   }
 
+  bool Space::_shouldNarrowphaseParallel(size_t pairCount) {
+    if(!(gOptions.mThreadingFlags & SyxOptions::ParallelNarrowphase) || pairCount < 2*sNarrowphaseBatchSize)
+      return false;
+    return !(gOptions.mDebugFlags & (SyxOptions::DrawCollidingPairs | SyxOptions::DrawGJK | SyxOptions::DrawEPA));
+  }
+
+  void Space::_parallelNarrowphase(const std::vector<std::pair<ResultNode, ResultNode>>& pairs) {
+    const size_t batchSize = std::max(sNarrowphaseBatchSize, size_t(1));
+    const size_t batches = (pairs.size() + batchSize - 1)/batchSize;
+    if(mNarrowphaseBatches.size() < batches)
+      mNarrowphaseBatches.resize(batches);
+
+    //Manifold lookup touches shared constraint state, so batches only find contacts and defer them
+    Interface::parallelFor(batches, [this, &pairs, batchSize](size_t i) {
+      AutoProfileBlock block(mProfiler, "Narrowphase Batch");
+      Narrowphase& narrowphase = mNarrowphaseBatches[i];
+      narrowphase.setDeferContacts(true);
+      narrowphase.processPairQuery(pairs, i*batchSize, std::min(pairs.size(), (i + 1)*batchSize), *this);
+    });
+
+    //Batches are contiguous ranges of pairs, so merging in batch order matches the serial result exactly
+    for(size_t i = 0; i < batches; ++i)
+      mNarrowphaseBatches[i].submitDeferredContacts(*this);
+  }
+
   void Space::_solveConstraints(float dt) {
     AutoProfileBlock block(mProfiler, "Constraint Solving");
     if(gOptions.mSimdFlags & SyxOptions::SIMD::ConstraintSolve)
@@ -210,6 +353,113 @@ namespace Syx {
     return CastResult(&mCasterContext.getResults());
   }
 
+  void Space::lineCastBatch(const Vec3* starts, const Vec3* ends, size_t count, int mode, std::vector<CastResult>& results) {
+    results.resize(count);
+    _queryBatches(count, [this, starts, ends, mode, &results](QueryContext& context, size_t begin, size_t end) {
+      //Broadphase is traversed once per packet of lines, then each line is cast against what it found
+      for(size_t i = begin; i < end; i += BroadphaseContext::sPacketSize) {
+        size_t packetSize = std::min(BroadphaseContext::sPacketSize, end - i);
+        context.mBroadphaseContext->queryRaycastPacket(starts + i, ends + i, packetSize);
+        for(size_t ray = 0; ray < packetSize; ++ray)
+          results[i + ray] = _lineCast(starts[i + ray], ends[i + ray], context.mBroadphaseContext->getPacket(ray), mode, context.mCasterContext);
+      }
+    });
+  }
+
+  CastResult Space::_lineCast(const Vec3& start, const Vec3& end, const std::vector<ResultNode>& candidates, int mode, CasterContext& context) {
+    SAlign Vec3 sStart = start;
+    SAlign Vec3 sEnd = end;
+    context.clearResults();
+    for(const ResultNode& candidate : candidates) {
+      mCaster.lineCast(*reinterpret_cast<PhysicsObject*>(candidate.mUserdata), sStart, sEnd, context);
+      if(mode == CastMode::Any && !context.getResults().empty())
+        break;
+    }
+
+    const std::vector<CastResult>& hits = context.getResults();
+    if(hits.empty())
+      return CastResult();
+    return *std::min_element(hits.begin(), hits.end(), [](const CastResult& l, const CastResult& r) {
+      return l.mDistSq < r.mDistSq;
+    });
+  }
+
+  void Space::overlapBatch(const AABB* volumes, size_t count, std::vector<Handle>& results, std::vector<size_t>& offsets) {
+    _overlapBatch(volumes, count, [volumes](size_t i, const AABB& bounds) {
+      return volumes[i].overlapping(bounds);
+    }, results, offsets);
+  }
+
+  void Space::overlapBatch(const Vec3* centers, const float* radii, size_t count, std::vector<Handle>& results, std::vector<size_t>& offsets) {
+    std::vector<AABB> bounds(count);
+    for(size_t i = 0; i < count; ++i) {
+      Vec3 extent(radii[i]);
+      bounds[i] = AABB(centers[i] - extent, centers[i] + extent);
+    }
+
+    _overlapBatch(bounds.data(), count, [centers, radii](size_t i, const AABB& objBounds) {
+      //Distance from the center to the closest point in the bounds
+      const Vec3 boxMin = objBounds.getMin();
+      const Vec3 boxMax = objBounds.getMax();
+      Vec3 closest = centers[i];
+      for(int axis = 0; axis < 3; ++axis)
+        closest[axis] = std::max(boxMin[axis], std::min(closest[axis], boxMax[axis]));
+      return closest.distance2(centers[i]) <= radii[i]*radii[i];
+    }, results, offsets);
+  }
+
+  void Space::_overlapBatch(const AABB* bounds, size_t count, const std::function<bool(size_t, const AABB&)>& isOverlapping, std::vector<Handle>& results, std::vector<size_t>& offsets) {
+    _queryBatches(count, [bounds, &isOverlapping](QueryContext& context, size_t begin, size_t end) {
+      context.mOverlaps.clear();
+      context.mOverlapCounts.clear();
+      for(size_t i = begin; i < end; ++i) {
+        size_t found = context.mOverlaps.size();
+        context.mBroadphaseContext->queryVolume(BoundingVolume(bounds[i]));
+        //Broadphase volumes are enlarged, so check the objects' actual bounds
+        for(const ResultNode& candidate : context.mBroadphaseContext->get()) {
+          PhysicsObject* obj = reinterpret_cast<PhysicsObject*>(candidate.mUserdata);
+          if(isOverlapping(i, obj->getCollider()->getAABB()))
+            context.mOverlaps.push_back(obj->getHandle());
+        }
+        context.mOverlapCounts.push_back(context.mOverlaps.size() - found);
+      }
+    });
+
+    //Batches are contiguous ranges of volumes, so appending in batch order keeps results in volume order
+    results.clear();
+    offsets.resize(count + 1);
+    offsets[0] = 0;
+    size_t volume = 0;
+    for(size_t i = 0; volume < count; ++i) {
+      const QueryContext& context = mQueryContexts[i];
+      results.insert(results.end(), context.mOverlaps.begin(), context.mOverlaps.end());
+      for(size_t found : context.mOverlapCounts) {
+        offsets[volume + 1] = offsets[volume] + found;
+        ++volume;
+      }
+    }
+  }
+
+  void Space::_queryBatches(size_t count, const std::function<void(QueryContext&, size_t, size_t)>& query) {
+    const size_t batchSize = std::max(sQueryBatchSize, size_t(1));
+    const size_t batches = (count + batchSize - 1)/batchSize;
+    if(mQueryContexts.size() < batches)
+      mQueryContexts.resize(batches);
+    for(size_t i = 0; i < batches; ++i)
+      if(!mQueryContexts[i].mBroadphaseContext)
+        mQueryContexts[i].mBroadphaseContext = mBroadphase->createHitContext();
+
+    auto queryBatch = [this, count, batchSize, &query](size_t i) {
+      query(mQueryContexts[i], i*batchSize, std::min(count, (i + 1)*batchSize));
+    };
+    if(batches > 1 && (Interface::getOptions().mThreadingFlags & SyxOptions::ParallelQueries))
+      Interface::parallelFor(batches, queryBatch);
+    else {
+      for(size_t i = 0; i < batches; ++i)
+        queryBatch(i);
+    }
+  }
+
   void Space::setColliderEnabled(PhysicsObject& obj, bool enabled) {
     Collider* collider = obj.getCollider();
     if(collider && !enabled) {
@@ -225,12 +475,20 @@ namespace Syx {
   void Space::setRigidbodyEnabled(PhysicsObject& obj, bool enabled) {
     //Will probably soon have the same initialization as collider
     obj.setRigidbodyEnabled(enabled);
+    if(enabled)
+      mRigidbodies.add(obj);
+    else
+      mRigidbodies.remove(obj);
   }
 
   Manifold* Space::getManifold(PhysicsObject& a, PhysicsObject& b, ModelInstance& instA, ModelInstance& instB) {
     return mConstraintSystem.getManifold(a, b, instA, instB);
   }
 
+  Manifold* Space::findManifold(const ModelInstance& instA, const ModelInstance& instB) const {
+    return mConstraintSystem.findManifold(instA.getHandle(), instB.getHandle());
+  }
+
 #define AddConstraint(func)\
     if(!_fillOps(ops))\
       return SyxInvalidHandle;\
@@ -301,14 +559,12 @@ namespace Syx {
     SFloats sdt = sLoadSplatFloats(dt);
     SFloats half = sLoadSplatFloats(0.5f);
 
-    for(auto it = mObjects.begin(); it != mObjects.end(); ++it) {
-      PhysicsObject& obj = *it;
-      Rigidbody* rigidbody = obj.getRigidbody();
-      //This ultimately shouldn't be needed because I should have a dynamic objects list that this would iterate over
-      if(!obj.shouldIntegrate())
+    for(PhysicsObject* obj : mRigidbodies.getAwake()) {
+      Rigidbody* rigidbody = obj->getRigidbody();
+      if(!obj->shouldIntegrate())
         continue;
 
-      Transform& t = obj.getTransform();
+      Transform& t = obj->getTransform();
       SFloats pos = toSVec3(t.mPos);
       SFloats linVel = toSVec3(rigidbody->mLinVel);
       pos = SAddAll(pos, SMulAll(linVel, sdt));
@@ -336,8 +592,8 @@ namespace Syx {
       //rotMat now contains Rot.Scaled(m_localInertia) * rot.Transposed
       rotMat.store(rigidbody->mInvInertia);
 
-      _fireUpdateEvent(obj);
-      updateMovedObject(*it);
+      _fireUpdateEvent(*obj);
+      updateMovedObject(*obj, rigidbody->mLinVel*dt);
     }
   }
 
@@ -345,13 +601,9 @@ namespace Syx {
     SFloats gravity = sLoadSplatFloats(dt);
     gravity = SMulAll(gravity, sLoadFloats(0.0f, -10.0f, 0.0f));
 
-    for(auto it = mObjects.begin(); it != mObjects.end(); ++it) {
-      PhysicsObject& obj = *it;
-      if(obj.getAsleep())
-        continue;
-      Rigidbody* rigidbody = obj.getRigidbody();
-
-      if(rigidbody && rigidbody->mInvMass > SYX_EPSILON) {
+    for(PhysicsObject* obj : mRigidbodies.getAwake()) {
+      Rigidbody* rigidbody = obj->getRigidbody();
+      if(rigidbody->mInvMass > SYX_EPSILON) {
         SFloats sVel = toSVec3(rigidbody->mLinVel);
         sVel = SAddAll(sVel, gravity);
         SStoreAll(&rigidbody->mLinVel.x, sVel);
@@ -6,6 +6,7 @@
 #include "SyxCaster.h"
 #include "SyxIslandGraph.h"
 #include "SyxEvents.h"
+#include "SyxRigidbodyStore.h"
 
 namespace Syx {
   class Broadphase;
@@ -15,6 +16,7 @@ namespace Syx {
   class Collider;
   class Manifold;
   class NarrowphaseTest;
+  class SimulationTest;
   class ModelInstance;
 
   class Space {
@@ -23,9 +25,15 @@ namespace Syx {
     friend PhysicsObject;
     friend Collider;
     friend NarrowphaseTest;
+    friend SimulationTest;
 
     DeclareHandleMapNode(Space);
 
+    //Minimum pairs per narrowphase batch when running the narrowphase in parallel
+    static size_t sNarrowphaseBatchSize;
+    //Queries per batch when running batched queries in parallel
+    static size_t sQueryBatchSize;
+
     Space(Handle handle = 0);
     Space(const Space& rhs);
     ~Space(void);
@@ -35,24 +43,41 @@ namespace Syx {
     bool operator==(Handle rhs) { return mMyHandle == rhs; }
     Handle getHandle(void) { return mMyHandle; }
 
+    //Replaces the broadphase with one of BroadphaseType, moving all existing colliders into it
+    void setBroadphaseType(int type);
+    int getBroadphaseType() const { return mBroadphaseType; }
+
     PhysicsObject* createObject(void);
     void destroyObject(Handle handle);
     PhysicsObject* getObject(Handle handle);
 
     const std::string& getProfileReport(const std::string& indent) { return mProfiler.getReport(indent); }
     const std::vector<ProfileResult>& getProfileHistory() { return mProfiler.getHistory(); }
+    void writeProfileTrace(std::ostream& stream) const { mProfiler.writeTrace(stream); }
+    void setProfileEnabled(bool enabled) { mProfiler.setEnabled(enabled); }
+    void setSolverIterations(int iterations) { mConstraintSystem.setIterations(iterations); }
+    int getSolverIterations() const { return mConstraintSystem.getIterations(); }
 
     CastResult lineCastAll(const Vec3& start, const Vec3& end);
+    //Fills results with one result per line, the hit picked by CastMode mode. Lines that hit nothing have an mObj of SyxInvalidHandle
+    void lineCastBatch(const Vec3* starts, const Vec3* ends, size_t count, int mode, std::vector<CastResult>& results);
+    //Finds objects whose bounds overlap each volume. Objects for volume i are results[offsets[i]] up to results[offsets[i + 1]]
+    void overlapBatch(const AABB* volumes, size_t count, std::vector<Handle>& results, std::vector<size_t>& offsets);
+    void overlapBatch(const Vec3* centers, const float* radii, size_t count, std::vector<Handle>& results, std::vector<size_t>& offsets);
 
     void clear(void);
     void update(float dt);
+    //Drops query contexts cached for model broadphases, which must happen whenever a model is updated or removed
+    void clearModelContexts();
 
     void wakeObject(PhysicsObject& obj);
-    void updateMovedObject(PhysicsObject& obj);
+    //Displacement is how far the object is expected to move next step, used to avoid updating the broadphase every step
+    void updateMovedObject(PhysicsObject& obj, const Vec3& displacement = Vec3::Zero);
     void setColliderEnabled(PhysicsObject& obj, bool enabled);
     void setRigidbodyEnabled(PhysicsObject& obj, bool enabled);
 
     Manifold* getManifold(PhysicsObject& a, PhysicsObject& b, ModelInstance& instA, ModelInstance& instB);
+    Manifold* findManifold(const ModelInstance& instA, const ModelInstance& instB) const;
 
     Handle addDistanceConstraint(DistanceOps& ops);
     Handle addSphericalConstraint(SphericalOps& ops);
@@ -64,12 +89,32 @@ namespace Syx {
     const EventListener<UpdateEvent>& getUpdateEvents();
 
   private:
+    //Per batch state for batched queries so batches can run concurrently
+    struct QueryContext {
+      std::unique_ptr<BroadphaseContext> mBroadphaseContext;
+      CasterContext mCasterContext;
+      //Overlap results for this batch's volumes, and how many each volume found
+      std::vector<Handle> mOverlaps;
+      std::vector<size_t> mOverlapCounts;
+    };
+
     bool _fillOps(ConstraintOptions& ops);
 
+    CastResult _lineCast(const Vec3& start, const Vec3& end, const std::vector<ResultNode>& candidates, int mode, CasterContext& context);
+    //Calls query with each batch's context and the range of queries it's responsible for, in parallel if enabled
+    void _queryBatches(size_t count, const std::function<void(QueryContext&, size_t, size_t)>& query);
+    //Overlap queries where isOverlapping(i, aabb) tells if volume i overlaps an object's bounds
+    void _overlapBatch(const AABB* bounds, size_t count, const std::function<bool(size_t, const AABB&)>& isOverlapping, std::vector<Handle>& results, std::vector<size_t>& offsets);
+
     void _integrateVelocity(float dt);
     void _integratePosition(float dt);
     void _collisionDetection(void);
     void _solveConstraints(float dt);
+    //Shortens the motion of continuous bodies that would pass through something this step
+    void _sweepContinuous(float dt);
+
+    bool _shouldNarrowphaseParallel(size_t pairCount);
+    void _parallelNarrowphase(const std::vector<std::pair<ResultNode, ResultNode>>& pairs);
 
     void _integrateAllPositions(float dt);
     void _sIntegrateAllPositions(float dt);
@@ -78,19 +123,33 @@ namespace Syx {
     void _sIntegrateAllVelocity(float dt);
 
     void _fireUpdateEvent(PhysicsObject& obj);
+    void _createBroadphase();
+    void _rebuildRigidbodyStore();
 
-    HandleMap<PhysicsObject> mObjects;
+    SlotHandleMap<PhysicsObject> mObjects;
+    //Objects in mObjects that have rigidbodies, packed for integration
+    RigidbodyStore mRigidbodies;
     Handle mMyHandle;
+    int mBroadphaseType;
     std::unique_ptr<Broadphase> mBroadphase;
     std::unique_ptr<BroadphaseContext> mBroadphaseContext;
     std::unique_ptr<BroadphasePairContext> mBroadphasePairContext;
+    //Transient memory for a single update, reset at the start of each. Only the island solvers' object index maps live here,
+    //other per-step buffers are members that keep their capacity between updates
+    FrameArena mFrameArena;
     Narrowphase mNarrowphase;
+    //One narrowphase per batch of pairs when processing pairs in parallel, each deferring its contacts
+    std::vector<Narrowphase, AlignmentAllocator<Narrowphase>> mNarrowphaseBatches;
     ConstraintSystem mConstraintSystem;
     IslandGraph mIslandGraph;
     IslandContents mIslandStore;
     Caster mCaster;
     Profiler mProfiler;
     CasterContext mCasterContext;
+    //One per query batch, created on demand
+    std::vector<QueryContext> mQueryContexts;
+    //Bodies whose velocity was scaled down for this step's position integration, and the velocity to restore afterwards
+    std::vector<std::pair<PhysicsObject*, Vec3>> mContinuousClamps;
     EventListener<UpdateEvent> mUpdateEvents;
   };
 }
\ No newline at end of file
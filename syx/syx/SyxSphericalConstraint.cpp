@@ -70,7 +70,7 @@ namespace Syx {
         mAngularMA[i] = inertiaA*mAngularA[i];
         mAngularMB[i] = inertiaB*mAngularB[i];
 
-        mBias[i] = Constraints::computeBias(error[i], halfSlop, LocalConstraint::sVelBaumgarteTerm, LocalConstraint::sMaxVelCorrection);
+        mBias[i] = Constraints::computeBias(error[i], halfSlop, LocalConstraint::getVelBaumgarteTerm(), LocalConstraint::sMaxVelCorrection);
       }
 
       mMassA = massA;
@@ -187,7 +187,7 @@ namespace Syx {
         if(swingError > 0.0f) {
           //Only enforce positive direction to prevent further error
           mEnforceDir[0] = LocalConstraint::EnforcePos;
-          mBias[0] = -Constraints::computeBiasPos(swingError, halfSlop, LocalConstraint::sVelBaumgarteTerm, LocalConstraint::sMaxVelCorrection);
+          mBias[0] = -Constraints::computeBiasPos(swingError, halfSlop, LocalConstraint::getVelBaumgarteTerm(), LocalConstraint::sMaxVelCorrection);
           fillSwingJac = true;
         }
       }
@@ -223,7 +223,7 @@ namespace Syx {
 
         if(mEnforceDir[1] != LocalConstraint::NoEnforce) {
           if(limitTwist) {
-            mBias[1] = -Constraints::computeBias(twistError, halfSlop, LocalConstraint::sVelBaumgarteTerm, LocalConstraint::sMaxVelCorrection);
+            mBias[1] = -Constraints::computeBias(twistError, halfSlop, LocalConstraint::getVelBaumgarteTerm(), LocalConstraint::sMaxVelCorrection);
           }
           mAngularMA[1] = inertiaA * mAngular[1];
           mAngularMB[1] = inertiaB * -mAngular[1];
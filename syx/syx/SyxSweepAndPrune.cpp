@@ -0,0 +1,316 @@
+#include "Precompile.h"
+#include "SyxSweepAndPrune.h"
+
+namespace Syx {
+  namespace {
+    typedef std::pair<ResultNode, ResultNode> ResultPair;
+
+    std::pair<Handle, Handle> _getKey(const ResultPair& pair) {
+      return { std::min(pair.first.mHandle, pair.second.mHandle), std::max(pair.first.mHandle, pair.second.mHandle) };
+    }
+
+    bool _keyLess(const ResultPair& lhs, const ResultPair& rhs) {
+      return _getKey(lhs) < _getKey(rhs);
+    }
+  }
+
+  class SAPContextBase {
+  public:
+    SAPContextBase(const SweepAndPrune& broadphase, std::weak_ptr<bool> existenceTracker)
+      : mBroadphase(broadphase)
+      , mExistenceTracker(std::move(existenceTracker)) {
+    }
+
+    const SweepAndPrune& mBroadphase;
+    std::weak_ptr<bool> mExistenceTracker;
+  };
+
+  class SAPHitContext : public BroadphaseContext, public SAPContextBase {
+  public:
+    using SAPContextBase::SAPContextBase;
+
+    void queryRaycast(const Vec3& start, const Vec3& end) override {
+      mResults.clear();
+      if(auto e = mExistenceTracker.lock()) {
+        mBroadphase.queryRaycast(start, end, mResults);
+      }
+    }
+
+    void queryVolume(const BoundingVolume& volume) override {
+      mResults.clear();
+      if(auto e = mExistenceTracker.lock()) {
+        mBroadphase.queryVolume(volume, mResults);
+      }
+    }
+
+    const std::vector<ResultNode>& get() const override {
+      return mResults;
+    }
+
+  private:
+    std::vector<ResultNode> mResults;
+  };
+
+  struct SAPPairContext : public BroadphasePairContext, public SAPContextBase {
+    typedef std::vector<float, AlignmentAllocator<float>> FloatArray;
+
+    using SAPContextBase::SAPContextBase;
+
+    void queryPairs() override {
+      mPrevious.swap(mResults);
+      mResults.clear();
+      if(auto e = mExistenceTracker.lock()) {
+        mBroadphase.queryPairs(*this);
+      }
+      _computeChanges();
+    }
+
+    const std::vector<ResultPair>& get() const override {
+      return mResults;
+    }
+
+    const std::vector<ResultPair>& getAdded() const override {
+      return mAdded;
+    }
+
+    const std::vector<ResultPair>& getRemoved() const override {
+      return mRemoved;
+    }
+
+    //Both lists are sorted by handle, so walk them together to find the differences
+    void _computeChanges() {
+      mAdded.clear();
+      mRemoved.clear();
+      size_t prev = 0;
+      size_t cur = 0;
+      while(prev < mPrevious.size() || cur < mResults.size()) {
+        if(cur == mResults.size() || (prev < mPrevious.size() && _keyLess(mPrevious[prev], mResults[cur])))
+          mRemoved.push_back(mPrevious[prev++]);
+        else if(prev == mPrevious.size() || _keyLess(mResults[cur], mPrevious[prev]))
+          mAdded.push_back(mResults[cur++]);
+        else {
+          ++prev;
+          ++cur;
+        }
+      }
+    }
+
+    std::vector<ResultPair> mResults;
+    std::vector<ResultPair> mPrevious;
+    std::vector<ResultPair> mAdded;
+    std::vector<ResultPair> mRemoved;
+
+    //Volume indices sorted along mSortAxis, kept between queries so sorting a coherent scene is nearly linear
+    std::vector<size_t> mOrder;
+    int mSortAxis = -1;
+    //Volume bounds in sorted order, padded to a multiple of 4 with volumes that never overlap anything
+    FloatArray mMin[3];
+    FloatArray mMax[3];
+  };
+
+  SweepAndPrune::SweepAndPrune()
+    : mExistenceTracker(std::make_shared<bool>()) {
+  }
+
+  SweepAndPrune::~SweepAndPrune() {
+    while(mExistenceTracker.use_count() > 1) {
+      std::this_thread::yield();
+    }
+  }
+
+  Handle SweepAndPrune::insert(const BoundingVolume& obj, void* userdata) {
+    Handle result = _getNewHandle();
+    mHandleToIndex[result] = mVolumes.size();
+    mVolumes.push_back(obj.mAABB);
+    mNodes.push_back(ResultNode(result, userdata));
+    return result;
+  }
+
+  void SweepAndPrune::remove(Handle handle) {
+    auto it = mHandleToIndex.find(handle);
+    if(it == mHandleToIndex.end())
+      return;
+
+    //Swap the last volume into the removed slot. Contexts notice the size change and rebuild their order
+    size_t index = it->second;
+    mHandleToIndex.erase(it);
+    if(index + 1 != mVolumes.size()) {
+      mVolumes[index] = mVolumes.back();
+      mNodes[index] = mNodes.back();
+      mHandleToIndex[mNodes[index].mHandle] = index;
+    }
+    mVolumes.pop_back();
+    mNodes.pop_back();
+  }
+
+  void SweepAndPrune::clear() {
+    mVolumes.clear();
+    mNodes.clear();
+    mHandleToIndex.clear();
+  }
+
+  void SweepAndPrune::draw() {
+    DebugDrawer& d = DebugDrawer::get();
+    d.setColor(1.0f, 0.0f, 0.0f);
+    for(const AABB& volume : mVolumes)
+      d.drawCube(volume.getCenter(), volume.getDiagonal(), Vec3::UnitX, Vec3::UnitY);
+  }
+
+  //Volumes are stored exactly and updating is cheap, so there's no need to enlarge them
+  Handle SweepAndPrune::update(const BoundingVolume& newVol, Handle handle) {
+    auto it = mHandleToIndex.find(handle);
+    if(it != mHandleToIndex.end())
+      mVolumes[it->second] = newVol.mAABB;
+    return handle;
+  }
+
+  void SweepAndPrune::queryPairs(SAPPairContext& context) const {
+    const int axis = _getSweepAxis();
+    _sort(context, axis);
+    _sweep(context, axis);
+    //Sweep order depends on positions, so sort to give consistent results and allow comparison against the previous query
+    std::sort(context.mResults.begin(), context.mResults.end(), _keyLess);
+  }
+
+  void SweepAndPrune::queryRaycast(const Vec3& start, const Vec3& end, std::vector<ResultNode>& results) const {
+    for(size_t i = 0; i < mVolumes.size(); ++i)
+      if(mVolumes[i].lineIntersect(start, end))
+        results.push_back(mNodes[i]);
+  }
+
+  void SweepAndPrune::queryVolume(const BoundingVolume& volume, std::vector<ResultNode>& results) const {
+    for(size_t i = 0; i < mVolumes.size(); ++i)
+      if(mVolumes[i].overlapping(volume.mAABB))
+        results.push_back(mNodes[i]);
+  }
+
+  std::unique_ptr<BroadphaseContext> SweepAndPrune::createHitContext() const {
+    return std::make_unique<SAPHitContext>(*this, mExistenceTracker);
+  }
+
+  std::unique_ptr<BroadphasePairContext> SweepAndPrune::createPairContext() const {
+    return std::make_unique<SAPPairContext>(*this, mExistenceTracker);
+  }
+
+  //Sweep along the axis with the most variance in volume centers to minimize overlap along it
+  int SweepAndPrune::_getSweepAxis() const {
+    Vec3 sum, sumSquared;
+    for(const AABB& volume : mVolumes) {
+      Vec3 center = volume.getCenter();
+      sum += center;
+      sumSquared += Vec3(center.x*center.x, center.y*center.y, center.z*center.z);
+    }
+    const float count = static_cast<float>(std::max(mVolumes.size(), size_t(1)));
+    Vec3 variance = sumSquared/count - Vec3(sum.x*sum.x, sum.y*sum.y, sum.z*sum.z)/(count*count);
+    return variance.mostSignificantAxis();
+  }
+
+  void SweepAndPrune::_sort(SAPPairContext& context, int axis) const {
+    std::vector<size_t>& order = context.mOrder;
+    auto lessOnAxis = [this, axis](size_t l, size_t r) {
+      return mVolumes[l].getMin()[axis] < mVolumes[r].getMin()[axis];
+    };
+
+    if(order.size() != mVolumes.size() || context.mSortAxis != axis) {
+      order.resize(mVolumes.size());
+      for(size_t i = 0; i < order.size(); ++i)
+        order[i] = i;
+      std::sort(order.begin(), order.end(), lessOnAxis);
+      context.mSortAxis = axis;
+    }
+    else {
+      //Insertion sort, since objects don't move much relative to each other between queries
+      for(size_t i = 1; i < order.size(); ++i) {
+        size_t toInsert = order[i];
+        size_t j = i;
+        for(; j > 0 && lessOnAxis(toInsert, order[j - 1]); --j)
+          order[j] = order[j - 1];
+        order[j] = toInsert;
+      }
+    }
+
+    const size_t count = order.size();
+    const size_t padded = ((count + 3)/4)*4;
+    for(int a = 0; a < 3; ++a) {
+      //Padding volumes start beyond every real one so they can't be swept into
+      context.mMin[a].resize(padded);
+      context.mMax[a].resize(padded);
+      for(size_t i = 0; i < count; ++i) {
+        const AABB& volume = mVolumes[order[i]];
+        context.mMin[a][i] = volume.getMin()[a];
+        context.mMax[a][i] = volume.getMax()[a];
+      }
+      for(size_t i = count; i < padded; ++i) {
+        context.mMin[a][i] = std::numeric_limits<float>::max();
+        context.mMax[a][i] = -std::numeric_limits<float>::max();
+      }
+    }
+  }
+
+#ifdef SENABLED
+  void SweepAndPrune::_sweep(SAPPairContext& context, int axis) const {
+    const int axisB = (axis + 1) % 3;
+    const int axisC = (axis + 2) % 3;
+    const std::vector<size_t>& order = context.mOrder;
+    const size_t count = order.size();
+    const float* sweepMin = context.mMin[axis].data();
+    const float* minB = context.mMin[axisB].data();
+    const float* maxB = context.mMax[axisB].data();
+    const float* minC = context.mMin[axisC].data();
+    const float* maxC = context.mMax[axisC].data();
+
+    for(size_t i = 0; i < count; ++i) {
+      const float sweepMax = context.mMax[axis][i];
+      auto overlaps = [&](size_t j) {
+        return minB[j] <= maxB[i] && maxB[j] >= minB[i] && minC[j] <= maxC[i] && maxC[j] >= minC[i];
+      };
+
+      //Scalar until aligned for SIMD loads
+      size_t j = i + 1;
+      for(; j < count && j % 4 && sweepMin[j] <= sweepMax; ++j)
+        if(overlaps(j))
+          context.mResults.push_back({ mNodes[order[i]], mNodes[order[j]] });
+      if(j % 4)
+        continue;
+
+      const SFloats sSweepMax = sLoadSplatFloats(sweepMax);
+      const SFloats sMinB = sLoadSplatFloats(minB[i]);
+      const SFloats sMaxB = sLoadSplatFloats(maxB[i]);
+      const SFloats sMinC = sLoadSplatFloats(minC[i]);
+      const SFloats sMaxC = sLoadSplatFloats(maxC[i]);
+      for(; j < count; j += 4) {
+        SFloats inSweep = SLessEqualAll(SLoadAll(sweepMin + j), sSweepMax);
+        //Sorted by min, so once a whole group starts past this volume nothing later can overlap it
+        if(!SMoveMask(inSweep))
+          break;
+
+        SFloats overlap = SAnd(inSweep, SLessEqualAll(SLoadAll(minB + j), sMaxB));
+        overlap = SAnd(overlap, SGreaterEqualAll(SLoadAll(maxB + j), sMinB));
+        overlap = SAnd(overlap, SLessEqualAll(SLoadAll(minC + j), sMaxC));
+        overlap = SAnd(overlap, SGreaterEqualAll(SLoadAll(maxC + j), sMinC));
+        int mask = SMoveMask(overlap);
+        for(int lane = 0; mask; ++lane, mask >>= 1)
+          if(mask & 1)
+            context.mResults.push_back({ mNodes[order[i]], mNodes[order[j + lane]] });
+      }
+    }
+  }
+#else
+  void SweepAndPrune::_sweep(SAPPairContext& context, int axis) const {
+    const std::vector<size_t>& order = context.mOrder;
+    const size_t count = order.size();
+    for(size_t i = 0; i < count; ++i) {
+      const float sweepMax = context.mMax[axis][i];
+      for(size_t j = i + 1; j < count && context.mMin[axis][j] <= sweepMax; ++j)
+        if(mVolumes[order[i]].overlapping(mVolumes[order[j]]))
+          context.mResults.push_back({ mNodes[order[i]], mNodes[order[j]] });
+    }
+  }
+#endif
+
+  namespace Create {
+    std::unique_ptr<Broadphase> sweepAndPrune() {
+      return std::make_unique<SweepAndPrune>();
+    }
+  }
+}
\ No newline at end of file
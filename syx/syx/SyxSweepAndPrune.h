@@ -0,0 +1,43 @@
+#pragma once
+#include "SyxBroadphase.h"
+
+namespace Syx {
+  struct SAPPairContext;
+
+  //Sorts volumes along the axis they're most spread out on then sweeps along it, testing the other axes four volumes at a time.
+  //No hierarchy to maintain, so suits large worlds of similarly sized objects that are mostly spread along a plane
+  class SweepAndPrune: public Broadphase {
+  public:
+    SweepAndPrune();
+    ~SweepAndPrune();
+
+    Handle insert(const BoundingVolume& obj, void* userdata) override;
+    void remove(Handle handle) override;
+    void clear() override;
+
+    void draw() override;
+    Handle update(const BoundingVolume& newVol, Handle handle) override;
+    int getType() const override { return BroadphaseType::SweepAndPrune; }
+
+    void queryPairs(SAPPairContext& context) const;
+    void queryRaycast(const Vec3& start, const Vec3& end, std::vector<ResultNode>& results) const;
+    void queryVolume(const BoundingVolume& volume, std::vector<ResultNode>& results) const;
+
+    std::unique_ptr<BroadphaseContext> createHitContext() const override;
+    std::unique_ptr<BroadphasePairContext> createPairContext() const override;
+
+  private:
+    int _getSweepAxis() const;
+    void _sort(SAPPairContext& context, int axis) const;
+    void _sweep(SAPPairContext& context, int axis) const;
+
+    std::vector<AABB> mVolumes;
+    std::vector<ResultNode> mNodes;
+    std::unordered_map<Handle, size_t> mHandleToIndex;
+    std::shared_ptr<bool> mExistenceTracker;
+  };
+
+  namespace Create {
+    std::unique_ptr<Broadphase> sweepAndPrune();
+  }
+}
\ No newline at end of file
@@ -36,7 +36,7 @@ namespace Syx {
 
     float halfAngularSlop = sSlop*0.5f;
     for(int i = 0; i < 3; ++i) {
-      mBias[i] = Constraints::computeBias(angularError[i], halfAngularSlop, LocalConstraint::sVelBaumgarteTerm, LocalConstraint::sMaxVelCorrection);
+      mBias[i] = Constraints::computeBias(angularError[i], halfAngularSlop, LocalConstraint::getVelBaumgarteTerm(), LocalConstraint::sMaxVelCorrection);
     }
     mLambdaSum = Vec3::Zero;
   }
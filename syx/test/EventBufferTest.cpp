@@ -0,0 +1,310 @@
+#include "Precompile.h"
+#include "CppUnitTest.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+#include <thread>
+#include "event/Event.h"
+#include "event/EventBuffer.h"
+#include "event/EventHandler.h"
+#include "event/EventIndex.h"
+#include "event/EventQueue.h"
+
+namespace EventBufferTest {
+  //Registered up front rather than a TypedEvent, which registers on construction and so can't be made on several threads at once
+  class TestEvent : public Event {
+  public:
+    TestEvent(int value, int producer = 0)
+      : Event(Event::typeId<TestEvent>(), sizeof(TestEvent))
+      , mValue(value)
+      , mProducer(producer)
+      //Long enough to be heap allocated, so a bad move or double destroy would show up
+      , mPayload(64, static_cast<char>('a' + value % 26)) {
+    }
+
+    int mValue;
+    int mProducer;
+    std::string mPayload;
+  };
+  REGISTER_EVENT(TestEvent)
+
+  class OtherTestEvent : public Event {
+  public:
+    OtherTestEvent(int value)
+      : Event(Event::typeId<OtherTestEvent>(), sizeof(OtherTestEvent))
+      , mValue(value) {
+    }
+
+    int mValue;
+  };
+  REGISTER_EVENT(OtherTestEvent)
+
+  std::vector<int> getValues(const EventBuffer& buffer) {
+    std::vector<int> result;
+    for(const Event& e : buffer) {
+      const TestEvent& test = static_cast<const TestEvent&>(e);
+      Assert::IsTrue(test.mPayload == std::string(64, static_cast<char>('a' + test.mValue % 26)), L"Payload should survive being stored", LINE_INFO());
+      result.push_back(test.mValue);
+    }
+    return result;
+  }
+
+  std::vector<int> range(int begin, int end) {
+    std::vector<int> result;
+    for(int i = begin; i < end; ++i)
+      result.push_back(i);
+    return result;
+  }
+
+  TEST_CLASS(EventBufferTest) {
+  public:
+    TEST_METHOD(EventBuffer_PushPastCapacity_AllInOrder) {
+      EventBuffer buffer(sizeof(TestEvent));
+      for(int i = 0; i < 1000; ++i)
+        buffer.push(TestEvent(i));
+      Assert::IsTrue(getValues(buffer) == range(0, 1000), L"Events should be iterated in the order they were pushed", LINE_INFO());
+    }
+
+    TEST_METHOD(EventBuffer_Clear_EmptyAndReusable) {
+      EventBuffer buffer(sizeof(TestEvent));
+      Assert::IsTrue(buffer.empty(), LINE_INFO());
+      for(int i = 0; i < 10; ++i)
+        buffer.push(TestEvent(i));
+      buffer.clear();
+      Assert::IsTrue(buffer.empty(), L"Nothing should be left after clearing", LINE_INFO());
+      for(int i = 0; i < 20; ++i)
+        buffer.push(TestEvent(i));
+      Assert::IsTrue(getValues(buffer) == range(0, 20), LINE_INFO());
+    }
+
+    TEST_METHOD(EventBuffer_Splice_AppendsAndEmptiesOther) {
+      EventBuffer a(sizeof(TestEvent)*4);
+      EventBuffer b(sizeof(TestEvent)*4);
+      for(int i = 0; i < 10; ++i)
+        a.push(TestEvent(i));
+      for(int i = 10; i < 20; ++i)
+        b.push(TestEvent(i));
+
+      a.splice(b);
+      Assert::IsTrue(getValues(a) == range(0, 20), L"Spliced events should follow existing ones", LINE_INFO());
+      Assert::IsTrue(b.empty(), L"Spliced buffer should be left empty", LINE_INFO());
+
+      b.push(TestEvent(20));
+      Assert::IsTrue(getValues(b) == range(20, 21), L"Spliced buffer should still be usable", LINE_INFO());
+    }
+
+    TEST_METHOD(EventBuffer_SpliceAfterClear_RecyclesChunks) {
+      //Small base so each frame's events span several chunks
+      EventBuffer frozen(sizeof(TestEvent)*2);
+      EventBuffer producer(sizeof(TestEvent)*2);
+      const int eventsPerFrame = 40;
+      size_t warmChunks = 0;
+      for(int frame = 0; frame < 100; ++frame) {
+        for(int i = 0; i < eventsPerFrame; ++i)
+          producer.push(TestEvent(frame*eventsPerFrame + i));
+        if(frame == 0)
+          Assert::IsTrue(producer.getChunkCount() > 2, L"Events should span several chunks", LINE_INFO());
+        frozen.splice(producer);
+        Assert::IsTrue(getValues(frozen) == range(frame*eventsPerFrame, (frame + 1)*eventsPerFrame), LINE_INFO());
+        Assert::IsTrue(producer.empty(), LINE_INFO());
+        frozen.clear();
+
+        //The first frame's chunks are all in frozen, so the producer allocates once more on the second
+        const size_t chunks = frozen.getChunkCount() + producer.getChunkCount();
+        if(frame <= 1)
+          warmChunks = chunks;
+        Assert::AreEqual(warmChunks, chunks, L"Chunks should be reused rather than allocated each frame", LINE_INFO());
+      }
+    }
+
+    TEST_METHOD(EventBuffer_AppendTo_Copies) {
+      EventBuffer a, b;
+      for(int i = 0; i < 10; ++i)
+        a.push(TestEvent(i));
+      a.appendTo(b);
+      Assert::IsTrue(getValues(a) == range(0, 10), L"Source should be unchanged", LINE_INFO());
+      Assert::IsTrue(getValues(b) == range(0, 10), LINE_INFO());
+    }
+  };
+
+  TEST_CLASS(EventHandlerTest) {
+  public:
+    //Values are pushed so they come out in increasing order if events are handled in the order they were pushed
+    static void pushMixed(EventBuffer& buffer) {
+      buffer.push(TestEvent(0));
+      buffer.push(TestEvent(1));
+      buffer.push(OtherTestEvent(2));
+      buffer.push(TestEvent(3));
+      buffer.push(OtherTestEvent(4));
+      buffer.push(OtherTestEvent(5));
+      buffer.push(TestEvent(6));
+    }
+
+    TEST_METHOD(EventHandler_HandleIndex_SameOrderAsBuffer) {
+      EventBuffer buffer;
+      pushMixed(buffer);
+      EventIndex index;
+      index.build(buffer);
+
+      std::vector<int> handled;
+      EventHandler handler;
+      handler.registerEventHandler<TestEvent>([&handled](const TestEvent& e) { handled.push_back(e.mValue); });
+      handler.registerEventHandler<OtherTestEvent>([&handled](const OtherTestEvent& e) { handled.push_back(e.mValue); });
+
+      handler.handleEvents(index);
+      Assert::IsTrue(handled == range(0, 7), L"Events of different types should still be handled in the order they were pushed", LINE_INFO());
+
+      handled.clear();
+      handler.handleEvents(buffer);
+      Assert::IsTrue(handled == range(0, 7), LINE_INFO());
+    }
+
+    TEST_METHOD(EventHandler_BatchHandler_GetsConsecutiveRuns) {
+      EventBuffer buffer;
+      pushMixed(buffer);
+      EventIndex index;
+      index.build(buffer);
+
+      std::vector<std::vector<int>> batches;
+      EventHandler handler;
+      handler.registerBatchHandler<TestEvent>([&batches](EventSpan<TestEvent> events) {
+        batches.emplace_back();
+        for(const TestEvent& e : events)
+          batches.back().push_back(e.mValue);
+      });
+      handler.registerBatchHandler<OtherTestEvent>([&batches](EventSpan<OtherTestEvent> events) {
+        batches.emplace_back();
+        for(const OtherTestEvent& e : events)
+          batches.back().push_back(e.mValue);
+      });
+
+      handler.handleEvents(index);
+      const std::vector<std::vector<int>> expected = { { 0, 1 }, { 2 }, { 3 }, { 4, 5 }, { 6 } };
+      Assert::IsTrue(batches == expected, L"Each run of one type should be a single batch", LINE_INFO());
+    }
+
+    TEST_METHOD(EventHandler_UnhandledType_NotVisited) {
+      EventBuffer buffer;
+      pushMixed(buffer);
+      EventIndex index;
+      index.build(buffer);
+
+      std::vector<int> handled;
+      EventHandler handler;
+      handler.registerEventHandler<OtherTestEvent>([&handled](const OtherTestEvent& e) { handled.push_back(e.mValue); });
+      handler.handleEvents(index);
+      Assert::IsTrue(handled == std::vector<int>{ 2, 4, 5 }, LINE_INFO());
+    }
+
+    TEST_METHOD(EventHandler_MultipleHandlers_CalledInRegistrationOrder) {
+      EventBuffer buffer;
+      buffer.push(TestEvent(0));
+      EventIndex index;
+      index.build(buffer);
+
+      std::vector<int> calls;
+      EventHandler handler;
+      handler.registerEventHandler<TestEvent>([&calls](const TestEvent&) { calls.push_back(1); });
+      handler.registerEventHandler<TestEvent>([&calls](const TestEvent&) { calls.push_back(2); });
+      handler.handleEvents(index);
+      Assert::IsTrue(calls == std::vector<int>{ 1, 2 }, LINE_INFO());
+    }
+
+    TEST_METHOD(EventHandler_GlobalHandler_GetsUnhandledTypes) {
+      EventBuffer buffer;
+      pushMixed(buffer);
+      EventIndex index;
+      index.build(buffer);
+
+      std::vector<int> handled, global;
+      EventHandler handler;
+      handler.registerEventHandler<TestEvent>([&handled](const TestEvent& e) { handled.push_back(e.mValue); });
+      handler.registerGlobalHandler([&global](const Event& e) { global.push_back(static_cast<const OtherTestEvent&>(e).mValue); });
+      handler.handleEvents(index);
+      Assert::IsTrue(handled == std::vector<int>{ 0, 1, 3, 6 }, LINE_INFO());
+      Assert::IsTrue(global == std::vector<int>{ 2, 4, 5 }, LINE_INFO());
+    }
+
+    TEST_METHOD(EventHandler_RegisterDuringHandling_NewHandlerCalled) {
+      EventBuffer buffer;
+      pushMixed(buffer);
+      EventIndex index;
+      index.build(buffer);
+
+      std::vector<int> handled;
+      EventHandler handler;
+      handler.registerEventHandler<OtherTestEvent>([](const OtherTestEvent&) {});
+      bool registered = false;
+      handler.registerEventHandler<TestEvent>([&](const TestEvent&) {
+        if(!registered) {
+          registered = true;
+          handler.registerEventHandler<OtherTestEvent>([&handled](const OtherTestEvent& e) { handled.push_back(e.mValue); });
+        }
+      });
+      handler.handleEvents(index);
+      Assert::IsTrue(handled == std::vector<int>{ 2, 4, 5 }, L"Handlers registered while handling should get later events", LINE_INFO());
+    }
+
+    TEST_METHOD(EventIndex_Rebuild_OnlyNewEvents) {
+      EventBuffer buffer;
+      pushMixed(buffer);
+      EventIndex index;
+      index.build(buffer);
+      buffer.clear();
+      buffer.push(TestEvent(7));
+      index.build(buffer);
+      Assert::AreEqual(size_t(1), index.getEvents(Event::typeId<TestEvent>()).size(), LINE_INFO());
+      Assert::IsTrue(index.getEvents(Event::typeId<OtherTestEvent>()).empty(), LINE_INFO());
+    }
+  };
+
+  TEST_CLASS(EventQueueTest) {
+  public:
+    TEST_METHOD(EventQueue_TakeAll_OnlyNewEvents) {
+      EventQueue queue;
+      EventBuffer frozen;
+      queue.getBuffer().get().push(TestEvent(0));
+      queue.takeAll(frozen);
+      Assert::IsTrue(getValues(frozen) == range(0, 1), LINE_INFO());
+
+      frozen.clear();
+      queue.getBuffer().get().push(TestEvent(1));
+      queue.takeAll(frozen);
+      Assert::IsTrue(getValues(frozen) == range(1, 2), L"Events already taken shouldn't be taken again", LINE_INFO());
+    }
+
+    TEST_METHOD(EventQueue_ManyProducers_AllTakenInOrderPerProducer) {
+      const int producers = 4;
+      const int count = 5000;
+      EventQueue queue;
+      EventBuffer frozen;
+      std::atomic_bool done(false);
+      std::vector<std::thread> threads;
+      for(int p = 0; p < producers; ++p) {
+        threads.emplace_back([&queue, p, count] {
+          for(int i = 0; i < count; ++i)
+            queue.getBuffer().get().push(TestEvent(i, p));
+        });
+      }
+
+      //Take while producers are pushing to make sure taking doesn't lose or reorder anything
+      std::vector<std::vector<int>> received(producers);
+      auto takeAll = [&] {
+        queue.takeAll(frozen);
+        for(const Event& e : frozen) {
+          const TestEvent& test = static_cast<const TestEvent&>(e);
+          received[test.mProducer].push_back(test.mValue);
+        }
+        frozen.clear();
+      };
+      for(int i = 0; i < 100; ++i)
+        takeAll();
+      for(std::thread& thread : threads)
+        thread.join();
+      takeAll();
+
+      for(int p = 0; p < producers; ++p)
+        Assert::IsTrue(received[p] == range(0, count), L"Each producer's events should all arrive in the order they were pushed", LINE_INFO());
+    }
+  };
+}
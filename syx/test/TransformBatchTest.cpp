@@ -0,0 +1,68 @@
+#include "Precompile.h"
+#include "CppUnitTest.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+#include "event/TransformEvent.h"
+
+namespace TransformBatchTest {
+  TEST_CLASS(TransformBatchTest) {
+  public:
+    //How physics updates were turned into model transforms before they were batched
+    static Syx::Mat4 getExpected(const Syx::Mat4& syxToModel, const Syx::Vec3& pos, const Syx::Quat& rot) {
+      return Syx::Mat4::transform(syxToModel.getScale().reciprocal(), rot, pos) * syxToModel;
+    }
+
+    static void assertClose(const Syx::Mat4& expected, const Syx::Mat4& actual) {
+      for(int c = 0; c < 4; ++c)
+        for(int r = 0; r < 4; ++r)
+          Assert::AreEqual(expected[c][r], actual[c][r], 0.001f, L"Batched transform should match the matrix product", LINE_INFO());
+    }
+
+    static void assertMatchesProduct(const Syx::Mat4& syxToModel) {
+      const Syx::Vec3 positions[] = { Syx::Vec3::Zero, Syx::Vec3(1.0f, -2.0f, 3.0f), Syx::Vec3(-4.5f, 0.5f, 10.0f) };
+      const Syx::Quat rotations[] = {
+        Syx::Quat::Identity,
+        Syx::Quat::axisAngle(Syx::Vec3::UnitY, 0.7f),
+        Syx::Quat::axisAngle(Syx::Vec3(1.0f, 2.0f, -1.0f).normalized(), 2.1f)
+      };
+      const SyxToModel toModel(syxToModel);
+      TransformBatch batch;
+      for(const Syx::Vec3& pos : positions)
+        for(const Syx::Quat& rot : rotations)
+          toModel.push(batch, batch.size(), pos, rot);
+
+      size_t i = 0;
+      for(const Syx::Vec3& pos : positions)
+        for(const Syx::Quat& rot : rotations)
+          assertClose(getExpected(syxToModel, pos, rot), batch.getTransform(i++));
+    }
+
+    TEST_METHOD(TransformBatch_Identity_MatchesProduct) {
+      assertMatchesProduct(Syx::Mat4::identity());
+    }
+
+    TEST_METHOD(TransformBatch_UniformScaleRotation_MatchesProduct) {
+      assertMatchesProduct(Syx::Mat4::transform(Syx::Vec3(2.0f), Syx::Quat::axisAngle(Syx::Vec3::UnitX, 1.2f), Syx::Vec3(0.5f, 1.0f, -3.0f)));
+    }
+
+    TEST_METHOD(TransformBatch_NonUniformScale_MatchesProduct) {
+      assertMatchesProduct(Syx::Mat4::transform(Syx::Vec3(1.0f, 3.0f, 0.5f), Syx::Quat::Identity, Syx::Vec3(2.0f, 0.0f, 1.0f)));
+    }
+
+    TEST_METHOD(TransformBatch_NonUniformScaleRotation_MatchesProduct) {
+      assertMatchesProduct(Syx::Mat4::transform(Syx::Vec3(1.0f, 3.0f, 0.5f), Syx::Quat::axisAngle(Syx::Vec3(0.0f, 1.0f, 1.0f).normalized(), 0.9f), Syx::Vec3(2.0f, 0.0f, 1.0f)));
+    }
+
+    TEST_METHOD(TransformBatch_Clear_DropsMatrices) {
+      const SyxToModel toModel(Syx::Mat4::transform(Syx::Vec3(1.0f, 3.0f, 0.5f), Syx::Quat::axisAngle(Syx::Vec3::UnitZ, 0.4f), Syx::Vec3::Zero));
+      TransformBatch batch;
+      toModel.push(batch, 1, Syx::Vec3::UnitX, Syx::Quat::Identity);
+      batch.clear();
+      batch.push(2, Syx::Vec3::UnitY, Syx::Quat::Identity, Syx::Vec3::Identity);
+
+      Assert::AreEqual(size_t(1), batch.size());
+      assertClose(Syx::Mat4::transform(Syx::Vec3::Identity, Syx::Quat::Identity, Syx::Vec3::UnitY).transposed(), batch.getTransform(0));
+    }
+  };
+}
@@ -0,0 +1,323 @@
+#include "Precompile.h"
+#include "CppUnitTest.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include "threading/FunctionTask.h"
+#include "threading/SyncTask.h"
+#include "threading/TaskGroup.h"
+#include "threading/TaskPool.h"
+#include "threading/WorkStealingDeque.h"
+#include "threading/WorkStealingPool.h"
+
+namespace WorkerPoolTest {
+  TEST_CLASS(WorkStealingDequeTest) {
+  public:
+    TEST_METHOD(WorkStealingDeque_Pop_IsLastPushed) {
+      WorkStealingDeque<int> deque;
+      deque.push(1);
+      deque.push(2);
+      int result = 0;
+      Assert::IsTrue(deque.pop(result));
+      Assert::AreEqual(2, result, L"Owner should take newest first", LINE_INFO());
+      Assert::IsTrue(deque.pop(result));
+      Assert::AreEqual(1, result, LINE_INFO());
+      Assert::IsFalse(deque.pop(result), L"Deque should be empty", LINE_INFO());
+      Assert::IsTrue(deque.empty());
+    }
+
+    TEST_METHOD(WorkStealingDeque_Steal_IsFirstPushed) {
+      WorkStealingDeque<int> deque;
+      deque.push(1);
+      deque.push(2);
+      int result = 0;
+      Assert::IsTrue(deque.steal(result));
+      Assert::AreEqual(1, result, L"Thieves should take oldest first", LINE_INFO());
+      Assert::IsTrue(deque.pop(result));
+      Assert::AreEqual(2, result, LINE_INFO());
+      Assert::IsFalse(deque.steal(result), L"Deque should be empty", LINE_INFO());
+    }
+
+    TEST_METHOD(WorkStealingDeque_PushPastCapacity_KeepsAllItems) {
+      WorkStealingDeque<int> deque(4);
+      for(int i = 0; i < 100; ++i)
+        deque.push(i);
+      int result = 0;
+      for(int i = 99; i >= 0; --i) {
+        Assert::IsTrue(deque.pop(result));
+        Assert::AreEqual(i, result, L"Items should survive growing", LINE_INFO());
+      }
+    }
+
+    TEST_METHOD(WorkStealingDeque_ConcurrentSteal_EachItemTakenOnce) {
+      const int count = 10000;
+      WorkStealingDeque<int> deque(16);
+      std::vector<std::atomic_int> taken(count);
+      std::atomic_bool done(false);
+      std::vector<std::thread> thieves;
+      for(int i = 0; i < 3; ++i) {
+        thieves.emplace_back([&deque, &taken, &done] {
+          int result = 0;
+          while(!done || !deque.empty()) {
+            if(deque.steal(result))
+              ++taken[result];
+          }
+        });
+      }
+
+      //Owner pushes while popping some so both ends are contended
+      int result = 0;
+      for(int i = 0; i < count; ++i) {
+        deque.push(i);
+        if(i % 3 == 0 && deque.pop(result))
+          ++taken[result];
+      }
+      while(deque.pop(result))
+        ++taken[result];
+      done = true;
+      for(std::thread& thief : thieves)
+        thief.join();
+
+      for(int i = 0; i < count; ++i)
+        Assert::AreEqual(1, taken[i].load(), L"Every item should be taken exactly once", LINE_INFO());
+    }
+  };
+
+  TEST_CLASS(WorkStealingPoolTest) {
+  public:
+    TEST_METHOD(WorkStealingPool_QueueMany_AllRun) {
+      WorkStealingPool pool(4);
+      std::atomic_int ran(0);
+      auto sync = std::make_shared<SyncTask>();
+      std::vector<std::shared_ptr<Task>> tasks;
+      //All dependencies are added before queueing so sync can't become ready when only some have finished
+      for(int i = 0; i < 1000; ++i) {
+        tasks.push_back(std::make_shared<FunctionTask>([&ran] { ++ran; }));
+        tasks.back()->then(sync);
+      }
+      for(std::shared_ptr<Task>& task : tasks)
+        pool.queueTask(task);
+      pool.queueTask(sync);
+      sync->sync();
+      Assert::AreEqual(1000, ran.load(), L"All tasks should have run before sync task", LINE_INFO());
+    }
+
+    TEST_METHOD(WorkStealingPool_Chain_RunsInOrder) {
+      WorkStealingPool pool(4);
+      std::vector<int> order;
+      std::mutex orderMutex;
+      auto record = [&order, &orderMutex](int i) {
+        return std::make_shared<FunctionTask>([&order, &orderMutex, i] {
+          std::lock_guard<std::mutex> lock(orderMutex);
+          order.push_back(i);
+        });
+      };
+      std::shared_ptr<Task> tasks[] = { record(0), record(1), record(2) };
+      auto sync = std::make_shared<SyncTask>();
+      tasks[0]->then(tasks[1])->then(tasks[2])->then(sync);
+      //Queue in reverse so nothing runs early just by being queued first
+      pool.queueTask(sync);
+      for(int i = 2; i >= 0; --i)
+        pool.queueTask(tasks[i]);
+      sync->sync();
+      Assert::IsTrue(order == std::vector<int>{ 0, 1, 2 }, L"Dependents should run after their dependencies", LINE_INFO());
+    }
+
+    TEST_METHOD(WorkStealingPool_QueueFromTask_Runs) {
+      WorkStealingPool pool(2);
+      std::atomic_int ran(0);
+      auto sync = std::make_shared<SyncTask>();
+      //Children are queued from a worker, so they go on its own deque and the other worker can only get them by stealing
+      auto parent = std::make_shared<FunctionTask>([&pool, &ran, sync] {
+        for(int i = 0; i < 100; ++i) {
+          auto child = std::make_shared<FunctionTask>([&ran] { ++ran; });
+          child->then(sync);
+          pool.queueTask(child);
+        }
+      });
+      parent->then(sync);
+      pool.queueTask(parent);
+      pool.queueTask(sync);
+      sync->sync();
+      Assert::AreEqual(100, ran.load(), L"Tasks queued from other tasks should run", LINE_INFO());
+    }
+
+    TEST_METHOD(WorkStealingPool_DefaultWorkerCount_NotZero) {
+      Assert::IsTrue(WorkStealingPool::getDefaultWorkerCount() > 0, LINE_INFO());
+    }
+
+    TEST_METHOD(WorkStealingPool_ManyDependents_AllReady) {
+      WorkStealingPool pool(2);
+      std::atomic_int ran(0);
+      auto first = std::make_shared<FunctionTask>([] {});
+      auto sync = std::make_shared<SyncTask>();
+      //More than fit inline so some go in the overflow
+      std::vector<std::shared_ptr<Task>> dependents;
+      for(int i = 0; i < 10; ++i) {
+        dependents.push_back(std::make_shared<FunctionTask>([&ran] { ++ran; }));
+        first->then(dependents.back())->then(sync);
+      }
+      pool.queueTask(sync);
+      for(std::shared_ptr<Task>& task : dependents)
+        pool.queueTask(task);
+      pool.queueTask(first);
+      sync->sync();
+      Assert::AreEqual(10, ran.load(), L"All dependents should run once their dependency is done", LINE_INFO());
+    }
+
+    TEST_METHOD(WorkStealingPool_QueueWhileDependencyFinishes_TaskReleased) {
+      WorkStealingPool pool(2);
+      std::atomic_int ran(0);
+      for(int i = 0; i < 2000; ++i) {
+        auto dependency = std::make_shared<FunctionTask>([] {});
+        auto task = std::make_shared<FunctionTask>([&ran] { ++ran; });
+        dependency->then(task);
+        std::weak_ptr<Task> weakTask = task;
+        //The dependency can finish on a worker while task is being queued here, so both hand task to the pool at once
+        pool.queueTask(dependency);
+        pool.queueTask(task);
+        dependency = task = nullptr;
+
+        for(int spin = 0; !weakTask.expired() && spin < 1000000; ++spin)
+          std::this_thread::yield();
+        Assert::IsTrue(weakTask.expired(), L"Task should drop its reference to itself once it has run", LINE_INFO());
+      }
+      Assert::AreEqual(2000, ran.load(), L"Every task should run once", LINE_INFO());
+    }
+  };
+
+  TEST_CLASS(TaskGroupTest) {
+  public:
+    TEST_METHOD(TaskPool_ReleasedTask_MemoryReused) {
+      TaskPool pool;
+      std::shared_ptr<FunctionTask> task = pool.create<FunctionTask>([] {});
+      const void* first = task.get();
+      task = nullptr;
+      task = pool.create<FunctionTask>([] {});
+      Assert::IsTrue(first == task.get(), L"Released task memory should be reused", LINE_INFO());
+    }
+
+    TEST_METHOD(TaskPool_TaskOutlivesPool_StillValid) {
+      std::shared_ptr<FunctionTask> task;
+      {
+        TaskPool pool;
+        task = pool.create<FunctionTask>([] {});
+      }
+      //Storage is kept alive by the task so releasing it now is safe
+      task = nullptr;
+    }
+
+    TEST_METHOD(TaskGroup_Run_AllDoneAfterWait) {
+      WorkStealingPool pool(4);
+      std::atomic_int ran(0);
+      TaskGroup group(pool);
+      for(int i = 0; i < 1000; ++i)
+        group.run([&ran] { ++ran; });
+      group.wait();
+      Assert::AreEqual(1000, ran.load(), LINE_INFO());
+    }
+
+    TEST_METHOD(TaskGroup_RunFromTask_WaitIncludesNestedWork) {
+      WorkStealingPool pool(2);
+      std::atomic_int ran(0);
+      TaskGroup group(pool);
+      for(int i = 0; i < 10; ++i) {
+        group.run([&group, &ran] {
+          for(int j = 0; j < 10; ++j)
+            group.run([&ran] { ++ran; });
+        });
+      }
+      group.wait();
+      Assert::AreEqual(100, ran.load(), L"Work added from other work in the group should be waited on", LINE_INFO());
+    }
+
+    TEST_METHOD(TaskGroup_WaitInTaskWithOneWorker_Helps) {
+      //The only worker waits on a group inside a task, which would deadlock if waiting didn't run the group's work itself
+      WorkStealingPool pool(1);
+      std::atomic_int ran(0);
+      auto sync = std::make_shared<SyncTask>();
+      auto outer = std::make_shared<FunctionTask>([&pool, &ran] {
+        TaskGroup inner(pool);
+        for(int i = 0; i < 10; ++i)
+          inner.run([&ran] { ++ran; });
+        inner.wait();
+      });
+      outer->then(sync);
+      pool.queueTask(sync);
+      pool.queueTask(outer);
+      sync->sync();
+      Assert::AreEqual(10, ran.load(), LINE_INFO());
+    }
+
+    TEST_METHOD(ParallelFor_Range_EachIndexOnce) {
+      WorkStealingPool pool(4);
+      const size_t count = 10000;
+      std::vector<std::atomic_int> visits(count);
+      parallelFor(pool, 0, count, 64, [&visits](size_t i) {
+        ++visits[i];
+      });
+      for(size_t i = 0; i < count; ++i)
+        Assert::AreEqual(1, visits[i].load(), L"Every index should be visited exactly once", LINE_INFO());
+    }
+
+    TEST_METHOD(ParallelFor_EmptyRange_NoCalls) {
+      WorkStealingPool pool(2);
+      std::atomic_int calls(0);
+      parallelFor(pool, 5, 5, 1, [&calls](size_t) { ++calls; });
+      Assert::AreEqual(0, calls.load(), LINE_INFO());
+    }
+  };
+
+  //Not a correctness test, prints the cost of making, running and finishing small tasks each way to the test output
+  TEST_CLASS(TaskBenchmark) {
+  public:
+    typedef std::chrono::steady_clock Clock;
+
+    static const int COUNT = 100000;
+
+    static void report(const char* name, Clock::time_point start) {
+      const double ns = std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+      char buffer[128];
+      std::snprintf(buffer, sizeof(buffer), "%-32s %8.1f ns per task\n", name, ns/static_cast<double>(COUNT));
+      Logger::WriteMessage(buffer);
+    }
+
+    TEST_METHOD(TaskBenchmark_SpawnAndComplete) {
+      WorkStealingPool pool(WorkStealingPool::getDefaultWorkerCount());
+      std::atomic_int ran(0);
+
+      Clock::time_point start = Clock::now();
+      {
+        auto sync = std::make_shared<SyncTask>();
+        std::vector<std::shared_ptr<Task>> tasks;
+        tasks.reserve(COUNT);
+        for(int i = 0; i < COUNT; ++i) {
+          tasks.push_back(std::make_shared<FunctionTask>([&ran] { ++ran; }));
+          tasks.back()->then(sync);
+        }
+        for(std::shared_ptr<Task>& task : tasks)
+          pool.queueTask(task);
+        pool.queueTask(sync);
+        sync->sync();
+      }
+      report("FunctionTask and SyncTask", start);
+
+      start = Clock::now();
+      {
+        TaskGroup group(pool);
+        for(int i = 0; i < COUNT; ++i)
+          group.run([&ran] { ++ran; });
+      }
+      report("TaskGroup", start);
+
+      start = Clock::now();
+      parallelFor(pool, 0, COUNT, 1, [&ran](size_t) { ++ran; });
+      report("parallelFor grain 1", start);
+
+      Assert::AreEqual(3*COUNT, ran.load(), LINE_INFO());
+    }
+  };
+}
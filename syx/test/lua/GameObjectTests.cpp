@@ -17,6 +17,7 @@ using namespace Microsoft::VisualStudio::CppUnitTestFramework;
 #include "event/BaseComponentEvents.h"
 #include "event/SpaceEvents.h"
 #include "event/EventBuffer.h"
+#include "event/TransformEvent.h"
 #include "LuaGameObject.h"
 #include "lua/LuaVariant.h"
 
@@ -302,5 +303,34 @@ namespace LuaTests {
       Assert::IsNotNull(obj, L"Gameobject should exist", LINE_INFO());
       Assert::IsTrue(obj && obj->getComponent<Transform>()->get().getTranslate() == Syx::Vec3(0, 5, 0), L"Translate should have been updated by script", LINE_INFO());
     }
+
+    std::shared_ptr<TransformBatch> _sendTransformBatch(App& app, Handle obj, const Syx::Vec3& pos, uint64_t layout) {
+      auto batch = std::make_shared<TransformBatch>();
+      batch->push(obj, pos, Syx::Quat::Identity, Syx::Vec3::Identity);
+      batch->mLayout = layout;
+      app.getMessageQueue().get().push(TransformBatchEvent(batch));
+      return batch;
+    }
+
+    TEST_METHOD(GameObject_ReplacedBetweenSameLayoutBatches_NewObjectUpdated) {
+      MockApp app;
+      const Handle objHandle = app.get().getSystem<LuaGameSystem>()->addGameObject().getHandle();
+      app.get().update(1.0f);
+      const uint64_t layout = TransformBatch::newLayoutId();
+      auto batch = _sendTransformBatch(app.get(), objHandle, Syx::Vec3(1, 0, 0), layout);
+      app.get().update(1.0f);
+      const LuaGameObject* obj = app.get().getSystem<LuaGameSystem>()->getObject(objHandle);
+      Assert::IsTrue(obj && obj->getComponent<Transform>()->get() == batch->getTransform(0), L"Batch should have moved the object", LINE_INFO());
+
+      //The sender doesn't know about the receiver's objects, so it can keep using the same layout after they're replaced
+      app.get().getMessageQueue().get().push(RemoveGameObjectEvent(objHandle));
+      app.get().getMessageQueue().get().push(AddGameObjectEvent(objHandle));
+      app.get().update(1.0f);
+      batch = _sendTransformBatch(app.get(), objHandle, Syx::Vec3(2, 0, 0), layout);
+      app.get().update(1.0f);
+
+      obj = app.get().getSystem<LuaGameSystem>()->getObject(objHandle);
+      Assert::IsTrue(obj && obj->getComponent<Transform>()->get() == batch->getTransform(0), L"Object should have been looked up again after it was replaced", LINE_INFO());
+    }
   };
 }
\ No newline at end of file
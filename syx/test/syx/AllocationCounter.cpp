@@ -0,0 +1,79 @@
+#include "Precompile.h"
+#include "AllocationCounter.h"
+
+#ifdef SYX_COUNT_ALLOCATIONS
+namespace {
+  //Per thread so allocations from threads a test isn't measuring, like the test runner's, don't show up in its count
+  thread_local size_t sAllocations = 0;
+}
+
+void* operator new(size_t size) {
+  ++sAllocations;
+  if(void* result = std::malloc(size ? size : 1))
+    return result;
+  throw std::bad_alloc();
+}
+
+void* operator new[](size_t size) {
+  return operator new(size);
+}
+
+void operator delete(void* p) noexcept {
+  std::free(p);
+}
+
+void operator delete[](void* p) noexcept {
+  std::free(p);
+}
+
+//Used by AlignmentAllocator and Interface::allocAligned
+void* operator new(size_t size, std::align_val_t alignment) {
+  ++sAllocations;
+  if(void* result = _aligned_malloc(size ? size : 1, static_cast<size_t>(alignment)))
+    return result;
+  throw std::bad_alloc();
+}
+
+void* operator new[](size_t size, std::align_val_t alignment) {
+  return operator new(size, alignment);
+}
+
+void operator delete(void* p, std::align_val_t) noexcept {
+  _aligned_free(p);
+}
+
+void operator delete[](void* p, std::align_val_t) noexcept {
+  _aligned_free(p);
+}
+
+namespace SyxTest {
+  namespace AllocationCounter {
+    bool isEnabled() {
+      return true;
+    }
+
+    size_t get() {
+      return sAllocations;
+    }
+
+    void reset() {
+      sAllocations = 0;
+    }
+  }
+}
+#else
+namespace SyxTest {
+  namespace AllocationCounter {
+    bool isEnabled() {
+      return false;
+    }
+
+    size_t get() {
+      return 0;
+    }
+
+    void reset() {
+    }
+  }
+}
+#endif
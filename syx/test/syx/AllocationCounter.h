@@ -0,0 +1,13 @@
+#pragma once
+
+namespace SyxTest {
+  //Counts heap allocations so tests can check that steps don't allocate once a scene has settled
+  //Only counts if the test project defines SYX_COUNT_ALLOCATIONS, which replaces the global operator new for the whole test binary
+  namespace AllocationCounter {
+    //False if SYX_COUNT_ALLOCATIONS isn't defined, in which case the count is always zero
+    bool isEnabled();
+    //Allocations made by the calling thread through any form of operator new since its last reset
+    size_t get();
+    void reset();
+  }
+}
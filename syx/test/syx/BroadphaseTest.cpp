@@ -5,6 +5,9 @@ using namespace Microsoft::VisualStudio::CppUnitTestFramework;
 //TODO: solve includes for syx so this careful order isn't necessary
 #include "../syx/Precompile.h"
 #include "SyxAABBTree.h"
+#include "SyxSweepAndPrune.h"
+#include "SyxQuantizedBVH.h"
+#include "SyxTransform.h"
 
 namespace Syx {
   bool operator==(const ResultNode& lhs, const ResultNode& rhs) {
@@ -40,72 +43,254 @@ namespace SyxTest {
       Assert::IsTrue(expectedPairs == pair->get(), L"Pair query should match", LINE_INFO());
       Assert::IsTrue(expectedHits == raycast->get(), L"Raycast query should match", LINE_INFO());
       Assert::IsTrue(expectedHits == volume->get(), L"Volume query should match", LINE_INFO());
+
+      //Same cast in a packet next to one that misses everything
+      const Syx::Vec3 missOffset(1000.0f);
+      const Syx::Vec3 starts[] = { queryVolume.mAABB.getCenter() + queryVolume.mAABB.getDiagonal(), queryVolume.mAABB.getCenter() + missOffset };
+      const Syx::Vec3 ends[] = { queryVolume.mAABB.getCenter(), queryVolume.mAABB.getCenter() + missOffset*2.0f };
+      raycast->queryRaycastPacket(starts, ends, 2);
+      Assert::IsTrue(expectedHits == raycast->getPacket(0), L"Packet raycast should match", LINE_INFO());
+      Assert::IsTrue(raycast->getPacket(1).empty(), L"Packet raycast that misses should be empty", LINE_INFO());
+    }
+
+    //Runs the test against every broadphase type, since they should all give the same results
+    void _forEachBroadphase(const std::function<void(Syx::Broadphase&)>& test) {
+      std::unique_ptr<Syx::Broadphase> broadphases[] = { Syx::Create::aabbTree(), Syx::Create::sweepAndPrune() };
+      for(std::unique_ptr<Syx::Broadphase>& broadphase : broadphases)
+        test(*broadphase);
     }
 
     TEST_METHOD(Broadphase_AddOne_ShowsInQueries) {
-      auto broadphase = Syx::Create::aabbTree();
-      Syx::BoundingVolume volume(Syx::AABB(Syx::Vec3(0.0f), Syx::Vec3(1.0f)));
-      Syx::Handle handle = broadphase->insert(volume, nullptr);
-      std::vector<Syx::ResultNode> expectedHits;
-      expectedHits.push_back({ handle, nullptr });
-      _assertQueryResults(*broadphase, volume, expectedHits, {});
+      _forEachBroadphase([this](Syx::Broadphase& broadphase) {
+        Syx::BoundingVolume volume(Syx::AABB(Syx::Vec3(0.0f), Syx::Vec3(1.0f)));
+        Syx::Handle handle = broadphase.insert(volume, nullptr);
+        std::vector<Syx::ResultNode> expectedHits;
+        expectedHits.push_back({ handle, nullptr });
+        _assertQueryResults(broadphase, volume, expectedHits, {});
+      });
     }
 
     TEST_METHOD(Broadphase_AddRemoveOne_IsEmpty) {
-      auto broadphase = Syx::Create::aabbTree();
-      Syx::BoundingVolume volume(Syx::AABB(Syx::Vec3(0.0f), Syx::Vec3(1.0f)));
-      Syx::Handle handle = broadphase->insert(volume, nullptr);
-      broadphase->remove(handle);
-      //Results should be empty
-      _assertQueryResults(*broadphase, volume, {}, {});
+      _forEachBroadphase([this](Syx::Broadphase& broadphase) {
+        Syx::BoundingVolume volume(Syx::AABB(Syx::Vec3(0.0f), Syx::Vec3(1.0f)));
+        Syx::Handle handle = broadphase.insert(volume, nullptr);
+        broadphase.remove(handle);
+        //Results should be empty
+        _assertQueryResults(broadphase, volume, {}, {});
+      });
     }
 
     TEST_METHOD(Brodphase_AddOneClear_IsEmpty) {
-      auto broadphase = Syx::Create::aabbTree();
-      const Syx::BoundingVolume volume(Syx::AABB(Syx::Vec3(0.0f), Syx::Vec3(1.0f)));
-      broadphase->insert(volume, nullptr);
-      broadphase->clear();
-      //Results should be empty
-      _assertQueryResults(*broadphase, volume, {}, {});
+      _forEachBroadphase([this](Syx::Broadphase& broadphase) {
+        const Syx::BoundingVolume volume(Syx::AABB(Syx::Vec3(0.0f), Syx::Vec3(1.0f)));
+        broadphase.insert(volume, nullptr);
+        broadphase.clear();
+        //Results should be empty
+        _assertQueryResults(broadphase, volume, {}, {});
+      });
     }
 
     TEST_METHOD(Broadphase_AddPair_ShowsInQuery) {
-      auto broadphase = Syx::Create::aabbTree();
-      const Syx::BoundingVolume volume(Syx::AABB(Syx::Vec3(0.0f), Syx::Vec3(1.0f)));
-      const Syx::Handle a = broadphase->insert(volume, nullptr);
-      const Syx::Handle b = broadphase->insert(volume, nullptr);
+      _forEachBroadphase([this](Syx::Broadphase& broadphase) {
+        const Syx::BoundingVolume volume(Syx::AABB(Syx::Vec3(0.0f), Syx::Vec3(1.0f)));
+        const Syx::Handle a = broadphase.insert(volume, nullptr);
+        const Syx::Handle b = broadphase.insert(volume, nullptr);
 
-      auto context = broadphase->createPairContext();
-      context->queryPairs();
-      Assert::IsTrue(_equals(context->get(), { { a, b } }), L"Added pair should show up in query");
+        auto context = broadphase.createPairContext();
+        context->queryPairs();
+        Assert::IsTrue(_equals(context->get(), { { a, b } }), L"Added pair should show up in query");
+      });
     }
 
     TEST_METHOD(Broadphase_DistantPairs_LocalPairShowsInQuery) {
-      auto broadphase = Syx::Create::aabbTree();
-      const Syx::BoundingVolume volumeA(Syx::AABB(Syx::Vec3(0.0f), Syx::Vec3(1.0f)));
-      auto pairA = std::make_pair(broadphase->insert(volumeA, nullptr), broadphase->insert(volumeA, nullptr));
-      const Syx::BoundingVolume volumeB(Syx::AABB(Syx::Vec3(1000.0f), Syx::Vec3(1001.0f)));
-      auto pairB = std::make_pair(broadphase->insert(volumeB, nullptr), broadphase->insert(volumeB, nullptr));
-      auto context = broadphase->createPairContext();
+      _forEachBroadphase([this](Syx::Broadphase& broadphase) {
+        const Syx::BoundingVolume volumeA(Syx::AABB(Syx::Vec3(0.0f), Syx::Vec3(1.0f)));
+        auto pairA = std::make_pair(broadphase.insert(volumeA, nullptr), broadphase.insert(volumeA, nullptr));
+        const Syx::BoundingVolume volumeB(Syx::AABB(Syx::Vec3(1000.0f), Syx::Vec3(1001.0f)));
+        auto pairB = std::make_pair(broadphase.insert(volumeB, nullptr), broadphase.insert(volumeB, nullptr));
+        auto context = broadphase.createPairContext();
 
-      context->queryPairs();
-      Assert::IsTrue(context->get().size() == 2, L"There should only be two pairs since they are both far away from each other");
-      Assert::IsTrue(_equals(context->get(), { pairA, pairB }), L"Pairs should match based volumes");
+        context->queryPairs();
+        Assert::IsTrue(context->get().size() == 2, L"There should only be two pairs since they are both far away from each other");
+        Assert::IsTrue(_equals(context->get(), { pairA, pairB }), L"Pairs should match based volumes");
+      });
     }
 
     TEST_METHOD(Broadphase_MoveFromOneAreaToOther_ResultsInNewArea) {
-      auto broadphase = Syx::Create::aabbTree();
-      const Syx::BoundingVolume volumeA(Syx::AABB(Syx::Vec3(0.0f), Syx::Vec3(1.0f)));
-      auto pairA = std::make_pair(broadphase->insert(volumeA, nullptr), broadphase->insert(volumeA, nullptr));
-      const Syx::BoundingVolume volumeB(Syx::AABB(Syx::Vec3(1000.0f), Syx::Vec3(1001.0f)));
-      auto pairB = std::make_pair(broadphase->insert(volumeB, nullptr), broadphase->insert(volumeB, nullptr));
-      auto context = broadphase->createPairContext();
-
-      const Syx::Handle toMove = pairB.first;
-      const Syx::Handle moved = broadphase->update(volumeA, toMove);
-
-      context->queryPairs();
-      Assert::IsTrue(_equals(context->get(), { pairA, { pairA.first, moved }, { pairA.second, moved } }), L"Moved item should show up in query at destination");
+      _forEachBroadphase([this](Syx::Broadphase& broadphase) {
+        const Syx::BoundingVolume volumeA(Syx::AABB(Syx::Vec3(0.0f), Syx::Vec3(1.0f)));
+        auto pairA = std::make_pair(broadphase.insert(volumeA, nullptr), broadphase.insert(volumeA, nullptr));
+        const Syx::BoundingVolume volumeB(Syx::AABB(Syx::Vec3(1000.0f), Syx::Vec3(1001.0f)));
+        auto pairB = std::make_pair(broadphase.insert(volumeB, nullptr), broadphase.insert(volumeB, nullptr));
+        auto context = broadphase.createPairContext();
+
+        const Syx::Handle toMove = pairB.first;
+        const Syx::Handle moved = broadphase.update(volumeA, toMove);
+
+        context->queryPairs();
+        Assert::IsTrue(_equals(context->get(), { pairA, { pairA.first, moved }, { pairA.second, moved } }), L"Moved item should show up in query at destination");
+      });
+    }
+
+    TEST_METHOD(Broadphase_QueryWithoutMoving_NoPairChanges) {
+      _forEachBroadphase([this](Syx::Broadphase& broadphase) {
+        const Syx::BoundingVolume volume(Syx::AABB(Syx::Vec3(0.0f), Syx::Vec3(1.0f)));
+        const Syx::Handle a = broadphase.insert(volume, nullptr);
+        const Syx::Handle b = broadphase.insert(volume, nullptr);
+        auto context = broadphase.createPairContext();
+
+        context->queryPairs();
+        Assert::IsTrue(_equals(context->getAdded(), { { a, b } }), L"New pair should be reported as added");
+        context->queryPairs();
+        Assert::IsTrue(_equals(context->get(), { { a, b } }), L"Pair should persist between queries");
+        Assert::IsTrue(context->getAdded().empty() && context->getRemoved().empty(), L"Nothing moved so no pairs should change");
+      });
+    }
+
+    TEST_METHOD(Broadphase_MoveApart_PairReportedAsRemoved) {
+      _forEachBroadphase([this](Syx::Broadphase& broadphase) {
+        const Syx::BoundingVolume volumeA(Syx::AABB(Syx::Vec3(0.0f), Syx::Vec3(1.0f)));
+        const Syx::BoundingVolume volumeB(Syx::AABB(Syx::Vec3(1000.0f), Syx::Vec3(1001.0f)));
+        const Syx::Handle a = broadphase.insert(volumeA, nullptr);
+        const Syx::Handle b = broadphase.insert(volumeA, nullptr);
+        auto context = broadphase.createPairContext();
+        context->queryPairs();
+
+        Assert::IsTrue(broadphase.update(volumeB, b) == b, L"Handle should be stable when moving");
+        context->queryPairs();
+        Assert::IsTrue(context->get().empty(), L"Pair should be gone after moving apart");
+        Assert::IsTrue(_equals(context->getRemoved(), { { a, b } }), L"Pair should be reported as removed");
+        Assert::IsTrue(context->getAdded().empty(), L"No pairs should be added");
+      });
+    }
+
+    //Whether a volume query hits the stored leaf, which is larger than the object by the tree's margin and displacement
+    bool _leafTouches(const Syx::Broadphase& broadphase, const Syx::AABB& region) const {
+      auto context = broadphase.createHitContext();
+      context->queryVolume(Syx::BoundingVolume(region));
+      return !context->get().empty();
+    }
+
+    TEST_METHOD(AABBTree_MoveInsideFatBounds_NotReinserted) {
+      const Syx::AABBTreeConfig config(0.1f, 2.0f);
+      auto tree = Syx::Create::aabbTree(config);
+      const Syx::Handle handle = tree->insert(Syx::BoundingVolume(Syx::AABB(Syx::Vec3(0.0f), Syx::Vec3(1.0f))), nullptr);
+      //Inside the margin below the original box, but outside the margin of the moved one
+      const Syx::AABB belowOriginal(Syx::Vec3(-0.09f), Syx::Vec3(-0.08f));
+      Assert::IsTrue(_leafTouches(*tree, belowOriginal), L"Leaf should be enlarged by the margin", LINE_INFO());
+
+      Assert::IsTrue(tree->update(Syx::BoundingVolume(Syx::AABB(Syx::Vec3(0.05f), Syx::Vec3(1.05f))), handle) == handle, L"Handle should be stable when moving", LINE_INFO());
+
+      Assert::IsTrue(_leafTouches(*tree, belowOriginal), L"Leaf should keep its old bounds while the object stays inside them", LINE_INFO());
+    }
+
+    TEST_METHOD(AABBTree_MoveOutsideFatBounds_Reinserted) {
+      const Syx::AABBTreeConfig config(0.1f, 2.0f);
+      auto tree = Syx::Create::aabbTree(config);
+      const Syx::Handle handle = tree->insert(Syx::BoundingVolume(Syx::AABB(Syx::Vec3(0.0f), Syx::Vec3(1.0f))), nullptr);
+
+      tree->update(Syx::BoundingVolume(Syx::AABB(Syx::Vec3(0.5f), Syx::Vec3(1.5f))), handle);
+
+      Assert::IsFalse(_leafTouches(*tree, Syx::AABB(Syx::Vec3(-0.09f), Syx::Vec3(-0.08f))), L"Leaf should have moved with the object", LINE_INFO());
+      Assert::IsTrue(_leafTouches(*tree, Syx::AABB(Syx::Vec3(1.55f), Syx::Vec3(1.58f))), L"Leaf should be enlarged around the new position", LINE_INFO());
+    }
+
+    TEST_METHOD(AABBTree_SlowDownAfterFastMove_FatBoundsShrink) {
+      const Syx::AABBTreeConfig config(0.1f, 2.0f);
+      auto tree = Syx::Create::aabbTree(config);
+      const Syx::AABB box(Syx::Vec3(0.0f), Syx::Vec3(1.0f));
+      //Fast enough that the leaf is stretched far ahead of the object
+      const Syx::Handle handle = tree->insert(Syx::BoundingVolume(box, Syx::Vec3(10.0f, 0.0f, 0.0f)), nullptr);
+      const Syx::AABB ahead(Syx::Vec3(15.0f, 0.5f, 0.5f), Syx::Vec3(16.0f, 0.6f, 0.6f));
+      Assert::IsTrue(_leafTouches(*tree, ahead), L"Leaf should be stretched along the displacement", LINE_INFO());
+
+      //Stopped without leaving the stretched leaf
+      tree->update(Syx::BoundingVolume(box), handle);
+
+      Assert::IsFalse(_leafTouches(*tree, ahead), L"Leaf far bigger than the object should be shrunk", LINE_INFO());
+      Assert::IsTrue(_leafTouches(*tree, Syx::AABB(Syx::Vec3(1.05f), Syx::Vec3(1.08f))), L"Shrunk leaf should still have the margin", LINE_INFO());
+    }
+
+    TEST_METHOD(AABBTree_QueryTree_MatchesBruteForce) {
+      //No margin so leaves match the boxes exactly, like the trees models use
+      const Syx::AABBTreeConfig exact(0.0f, 0.0f);
+      auto treeA = Syx::Create::aabbTree(exact);
+      auto treeB = Syx::Create::aabbTree(exact);
+      std::vector<Syx::AABB> boxesA, boxesB;
+      //Grid of unit boxes spaced out a bit so only some overlap once B is moved and rotated
+      for(int x = 0; x < 6; ++x) {
+        for(int z = 0; z < 6; ++z) {
+          const Syx::Vec3 min(x*1.5f, 0.0f, z*1.5f);
+          boxesA.push_back(Syx::AABB(min, min + Syx::Vec3(1.0f)));
+          boxesB.push_back(Syx::AABB(min, min + Syx::Vec3(1.0f)));
+        }
+      }
+      for(size_t i = 0; i < boxesA.size(); ++i) {
+        treeA->insert(Syx::BoundingVolume(boxesA[i]), reinterpret_cast<void*>(i));
+        treeB->insert(Syx::BoundingVolume(boxesB[i]), reinterpret_cast<void*>(i));
+      }
+      const Syx::Transformer bToA(Syx::Mat3::yRot(0.3f), Syx::Vec3(2.0f, 0.5f, 1.0f));
+
+      auto context = treeA->createHitContext();
+      context->queryTree(*treeB, bToA);
+
+      std::vector<std::pair<size_t, size_t>> expected, actual;
+      for(size_t a = 0; a < boxesA.size(); ++a)
+        for(size_t b = 0; b < boxesB.size(); ++b)
+          if(boxesA[a].overlapping(boxesB[b].transform(bToA)))
+            expected.push_back({ a, b });
+      for(const auto& pair : context->getTreePairs())
+        actual.push_back({ reinterpret_cast<size_t>(pair.first.mUserdata), reinterpret_cast<size_t>(pair.second.mUserdata) });
+      std::sort(actual.begin(), actual.end());
+
+      Assert::IsFalse(expected.empty(), L"Test should have some overlaps to find", LINE_INFO());
+      Assert::IsTrue(expected == actual, L"Tree query should find the same pairs as testing every pair", LINE_INFO());
+    }
+
+    TEST_METHOD(QuantizedBVH_Queries_MatchBruteForce) {
+      auto bvh = Syx::Create::quantizedBVH();
+      std::vector<Syx::AABB> boxes;
+      std::vector<Syx::InsertParam> params;
+      for(int x = 0; x < 10; ++x) {
+        for(int z = 0; z < 10; ++z) {
+          const Syx::Vec3 min(x*1.5f, 0.0f, z*1.5f);
+          boxes.push_back(Syx::AABB(min, min + Syx::Vec3(1.0f)));
+          params.push_back(Syx::InsertParam(Syx::BoundingVolume(boxes.back()), reinterpret_cast<void*>(boxes.size() - 1)));
+        }
+      }
+      bvh->buildStatic(params);
+      auto context = bvh->createHitContext();
+
+      auto toIndices = [](const std::vector<Syx::ResultNode>& results) {
+        std::vector<size_t> indices;
+        for(const Syx::ResultNode& node : results)
+          indices.push_back(reinterpret_cast<size_t>(node.mUserdata));
+        std::sort(indices.begin(), indices.end());
+        return indices;
+      };
+
+      //Query edges are between boxes so rounding the quantized bounds outwards can't pick up extra ones
+      const Syx::AABB query(Syx::Vec3(2.75f, 0.5f, 4.25f), Syx::Vec3(7.25f, 2.0f, 8.75f));
+      std::vector<size_t> expected;
+      for(size_t i = 0; i < boxes.size(); ++i)
+        if(boxes[i].overlapping(query))
+          expected.push_back(i);
+      context->queryVolume(Syx::BoundingVolume(query));
+      Assert::IsFalse(expected.empty(), L"Test should have some overlaps to find", LINE_INFO());
+      Assert::IsTrue(expected == toIndices(context->get()), L"Volume query should match testing every box", LINE_INFO());
+
+      const Syx::Vec3 start(-1.0f, 0.5f, 0.5f);
+      const Syx::Vec3 end(20.0f, 0.5f, 0.5f);
+      expected.clear();
+      for(size_t i = 0; i < boxes.size(); ++i)
+        if(boxes[i].lineIntersect(start, end))
+          expected.push_back(i);
+      context->queryRaycast(start, end);
+      Assert::IsFalse(expected.empty(), L"Test should have some hits to find", LINE_INFO());
+      Assert::IsTrue(expected == toIndices(context->get()), L"Raycast should match testing every box", LINE_INFO());
+
+      context->queryVolume(Syx::BoundingVolume(Syx::AABB(Syx::Vec3(100.0f), Syx::Vec3(101.0f))));
+      Assert::IsTrue(context->get().empty(), L"Volume outside of the hierarchy should hit nothing", LINE_INFO());
     }
   };
 }
\ No newline at end of file
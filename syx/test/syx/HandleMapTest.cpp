@@ -0,0 +1,62 @@
+#include "Precompile.h"
+#include "CppUnitTest.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+#include "../syx/Precompile.h"
+
+namespace SyxTest {
+  struct TestValue {
+    Syx::IntrusiveNode<TestValue> mIntrusiveNode;
+    TestValue(Syx::Handle handle = SyxInvalidHandle)
+      : mHandle(handle) {
+    }
+    Syx::Handle mHandle;
+  };
+
+  TEST_CLASS(HandleMapTest) {
+  public:
+    TEST_METHOD(SlotHandleMap_Add_GetFindsValue) {
+      Syx::SlotHandleMap<TestValue> map;
+      TestValue* a = map.add();
+      TestValue* b = map.add();
+
+      Assert::IsTrue(a->mHandle != b->mHandle);
+      Assert::IsTrue(map.get(a->mHandle) == a);
+      Assert::IsTrue(map.get(b->mHandle) == b);
+      Assert::AreEqual(size_t(2), map.size());
+    }
+
+    TEST_METHOD(SlotHandleMap_Remove_GetReturnsNull) {
+      Syx::SlotHandleMap<TestValue> map;
+      Syx::Handle handle = map.add()->mHandle;
+
+      map.remove(handle);
+
+      Assert::IsNull(map.get(handle));
+      Assert::AreEqual(size_t(0), map.size());
+    }
+
+    TEST_METHOD(SlotHandleMap_RemoveAndReuseSlot_StaleHandleNotFound) {
+      Syx::SlotHandleMap<TestValue> map;
+      Syx::Handle stale = map.add()->mHandle;
+      map.remove(stale);
+
+      TestValue* reused = map.add();
+
+      Assert::AreEqual(Syx::SlotHandle::getSlot(stale), Syx::SlotHandle::getSlot(reused->mHandle));
+      Assert::IsNull(map.get(stale));
+      Assert::IsTrue(map.get(reused->mHandle) == reused);
+      //Removing through the stale handle shouldn't remove the new value
+      map.remove(stale);
+      Assert::IsTrue(map.get(reused->mHandle) == reused);
+    }
+
+    TEST_METHOD(SlotHandleMap_GetUnknownHandle_ReturnsNull) {
+      Syx::SlotHandleMap<TestValue> map;
+      map.add();
+
+      Assert::IsNull(map.get(SyxInvalidHandle));
+      Assert::IsNull(map.get(Syx::SlotHandle::make(5, 0)));
+    }
+  };
+}
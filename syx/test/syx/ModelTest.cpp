@@ -0,0 +1,101 @@
+#include "Precompile.h"
+#include "CppUnitTest.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+#include "../syx/Precompile.h"
+#include "SyxModel.h"
+#include "SyxModelParam.h"
+
+namespace SyxTest {
+  TEST_CLASS(ModelTest) {
+  public:
+    //Closed prism around the y axis with a ring of points on each end and a center point on each cap
+    //If splitFaces, every triangle gets its own copies of its vertices like a mesh with per face normals would
+    static Syx::ModelParam _createPrism(size_t ringPoints, bool concave, bool splitFaces, std::vector<Syx::Vec3>& points) {
+      const float step = 6.2831853f/static_cast<float>(ringPoints);
+      points.clear();
+      for(size_t i = 0; i < ringPoints; ++i) {
+        //Pulling every other point in makes a star, which can't be hill climbed
+        float radius = concave && (i % 2) ? 0.5f : 1.0f;
+        float x = std::cos(step*i)*radius;
+        float z = std::sin(step*i)*radius;
+        points.push_back(Syx::Vec3(x, -1.0f, z));
+        points.push_back(Syx::Vec3(x, 1.0f, z));
+      }
+      const size_t bottom = points.size();
+      const size_t top = bottom + 1;
+      points.push_back(Syx::Vec3(0.0f, -1.0f, 0.0f));
+      points.push_back(Syx::Vec3(0.0f, 1.0f, 0.0f));
+
+      std::vector<size_t> indices;
+      for(size_t i = 0; i < ringPoints; ++i) {
+        size_t next = (i + 1) % ringPoints;
+        for(size_t index : { i*2, next*2, i*2 + 1, next*2, next*2 + 1, i*2 + 1, bottom, next*2, i*2, top, i*2 + 1, next*2 + 1 })
+          indices.push_back(index);
+      }
+
+      Syx::ModelParam result;
+      if(splitFaces) {
+        for(size_t i = 0; i < indices.size(); ++i) {
+          result.addVertex(points[indices[i]]);
+          result.addIndex(i);
+        }
+      }
+      else {
+        for(const Syx::Vec3& point : points)
+          result.addVertex(point);
+        for(size_t index : indices)
+          result.addIndex(index);
+      }
+      return result;
+    }
+
+    static void _assertSupportsMatch(const Syx::ModelParam& param, const std::vector<Syx::Vec3>& points) {
+      Syx::Model model = param.toModel();
+      Syx::SupportHint hint;
+      unsigned seed = 1;
+      auto random = [&seed]() {
+        seed = seed*1103515245 + 12345;
+        return static_cast<float>((seed >> 16) & 0x7fff)/16383.5f - 1.0f;
+      };
+
+      for(int i = 0; i < 500; ++i) {
+        Syx::Vec3 dir(random(), random(), random());
+        float expected = std::numeric_limits<float>::lowest();
+        for(const Syx::Vec3& point : points)
+          expected = std::max(expected, point.dot(dir));
+
+        //Ties between points are fine as long as they're equally far along dir
+        Assert::AreEqual(expected, model.getSupport(dir).dot(dir), 0.0001f);
+        Assert::AreEqual(expected, model.getSupport(dir, hint).dot(dir), 0.0001f);
+        SAlign Syx::Vec3 sDir = dir;
+        SAlign Syx::Vec3 sSupport;
+        Syx::SVec3::store(model.sGetSupport(SLoadAll(&sDir.x), hint), sSupport);
+        Assert::AreEqual(expected, sSupport.dot(dir), 0.0001f);
+        Syx::SVec3::store(model.sGetSupport(SLoadAll(&sDir.x)), sSupport);
+        Assert::AreEqual(expected, sSupport.dot(dir), 0.0001f);
+      }
+    }
+
+    TEST_METHOD(Model_LargeConvexMesh_SupportMatchesBruteForce) {
+      std::vector<Syx::Vec3> points;
+      _assertSupportsMatch(_createPrism(64, false, false, points), points);
+    }
+
+    TEST_METHOD(Model_LargeConvexMeshSplitFaces_SupportMatchesBruteForce) {
+      std::vector<Syx::Vec3> points;
+      _assertSupportsMatch(_createPrism(64, false, true, points), points);
+    }
+
+    TEST_METHOD(Model_LargeConcaveMesh_SupportMatchesBruteForce) {
+      std::vector<Syx::Vec3> points;
+      _assertSupportsMatch(_createPrism(64, true, false, points), points);
+    }
+
+    TEST_METHOD(Model_SmallMesh_SupportMatchesBruteForce) {
+      std::vector<Syx::Vec3> points;
+      //Odd point count so the last support group is padded
+      _assertSupportsMatch(_createPrism(5, false, false, points), points);
+    }
+  };
+}
@@ -0,0 +1,177 @@
+#include "Precompile.h"
+#include "CppUnitTest.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+#include "../syx/Precompile.h"
+
+namespace SyxTest {
+  TEST_CLASS(ProfilerTest) {
+  public:
+    static void _sleep() {
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+
+    static const Syx::ProfileResult& _getResult(const std::vector<Syx::ProfileResult>& history, size_t index) {
+      Assert::IsTrue(index < history.size());
+      return history[index];
+    }
+
+    TEST_METHOD(Profiler_NestedBlocks_HistoryInOrderWithDepth) {
+      Syx::Profiler profiler;
+      {
+        Syx::AutoProfileBlock frame(profiler, "Frame");
+        {
+          Syx::AutoProfileBlock a(profiler, "A");
+          Syx::AutoProfileBlock b(profiler, "B");
+          _sleep();
+        }
+        Syx::AutoProfileBlock c(profiler, "C");
+      }
+
+      const std::vector<Syx::ProfileResult>& history = profiler.getHistory();
+      Assert::AreEqual(size_t(4), history.size());
+      const char* names[] = { "Frame", "A", "B", "C" };
+      size_t depths[] = { 0, 1, 2, 1 };
+      for(size_t i = 0; i < 4; ++i) {
+        Assert::AreEqual(std::string(names[i]), std::string(history[i].mName));
+        Assert::AreEqual(depths[i], history[i].mDepth);
+      }
+      Assert::IsTrue(history[0].mDuration >= history[1].mDuration);
+      Assert::IsTrue(history[1].mDuration >= history[2].mDuration);
+    }
+
+    TEST_METHOD(Profiler_NewFrame_ReplacesHistory) {
+      Syx::Profiler profiler;
+      for(int i = 0; i < 3; ++i) {
+        Syx::AutoProfileBlock frame(profiler, "Frame");
+        Syx::AutoProfileBlock a(profiler, "A");
+      }
+
+      Assert::AreEqual(size_t(2), profiler.getHistory().size());
+      Assert::AreEqual(size_t(1), profiler.getHistory()[1].mCount);
+    }
+
+    TEST_METHOD(Profiler_RepeatedBlocks_Merged) {
+      Syx::Profiler profiler;
+      {
+        Syx::AutoProfileBlock frame(profiler, "Frame");
+        for(int i = 0; i < 5; ++i)
+          Syx::AutoProfileBlock a(profiler, "Repeated");
+      }
+
+      const std::vector<Syx::ProfileResult>& history = profiler.getHistory();
+      Assert::AreEqual(size_t(2), history.size());
+      Assert::AreEqual(size_t(5), _getResult(history, 1).mCount);
+    }
+
+    TEST_METHOD(Profiler_BlocksFromOtherThreads_NestedUnderOpenBlock) {
+      Syx::Profiler profiler;
+      {
+        Syx::AutoProfileBlock frame(profiler, "Frame");
+        Syx::AutoProfileBlock work(profiler, "Work");
+        //Frame thread helps with the work like parallelFor does
+        auto task = [&profiler] {
+          Syx::AutoProfileBlock task(profiler, "Task");
+          Syx::AutoProfileBlock inner(profiler, "Inner");
+          _sleep();
+        };
+        std::thread a(task);
+        std::thread b(task);
+        task();
+        a.join();
+        b.join();
+      }
+
+      const std::vector<Syx::ProfileResult>& history = profiler.getHistory();
+      Assert::AreEqual(size_t(4), history.size());
+      const Syx::ProfileResult& task = _getResult(history, 2);
+      const Syx::ProfileResult& inner = _getResult(history, 3);
+      Assert::AreEqual(std::string("Task"), std::string(task.mName));
+      Assert::AreEqual(size_t(2), task.mDepth);
+      Assert::AreEqual(size_t(3), task.mCount);
+      Assert::AreEqual(std::string("Inner"), std::string(inner.mName));
+      Assert::AreEqual(size_t(3), inner.mDepth);
+      Assert::AreEqual(size_t(3), inner.mCount);
+    }
+
+    TEST_METHOD(Profiler_Disabled_RecordsNothing) {
+      Syx::Profiler profiler;
+      profiler.setEnabled(false);
+      {
+        Syx::AutoProfileBlock frame(profiler, "Frame");
+      }
+
+      Assert::IsTrue(profiler.getHistory().empty());
+    }
+
+    TEST_METHOD(Profiler_WriteTrace_ContainsCompleteEvents) {
+      Syx::Profiler profiler;
+      {
+        Syx::AutoProfileBlock frame(profiler, "Frame");
+        std::thread worker([&profiler] {
+          Syx::AutoProfileBlock task(profiler, "Quoted \"Task\"");
+        });
+        worker.join();
+      }
+
+      std::stringstream stream;
+      profiler.writeTrace(stream);
+      std::string trace = stream.str();
+      Assert::AreEqual(size_t(0), trace.find("{\"traceEvents\":["));
+      Assert::IsTrue(trace.find("\"name\":\"Frame\"") != std::string::npos);
+      Assert::IsTrue(trace.find("\"name\":\"Quoted \\\"Task\\\"\"") != std::string::npos);
+      Assert::IsTrue(trace.find("\"ph\":\"X\"") != std::string::npos);
+    }
+
+    TEST_METHOD(Profiler_NewProfilerAtSameAddress_IgnoresOldBlocks) {
+      //Placement new makes sure the second profiler gets the first one's address
+      alignas(Syx::Profiler) unsigned char storage[sizeof(Syx::Profiler)];
+      Syx::Profiler* old = new (storage) Syx::Profiler();
+      {
+        Syx::AutoProfileBlock frame(*old, "Old");
+      }
+      old->~Profiler();
+
+      Syx::Profiler* profiler = new (storage) Syx::Profiler();
+      {
+        Syx::AutoProfileBlock frame(*profiler, "New");
+      }
+      std::stringstream stream;
+      profiler->writeTrace(stream);
+      std::string trace = stream.str();
+      Assert::IsTrue(trace.find("\"name\":\"New\"") != std::string::npos);
+      Assert::IsTrue(trace.find("\"name\":\"Old\"") == std::string::npos);
+      Assert::AreEqual(size_t(1), profiler->getHistory().size());
+      profiler->~Profiler();
+    }
+
+    //Each frame has the frame and inner blocks, and nothing else may show up even while the other thread is overwriting its buffer
+    static void _recordFrames(Syx::Profiler& profiler, const char* frameName, const char* innerName, std::atomic_bool& failed) {
+      for(int i = 0; i < 3000 && !failed; ++i) {
+        {
+          Syx::AutoProfileBlock frame(profiler, frameName);
+          Syx::AutoProfileBlock inner(profiler, innerName);
+        }
+        const std::vector<Syx::ProfileResult>& history = profiler.getHistory();
+        if(history.size() != 2 || history[0].mName != frameName || history[1].mName != innerName || history[1].mCount != 1)
+          failed = true;
+      }
+    }
+
+    TEST_METHOD(Profiler_FramesWhileOtherThreadRecords_OnlyOwnBlocks) {
+      Syx::Profiler main, worker;
+      std::atomic_bool failed(false);
+      //Each thread gathers from the other's buffer while that thread keeps wrapping around it
+      std::thread thread([&worker, &failed] {
+        _recordFrames(worker, "WorkerFrame", "WorkerInner", failed);
+      });
+      _recordFrames(main, "MainFrame", "MainInner", failed);
+      thread.join();
+
+      Assert::IsFalse(failed.load(), L"Frames should only contain their own profiler's blocks", LINE_INFO());
+      std::stringstream stream;
+      main.writeTrace(stream);
+      Assert::IsTrue(stream.str().find("Worker") == std::string::npos, LINE_INFO());
+    }
+  };
+}
@@ -0,0 +1,123 @@
+#include "Precompile.h"
+#include "CppUnitTest.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+#include "../syx/Precompile.h"
+#include "SyxPhysicsObject.h"
+#include "SyxRigidbodyStore.h"
+
+#include <set>
+
+namespace SyxTest {
+  TEST_CLASS(RigidbodyStoreTest) {
+  public:
+    static std::set<Syx::Handle> getHandles(const Syx::RigidbodyStore::BodyRange& range) {
+      std::set<Syx::Handle> result;
+      for(Syx::PhysicsObject* obj : range)
+        result.insert(obj->getHandle());
+      return result;
+    }
+
+    static void assertContents(const Syx::RigidbodyStore& store, const std::set<Syx::Handle>& awake, const std::set<Syx::Handle>& asleep) {
+      Assert::IsTrue(getHandles(store.getAwake()) == awake);
+      Assert::IsTrue(getHandles(store.getAsleep()) == asleep);
+      Assert::AreEqual(awake.size(), store.getAwake().size());
+      Assert::AreEqual(asleep.size(), store.getAsleep().size());
+      Assert::AreEqual(awake.size() + asleep.size(), store.size());
+      for(Syx::PhysicsObject* obj : store.getAwake())
+        Assert::IsFalse(obj->getAsleep());
+      for(Syx::PhysicsObject* obj : store.getAsleep())
+        Assert::IsTrue(obj->getAsleep());
+    }
+
+    TEST_METHOD(RigidbodyStore_Add_SplitsAwakeAndAsleep) {
+      Syx::PhysicsObject a(0), b(1), c(2);
+      b.setAsleep(true);
+      Syx::RigidbodyStore store;
+
+      store.add(a);
+      store.add(b);
+      store.add(c);
+
+      assertContents(store, { 0, 2 }, { 1 });
+    }
+
+    TEST_METHOD(RigidbodyStore_SetAsleepTwice_NoChange) {
+      Syx::PhysicsObject a(0), b(1);
+      Syx::RigidbodyStore store;
+      store.add(a);
+      store.add(b);
+
+      store.setAsleep(a, true);
+      store.setAsleep(a, true);
+      store.setAsleep(b, false);
+
+      assertContents(store, { 1 }, { 0 });
+    }
+
+    TEST_METHOD(RigidbodyStore_SetAsleepNotInStore_OnlySetsFlag) {
+      Syx::PhysicsObject a(0), b(1);
+      Syx::RigidbodyStore store;
+      store.add(a);
+
+      store.setAsleep(b, true);
+
+      Assert::IsTrue(b.getAsleep());
+      assertContents(store, { 0 }, {});
+    }
+
+    TEST_METHOD(RigidbodyStore_MixedSleepWakeRemove_PartitionMatches) {
+      Syx::PhysicsObject objs[8];
+      Syx::RigidbodyStore store;
+      std::set<Syx::Handle> awake, asleep;
+      for(Syx::Handle i = 0; i < 8; ++i) {
+        objs[i] = Syx::PhysicsObject(i);
+        store.add(objs[i]);
+        awake.insert(i);
+      }
+      auto sleep = [&](Syx::Handle h, bool s) {
+        store.setAsleep(objs[h], s);
+        (s ? awake : asleep).erase(h);
+        (s ? asleep : awake).insert(h);
+      };
+      auto remove = [&](Syx::Handle h) {
+        store.remove(objs[h]);
+        awake.erase(h);
+        asleep.erase(h);
+      };
+
+      sleep(0, true);
+      sleep(5, true);
+      sleep(7, true);
+      assertContents(store, awake, asleep);
+
+      //Remove from the middle of each partition and from either end
+      remove(3);
+      remove(5);
+      assertContents(store, awake, asleep);
+      remove(7);
+      remove(1);
+      assertContents(store, awake, asleep);
+
+      sleep(0, false);
+      sleep(2, true);
+      sleep(6, true);
+      assertContents(store, awake, asleep);
+
+      remove(0);
+      sleep(4, true);
+      assertContents(store, awake, asleep);
+
+      //Everything left is asleep, wake one and remove the rest
+      sleep(6, false);
+      remove(2);
+      remove(4);
+      assertContents(store, { 6 }, {});
+      Assert::IsTrue(store.contains(objs[6]));
+      Assert::IsFalse(store.contains(objs[2]));
+
+      remove(6);
+      assertContents(store, {}, {});
+    }
+  };
+}
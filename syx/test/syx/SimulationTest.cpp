@@ -0,0 +1,763 @@
+#include "Precompile.h"
+#include "CppUnitTest.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+#include "../syx/Precompile.h"
+#include "SyxPhysicsSystem.h"
+#include "SyxModelParam.h"
+#include "AllocationCounter.h"
+#include "threading/WorkStealingPool.h"
+
+namespace Syx {
+  namespace Interface {
+    extern IWorkerPool* gWorkerPool;
+  }
+
+  //Reads state the physics system doesn't expose for the simulation tests
+  class SimulationTest {
+  public:
+    //Accumulated normal impulse of every contact point in the space, in contact order
+    static std::vector<float> getContactImpulses(PhysicsSystem& system, Handle space) {
+      std::vector<float> result;
+      if(Space* s = system.mSpaces.get(space))
+        for(const ContactConstraint& contact : s->mConstraintSystem.mContacts)
+          for(size_t i = 0; i < contact.mManifold.mSize; ++i)
+            result.push_back(contact.mManifold.mContacts[i].mWarmContact);
+      return result;
+    }
+
+    //Manifold of every contact in the space, in contact order
+    static std::vector<const Manifold*> getManifolds(PhysicsSystem& system, Handle space) {
+      std::vector<const Manifold*> result;
+      if(Space* s = system.mSpaces.get(space))
+        for(const ContactConstraint& contact : s->mConstraintSystem.mContacts)
+          result.push_back(&contact.mManifold);
+      return result;
+    }
+
+    //Makes the next narrowphase test of every pair start from scratch, as if nothing was cached
+    static void clearNarrowphaseCaches(PhysicsSystem& system, Handle space) {
+      if(Space* s = system.mSpaces.get(space))
+        for(ContactConstraint& contact : s->mConstraintSystem.mContacts)
+          contact.mManifold.mNarrowphaseCache.mValid = false;
+    }
+  };
+}
+
+namespace SyxTest {
+  struct BodyState {
+    Syx::Vec3 mPos;
+    Syx::Quat mRot;
+    Syx::Vec3 mLinVel;
+    Syx::Vec3 mAngVel;
+  };
+
+  //Gives syx a worker pool while in scope so parallel paths actually run on several threads
+  struct ScopedWorkerPool {
+    ScopedWorkerPool()
+      : mPool(4) {
+      Syx::Interface::gWorkerPool = &mPool;
+    }
+
+    ~ScopedWorkerPool() {
+      Syx::Interface::gWorkerPool = nullptr;
+    }
+
+    WorkStealingPool mPool;
+  };
+
+  Syx::SyxOptions getTestOptions(int threadingFlags) {
+    Syx::SyxOptions options = Syx::Interface::getOptions();
+    //Nothing to draw to in tests
+    options.mDebugFlags = 0;
+    options.mThreadingFlags = threadingFlags;
+    return options;
+  }
+
+  //Boxes stacked in touching columns so they're all one island with enough contacts to be batched
+  std::vector<Syx::Handle> addWall(Syx::PhysicsSystem& system, Syx::Handle space, int width, int height) {
+    Syx::Handle ground = system.addPhysicsObject(false, true, space);
+    system.setScale(space, ground, Syx::Vec3(width*2.0f, 1.0f, 3.0f));
+    system.setPosition(space, ground, Syx::Vec3(0.0f, -1.0f, 0.0f));
+
+    std::vector<Syx::Handle> boxes;
+    for(int x = 0; x < width; ++x)
+      for(int y = 0; y < height; ++y) {
+        Syx::Handle box = system.addPhysicsObject(true, true, space);
+        system.setPosition(space, box, Syx::Vec3(x*2.0f - width, 1.0f + y*2.0f, 0.0f));
+        boxes.push_back(box);
+      }
+    return boxes;
+  }
+
+  //Separate stacks of boxes on a static ground, so there are many islands and enough pairs for everything to be split into batches
+  std::vector<Syx::Handle> addStacks(Syx::PhysicsSystem& system, Syx::Handle space, int stacks, int height) {
+    Syx::Handle ground = system.addPhysicsObject(false, true, space);
+    system.setScale(space, ground, Syx::Vec3(stacks*3.0f, 1.0f, 3.0f));
+    system.setPosition(space, ground, Syx::Vec3(0.0f, -1.0f, 0.0f));
+
+    std::vector<Syx::Handle> boxes;
+    for(int x = 0; x < stacks; ++x)
+      for(int y = 0; y < height; ++y) {
+        Syx::Handle box = system.addPhysicsObject(true, true, space);
+        system.setPosition(space, box, Syx::Vec3(x*5.0f - stacks*2.5f, 1.0f + y*2.02f, 0.1f*y));
+        system.setRotation(space, box, Syx::Quat::axisAngle(Syx::Vec3::UnitY, 0.05f*y));
+        boxes.push_back(box);
+      }
+    return boxes;
+  }
+
+  //The same scene built in two systems that are stepped side by side, so a variant path can be compared against a reference after every step
+  class SimulationPair {
+  public:
+    //Adds the scene to the given space, returning the bodies to compare
+    using BuildScene = std::function<std::vector<Syx::Handle>(Syx::PhysicsSystem&, Syx::Handle)>;
+
+    SimulationPair(const BuildScene& build, size_t spaceCount = 1) {
+      for(size_t i = 0; i < spaceCount; ++i) {
+        Syx::Handle space = mReference.addSpace();
+        Syx::Handle variantSpace = mVariant.addSpace();
+        std::vector<Syx::Handle> bodies = build(mReference, space);
+        //Handles are handed out the same way in both, so one set refers to the same bodies in either
+        Assert::IsTrue(variantSpace == space && build(mVariant, variantSpace) == bodies, L"Scenes should be built identically", LINE_INFO());
+        mSpaces.push_back(space);
+        for(Syx::Handle body : bodies)
+          mBodies.push_back({ space, body });
+      }
+    }
+
+    void step(const Syx::SyxOptions& reference, const Syx::SyxOptions& variant) {
+      mReference.update(Syx::PhysicsSystem::sSimRate, reference);
+      mVariant.update(Syx::PhysicsSystem::sSimRate, variant);
+    }
+
+    std::vector<BodyState> getStates(Syx::PhysicsSystem& system) const {
+      std::vector<BodyState> result;
+      for(const auto& body : mBodies)
+        result.push_back({ system.getPosition(body.first, body.second), system.getRotation(body.first, body.second),
+          system.getVelocity(body.first, body.second), system.getAngularVelocity(body.first, body.second) });
+      return result;
+    }
+
+    //For paths that only change the order work is done in, which should give exactly the same results
+    void assertSame() {
+      std::vector<BodyState> reference = getStates(mReference);
+      std::vector<BodyState> variant = getStates(mVariant);
+      for(size_t i = 0; i < reference.size(); ++i) {
+        const BodyState& r = reference[i];
+        const BodyState& v = variant[i];
+        Assert::IsTrue(r.mPos.equal(v.mPos, 0.0f) && r.mRot.mV.equal(v.mRot.mV, 0.0f) && r.mRot.mV.w == v.mRot.mV.w
+          && r.mLinVel.equal(v.mLinVel, 0.0f) && r.mAngVel.equal(v.mAngVel, 0.0f), L"Bodies should match exactly", LINE_INFO());
+      }
+    }
+
+    //For paths that solve differently enough to round differently, but should still behave the same
+    //Velocities can be left out for paths that jostle differently on the way to the same place
+    void assertClose(float epsilon, bool compareVelocities = true) {
+      std::vector<BodyState> reference = getStates(mReference);
+      std::vector<BodyState> variant = getStates(mVariant);
+      for(size_t i = 0; i < reference.size(); ++i) {
+        const BodyState& r = reference[i];
+        const BodyState& v = variant[i];
+        Assert::IsTrue(r.mPos.equal(v.mPos, epsilon), L"Positions should be close", LINE_INFO());
+        if(compareVelocities)
+          Assert::IsTrue(r.mLinVel.equal(v.mLinVel, epsilon) && r.mAngVel.equal(v.mAngVel, epsilon), L"Velocities should be close", LINE_INFO());
+      }
+    }
+
+    Syx::PhysicsSystem mReference;
+    Syx::PhysicsSystem mVariant;
+    std::vector<Syx::Handle> mSpaces;
+    //Space and handle of every body the scene returned
+    std::vector<std::pair<Syx::Handle, Syx::Handle>> mBodies;
+  };
+
+  TEST_CLASS(ParallelSimulationTest) {
+  public:
+    static std::vector<Syx::Handle> _addStacks(Syx::PhysicsSystem& system, Syx::Handle space) {
+      return addStacks(system, space, 8, 10);
+    }
+
+    //Islands are solved and pairs are narrowphased in different orders, but results should come out exactly the same
+    static void _assertMatchesSerial(int threadingFlags) {
+      ScopedWorkerPool pool;
+      SimulationPair sim(&_addStacks);
+      for(int i = 0; i < 90; ++i) {
+        sim.step(getTestOptions(0), getTestOptions(threadingFlags));
+        sim.assertSame();
+      }
+    }
+
+    TEST_METHOD(ParallelSimulation_ParallelSolve_MatchesSerial) {
+      _assertMatchesSerial(Syx::SyxOptions::ParallelSolve);
+    }
+
+    TEST_METHOD(ParallelSimulation_ParallelNarrowphase_MatchesSerial) {
+      _assertMatchesSerial(Syx::SyxOptions::ParallelNarrowphase);
+    }
+
+    TEST_METHOD(ParallelSimulation_ParallelSolveAndNarrowphase_MatchesSerial) {
+      _assertMatchesSerial(Syx::SyxOptions::ParallelSolve | Syx::SyxOptions::ParallelNarrowphase);
+    }
+
+    static std::vector<Syx::Handle> _addSmallStacks(Syx::PhysicsSystem& system, Syx::Handle space) {
+      return addStacks(system, space, 4, 6);
+    }
+
+    TEST_METHOD(ParallelSimulation_ParallelSpaces_MatchesSerial) {
+      ScopedWorkerPool pool;
+      SimulationPair sim(&_addSmallStacks, 2);
+      for(int i = 0; i < 60; ++i) {
+        sim.step(getTestOptions(0), getTestOptions(Syx::SyxOptions::ParallelSpaces));
+        sim.assertSame();
+        for(Syx::Handle space : sim.mSpaces) {
+          const std::vector<Syx::UpdateEvent>& serial = sim.mReference.getUpdateEvents(space)->mEvents;
+          const std::vector<Syx::UpdateEvent>& parallel = sim.mVariant.getUpdateEvents(space)->mEvents;
+          //Every box moves while the stacks fall, so each space should send the same events
+          Assert::IsFalse(serial.empty(), LINE_INFO());
+          Assert::AreEqual(serial.size(), parallel.size(), LINE_INFO());
+          for(size_t e = 0; e < std::min(serial.size(), parallel.size()); ++e)
+            Assert::IsTrue(serial[e].mHandle == parallel[e].mHandle && serial[e].mPos.equal(parallel[e].mPos, 0.0f), LINE_INFO());
+        }
+      }
+    }
+
+    TEST_METHOD(ParallelSimulation_ParallelSpacesWhileDrawing_MatchesSerial) {
+      ScopedWorkerPool pool;
+      SimulationPair sim(&_addSmallStacks, 2);
+      Syx::SyxOptions serialOptions = getTestOptions(0);
+      Syx::SyxOptions parallelOptions = getTestOptions(Syx::SyxOptions::ParallelSpaces);
+      serialOptions.mDebugFlags = parallelOptions.mDebugFlags = Syx::SyxOptions::DrawModels;
+      for(int i = 0; i < 30; ++i) {
+        //Each system's drawing is kept apart from the other's and from the shared drawer
+        Syx::DebugDrawer serialDraws, parallelDraws;
+        {
+          Syx::DebugDrawer::ScopedTarget target(serialDraws);
+          sim.mReference.update(Syx::PhysicsSystem::sSimRate, serialOptions);
+        }
+        {
+          Syx::DebugDrawer::ScopedTarget target(parallelDraws);
+          sim.mVariant.update(Syx::PhysicsSystem::sSimRate, parallelOptions);
+        }
+        sim.assertSame();
+
+        const std::vector<Syx::Command>& serial = serialDraws.getCommands();
+        const std::vector<Syx::Command>& parallel = parallelDraws.getCommands();
+        Assert::IsFalse(serial.empty(), LINE_INFO());
+        Assert::AreEqual(serial.size(), parallel.size(), LINE_INFO());
+        for(size_t c = 0; c < std::min(serial.size(), parallel.size()); ++c) {
+          const Syx::Command& s = serial[c];
+          const Syx::Command& p = parallel[c];
+          Assert::IsTrue(s.mType == p.mType && s.mA.equal(p.mA, 0.0f) && s.mB.equal(p.mB, 0.0f) && s.mC.equal(p.mC, 0.0f) && s.mD.equal(p.mD, 0.0f),
+            L"Parallel spaces should draw the same thing in the same order", LINE_INFO());
+        }
+      }
+    }
+  };
+
+  TEST_CLASS(ContactSolverTest) {
+  public:
+    static Syx::SyxOptions _getSolverOptions(bool contactBatches) {
+      Syx::SyxOptions options = getTestOptions(0);
+      options.mSimdFlags |= Syx::SyxOptions::SIMD::ConstraintSolve;
+      if(contactBatches)
+        options.mSimdFlags |= Syx::SyxOptions::SIMD::ContactBatches;
+      else
+        options.mSimdFlags &= ~Syx::SyxOptions::SIMD::ContactBatches;
+      return options;
+    }
+
+    static std::vector<Syx::Handle> _addWall(Syx::PhysicsSystem& system, Syx::Handle space) {
+      return addWall(system, space, 4, 5);
+    }
+
+    TEST_METHOD(ContactSolver_Batches_MatchScalar) {
+      SimulationPair sim(&_addWall);
+      const Syx::Handle space = sim.mSpaces.front();
+      //Settle both the same way so the steps being compared start from identical contacts and warm starts
+      for(int i = 0; i < 60; ++i)
+        sim.step(_getSolverOptions(false), _getSolverOptions(false));
+      sim.assertSame();
+
+      //Batches solve contacts in a different order, so the results are close rather than identical
+      const float epsilon = 0.01f;
+      for(int i = 0; i < 60; ++i) {
+        sim.step(_getSolverOptions(false), _getSolverOptions(true));
+
+        std::vector<float> scalarImpulses = Syx::SimulationTest::getContactImpulses(sim.mReference, space);
+        std::vector<float> batchedImpulses = Syx::SimulationTest::getContactImpulses(sim.mVariant, space);
+        Assert::IsTrue(scalarImpulses.size() >= 20, L"Wall should have enough contacts to be batched", LINE_INFO());
+        Assert::AreEqual(scalarImpulses.size(), batchedImpulses.size(), LINE_INFO());
+        for(size_t c = 0; c < std::min(scalarImpulses.size(), batchedImpulses.size()); ++c)
+          Assert::AreEqual(scalarImpulses[c], batchedImpulses[c], epsilon*std::max(1.0f, std::abs(scalarImpulses[c])), LINE_INFO());
+        sim.assertClose(epsilon);
+      }
+    }
+  };
+
+  TEST_CLASS(ContinuousCollisionTest) {
+  public:
+    //Small and fast enough to step past a thin wall in a single update, returns the wall and the bullet
+    static std::pair<Syx::Handle, Syx::Handle> _addWallAndBullet(Syx::PhysicsSystem& system, Syx::Handle space, Syx::Handle (Syx::PhysicsSystem::*getModel)()) {
+      Syx::Handle wall = system.addPhysicsObject(false, true, space);
+      system.setObjectModel(space, wall, system.getCube());
+      system.setScale(space, wall, Syx::Vec3(0.05f, 3.0f, 3.0f));
+      system.setPosition(space, wall, Syx::Vec3(5.0f, 0.0f, 0.0f));
+
+      Syx::Handle bullet = system.addPhysicsObject(true, true, space);
+      system.setObjectModel(space, bullet, (system.*getModel)());
+      system.setScale(space, bullet, Syx::Vec3(0.1f));
+      system.setVelocity(space, bullet, Syx::Vec3(400.0f, 0.0f, 0.0f));
+      system.setContinuous(space, bullet, true);
+      Assert::IsTrue(system.getContinuous(space, bullet), LINE_INFO());
+      return { wall, bullet };
+    }
+
+    static void _assertStopsAtWall(Syx::Handle (Syx::PhysicsSystem::*getModel)()) {
+      Syx::PhysicsSystem system;
+      Syx::Handle space = system.addSpace();
+      Syx::Handle bullet = _addWallAndBullet(system, space, getModel).second;
+
+      for(int i = 0; i < 30; ++i) {
+        system.update(Syx::PhysicsSystem::sSimRate, getTestOptions(0));
+        Assert::IsTrue(system.getPosition(space, bullet).x < 5.0f, L"Continuous body should not pass through the wall", LINE_INFO());
+      }
+    }
+
+    TEST_METHOD(ContinuousCollision_FastSphere_StopsAtWall) {
+      _assertStopsAtWall(&Syx::PhysicsSystem::getSphere);
+    }
+
+    TEST_METHOD(ContinuousCollision_FastCube_StopsAtWall) {
+      _assertStopsAtWall(&Syx::PhysicsSystem::getCube);
+    }
+
+    TEST_METHOD(ContinuousCollision_JointDisablesCollision_PassesWall) {
+      Syx::PhysicsSystem system;
+      Syx::Handle space = system.addSpace();
+      std::pair<Syx::Handle, Syx::Handle> objs = _addWallAndBullet(system, space, &Syx::PhysicsSystem::getSphere);
+      //Long enough that the bullet swings through the wall without the joint itself stopping it
+      Syx::DistanceOps ops;
+      ops.set(objs.second, objs.first, space);
+      const Syx::Vec3 pivot(5.0f, 0.0f, -100.0f);
+      ops.setAnchors(system.getPosition(space, objs.second), pivot, true);
+      ops.mDistance = system.getPosition(space, objs.second).distance(pivot);
+      Assert::IsFalse(ops.mCollisionEnabled, LINE_INFO());
+      Assert::IsTrue(system.addDistanceConstraint(ops) != SyxInvalidHandle, LINE_INFO());
+
+      for(int i = 0; i < 3; ++i)
+        system.update(Syx::PhysicsSystem::sSimRate, getTestOptions(0));
+      Assert::IsTrue(system.getPosition(space, objs.second).x > 5.5f, L"Bodies that don't collide shouldn't be swept against each other", LINE_INFO());
+    }
+  };
+
+  TEST_CLASS(NarrowphaseCacheTest) {
+  public:
+    //One resting stack, so every pair goes through gjk and epa and barely moves once it settles
+    static std::vector<Syx::Handle> _addStack(Syx::PhysicsSystem& system, Syx::Handle space) {
+      return addWall(system, space, 1, 3);
+    }
+
+    //Narrowphase sees the placement from the end of the last update, which is what a test that wasn't skipped caches
+    static std::vector<Syx::Vec3> _getPlacements(const std::vector<const Syx::Manifold*>& manifolds) {
+      std::vector<Syx::Vec3> result;
+      for(const Syx::Manifold* manifold : manifolds)
+        result.push_back(Syx::Transformer::combined(manifold->mB->getModelInstance().getModelToWorld(), manifold->mA->getModelInstance().getWorldToModel()).mPos);
+      return result;
+    }
+
+    static float _getDeepest(const Syx::Manifold& manifold) {
+      float result = 0.0f;
+      for(size_t i = 0; i < manifold.mSize; ++i)
+        result = std::max(result, manifold.mContacts[i].mPenetration);
+      return result;
+    }
+
+    TEST_METHOD(NarrowphaseCache_UpdateModelUnderRestingStack_ContactsUpdate) {
+      Syx::PhysicsSystem system;
+      Syx::Handle space = system.addSpace();
+      const Syx::SyxOptions options = getTestOptions(0);
+      //A model of its own that can be changed without affecting the boxes
+      Syx::ModelParam placeholder;
+      placeholder.addVertex(Syx::Vec3::Zero);
+      Syx::Handle groundModel = system.addModel(placeholder);
+      system.updateModel(groundModel, Syx::Model(Syx::ModelType::Cube));
+      Syx::Handle ground = system.addPhysicsObject(false, true, space);
+      system.setObjectModel(space, ground, groundModel);
+      system.setScale(space, ground, Syx::Vec3(4.0f, 1.0f, 3.0f));
+      system.setPosition(space, ground, Syx::Vec3(0.0f, -1.0f, 0.0f));
+      //Off center so the ground's surface under them drops when it becomes round
+      std::vector<Syx::Handle> boxes;
+      for(int y = 0; y < 3; ++y) {
+        boxes.push_back(system.addPhysicsObject(true, true, space));
+        system.setPosition(space, boxes.back(), Syx::Vec3(-2.5f, 1.0f + y*2.0f, 0.0f));
+      }
+
+      //Settled enough for full manifolds to be skipped, but not yet asleep
+      for(int i = 0; i < 30; ++i)
+        system.update(Syx::PhysicsSystem::sSimRate, options);
+      std::vector<const Syx::Manifold*> manifolds = Syx::SimulationTest::getManifolds(system, space);
+      Assert::AreEqual(size_t(3), manifolds.size(), LINE_INFO());
+      for(const Syx::Manifold* manifold : manifolds)
+        Assert::AreEqual(size_t(MAX_CONTACTS), manifold->mSize, L"Full manifolds are the ones narrowphase skips", LINE_INFO());
+      const float restingHeight = system.getPosition(space, boxes.front()).y;
+
+      //Same model address, different shape, which is lower under the stack
+      system.updateModel(groundModel, Syx::Model(Syx::ModelType::Sphere));
+      for(int i = 0; i < 10; ++i)
+        system.update(Syx::PhysicsSystem::sSimRate, options);
+      Assert::IsTrue(system.getPosition(space, boxes.front()).y < restingHeight - 0.05f, L"Contacts should follow the new shape", LINE_INFO());
+    }
+
+    TEST_METHOD(NarrowphaseCache_RestingStack_MatchesUncached) {
+      SimulationPair sim(&_addStack);
+      const Syx::Handle space = sim.mSpaces.front();
+      const Syx::SyxOptions options = getTestOptions(0);
+      const float epsilon = 0.01f;
+      size_t skipped = 0;
+      //Stops before the stack falls asleep, after which neither runs narrowphase
+      for(int i = 0; i < 50; ++i) {
+        std::vector<Syx::Vec3> uncachedPlacements = _getPlacements(Syx::SimulationTest::getManifolds(sim.mReference, space));
+        std::vector<Syx::Vec3> cachedPlacements = _getPlacements(Syx::SimulationTest::getManifolds(sim.mVariant, space));
+        Syx::SimulationTest::clearNarrowphaseCaches(sim.mReference, space);
+        sim.step(options, options);
+
+        std::vector<const Syx::Manifold*> uncachedManifolds = Syx::SimulationTest::getManifolds(sim.mReference, space);
+        std::vector<const Syx::Manifold*> cachedManifolds = Syx::SimulationTest::getManifolds(sim.mVariant, space);
+        Assert::AreEqual(size_t(3), cachedManifolds.size(), LINE_INFO());
+        Assert::AreEqual(uncachedManifolds.size(), cachedManifolds.size(), LINE_INFO());
+        for(size_t m = 0; m < std::min(cachedManifolds.size(), uncachedManifolds.size()); ++m) {
+          const Syx::Manifold& c = *cachedManifolds[m];
+          const Syx::Manifold& u = *uncachedManifolds[m];
+          //Pairs tested from scratch always cache their current placement, while skipped ones keep an older one
+          if(m < uncachedPlacements.size())
+            Assert::IsTrue(u.mNarrowphaseCache.mBToA.mPos.equal(uncachedPlacements[m], 0.0f), LINE_INFO());
+          if(m < cachedPlacements.size() && !c.mNarrowphaseCache.mBToA.mPos.equal(cachedPlacements[m], 0.0f))
+            ++skipped;
+
+          //Points on resting faces depend on where the search started, so compare what doesn't
+          Assert::IsTrue(c.mSize > 0 && u.mSize > 0, LINE_INFO());
+          Assert::IsTrue(c.mNormal.equal(u.mNormal, epsilon), LINE_INFO());
+          Assert::AreEqual(_getDeepest(u), _getDeepest(c), epsilon, LINE_INFO());
+        }
+        //Different contact points make the stacks jostle differently while settling, but they settle in the same place
+        sim.assertClose(epsilon, false);
+      }
+      //Otherwise this only tested that warm starting gives the same result
+      Assert::IsTrue(skipped > 0, L"Some resting pairs should have been skipped", LINE_INFO());
+    }
+  };
+
+  TEST_CLASS(MeshCollisionTest) {
+  public:
+    //Flat square of triangles with its top at y=0, so every edge not on its border is internal
+    static Syx::Handle _addFlatMesh(Syx::PhysicsSystem& system, Syx::Handle space, int cells, float cellSize) {
+      Syx::ModelParam mesh;
+      mesh.setEnvironment(true);
+      const float half = cells*cellSize*0.5f;
+      for(int z = 0; z <= cells; ++z)
+        for(int x = 0; x <= cells; ++x)
+          mesh.addVertex(Syx::Vec3(x*cellSize - half, 0.0f, z*cellSize - half));
+      for(int z = 0; z < cells; ++z) {
+        for(int x = 0; x < cells; ++x) {
+          size_t a = z*(cells + 1) + x;
+          size_t b = a + 1;
+          size_t c = a + cells + 1;
+          size_t d = c + 1;
+          mesh.addTriangle(a, c, b);
+          mesh.addTriangle(b, c, d);
+        }
+      }
+      Syx::Handle result = system.addPhysicsObject(false, true, space);
+      system.setObjectModel(space, result, system.addModel(mesh));
+      return result;
+    }
+
+    //Shapes with a flat or round side resting on the ground, hitting each of the triangle primitive tests
+    struct MeshShape {
+      Syx::Handle (Syx::PhysicsSystem::*mGetModel)();
+      Syx::Vec3 mScale;
+      Syx::Quat mRot;
+    };
+
+    static std::vector<MeshShape> _getMeshShapes() {
+      return {
+        { &Syx::PhysicsSystem::getSphere, Syx::Vec3(0.5f), Syx::Quat::Identity },
+        { &Syx::PhysicsSystem::getCube, Syx::Vec3(0.5f), Syx::Quat::Identity },
+        //On its side so the whole segment is along the ground
+        { &Syx::PhysicsSystem::getCapsule, Syx::Vec3(0.5f), Syx::Quat::axisAngle(Syx::Vec3::UnitZ, SYX_PI_2) }
+      };
+    }
+
+    static Syx::Handle _addMeshShape(Syx::PhysicsSystem& system, Syx::Handle space, const MeshShape& shape, const Syx::Vec3& pos) {
+      Syx::Handle result = system.addPhysicsObject(true, true, space);
+      system.setObjectModel(space, result, (system.*shape.mGetModel)());
+      system.setScale(space, result, shape.mScale);
+      system.setRotation(space, result, shape.mRot);
+      system.setPosition(space, result, pos);
+      return result;
+    }
+
+    TEST_METHOD(MeshCollision_SlideOverInternalEdges_FaceNormals) {
+      const Syx::SyxOptions options = getTestOptions(0);
+      for(const MeshShape& shape : _getMeshShapes()) {
+        Syx::PhysicsSystem system;
+        Syx::Handle space = system.addSpace();
+        _addFlatMesh(system, space, 8, 1.0f);
+        //Starts resting on the ground, so the only thing that could push it up is an edge
+        Syx::Handle body = _addMeshShape(system, space, shape, Syx::Vec3(-3.0f, 0.5f, -2.5f));
+
+        for(int i = 0; i < 60; ++i) {
+          //Pushed along a diagonal so it keeps sliding over edges in all three directions the triangles have, despite friction
+          system.setVelocity(space, body, Syx::Vec3(4.0f, system.getVelocity(space, body).y, 3.0f));
+          system.setAngularVelocity(space, body, Syx::Vec3::Zero);
+          system.update(Syx::PhysicsSystem::sSimRate, options);
+          for(const Syx::Manifold* manifold : Syx::SimulationTest::getManifolds(system, space))
+            Assert::IsTrue(!manifold->mSize || std::abs(manifold->mNormal.y) > 0.99f, L"Contacts should use the face normal", LINE_INFO());
+          //Landing on the next triangle's edge would knock it upwards
+          Assert::IsTrue(system.getVelocity(space, body).y < 0.2f, LINE_INFO());
+        }
+      }
+    }
+
+    TEST_METHOD(MeshCollision_RestOnFaceEdgeAndVertex_StaysAtRest) {
+      const Syx::SyxOptions options = getTestOptions(0);
+      //In the middle of a triangle, on an edge between two and on a vertex between six
+      const Syx::Vec3 spots[] = { Syx::Vec3(0.3f, 0.0f, 0.6f), Syx::Vec3(0.5f, 0.0f, 0.0f), Syx::Vec3::Zero };
+      for(const MeshShape& shape : _getMeshShapes()) {
+        for(const Syx::Vec3& spot : spots) {
+          Syx::PhysicsSystem system;
+          Syx::Handle space = system.addSpace();
+          _addFlatMesh(system, space, 4, 1.0f);
+          Syx::Handle body = _addMeshShape(system, space, shape, spot + Syx::Vec3(0.0f, 0.6f, 0.0f));
+
+          for(int i = 0; i < 60; ++i)
+            system.update(Syx::PhysicsSystem::sSimRate, options);
+
+          std::vector<const Syx::Manifold*> manifolds = Syx::SimulationTest::getManifolds(system, space);
+          Assert::IsFalse(manifolds.empty(), LINE_INFO());
+          for(const Syx::Manifold* manifold : manifolds)
+            Assert::IsTrue(manifold->mSize > 0 && std::abs(manifold->mNormal.y) > 0.99f, LINE_INFO());
+          //Every shape is half a unit from its center to the ground
+          Assert::IsTrue(system.getPosition(space, body).equal(spot + Syx::Vec3(0.0f, 0.5f, 0.0f), 0.05f), L"Should rest on the surface", LINE_INFO());
+
+          //And stays there
+          const Syx::Vec3 rest = system.getPosition(space, body);
+          for(int i = 0; i < 30; ++i)
+            system.update(Syx::PhysicsSystem::sSimRate, options);
+          Assert::IsTrue(system.getPosition(space, body).equal(rest, 0.01f), L"Should stay at rest", LINE_INFO());
+        }
+      }
+    }
+  };
+
+  TEST_CLASS(BatchQueryTest) {
+  public:
+    //Static boxes and spheres of varying size and orientation scattered through a volume, returned with the space they're in
+    static std::vector<Syx::Handle> _addQueryScene(Syx::PhysicsSystem& system, Syx::Handle space) {
+      std::vector<Syx::Handle> result;
+      for(int x = -2; x <= 2; ++x)
+        for(int y = -2; y <= 2; ++y)
+          for(int z = -1; z <= 1; ++z) {
+            const int i = static_cast<int>(result.size());
+            Syx::Handle obj = system.addPhysicsObject(false, true, space);
+            system.setObjectModel(space, obj, i % 3 ? system.getCube() : system.getSphere());
+            system.setScale(space, obj, Syx::Vec3(0.4f + 0.1f*(i % 4), 0.5f + 0.2f*(i % 3), 0.3f + 0.1f*(i % 5)));
+            system.setRotation(space, obj, Syx::Quat::axisAngle(Syx::Vec3(1.0f, 2.0f, 3.0f).normalized(), 0.3f*i));
+            system.setPosition(space, obj, Syx::Vec3(x*3.0f, y*3.0f, z*3.0f));
+            result.push_back(obj);
+          }
+      system.update(Syx::PhysicsSystem::sSimRate, getTestOptions(0));
+      return result;
+    }
+
+    //Lines from one point in the scene to another, deterministic so failures can be reproduced
+    static void _getLines(size_t count, std::vector<Syx::Vec3>& starts, std::vector<Syx::Vec3>& ends) {
+      uint32_t seed = 12345;
+      auto random = [&seed](float min, float max) {
+        seed = seed*1664525 + 1013904223;
+        return min + (max - min)*static_cast<float>(seed >> 8)/static_cast<float>(1 << 24);
+      };
+      for(size_t i = 0; i < count; ++i) {
+        starts.push_back(Syx::Vec3(random(-9.0f, 9.0f), random(-9.0f, 9.0f), random(-5.0f, 5.0f)));
+        ends.push_back(Syx::Vec3(random(-9.0f, 9.0f), random(-9.0f, 9.0f), random(-5.0f, 5.0f)));
+      }
+      //Straight through a row of objects, so there are several hits to stop early on
+      starts.push_back(Syx::Vec3(-8.0f, 0.0f, 0.0f));
+      ends.push_back(Syx::Vec3(8.0f, 0.0f, 0.0f));
+    }
+
+    //Small batches so queries are spread over several contexts, and a worker pool so they run in parallel
+    struct ScopedBatchSize {
+      ScopedBatchSize(size_t size)
+        : mOld(Syx::Space::sQueryBatchSize) {
+        Syx::Space::sQueryBatchSize = size;
+      }
+
+      ~ScopedBatchSize() {
+        Syx::Space::sQueryBatchSize = mOld;
+      }
+
+      size_t mOld;
+    };
+
+    static void _assertSameHit(const Syx::CastResult& expected, const Syx::CastResult& actual) {
+      Assert::AreEqual(expected.mObj, actual.mObj, L"Batch should hit the same object as the single cast", LINE_INFO());
+      Assert::AreEqual(expected.mDistSq, actual.mDistSq, 0.0001f, LINE_INFO());
+      Assert::IsTrue(expected.mPoint.distance2(actual.mPoint) < 0.0001f, LINE_INFO());
+    }
+
+    static std::vector<Syx::Handle> _getOverlaps(const std::vector<Syx::Handle>& results, const std::vector<size_t>& offsets, size_t volume) {
+      std::vector<Syx::Handle> result(results.begin() + offsets[volume], results.begin() + offsets[volume + 1]);
+      std::sort(result.begin(), result.end());
+      return result;
+    }
+
+    TEST_METHOD(BatchQuery_LineCastClosest_MatchesSingleCasts) {
+      ScopedWorkerPool pool;
+      ScopedBatchSize batchSize(8);
+      Syx::PhysicsSystem system;
+      Syx::Handle space = system.addSpace();
+      _addQueryScene(system, space);
+      std::vector<Syx::Vec3> starts, ends;
+      _getLines(100, starts, ends);
+
+      std::vector<Syx::CastResult> results;
+      system.lineCastBatch(space, starts.data(), ends.data(), starts.size(), Syx::CastMode::Closest, results);
+
+      Assert::AreEqual(starts.size(), results.size(), LINE_INFO());
+      size_t hits = 0;
+      for(size_t i = 0; i < starts.size(); ++i) {
+        const std::vector<Syx::CastResult> all = *system.lineCastAll(space, starts[i], ends[i]).mResults;
+        if(all.empty())
+          Assert::AreEqual(Syx::Handle(SyxInvalidHandle), results[i].mObj, L"Batch shouldn't hit anything the single cast missed", LINE_INFO());
+        else {
+          _assertSameHit(all.front(), results[i]);
+          ++hits;
+        }
+      }
+      Assert::IsTrue(hits > 10 && hits < starts.size() - 10, L"Lines should be a mix of hits and misses", LINE_INFO());
+    }
+
+    TEST_METHOD(BatchQuery_LineCastAny_HitsWhereSingleCastsHit) {
+      ScopedWorkerPool pool;
+      ScopedBatchSize batchSize(8);
+      Syx::PhysicsSystem system;
+      Syx::Handle space = system.addSpace();
+      _addQueryScene(system, space);
+      std::vector<Syx::Vec3> starts, ends;
+      _getLines(100, starts, ends);
+
+      std::vector<Syx::CastResult> results;
+      system.lineCastBatch(space, starts.data(), ends.data(), starts.size(), Syx::CastMode::Any, results);
+
+      size_t stoppedEarly = 0;
+      for(size_t i = 0; i < starts.size(); ++i) {
+        const std::vector<Syx::CastResult> all = *system.lineCastAll(space, starts[i], ends[i]).mResults;
+        if(all.empty()) {
+          Assert::AreEqual(Syx::Handle(SyxInvalidHandle), results[i].mObj, L"Batch shouldn't hit anything the single cast missed", LINE_INFO());
+          continue;
+        }
+        //Stopping at the first hit can pick any of them, but it must be one the full cast found
+        auto found = std::find_if(all.begin(), all.end(), [&results, i](const Syx::CastResult& hit) {
+          return hit.mObj == results[i].mObj;
+        });
+        Assert::IsTrue(found != all.end(), L"Any hit should be one of the single cast's hits", LINE_INFO());
+        if(found != all.end())
+          _assertSameHit(*found, results[i]);
+        if(found != all.begin())
+          ++stoppedEarly;
+      }
+      Assert::IsTrue(stoppedEarly > 0, L"Some lines should stop at a hit before reaching the closest one", LINE_INFO());
+      Assert::IsTrue(system.lineCastAll(space, starts.back(), ends.back()).mResults->size() > 2, L"Last line should pass through several objects", LINE_INFO());
+    }
+
+    TEST_METHOD(BatchQuery_OverlapBoxes_MatchesEachObjectsBounds) {
+      ScopedWorkerPool pool;
+      ScopedBatchSize batchSize(8);
+      Syx::PhysicsSystem system;
+      Syx::Handle space = system.addSpace();
+      const std::vector<Syx::Handle> objs = _addQueryScene(system, space);
+      std::vector<Syx::Vec3> starts, ends;
+      _getLines(50, starts, ends);
+      std::vector<Syx::AABB> volumes;
+      for(size_t i = 0; i < starts.size(); ++i)
+        volumes.push_back(Syx::AABB(starts[i], starts[i] + Syx::Vec3(0.5f + (i % 4), 1.0f, 0.5f + (i % 3))));
+
+      std::vector<Syx::Handle> results;
+      std::vector<size_t> offsets;
+      system.overlapBatch(space, volumes.data(), volumes.size(), results, offsets);
+
+      Assert::AreEqual(volumes.size() + 1, offsets.size(), LINE_INFO());
+      for(size_t i = 0; i < volumes.size(); ++i) {
+        std::vector<Syx::Handle> expected;
+        for(Syx::Handle obj : objs) {
+          Syx::Vec3 min, max;
+          system.getAABB(space, obj, min, max);
+          if(volumes[i].overlapping(Syx::AABB(min, max)))
+            expected.push_back(obj);
+        }
+        std::sort(expected.begin(), expected.end());
+        Assert::IsTrue(expected == _getOverlaps(results, offsets, i), L"Batch should find exactly the objects whose bounds overlap", LINE_INFO());
+      }
+      Assert::IsTrue(!results.empty(), L"Some volumes should overlap objects", LINE_INFO());
+    }
+
+    TEST_METHOD(BatchQuery_OverlapSpheres_MatchesEachObjectsBounds) {
+      ScopedWorkerPool pool;
+      ScopedBatchSize batchSize(8);
+      Syx::PhysicsSystem system;
+      Syx::Handle space = system.addSpace();
+      const std::vector<Syx::Handle> objs = _addQueryScene(system, space);
+      std::vector<Syx::Vec3> centers, ends;
+      _getLines(50, centers, ends);
+      std::vector<float> radii;
+      for(size_t i = 0; i < centers.size(); ++i)
+        radii.push_back(0.5f + 0.5f*(i % 5));
+
+      std::vector<Syx::Handle> results;
+      std::vector<size_t> offsets;
+      system.overlapBatch(space, centers.data(), radii.data(), centers.size(), results, offsets);
+
+      Assert::AreEqual(centers.size() + 1, offsets.size(), LINE_INFO());
+      for(size_t i = 0; i < centers.size(); ++i) {
+        std::vector<Syx::Handle> expected;
+        for(Syx::Handle obj : objs) {
+          Syx::Vec3 min, max;
+          system.getAABB(space, obj, min, max);
+          Syx::Vec3 closest = centers[i];
+          for(int axis = 0; axis < 3; ++axis)
+            closest[axis] = std::max(min[axis], std::min(closest[axis], max[axis]));
+          if(closest.distance2(centers[i]) <= radii[i]*radii[i])
+            expected.push_back(obj);
+        }
+        std::sort(expected.begin(), expected.end());
+        Assert::IsTrue(expected == _getOverlaps(results, offsets, i), L"Batch should find exactly the objects whose bounds touch the sphere", LINE_INFO());
+      }
+      Assert::IsTrue(!results.empty(), L"Some spheres should overlap objects", LINE_INFO());
+    }
+  };
+
+  TEST_CLASS(AllocationTest) {
+  public:
+    TEST_METHOD(Allocation_SettledStacks_NoAllocationsPerStep) {
+      //Without the counting operator new there's nothing to measure, so passing would mean nothing
+      Assert::IsTrue(AllocationCounter::isEnabled(), L"Allocation tests need SYX_COUNT_ALLOCATIONS", LINE_INFO());
+      //The counter only sees this thread, so nothing can be handed off to workers
+      const Syx::SyxOptions options = getTestOptions(0);
+      Syx::PhysicsSystem system;
+      Syx::Handle space = system.addSpace();
+      addStacks(system, space, 2, 4);
+
+      //Let the stacks settle so every container has grown to its working size
+      for(int i = 0; i < 240; ++i)
+        system.update(Syx::PhysicsSystem::sSimRate, options);
+
+      for(int i = 0; i < 60; ++i) {
+        AllocationCounter::reset();
+        system.update(Syx::PhysicsSystem::sSimRate, options);
+        Assert::AreEqual(size_t(0), AllocationCounter::get(), LINE_INFO());
+      }
+    }
+  };
+}